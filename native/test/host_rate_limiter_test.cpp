@@ -0,0 +1,144 @@
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "vodarchiver/host_rate_limiter.h"
+
+TEST(HostRateLimiter, SpacesRequestsPerHost) {
+    using namespace VodArchiver;
+    using namespace std::chrono_literals;
+    HostRateLimiter limiter(10s, 1s, 60s, 0s, 1);
+    const auto now = HostRateLimiter::Clock::now();
+
+    EXPECT_EQ(now, limiter.Reserve("a.example", now));
+    EXPECT_EQ(now + 10s, limiter.Reserve("a.example", now));
+    EXPECT_EQ(now + 20s, limiter.Reserve("a.example", now + 5s));
+
+    // other hosts aren't affected
+    EXPECT_EQ(now, limiter.Reserve("b.example", now));
+    EXPECT_EQ(now, limiter.Reserve("", now));
+    EXPECT_EQ(now, limiter.Reserve("", now));
+
+    // once the host was idle long enough the request can go out immediately
+    EXPECT_EQ(now + 60s, limiter.Reserve("a.example", now + 60s));
+
+    limiter.SetInterval("a.example", 30s);
+    EXPECT_EQ(30s, limiter.GetInterval("a.example"));
+    EXPECT_EQ(now + 70s, limiter.Reserve("a.example", now + 60s));
+    EXPECT_EQ(now + 100s, limiter.Reserve("a.example", now + 60s));
+}
+
+TEST(HostRateLimiter, Jitter) {
+    using namespace VodArchiver;
+    using namespace std::chrono_literals;
+    HostRateLimiter limiter(10s, 1s, 60s, 5s, 1);
+    const auto now = HostRateLimiter::Clock::now();
+
+    auto previous = limiter.Reserve("a.example", now);
+    for (int i = 0; i < 100; ++i) {
+        const auto slot = limiter.Reserve("a.example", now);
+        EXPECT_GE(slot - previous, 10s);
+        EXPECT_LT(slot - previous, 15s);
+        previous = slot;
+    }
+}
+
+TEST(HostRateLimiter, AdaptsToResponses) {
+    using namespace VodArchiver;
+    using namespace std::chrono_literals;
+    HostRateLimiter limiter(10s, 1s, 60s, 0s, 1);
+    const auto now = HostRateLimiter::Clock::now();
+    EXPECT_EQ(now, limiter.Reserve("a.example", now));
+
+    // plenty of budget left, so go fast
+    limiter.Update("a.example", {.Remaining = 30, .Reset = now + 60s}, now);
+    EXPECT_EQ(2s, limiter.GetInterval("a.example"));
+    EXPECT_EQ(now + 2s, limiter.Reserve("a.example", now));
+
+    // running low, slow down but never beyond the maximum
+    limiter.Update("a.example", {.Remaining = 1, .Reset = now + 120s}, now);
+    EXPECT_EQ(60s, limiter.GetInterval("a.example"));
+
+    // out of budget, nothing goes out until it resets
+    limiter.Update("a.example", {.Remaining = 0, .Reset = now + 300s}, now);
+    limiter.Update("a.example", {.Remaining = 40, .Reset = now + 20s}, now);
+    EXPECT_EQ(1s, limiter.GetInterval("a.example"));
+    EXPECT_EQ(now + 300s, limiter.Reserve("a.example", now));
+
+    // a 429 without any other information backs off
+    limiter.Update("b.example", {.TooManyRequests = true}, now);
+    EXPECT_EQ(20s, limiter.GetInterval("b.example"));
+    EXPECT_EQ(now + 20s, limiter.Reserve("b.example", now));
+
+    limiter.Update("c.example", {.TooManyRequests = true, .RetryAfter = 45s}, now);
+    EXPECT_EQ(now + 45s, limiter.Reserve("c.example", now));
+}
+
+TEST(HostRateLimiter, ParseRateLimitHeaders) {
+    using namespace VodArchiver;
+    using namespace std::chrono_literals;
+    using Headers = std::vector<std::pair<std::string, std::string>>;
+    const auto now = HostRateLimiter::Clock::now();
+    const int64_t unixNow = 1700000000;
+
+    // reset as a unix timestamp
+    auto info = ParseRateLimitHeaders(200,
+                                      Headers{{"ratelimit-remaining", "30"},
+                                              {"RateLimit-Reset", "1700000060"}},
+                                      now,
+                                      unixNow);
+    EXPECT_FALSE(info.TooManyRequests);
+    EXPECT_FALSE(info.RetryAfter);
+    EXPECT_EQ(30, info.Remaining);
+    EXPECT_EQ(now + 60s, info.Reset);
+
+    // reset as seconds from now
+    info = ParseRateLimitHeaders(
+        200, Headers{{"X-Ratelimit-Remaining", "5"}, {"X-Ratelimit-Reset", "90"}}, now, unixNow);
+    EXPECT_EQ(5, info.Remaining);
+    EXPECT_EQ(now + 90s, info.Reset);
+
+    // the unprefixed headers win
+    info = ParseRateLimitHeaders(
+        429,
+        Headers{{"X-Ratelimit-Reset", "90"}, {"Ratelimit-Reset", "15"}, {"Retry-After", "45"}},
+        now,
+        unixNow);
+    EXPECT_TRUE(info.TooManyRequests);
+    EXPECT_EQ(45s, info.RetryAfter);
+    EXPECT_FALSE(info.Remaining);
+    EXPECT_EQ(now + 15s, info.Reset);
+
+    info = ParseRateLimitHeaders(200, Headers{{"Ratelimit-Reset", "soon"}}, now, unixNow);
+    EXPECT_FALSE(info.Reset);
+
+    // both forms drive the limiter the same way
+    HostRateLimiter limiter(10s, 1s, 60s, 0s, 1);
+    limiter.Update(
+        "a.example",
+        ParseRateLimitHeaders(
+            200, Headers{{"Ratelimit-Remaining", "0"}, {"Ratelimit-Reset", "120"}}, now, unixNow),
+        now);
+    limiter.Update("b.example",
+                   ParseRateLimitHeaders(
+                       200,
+                       Headers{{"Ratelimit-Remaining", "0"}, {"Ratelimit-Reset", "1700000120"}},
+                       now,
+                       unixNow),
+                   now);
+    EXPECT_EQ(now + 120s, limiter.Reserve("a.example", now));
+    EXPECT_EQ(now + 120s, limiter.Reserve("b.example", now));
+}
+
+TEST(HostRateLimiter, QuietHostsStartOutSlower) {
+    using namespace VodArchiver;
+
+    // youtube.com is only reached through yt-dlp, so nothing would ever slow it down
+    HostRateLimiter& limiter = GetFetchRateLimiter();
+    EXPECT_GT(limiter.GetInterval("www.youtube.com"), limiter.GetInterval("api.twitch.tv"));
+    EXPECT_GT(limiter.GetInterval("archive.org"), limiter.GetInterval("api.twitch.tv"));
+}
@@ -0,0 +1,95 @@
+#include <cstdint>
+
+#include <string_view>
+
+#include "gtest/gtest.h"
+
+#include "vodarchiver/job_progress.h"
+
+TEST(JobProgress, FFMpegProgressParser) {
+    using namespace VodArchiver;
+    JobProgress progress;
+    progress.Begin(JobProgressKind::Encode, 100'000'000);
+    FFMpegProgressParser parser(progress);
+
+    parser.Feed("frame=1200\nfps=60.00\nstream_0_0_q=28.0\nbitrate=N/A\ntotal_si");
+    parser.Feed("ze=1048576\nout_time_us=25000000\nout_time_ms=25000000\n");
+    parser.Feed("out_time=00:00:25.000000\ndup_frames=0\ndrop_frames=0\nspeed=2.5x\r\n");
+    parser.Feed("progress=continue\n");
+
+    EXPECT_EQ(1200u, progress.Frame.load());
+    EXPECT_DOUBLE_EQ(60.0, progress.Fps.load());
+    EXPECT_EQ(1048576u, progress.TotalSizeBytes.load());
+    EXPECT_EQ(25'000'000, progress.OutTimeUs.load());
+    EXPECT_DOUBLE_EQ(2.5, progress.Speed.load());
+
+    JobProgressSnapshot s = SampleJobProgress(progress);
+    EXPECT_EQ(JobProgressKind::Encode, s.Kind);
+    EXPECT_DOUBLE_EQ(0.25, s.Fraction);
+    EXPECT_EQ(30, s.EtaSeconds);
+
+    // unknown values must not clobber the previous ones
+    parser.Feed("speed=N/A\nfps=N/A\n");
+    EXPECT_DOUBLE_EQ(2.5, progress.Speed.load());
+    EXPECT_DOUBLE_EQ(60.0, progress.Fps.load());
+
+    progress.End();
+    EXPECT_EQ(JobProgressKind::None, SampleJobProgress(progress).Kind);
+}
+
+TEST(JobProgress, YtDlpProgressParser) {
+    using namespace VodArchiver;
+    JobProgress progress;
+    progress.Begin(JobProgressKind::Download);
+    YtDlpProgressParser parser(progress);
+
+    parser.Feed("[youtube] abcdefghijk: Downloading webpage\n");
+    parser.Feed("[vodarchiver-progress] 1024 4096 NA 512.5 6\n");
+    EXPECT_EQ(1024u, progress.TotalSizeBytes.load());
+    EXPECT_EQ(4096u, progress.ExpectedSizeBytes.load());
+    EXPECT_DOUBLE_EQ(512.5, progress.BytesPerSecond.load());
+    EXPECT_EQ(6, progress.ReportedEtaSeconds.load());
+
+    JobProgressSnapshot s = SampleJobProgress(progress);
+    EXPECT_EQ(JobProgressKind::Download, s.Kind);
+    EXPECT_DOUBLE_EQ(0.25, s.Fraction);
+    EXPECT_EQ(6, s.EtaSeconds);
+
+    // estimated total is used if the exact one is unknown
+    parser.Feed("[vodarchiver-progress] 2048 NA 8192.0 NA NA\n");
+    EXPECT_EQ(8192u, progress.ExpectedSizeBytes.load());
+    EXPECT_EQ(-1, progress.ReportedEtaSeconds.load());
+}
+
+TEST(JobProgress, Throughput) {
+    using namespace VodArchiver;
+    JobProgressSnapshot a{.Kind = JobProgressKind::Encode, .Fps = 30.0, .Speed = 1.0};
+    JobProgressSnapshot b{.Kind = JobProgressKind::Encode, .Fps = 45.0, .Speed = 1.5};
+    JobProgressSnapshot c{.Kind = JobProgressKind::None, .Fps = 100.0};
+    JobProgressThroughput t;
+    t.Add(a);
+    t.Add(b);
+    t.Add(c);
+    EXPECT_EQ(2u, t.EncodeJobs);
+    EXPECT_DOUBLE_EQ(75.0, t.EncodeFps);
+    EXPECT_DOUBLE_EQ(2.5, t.EncodeSpeed);
+    EXPECT_EQ(0u, t.DownloadJobs);
+}
+
+TEST(JobProgress, StallDetection) {
+    using namespace VodArchiver;
+    JobProgress progress;
+    progress.Heartbeat();
+    EXPECT_FALSE(IsJobProgressStalled(progress, 60'000));
+
+    // pretend the last heartbeat was long ago
+    progress.LastHeartbeatTimeMs.store(progress.LastHeartbeatTimeMs.load() - 120'000);
+    EXPECT_TRUE(IsJobProgressStalled(progress, 60'000));
+    {
+        JobIdleWait idle(progress);
+        EXPECT_FALSE(IsJobProgressStalled(progress, 60'000));
+    }
+
+    // ending the wait counts as a heartbeat
+    EXPECT_FALSE(IsJobProgressStalled(progress, 60'000));
+}
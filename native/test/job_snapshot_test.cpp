@@ -0,0 +1,413 @@
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "util/file.h"
+
+#include "vodarchiver/videoinfo/ffmpeg-reencode-job-video-info.h"
+#include "vodarchiver/videoinfo/generic-video-info.h"
+#include "vodarchiver/videoinfo/hitbox-video-info.h"
+#include "vodarchiver/videoinfo/i-video-info.h"
+#include "vodarchiver/videoinfo/twitch-video-info.h"
+#include "vodarchiver/videoinfo/youtube-video-info.h"
+#include "vodarchiver/videojobs/ffmpeg-reencode-job.h"
+#include "vodarchiver/videojobs/ffmpeg-split-job.h"
+#include "vodarchiver/videojobs/generic-file-job.h"
+#include "vodarchiver/videojobs/hitbox-video-job.h"
+#include "vodarchiver/videojobs/i-video-job.h"
+#include "vodarchiver/videojobs/job_snapshot.h"
+#include "vodarchiver/videojobs/twitch-chat-replay-job.h"
+#include "vodarchiver/videojobs/twitch-video-job.h"
+#include "vodarchiver/videojobs/youtube-video-job.h"
+
+namespace {
+using namespace VodArchiver;
+
+std::unique_ptr<GenericVideoInfo> MakeGenericVideoInfo(StreamService service, std::string id) {
+    auto info = std::make_unique<GenericVideoInfo>();
+    info->Service = service;
+    info->Username = "some user";
+    info->VideoId = std::move(id);
+    info->VideoTitle = "a title";
+    info->VideoGame = "a game";
+    info->VideoTimestamp = DateTime::FromUnixTime(1700000000);
+    info->VideoLength = TimeSpan{.Ticks = 123456789};
+    info->VideoRecordingState = RecordingState::Recorded;
+    info->VideoType = VideoFileType::M3U;
+    return info;
+}
+
+std::unique_ptr<HitboxVideoInfo> MakeHitboxVideoInfo() {
+    auto info = std::make_unique<HitboxVideoInfo>();
+    HitboxVideo& v = info->VideoInfo;
+    v.MediaUserName = "hitbox user";
+    v.MediaId = 4242;
+    v.MediaFile = "file.m3u8";
+    v.MediaUserId = 17;
+    v.MediaProfiles.push_back(HitboxMediaProfile{.Url = "a.m3u8", .Height = 720, .Bitrate = 2500});
+    v.MediaProfiles.push_back(HitboxMediaProfile{.Url = "b.m3u8", .Height = 360, .Bitrate = 800});
+    v.MediaDateAdded = DateTime::FromUnixTime(1400000000);
+    v.MediaTitle = "hitbox title";
+    v.MediaDescription = "hitbox description";
+    v.MediaGame = "hitbox game";
+    v.MediaDuration = 3601.5;
+    v.MediaTypeId = 2;
+    return info;
+}
+
+std::unique_ptr<TwitchVideoInfo> MakeTwitchVideoInfo() {
+    auto info = std::make_unique<TwitchVideoInfo>();
+    info->Service = StreamService::Twitch;
+    TwitchVideo& v = info->Video;
+    v.ID = 1234567890123;
+    v.UserID = 987654;
+    v.Username = "twitch user";
+    v.Title = "twitch title";
+    v.Game = std::nullopt;
+    v.Description = "";
+    v.CreatedAt = DateTime::FromUnixTime(1600000000);
+    v.PublishedAt = std::nullopt;
+    v.Duration = 7200;
+    v.ViewCount = 31;
+    v.Type = TwitchVideoType::Highlight;
+    v.State = RecordingState::Live;
+    return info;
+}
+
+std::unique_ptr<YoutubeVideoInfo> MakeYoutubeVideoInfo() {
+    auto info = std::make_unique<YoutubeVideoInfo>();
+    info->Username = "UCxyz";
+    info->VideoId = "dQw4w9WgXcQ";
+    info->VideoTitle = "youtube title";
+    info->VideoGame = "";
+    info->VideoTimestamp = DateTime::FromUnixTime(1250000000);
+    info->VideoLength = TimeSpan{.Ticks = 2120000000};
+    info->VideoRecordingState = RecordingState::Recorded;
+    info->VideoType = VideoFileType::Unknown;
+    info->UserDisplayName = "youtube display name";
+    info->VideoDescription = "line one\nline two";
+    return info;
+}
+
+std::unique_ptr<FFMpegReencodeJobVideoInfo> MakeFFMpegReencodeVideoInfo() {
+    auto info = std::make_unique<FFMpegReencodeJobVideoInfo>();
+    info->FFMpegOptions = {"-c:v", "libx264", "-crf", "23"};
+    info->PostfixOld = "_old";
+    info->PostfixNew = "_new";
+    info->OutputFormat = "mkv";
+    info->Filesize = 5'000'000'000;
+    info->Bitrate = 6'000'000;
+    info->Framerate = 29.97f;
+    info->VideoId = "/videos/input.mp4";
+    info->VideoTitle = "input.mp4";
+    info->VideoTimestamp = DateTime::FromUnixTime(1500000000);
+    info->VideoLength = TimeSpan{.Ticks = 999};
+    return info;
+}
+
+void FillCommonFields(IVideoJob& job, VideoJobStatus status, std::string_view notes) {
+    job.TextStatus = "Some status";
+    job.JobStatus = status;
+    job.HasBeenValidated = (status == VideoJobStatus::Finished);
+    job.JobStartTimestamp = DateTime::FromUnixTime(1700000100);
+    job.JobFinishTimestamp = DateTime::FromUnixTime(1700000200);
+    job.Notes = std::string(notes);
+}
+
+// one job of every type, which together use every type of video info
+std::vector<std::unique_ptr<IVideoJob>> MakeJobs() {
+    std::vector<std::unique_ptr<IVideoJob>> jobs;
+    {
+        auto job = std::make_unique<GenericFileJob>();
+        job->VideoInfo = MakeGenericVideoInfo(StreamService::RawUrl, "https://example.com/a.mp4");
+        FillCommonFields(*job, VideoJobStatus::Finished, "notes 0");
+        jobs.push_back(std::move(job));
+    }
+    {
+        auto job = std::make_unique<HitboxVideoJob>();
+        job->VideoInfo = MakeHitboxVideoInfo();
+        FillCommonFields(*job, VideoJobStatus::Dead, "notes 1");
+        jobs.push_back(std::move(job));
+    }
+    {
+        auto job = std::make_unique<TwitchChatReplayJob>();
+        job->VideoInfo = MakeGenericVideoInfo(StreamService::TwitchChatReplay, "1234567890123");
+        FillCommonFields(*job, VideoJobStatus::Finished, "notes 2");
+        jobs.push_back(std::move(job));
+    }
+    {
+        auto job = std::make_unique<TwitchVideoJob>();
+        job->VideoInfo = MakeTwitchVideoInfo();
+        job->VideoQuality = "1080p60";
+        FillCommonFields(*job, VideoJobStatus::NotStarted, "notes 3");
+        jobs.push_back(std::move(job));
+    }
+    {
+        auto job = std::make_unique<YoutubeVideoJob>();
+        job->VideoInfo = MakeYoutubeVideoInfo();
+        FillCommonFields(*job, VideoJobStatus::Finished, "notes 4");
+        jobs.push_back(std::move(job));
+    }
+    {
+        auto job = std::make_unique<FFMpegReencodeJob>();
+        job->VideoInfo = MakeFFMpegReencodeVideoInfo();
+        FillCommonFields(*job, VideoJobStatus::Running, "notes 5");
+        jobs.push_back(std::move(job));
+    }
+    {
+        auto job = std::make_unique<FFMpegSplitJob>("/videos/split.mp4", "00:10:00,00:20:00");
+        FillCommonFields(*job, VideoJobStatus::Finished, "notes 6");
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
+
+void ExpectSameVideoInfo(const IVideoInfo& expected, const IVideoInfo& actual) {
+    if (auto* e = dynamic_cast<const GenericVideoInfo*>(&expected)) {
+        auto* a = dynamic_cast<const GenericVideoInfo*>(&actual);
+        ASSERT_NE(nullptr, a);
+        EXPECT_EQ(e->Service, a->Service);
+        EXPECT_EQ(e->Username, a->Username);
+        EXPECT_EQ(e->VideoId, a->VideoId);
+        EXPECT_EQ(e->VideoTitle, a->VideoTitle);
+        EXPECT_EQ(e->VideoGame, a->VideoGame);
+        EXPECT_EQ(e->VideoTimestamp, a->VideoTimestamp);
+        EXPECT_EQ(e->VideoLength, a->VideoLength);
+        EXPECT_EQ(e->VideoRecordingState, a->VideoRecordingState);
+        EXPECT_EQ(e->VideoType, a->VideoType);
+    } else if (auto* e = dynamic_cast<const HitboxVideoInfo*>(&expected)) {
+        auto* a = dynamic_cast<const HitboxVideoInfo*>(&actual);
+        ASSERT_NE(nullptr, a);
+        const HitboxVideo& ev = e->VideoInfo;
+        const HitboxVideo& av = a->VideoInfo;
+        EXPECT_EQ(ev.MediaUserName, av.MediaUserName);
+        EXPECT_EQ(ev.MediaId, av.MediaId);
+        EXPECT_EQ(ev.MediaFile, av.MediaFile);
+        EXPECT_EQ(ev.MediaUserId, av.MediaUserId);
+        ASSERT_EQ(ev.MediaProfiles.size(), av.MediaProfiles.size());
+        for (size_t i = 0; i < ev.MediaProfiles.size(); ++i) {
+            EXPECT_EQ(ev.MediaProfiles[i].Url, av.MediaProfiles[i].Url);
+            EXPECT_EQ(ev.MediaProfiles[i].Height, av.MediaProfiles[i].Height);
+            EXPECT_EQ(ev.MediaProfiles[i].Bitrate, av.MediaProfiles[i].Bitrate);
+        }
+        EXPECT_EQ(ev.MediaDateAdded, av.MediaDateAdded);
+        EXPECT_EQ(ev.MediaTitle, av.MediaTitle);
+        EXPECT_EQ(ev.MediaDescription, av.MediaDescription);
+        EXPECT_EQ(ev.MediaGame, av.MediaGame);
+        EXPECT_EQ(ev.MediaDuration, av.MediaDuration);
+        EXPECT_EQ(ev.MediaTypeId, av.MediaTypeId);
+    } else if (auto* e = dynamic_cast<const TwitchVideoInfo*>(&expected)) {
+        auto* a = dynamic_cast<const TwitchVideoInfo*>(&actual);
+        ASSERT_NE(nullptr, a);
+        EXPECT_EQ(e->Service, a->Service);
+        EXPECT_EQ(e->Video.ID, a->Video.ID);
+        EXPECT_EQ(e->Video.UserID, a->Video.UserID);
+        EXPECT_EQ(e->Video.Username, a->Video.Username);
+        EXPECT_EQ(e->Video.Title, a->Video.Title);
+        EXPECT_EQ(e->Video.Game, a->Video.Game);
+        EXPECT_EQ(e->Video.Description, a->Video.Description);
+        EXPECT_EQ(e->Video.CreatedAt, a->Video.CreatedAt);
+        EXPECT_EQ(e->Video.PublishedAt, a->Video.PublishedAt);
+        EXPECT_EQ(e->Video.Duration, a->Video.Duration);
+        EXPECT_EQ(e->Video.ViewCount, a->Video.ViewCount);
+        EXPECT_EQ(e->Video.Type, a->Video.Type);
+        EXPECT_EQ(e->Video.State, a->Video.State);
+    } else if (auto* e = dynamic_cast<const YoutubeVideoInfo*>(&expected)) {
+        auto* a = dynamic_cast<const YoutubeVideoInfo*>(&actual);
+        ASSERT_NE(nullptr, a);
+        EXPECT_EQ(e->Username, a->Username);
+        EXPECT_EQ(e->VideoId, a->VideoId);
+        EXPECT_EQ(e->VideoTitle, a->VideoTitle);
+        EXPECT_EQ(e->VideoGame, a->VideoGame);
+        EXPECT_EQ(e->VideoTimestamp, a->VideoTimestamp);
+        EXPECT_EQ(e->VideoLength, a->VideoLength);
+        EXPECT_EQ(e->VideoRecordingState, a->VideoRecordingState);
+        EXPECT_EQ(e->VideoType, a->VideoType);
+        EXPECT_EQ(e->UserDisplayName, a->UserDisplayName);
+        EXPECT_EQ(e->VideoDescription, a->VideoDescription);
+    } else if (auto* e = dynamic_cast<const FFMpegReencodeJobVideoInfo*>(&expected)) {
+        auto* a = dynamic_cast<const FFMpegReencodeJobVideoInfo*>(&actual);
+        ASSERT_NE(nullptr, a);
+        EXPECT_EQ(e->FFMpegOptions, a->FFMpegOptions);
+        EXPECT_EQ(e->PostfixOld, a->PostfixOld);
+        EXPECT_EQ(e->PostfixNew, a->PostfixNew);
+        EXPECT_EQ(e->OutputFormat, a->OutputFormat);
+        EXPECT_EQ(e->Filesize, a->Filesize);
+        EXPECT_EQ(e->Bitrate, a->Bitrate);
+        EXPECT_EQ(e->Framerate, a->Framerate);
+        EXPECT_EQ(e->VideoId, a->VideoId);
+        EXPECT_EQ(e->VideoTitle, a->VideoTitle);
+        EXPECT_EQ(e->VideoTimestamp, a->VideoTimestamp);
+        EXPECT_EQ(e->VideoLength, a->VideoLength);
+    } else {
+        FAIL() << "unhandled video info type";
+    }
+}
+
+void ExpectSameJob(const IVideoJob& expected, const IVideoJob& actual) {
+    EXPECT_EQ(typeid(expected), typeid(actual));
+    EXPECT_EQ(expected.TextStatus, actual.TextStatus);
+    EXPECT_EQ(expected.JobStatus.load(), actual.JobStatus.load());
+    EXPECT_EQ(expected.HasBeenValidated, actual.HasBeenValidated);
+    EXPECT_EQ(expected.JobStartTimestamp, actual.JobStartTimestamp);
+    EXPECT_EQ(expected.JobFinishTimestamp, actual.JobFinishTimestamp);
+    EXPECT_EQ(expected.Notes, actual.Notes);
+    if (auto* e = dynamic_cast<const TwitchVideoJob*>(&expected)) {
+        auto* a = dynamic_cast<const TwitchVideoJob*>(&actual);
+        ASSERT_NE(nullptr, a);
+        EXPECT_EQ(e->VideoQuality, a->VideoQuality);
+    }
+    if (auto* e = dynamic_cast<const FFMpegSplitJob*>(&expected)) {
+        auto* a = dynamic_cast<const FFMpegSplitJob*>(&actual);
+        ASSERT_NE(nullptr, a);
+        EXPECT_EQ(e->SplitTimes, a->SplitTimes);
+    }
+    ASSERT_NE(nullptr, expected.VideoInfo);
+    ASSERT_NE(nullptr, actual.VideoInfo);
+    ExpectSameVideoInfo(*expected.VideoInfo, *actual.VideoInfo);
+}
+
+std::string TempPath(std::string_view name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::string ReadWholeFile(std::string_view path) {
+    HyoutaUtils::IO::File file(path, HyoutaUtils::IO::OpenMode::Read);
+    std::string contents;
+    auto length = file.GetLength();
+    if (!length) {
+        return contents;
+    }
+    contents.resize(static_cast<size_t>(*length));
+    if (file.Read(contents.data(), contents.size()) != contents.size()) {
+        contents.clear();
+    }
+    return contents;
+}
+
+void WriteWholeFile(std::string_view path, std::string_view contents) {
+    HyoutaUtils::IO::File file(path, HyoutaUtils::IO::OpenMode::Write);
+    ASSERT_TRUE(file.IsOpen());
+    ASSERT_EQ(contents.size(), file.Write(contents.data(), contents.size()));
+}
+} // namespace
+
+TEST(JobSnapshot, RoundTripsEveryJobType) {
+    const std::string path = TempPath("vodarchiver_job_snapshot_test.snapshot");
+    const auto jobs = MakeJobs();
+    ASSERT_TRUE(WriteJobSnapshot(jobs, path));
+    EXPECT_TRUE(IsJobSnapshotFile(path));
+
+    JobSnapshot snapshot;
+    ASSERT_TRUE(snapshot.Open(path));
+    ASSERT_EQ(jobs.size(), snapshot.GetJobCount());
+    std::array<char, 256> buffer;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        EXPECT_TRUE(snapshot.IsJobIntact(i));
+        EXPECT_EQ(jobs[i]->JobStatus.load(), snapshot.GetJobStatus(i));
+        EXPECT_EQ(jobs[i]->VideoInfo->GetService(), snapshot.GetService(i));
+        EXPECT_EQ(jobs[i]->VideoInfo->GetVideoId(buffer), snapshot.GetVideoId(i));
+        auto job = snapshot.DecodeJob(i);
+        ASSERT_NE(nullptr, job);
+        ExpectSameJob(*jobs[i], *job);
+    }
+    EXPECT_EQ(nullptr, snapshot.DecodeJob(jobs.size()));
+
+    auto read = ReadJobSnapshot(path);
+    ASSERT_TRUE(read.has_value());
+    ASSERT_EQ(jobs.size(), read->size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        ExpectSameJob(*jobs[i], *(*read)[i]);
+    }
+    HyoutaUtils::IO::DeleteFile(std::string_view(path));
+}
+
+TEST(JobSnapshot, CopiesDormantJobs) {
+    const std::string sourcePath = TempPath("vodarchiver_job_snapshot_source.snapshot");
+    const std::string targetPath = TempPath("vodarchiver_job_snapshot_target.snapshot");
+    const auto jobs = MakeJobs();
+    ASSERT_TRUE(WriteJobSnapshot(jobs, sourcePath));
+
+    // write the unfinished jobs as usual and the finished ones straight from the first snapshot
+    auto source = std::make_shared<JobSnapshot>();
+    ASSERT_TRUE(source->Open(sourcePath));
+    DormantJobList dormant{.Snapshot = source};
+    std::vector<std::unique_ptr<IVideoJob>> awake;
+    std::vector<const IVideoJob*> expected;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (jobs[i]->JobStatus == VideoJobStatus::Finished) {
+            dormant.Indices.push_back(i);
+        } else {
+            awake.push_back(jobs[i]->Clone());
+            expected.push_back(jobs[i].get());
+        }
+    }
+    for (size_t index : dormant.Indices) {
+        expected.push_back(jobs[index].get());
+    }
+    ASSERT_TRUE(WriteJobSnapshot(awake, targetPath, &dormant));
+
+    auto read = ReadJobSnapshot(targetPath);
+    ASSERT_TRUE(read.has_value());
+    ASSERT_EQ(expected.size(), read->size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ExpectSameJob(*expected[i], *(*read)[i]);
+    }
+    HyoutaUtils::IO::DeleteFile(std::string_view(sourcePath));
+    HyoutaUtils::IO::DeleteFile(std::string_view(targetPath));
+}
+
+TEST(JobSnapshot, RejectsFlippedByte) {
+    const std::string path = TempPath("vodarchiver_job_snapshot_damaged.snapshot");
+    const auto jobs = MakeJobs();
+    ASSERT_TRUE(WriteJobSnapshot(jobs, path));
+
+    // the notes are unique to each job, so this only damages job 3
+    std::string contents = ReadWholeFile(path);
+    const size_t position = contents.find("notes 3");
+    ASSERT_NE(std::string::npos, position);
+    contents[position + 6] ^= 0x01;
+    WriteWholeFile(path, contents);
+
+    JobSnapshot snapshot;
+    ASSERT_TRUE(snapshot.Open(path));
+    ASSERT_EQ(jobs.size(), snapshot.GetJobCount());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (i == 3) {
+            EXPECT_FALSE(snapshot.IsJobIntact(i));
+            EXPECT_EQ(nullptr, snapshot.DecodeJob(i));
+        } else {
+            EXPECT_TRUE(snapshot.IsJobIntact(i));
+            EXPECT_NE(nullptr, snapshot.DecodeJob(i));
+        }
+    }
+
+    auto read = ReadJobSnapshot(path);
+    ASSERT_TRUE(read.has_value());
+    ASSERT_EQ(jobs.size() - 1, read->size());
+    for (size_t i = 0; i < read->size(); ++i) {
+        ExpectSameJob(*jobs[i < 3 ? i : i + 1], *(*read)[i]);
+    }
+    HyoutaUtils::IO::DeleteFile(std::string_view(path));
+}
+
+TEST(JobSnapshot, RejectsDamagedHeader) {
+    const std::string path = TempPath("vodarchiver_job_snapshot_header.snapshot");
+    ASSERT_TRUE(WriteJobSnapshot(MakeJobs(), path));
+
+    std::string contents = ReadWholeFile(path);
+    ASSERT_GT(contents.size(), 16u);
+    contents[12] ^= 0x01;
+    WriteWholeFile(path, contents);
+
+    JobSnapshot snapshot;
+    EXPECT_FALSE(snapshot.Open(path));
+    EXPECT_FALSE(ReadJobSnapshot(path).has_value());
+    HyoutaUtils::IO::DeleteFile(std::string_view(path));
+}
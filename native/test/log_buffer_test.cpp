@@ -0,0 +1,45 @@
+#include <cstdint>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "vodarchiver/log_buffer.h"
+
+TEST(LogBuffer, AppendAndRead) {
+    using namespace VodArchiver;
+    LogBuffer buffer(4);
+    buffer.Append(LogSource::Fetch, LogSeverity::Warning, "first");
+    buffer.Append(LogSource::Job, LogSeverity::Error, std::string(300, 'x'));
+    EXPECT_EQ(0u, buffer.GetBegin());
+    EXPECT_EQ(2u, buffer.GetEnd());
+
+    LogRecord record;
+    ASSERT_EQ(LogReadResult::Ok, buffer.Read(0, record));
+    EXPECT_EQ(LogSource::Fetch, record.Source);
+    EXPECT_EQ(LogSeverity::Warning, record.Severity);
+    EXPECT_EQ("first", record.Message);
+
+    // too long messages are cut off
+    ASSERT_EQ(LogReadResult::Ok, buffer.Read(1, record));
+    EXPECT_EQ(LogSource::Job, record.Source);
+    EXPECT_EQ(std::string(LogBuffer::MaxMessageLength, 'x'), record.Message);
+
+    EXPECT_EQ(LogReadResult::NotWrittenYet, buffer.Read(2, record));
+}
+
+TEST(LogBuffer, Overwrite) {
+    using namespace VodArchiver;
+    LogBuffer buffer(4);
+    for (int i = 0; i < 6; ++i) {
+        buffer.Append(LogSource::General, LogSeverity::Info, std::to_string(i));
+    }
+    EXPECT_EQ(2u, buffer.GetBegin());
+    EXPECT_EQ(6u, buffer.GetEnd());
+
+    LogRecord record;
+    EXPECT_EQ(LogReadResult::Overwritten, buffer.Read(1, record));
+    ASSERT_EQ(LogReadResult::Ok, buffer.Read(2, record));
+    EXPECT_EQ("2", record.Message);
+    ASSERT_EQ(LogReadResult::Ok, buffer.Read(5, record));
+    EXPECT_EQ("5", record.Message);
+}
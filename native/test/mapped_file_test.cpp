@@ -0,0 +1,48 @@
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "gtest/gtest.h"
+
+#include "util/file.h"
+
+#include "vodarchiver/mapped_file.h"
+
+TEST(MappedFile, MapsWholeFile) {
+    using namespace VodArchiver;
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "vodarchiver_mapped_file_test.bin").string();
+    const std::string contents = std::string("header\0body", 11) + std::string(10000, 'x');
+    {
+        HyoutaUtils::IO::File file(std::string_view(path), HyoutaUtils::IO::OpenMode::Write);
+        ASSERT_TRUE(file.IsOpen());
+        ASSERT_EQ(contents.size(), file.Write(contents.data(), contents.size()));
+    }
+
+    MappedFile mapped;
+    ASSERT_TRUE(mapped.Open(path));
+    EXPECT_TRUE(mapped.IsOpen());
+    ASSERT_EQ(contents.size(), mapped.GetSize());
+    EXPECT_EQ(contents, std::string_view(mapped.GetData(), mapped.GetSize()));
+
+    mapped.Close();
+    EXPECT_FALSE(mapped.IsOpen());
+    EXPECT_EQ(0u, mapped.GetSize());
+    HyoutaUtils::IO::DeleteFile(std::string_view(path));
+}
+
+TEST(MappedFile, FailsForMissingAndEmptyFiles) {
+    using namespace VodArchiver;
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "vodarchiver_mapped_file_empty.bin").string();
+    {
+        HyoutaUtils::IO::File file(std::string_view(path), HyoutaUtils::IO::OpenMode::Write);
+        ASSERT_TRUE(file.IsOpen());
+    }
+
+    MappedFile mapped;
+    EXPECT_FALSE(mapped.Open(path));
+    EXPECT_FALSE(mapped.IsOpen());
+    HyoutaUtils::IO::DeleteFile(std::string_view(path));
+    EXPECT_FALSE(mapped.Open(path));
+}
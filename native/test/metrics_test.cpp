@@ -0,0 +1,51 @@
+#include <array>
+#include <chrono>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "vodarchiver/metrics.h"
+
+TEST(Metrics, HistogramBuckets) {
+    using namespace VodArchiver;
+    static constexpr std::array<double, 3> bounds{1.0, 5.0, 10.0};
+    MetricsHistogram histogram(bounds);
+    histogram.Observe(0.5);
+    histogram.Observe(1.0);
+    histogram.Observe(7.0);
+    histogram.Observe(100.0);
+    histogram.Observe(std::chrono::milliseconds(2500));
+
+    EXPECT_EQ(2u, histogram.Counts[0].load());
+    EXPECT_EQ(1u, histogram.Counts[1].load());
+    EXPECT_EQ(1u, histogram.Counts[2].load());
+    EXPECT_EQ(1u, histogram.Counts[3].load());
+    EXPECT_DOUBLE_EQ(111.0, histogram.Sum.load());
+
+    std::string out;
+    AppendPrometheusHeader(out, "test_seconds", "histogram", "Test.");
+    AppendPrometheusHistogram(out, "test_seconds", "store=\"jobs\"", histogram);
+    EXPECT_EQ("# HELP test_seconds Test.\n"
+              "# TYPE test_seconds histogram\n"
+              "test_seconds_bucket{store=\"jobs\",le=\"1\"} 2\n"
+              "test_seconds_bucket{store=\"jobs\",le=\"5\"} 3\n"
+              "test_seconds_bucket{store=\"jobs\",le=\"10\"} 4\n"
+              "test_seconds_bucket{store=\"jobs\",le=\"+Inf\"} 5\n"
+              "test_seconds_sum{store=\"jobs\"} 111\n"
+              "test_seconds_count{store=\"jobs\"} 5\n",
+              out);
+}
+
+TEST(Metrics, Samples) {
+    using namespace VodArchiver;
+    std::string out;
+    AppendPrometheusSample(out, "test_total", "", 42.0);
+    AppendPrometheusSample(out, "test_total", PrometheusLabel("service", "Twitch"), 1.5);
+    EXPECT_EQ("test_total 42\ntest_total{service=\"Twitch\"} 1.5\n", out);
+}
+
+TEST(Metrics, LabelEscaping) {
+    using namespace VodArchiver;
+    EXPECT_EQ("device=\"C:\\\\\"", VodArchiver::PrometheusLabel("device", "C:\\"));
+    EXPECT_EQ("a=\"say \\\"hi\\\"\\n\"", VodArchiver::PrometheusLabel("a", "say \"hi\"\n"));
+}
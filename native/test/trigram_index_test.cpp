@@ -0,0 +1,45 @@
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "vodarchiver/trigram_index.h"
+
+TEST(TrigramIndex, Search) {
+    using namespace VodArchiver;
+    TrigramIndex index;
+    std::array<std::string_view, 2> doc0{"SomeStreamer", "Speedrun of Game"};
+    std::array<std::string_view, 2> doc1{"other", "Casual GAMEplay"};
+    std::array<std::string_view, 2> doc2{"abc", "def"};
+    index.Set(0, doc0);
+    index.Set(1, doc1);
+    index.Set(2, doc2);
+
+    EXPECT_EQ((std::vector<uint32_t>{0, 1}), index.Search("game"));
+    EXPECT_EQ((std::vector<uint32_t>{0}), index.Search("STREAMER"));
+    EXPECT_EQ((std::vector<uint32_t>{0, 1}), index.Search("am"));
+    EXPECT_EQ((std::vector<uint32_t>{}), index.Search("nothing"));
+
+    // all trigrams are there, but not in this order
+    EXPECT_EQ((std::vector<uint32_t>{}), index.Search("gamegame"));
+
+    // matches must not span two fields
+    EXPECT_EQ((std::vector<uint32_t>{}), index.Search("abcdef"));
+}
+
+TEST(TrigramIndex, Replace) {
+    using namespace VodArchiver;
+    TrigramIndex index;
+    std::array<std::string_view, 1> before{"first title"};
+    std::array<std::string_view, 1> after{"second title"};
+    index.Set(5, before);
+    EXPECT_EQ(6u, index.GetDocumentCount());
+    EXPECT_EQ((std::vector<uint32_t>{5}), index.Search("first"));
+
+    index.Set(5, after);
+    EXPECT_EQ((std::vector<uint32_t>{}), index.Search("first"));
+    EXPECT_EQ((std::vector<uint32_t>{5}), index.Search("second"));
+    EXPECT_EQ((std::vector<uint32_t>{5}), index.Search("title"));
+}
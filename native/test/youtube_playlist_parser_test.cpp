@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "rapidjson/document.h"
+
+#include "vodarchiver/youtube_playlist_parser.h"
+
+namespace {
+struct ParseResult {
+    bool Success = false;
+    std::vector<std::string> Ids;
+};
+
+// Feeds the document from a separate thread in small chunks of varying odd sizes, the way the
+// output of yt-dlp trickles in, so tokens get split across chunk boundaries.
+ParseResult ParseInChunks(std::string_view json) {
+    using namespace VodArchiver::Youtube;
+    ProcessOutputStream stream;
+    std::thread writer([&]() {
+        static constexpr size_t ChunkSizes[] = {1, 3, 7, 5, 11, 13};
+        size_t position = 0;
+        size_t chunk = 0;
+        while (position < json.size()) {
+            const size_t size = std::min(ChunkSizes[chunk % std::size(ChunkSizes)],
+                                         json.size() - position);
+            stream.Append(json.substr(position, size));
+            position += size;
+            ++chunk;
+        }
+        stream.Close();
+    });
+
+    ParseResult result;
+    result.Success = ParsePlaylistStream(stream, [&](const rapidjson::Document& entry) {
+        auto it = entry.FindMember("id");
+        if (it != entry.MemberEnd() && it->value.IsString()) {
+            result.Ids.emplace_back(it->value.GetString(), it->value.GetStringLength());
+        } else {
+            result.Ids.emplace_back();
+        }
+    });
+    stream.Abandon();
+    writer.join();
+    return result;
+}
+} // namespace
+
+TEST(YoutubePlaylistParser, ReadsEntriesInChunks) {
+    const auto result = ParseInChunks(R"({
+        "id": "UCxyz",
+        "title": "channel with \"entries\" in the title",
+        "tags": ["entries", {"entries": [{"id": "not an entry"}]}],
+        "entries": [
+            {"id": "first", "formats": [{"format_id": "18", "fragments": [[1, 2], []]}],
+             "nested": {"entries": [{"id": "also not an entry"}], "empty": {}}},
+            {"id": "second", "duration": 12.5, "is_live": false, "channel": null},
+            {"id": "third", "thumbnails": [[], [[{"url": "x"}]]], "description": "{[\"]}"}
+        ],
+        "epoch": 1700000000
+    })");
+    EXPECT_TRUE(result.Success);
+    ASSERT_EQ(3u, result.Ids.size());
+    EXPECT_EQ("first", result.Ids[0]);
+    EXPECT_EQ("second", result.Ids[1]);
+    EXPECT_EQ("third", result.Ids[2]);
+}
+
+TEST(YoutubePlaylistParser, EmptyEntries) {
+    const auto result = ParseInChunks(R"({"id": "UCxyz", "entries": []})");
+    EXPECT_TRUE(result.Success);
+    EXPECT_TRUE(result.Ids.empty());
+}
+
+TEST(YoutubePlaylistParser, MissingEntries) {
+    const auto result = ParseInChunks(R"({"id": "UCxyz", "nested": {"entries": [{"id": "a"}]}})");
+    EXPECT_FALSE(result.Success);
+    EXPECT_TRUE(result.Ids.empty());
+}
+
+TEST(YoutubePlaylistParser, TruncatedDocument) {
+    // cut off in the middle of the second entry
+    const auto result =
+        ParseInChunks(R"({"entries": [{"id": "first"}, {"id": "second", "formats": [{"a)");
+    EXPECT_FALSE(result.Success);
+    ASSERT_EQ(1u, result.Ids.size());
+    EXPECT_EQ("first", result.Ids[0]);
+
+    // cut off after the last entry
+    EXPECT_FALSE(ParseInChunks(R"({"entries": [{"id": "first"}])").Success);
+    EXPECT_FALSE(ParseInChunks("").Success);
+}
+
+TEST(YoutubePlaylistParser, NotAnObject) {
+    EXPECT_FALSE(ParseInChunks(R"([{"entries": []}])").Success);
+    EXPECT_FALSE(ParseInChunks(R"({"entries": [{"id": "first"}]} trailing)").Success);
+}
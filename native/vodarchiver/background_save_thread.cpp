@@ -0,0 +1,130 @@
+#include "background_save_thread.h"
+
+#include <chrono>
+#include <functional>
+
+#include "job_config.h"
+#include "job_handling.h"
+#include "metrics.h"
+#include "userinfo/i-user-info.h"
+#include "userinfo/serialization.h"
+#include "videojobs/serialization.h"
+
+namespace VodArchiver {
+BackgroundSaveThread::BackgroundSaveThread(JobConfig& jobConfig,
+                                           JobList& jobs,
+                                           std::recursive_mutex& userInfosLock,
+                                           std::vector<std::unique_ptr<IUserInfo>>& userInfos)
+  : JobConf(jobConfig)
+  , Jobs(jobs)
+  , UserInfosLock(userInfosLock)
+  , UserInfos(userInfos)
+  , Thread(std::bind(&BackgroundSaveThread::ThreadFunc, this)) {}
+
+BackgroundSaveThread::~BackgroundSaveThread() {
+    {
+        std::lock_guard lock(Mutex);
+        Finishing = true;
+    }
+    CondVar.notify_all();
+    Thread.join();
+}
+
+void BackgroundSaveThread::RequestSaveJobs() {
+    {
+        std::lock_guard lock(Mutex);
+        SaveJobsRequested = true;
+    }
+    CondVar.notify_all();
+}
+
+void BackgroundSaveThread::RequestSaveUsers() {
+    {
+        std::lock_guard lock(Mutex);
+        SaveUsersRequested = true;
+    }
+    CondVar.notify_all();
+}
+
+void BackgroundSaveThread::ThreadFunc() {
+    while (true) {
+        bool saveJobsRequested = false;
+        bool saveUsersRequested = false;
+        bool finishing = false;
+        {
+            std::unique_lock lock(Mutex);
+            CondVar.wait(lock,
+                         [&] { return SaveJobsRequested || SaveUsersRequested || Finishing; });
+            saveJobsRequested = SaveJobsRequested;
+            saveUsersRequested = SaveUsersRequested;
+            finishing = Finishing;
+        }
+
+        if (finishing) {
+            return;
+        }
+
+        if (saveJobsRequested) {
+            std::string xmlPath;
+            std::string snapshotPath;
+            JobStoreFormat format;
+            std::vector<std::unique_ptr<IVideoJob>> jobs;
+            DormantJobList dormant;
+            {
+                std::lock_guard lock(JobConf.Mutex);
+                xmlPath = JobConf.VodXmlPath;
+                snapshotPath = JobConf.VodSnapshotPath;
+                format =
+                    JobConf.SaveJobsAsSnapshot ? JobStoreFormat::Snapshot : JobStoreFormat::Xml;
+            }
+            {
+                std::lock_guard lock(Mutex);
+                SaveJobsRequested = false;
+            }
+            {
+                // the XML writing is kinda slow so we clone the vector first to not hold the lock
+                // for too long
+                std::lock_guard lock(Jobs.JobsLock);
+                jobs.reserve(Jobs.JobsVector.size());
+                for (auto& job : Jobs.JobsVector) {
+                    std::lock_guard jobLock(job->DataLock);
+                    jobs.push_back(job->Clone());
+                }
+
+                // the snapshot itself is shared and never modified, so only the indices are copied
+                dormant = Jobs.Dormant;
+            }
+            const auto saveStart = std::chrono::steady_clock::now();
+            WriteJobStore(jobs, xmlPath, snapshotPath, format, &dormant);
+            GetArchiverMetrics().JobsSaveSeconds.Observe(std::chrono::steady_clock::now()
+                                                         - saveStart);
+        }
+
+        if (saveUsersRequested) {
+            std::string path;
+            std::vector<std::unique_ptr<IUserInfo>> userInfos;
+            {
+                std::lock_guard lock(JobConf.Mutex);
+                path = JobConf.UserInfoXmlPath;
+            }
+            {
+                std::lock_guard lock(Mutex);
+                SaveUsersRequested = false;
+            }
+            {
+                // the XML writing is kinda slow so we clone the vector first to not hold the lock
+                // for too long
+                std::lock_guard lock(UserInfosLock);
+                userInfos.reserve(UserInfos.size());
+                for (auto& ui : UserInfos) {
+                    userInfos.push_back(ui->Clone());
+                }
+            }
+            const auto saveStart = std::chrono::steady_clock::now();
+            WriteUserInfosToFile(userInfos, path);
+            GetArchiverMetrics().UsersSaveSeconds.Observe(std::chrono::steady_clock::now()
+                                                          - saveStart);
+        }
+    }
+}
+} // namespace VodArchiver
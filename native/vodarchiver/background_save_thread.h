@@ -0,0 +1,38 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VodArchiver {
+struct IUserInfo;
+struct JobConfig;
+struct JobList;
+
+struct BackgroundSaveThread {
+    BackgroundSaveThread(JobConfig& jobConfig,
+                         JobList& jobs,
+                         std::recursive_mutex& userInfosLock,
+                         std::vector<std::unique_ptr<IUserInfo>>& userInfos);
+    ~BackgroundSaveThread();
+
+    void RequestSaveJobs();
+    void RequestSaveUsers();
+
+private:
+    void ThreadFunc();
+
+    JobConfig& JobConf;
+    JobList& Jobs;
+    std::recursive_mutex& UserInfosLock;
+    std::vector<std::unique_ptr<IUserInfo>>& UserInfos;
+    std::mutex Mutex;
+    std::condition_variable CondVar;
+    bool SaveJobsRequested = false;
+    bool SaveUsersRequested = false;
+    bool Finishing = false;
+    std::thread Thread;
+};
+} // namespace VodArchiver
@@ -0,0 +1,695 @@
+#include "control_server.h"
+
+#ifdef BUILD_FOR_WINDOWS
+// must come before anything that includes Windows.h
+#define WIN32_LEAN_AND_MEAN
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "rapidjson/document.h"
+
+#include "util/number.h"
+#include "util/text.h"
+#include "util/thread.h"
+
+#include "disk_lock.h"
+#include "job_config.h"
+#include "job_handling.h"
+#include "job_progress.h"
+#include "metrics.h"
+#include "tasks/video-task-group.h"
+#include "videoinfo/i-video-info.h"
+#include "videojobs/i-video-job.h"
+
+namespace VodArchiver {
+namespace {
+#ifdef BUILD_FOR_WINDOWS
+using SocketT = SOCKET;
+static constexpr SocketT InvalidSocket = INVALID_SOCKET;
+#else
+using SocketT = int;
+static constexpr SocketT InvalidSocket = -1;
+#endif
+
+struct HttpRequest {
+    std::string Method;
+    std::string Path;
+    std::optional<std::string> Host;
+    std::optional<std::string> Origin;
+    std::optional<std::string> ContentType;
+    std::string Body;
+};
+
+struct HttpResponse {
+    int Status = 200;
+    std::string_view Reason = "OK";
+    std::string_view ContentType = "application/json";
+    std::string Body;
+};
+} // namespace
+
+// we only expect small JSON bodies, anything bigger is not meant for us
+static constexpr size_t MaxRequestSize = 64 * 1024;
+
+static SocketT ToSocket(uintptr_t handle) {
+    return static_cast<SocketT>(handle);
+}
+
+static uintptr_t ToHandle(SocketT socket) {
+    return static_cast<uintptr_t>(socket);
+}
+
+static void CloseSocket(SocketT socket) {
+#ifdef BUILD_FOR_WINDOWS
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+// Waits up to timeoutMs for the socket to become readable.
+static bool WaitForReadable(SocketT socket, int timeoutMs) {
+#ifdef BUILD_FOR_WINDOWS
+    WSAPOLLFD pollfd{};
+    pollfd.fd = socket;
+    pollfd.events = POLLRDNORM;
+    return WSAPoll(&pollfd, 1, timeoutMs) > 0;
+#else
+    struct pollfd pollfd{};
+    pollfd.fd = socket;
+    pollfd.events = POLLIN;
+    return poll(&pollfd, 1, timeoutMs) > 0;
+#endif
+}
+
+static void SetReceiveTimeout(SocketT socket, int timeoutMs) {
+#ifdef BUILD_FOR_WINDOWS
+    DWORD timeout = static_cast<DWORD>(timeoutMs);
+    setsockopt(socket,
+               SOL_SOCKET,
+               SO_RCVTIMEO,
+               reinterpret_cast<const char*>(&timeout),
+               static_cast<int>(sizeof(timeout)));
+#else
+    struct timeval timeout{};
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+}
+
+static bool ReceiveMore(SocketT socket, std::string& data) {
+    std::array<char, 4096> buffer;
+    const auto received = recv(socket, buffer.data(), static_cast<int>(buffer.size()), 0);
+    if (received <= 0) {
+        return false;
+    }
+    data.append(buffer.data(), static_cast<size_t>(received));
+    return true;
+}
+
+static bool SendAll(SocketT socket, std::string_view data) {
+#ifdef BUILD_FOR_WINDOWS
+    static constexpr int flags = 0;
+#else
+    // a client that hangs up before reading the response must not kill us with SIGPIPE
+    static constexpr int flags = MSG_NOSIGNAL;
+#endif
+    while (!data.empty()) {
+        const auto sent = send(socket, data.data(), static_cast<int>(data.size()), flags);
+        if (sent <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(sent));
+    }
+    return true;
+}
+
+static std::optional<HttpRequest> ReceiveRequest(SocketT socket) {
+    std::string data;
+    size_t headerEnd;
+    while ((headerEnd = data.find("\r\n\r\n")) == std::string::npos) {
+        if (data.size() > MaxRequestSize || !ReceiveMore(socket, data)) {
+            return std::nullopt;
+        }
+    }
+
+    HttpRequest request;
+    std::string_view header = std::string_view(data).substr(0, headerEnd);
+    const size_t requestLineEnd = header.find("\r\n");
+    const std::string_view requestLine = header.substr(0, requestLineEnd);
+    const size_t methodEnd = requestLine.find(' ');
+    if (methodEnd == std::string_view::npos) {
+        return std::nullopt;
+    }
+    const size_t pathEnd = requestLine.find(' ', methodEnd + 1);
+    if (pathEnd == std::string_view::npos) {
+        return std::nullopt;
+    }
+    request.Method = std::string(requestLine.substr(0, methodEnd));
+    std::string_view path = requestLine.substr(methodEnd + 1, pathEnd - (methodEnd + 1));
+    path = path.substr(0, path.find('?'));
+    request.Path = std::string(path);
+
+    uint64_t contentLength = 0;
+    if (requestLineEnd != std::string_view::npos) {
+        std::string_view headerLines = header.substr(requestLineEnd + 2);
+        while (!headerLines.empty()) {
+            const size_t lineEnd = headerLines.find("\r\n");
+            const std::string_view line = headerLines.substr(0, lineEnd);
+            headerLines = lineEnd == std::string_view::npos ? std::string_view()
+                                                            : headerLines.substr(lineEnd + 2);
+            const size_t colon = line.find(':');
+            if (colon == std::string_view::npos) {
+                continue;
+            }
+            const std::string_view name = line.substr(0, colon);
+            const std::string_view value = HyoutaUtils::TextUtils::Trim(line.substr(colon + 1));
+            if (HyoutaUtils::TextUtils::CaseInsensitiveEquals(name, "Content-Length")) {
+                auto length = HyoutaUtils::NumberUtils::ParseUInt64(value);
+                if (!length || *length > MaxRequestSize) {
+                    return std::nullopt;
+                }
+                contentLength = *length;
+            } else if (HyoutaUtils::TextUtils::CaseInsensitiveEquals(name, "Host")) {
+                request.Host = std::string(value);
+            } else if (HyoutaUtils::TextUtils::CaseInsensitiveEquals(name, "Origin")) {
+                request.Origin = std::string(value);
+            } else if (HyoutaUtils::TextUtils::CaseInsensitiveEquals(name, "Content-Type")) {
+                request.ContentType = std::string(value);
+            }
+        }
+    }
+
+    const size_t bodyStart = headerEnd + 4;
+    while (data.size() - bodyStart < contentLength) {
+        if (!ReceiveMore(socket, data)) {
+            return std::nullopt;
+        }
+    }
+    request.Body = data.substr(bodyStart, static_cast<size_t>(contentLength));
+    return request;
+}
+
+static void SendResponse(SocketT socket, const HttpResponse& response) {
+    std::string data = std::format(
+        "HTTP/1.1 {} {}\r\nContent-Type: {}\r\nContent-Length: {}\r\nConnection: close\r\n\r\n",
+        response.Status,
+        response.Reason,
+        response.ContentType,
+        response.Body.size());
+    data.append(response.Body);
+    SendAll(socket, data);
+}
+
+// Only accept the names a local client would use to reach us, so that a website the user visits
+// can't talk to us through DNS rebinding.
+static bool IsAllowedHost(const std::optional<std::string>& host, uint16_t port) {
+    if (!host) {
+        return false;
+    }
+    using HyoutaUtils::TextUtils::CaseInsensitiveEquals;
+    return CaseInsensitiveEquals(*host, std::format("127.0.0.1:{}", port))
+           || CaseInsensitiveEquals(*host, std::format("localhost:{}", port));
+}
+
+static bool IsJsonContentType(const std::optional<std::string>& contentType) {
+    if (!contentType) {
+        return false;
+    }
+    const std::string_view mediaType = std::string_view(*contentType).substr(
+        0, std::string_view(*contentType).find(';'));
+    return HyoutaUtils::TextUtils::CaseInsensitiveEquals(
+        HyoutaUtils::TextUtils::Trim(mediaType), "application/json");
+}
+
+static HttpResponse MakeJsonError(int status, std::string_view reason, std::string_view message) {
+    // all messages are our own string literals, so they don't need escaping
+    return HttpResponse{.Status = status,
+                        .Reason = reason,
+                        .Body = std::format("{{\"ok\":false,\"error\":\"{}\"}}", message)};
+}
+
+static VideoTaskGroup*
+    FindVideoTaskGroup(std::vector<std::unique_ptr<VideoTaskGroup>>& videoTaskGroups,
+                       StreamService service) {
+    for (auto& g : videoTaskGroups) {
+        if (g && g->GetService() == service) {
+            return g.get();
+        }
+    }
+    return nullptr;
+}
+
+// must hold the JobsLock when calling this!
+static IVideoJob* FindJobNoLock(JobList& jobs, StreamService service, std::string_view id) {
+    if (!jobs.KnownVideos.contains(MakeKnownVideoKey(service, id))) {
+        return nullptr;
+    }
+    std::array<char, 256> buffer;
+    for (auto& job : jobs.JobsVector) {
+        std::lock_guard jobLock(job->DataLock);
+        if (job->VideoInfo && job->VideoInfo->GetService() == service
+            && job->VideoInfo->GetVideoId(buffer) == id) {
+            return job.get();
+        }
+    }
+    return WakeDormantJobNoLock(jobs, service, id);
+}
+
+static std::optional<std::string_view> GetJsonString(const rapidjson::Document& json,
+                                                     const char* key) {
+    auto it = json.FindMember(key);
+    if (it == json.MemberEnd() || !it->value.IsString()) {
+        return std::nullopt;
+    }
+    return std::string_view(it->value.GetString(), it->value.GetStringLength());
+}
+
+static bool GetJsonBool(const rapidjson::Document& json, const char* key, bool defaultValue) {
+    auto it = json.FindMember(key);
+    if (it == json.MemberEnd() || !it->value.IsBool()) {
+        return defaultValue;
+    }
+    return it->value.GetBool();
+}
+
+static HttpResponse HandleJobRequest(JobList& jobs,
+                                     std::vector<std::unique_ptr<VideoTaskGroup>>& videoTaskGroups,
+                                     const HttpRequest& request,
+                                     bool enqueue) {
+    rapidjson::Document json;
+    json.Parse(request.Body.data(), request.Body.size());
+    if (json.HasParseError() || !json.IsObject()) {
+        return MakeJsonError(400, "Bad Request", "body must be a JSON object");
+    }
+    auto serviceString = GetJsonString(json, "service");
+    auto id = GetJsonString(json, "id");
+    if (!serviceString || !id) {
+        return MakeJsonError(400, "Bad Request", "'service' and 'id' are required");
+    }
+    auto service = StreamServiceFromString(*serviceString);
+    if (!service) {
+        return MakeJsonError(400, "Bad Request", "unknown service");
+    }
+    VideoTaskGroup* group = FindVideoTaskGroup(videoTaskGroups, *service);
+    if (group == nullptr) {
+        return MakeJsonError(400, "Bad Request", "service has no task group");
+    }
+
+    // keeps the job list stable while we look for the job, the task group locks the job itself
+    std::lock_guard lock(jobs.JobsLock);
+    IVideoJob* job = FindJobNoLock(jobs, *service, *id);
+    if (job == nullptr) {
+        return MakeJsonError(404, "Not Found", "no such job");
+    }
+
+    if (enqueue) {
+        group->Enqueue(job, GetJsonBool(json, "startImmediately", false));
+        return HttpResponse{.Body = "{\"ok\":true}"};
+    }
+
+    const bool dequeued = group->Dequeue(job);
+    const bool cancelled = group->CancelJob(job);
+    return HttpResponse{.Body = std::format("{{\"ok\":true,\"dequeued\":{},\"cancelled\":{}}}",
+                                            dequeued,
+                                            cancelled)};
+}
+
+std::string FormatPrometheusMetrics(JobConfig& jobConfig,
+                                    JobList& jobs,
+                                    std::vector<std::unique_ptr<VideoTaskGroup>>& videoTaskGroups) {
+    std::string out;
+
+    {
+        std::array<size_t, static_cast<size_t>(VideoJobStatus::COUNT)> jobsByStatus{};
+        {
+            std::lock_guard lock(jobs.JobsLock);
+            for (auto& job : jobs.JobsVector) {
+                const VideoJobStatus status = job->JobStatus.load();
+                if (status < VideoJobStatus::COUNT) {
+                    ++jobsByStatus[static_cast<size_t>(status)];
+                }
+            }
+            if (jobs.Dormant.Snapshot) {
+                for (size_t index : jobs.Dormant.Indices) {
+                    auto status = jobs.Dormant.Snapshot->GetJobStatus(index);
+                    if (status && *status < VideoJobStatus::COUNT) {
+                        ++jobsByStatus[static_cast<size_t>(*status)];
+                    }
+                }
+            }
+        }
+        AppendPrometheusHeader(out, "vodarchiver_jobs", "gauge", "Known jobs by status.");
+        for (size_t i = 0; i < jobsByStatus.size(); ++i) {
+            AppendPrometheusSample(
+                out,
+                "vodarchiver_jobs",
+                PrometheusLabel("status", VideoJobStatusToString(static_cast<VideoJobStatus>(i))),
+                static_cast<double>(jobsByStatus[i]));
+        }
+    }
+
+    {
+        std::vector<std::pair<std::string, VideoTaskGroupStatistics>> groups;
+        JobProgressThroughput throughput;
+        for (auto& g : videoTaskGroups) {
+            if (g) {
+                groups.emplace_back(
+                    PrometheusLabel("service", StreamServiceToString(g->GetService())),
+                    g->GetStatistics());
+                g->AccumulateThroughput(throughput);
+            }
+        }
+
+        AppendPrometheusHeader(
+            out, "vodarchiver_queue_waiting", "gauge", "Jobs waiting in the queue.");
+        for (const auto& [service, statistics] : groups) {
+            AppendPrometheusSample(
+                out, "vodarchiver_queue_waiting", service, static_cast<double>(statistics.Waiting));
+        }
+        AppendPrometheusHeader(
+            out, "vodarchiver_queue_running", "gauge", "Running jobs by resource pool.");
+        for (const auto& [service, statistics] : groups) {
+            AppendPrometheusSample(out,
+                                   "vodarchiver_queue_running",
+                                   std::format("{},pool=\"network\"", service),
+                                   static_cast<double>(statistics.RunningNetwork));
+            AppendPrometheusSample(out,
+                                   "vodarchiver_queue_running",
+                                   std::format("{},pool=\"disk\"", service),
+                                   static_cast<double>(statistics.RunningDisk));
+        }
+        AppendPrometheusHeader(
+            out, "vodarchiver_jobs_finished_total", "counter", "Job runs by result.");
+        for (const auto& [service, statistics] : groups) {
+            for (size_t i = 0; i < statistics.FinishedByResult.size(); ++i) {
+                AppendPrometheusSample(
+                    out,
+                    "vodarchiver_jobs_finished_total",
+                    std::format("{},{}",
+                                service,
+                                PrometheusLabel("result",
+                                                ResultTypeToString(static_cast<ResultType>(i)))),
+                    static_cast<double>(statistics.FinishedByResult[i]));
+            }
+        }
+        AppendPrometheusHeader(out,
+                               "vodarchiver_jobs_retried_total",
+                               "counter",
+                               "Jobs automatically re-enqueued, by the result that caused it.");
+        for (const auto& [service, statistics] : groups) {
+            for (size_t i = 0; i < statistics.RetriedByResult.size(); ++i) {
+                AppendPrometheusSample(
+                    out,
+                    "vodarchiver_jobs_retried_total",
+                    std::format("{},{}",
+                                service,
+                                PrometheusLabel("result",
+                                                ResultTypeToString(static_cast<ResultType>(i)))),
+                    static_cast<double>(statistics.RetriedByResult[i]));
+            }
+        }
+
+        AppendPrometheusHeader(
+            out, "vodarchiver_encode_jobs", "gauge", "Jobs currently reporting encode progress.");
+        AppendPrometheusSample(
+            out, "vodarchiver_encode_jobs", "", static_cast<double>(throughput.EncodeJobs));
+        AppendPrometheusHeader(
+            out, "vodarchiver_encode_fps", "gauge", "Frames encoded per second, summed.");
+        AppendPrometheusSample(out, "vodarchiver_encode_fps", "", throughput.EncodeFps);
+        AppendPrometheusHeader(out,
+                               "vodarchiver_encode_speed",
+                               "gauge",
+                               "Seconds of video encoded per second, summed.");
+        AppendPrometheusSample(out, "vodarchiver_encode_speed", "", throughput.EncodeSpeed);
+        AppendPrometheusHeader(out,
+                               "vodarchiver_download_jobs",
+                               "gauge",
+                               "Jobs currently reporting download progress.");
+        AppendPrometheusSample(
+            out, "vodarchiver_download_jobs", "", static_cast<double>(throughput.DownloadJobs));
+        AppendPrometheusHeader(out,
+                               "vodarchiver_download_bytes_per_second",
+                               "gauge",
+                               "Download rate reported by yt-dlp, summed.");
+        AppendPrometheusSample(
+            out, "vodarchiver_download_bytes_per_second", "", throughput.DownloadBytesPerSecond);
+    }
+
+    {
+        ArchiverMetrics& metrics = GetArchiverMetrics();
+        AppendPrometheusHeader(
+            out, "vodarchiver_http_requests_total", "counter", "HTTP requests made by us.");
+        AppendPrometheusSample(out,
+                               "vodarchiver_http_requests_total",
+                               "",
+                               static_cast<double>(metrics.HttpRequests.load()));
+        AppendPrometheusHeader(out,
+                               "vodarchiver_http_requests_failed_total",
+                               "counter",
+                               "HTTP requests that got no response at all.");
+        AppendPrometheusSample(out,
+                               "vodarchiver_http_requests_failed_total",
+                               "",
+                               static_cast<double>(metrics.HttpRequestsFailed.load()));
+        AppendPrometheusHeader(out,
+                               "vodarchiver_http_received_bytes_total",
+                               "counter",
+                               "Response body bytes received over HTTP.");
+        AppendPrometheusSample(out,
+                               "vodarchiver_http_received_bytes_total",
+                               "",
+                               static_cast<double>(metrics.HttpBytesReceived.load()));
+        AppendPrometheusHeader(out,
+                               "vodarchiver_twitch_segments_downloaded_total",
+                               "counter",
+                               "Twitch video segments downloaded.");
+        AppendPrometheusSample(out,
+                               "vodarchiver_twitch_segments_downloaded_total",
+                               "",
+                               static_cast<double>(metrics.TwitchSegmentsDownloaded.load()));
+
+        AppendPrometheusHeader(out,
+                               "vodarchiver_disk_slot_wait_seconds",
+                               "histogram",
+                               "Time spent waiting for a disk IO slot.");
+        AppendPrometheusHistogram(
+            out, "vodarchiver_disk_slot_wait_seconds", "", metrics.DiskSlotWaitSeconds);
+        AppendPrometheusHeader(out,
+                               "vodarchiver_disk_space_wait_seconds",
+                               "histogram",
+                               "Time spent waiting for enough free disk space.");
+        AppendPrometheusHistogram(
+            out, "vodarchiver_disk_space_wait_seconds", "", metrics.DiskSpaceWaitSeconds);
+        AppendPrometheusHeader(out,
+                               "vodarchiver_save_duration_seconds",
+                               "histogram",
+                               "Time spent writing the job and user stores.");
+        AppendPrometheusHistogram(out,
+                                  "vodarchiver_save_duration_seconds",
+                                  "store=\"jobs\"",
+                                  metrics.JobsSaveSeconds);
+        AppendPrometheusHistogram(out,
+                                  "vodarchiver_save_duration_seconds",
+                                  "store=\"users\"",
+                                  metrics.UsersSaveSeconds);
+    }
+
+    {
+        const std::vector<DiskDeviceStatistics> devices =
+            jobConfig.ExpensiveDiskIO.GetStatistics();
+        AppendPrometheusHeader(
+            out, "vodarchiver_disk_slots", "gauge", "Disk IO slots per storage device.");
+        for (const auto& d : devices) {
+            AppendPrometheusSample(out,
+                                   "vodarchiver_disk_slots",
+                                   PrometheusLabel("device", d.DeviceId),
+                                   static_cast<double>(d.Slots));
+        }
+        AppendPrometheusHeader(
+            out, "vodarchiver_disk_slots_in_use", "gauge", "Disk IO slots currently taken.");
+        for (const auto& d : devices) {
+            AppendPrometheusSample(out,
+                                   "vodarchiver_disk_slots_in_use",
+                                   PrometheusLabel("device", d.DeviceId),
+                                   static_cast<double>(d.SlotsInUse));
+        }
+        AppendPrometheusHeader(out,
+                               "vodarchiver_disk_slot_waiting",
+                               "gauge",
+                               "Jobs currently waiting for a disk IO slot.");
+        for (const auto& d : devices) {
+            AppendPrometheusSample(out,
+                                   "vodarchiver_disk_slot_waiting",
+                                   PrometheusLabel("device", d.DeviceId),
+                                   static_cast<double>(d.Waiting));
+        }
+    }
+
+    return out;
+}
+
+ControlServer::ControlServer(JobConfig& jobConfig,
+                             JobList& jobs,
+                             std::vector<std::unique_ptr<VideoTaskGroup>>& videoTaskGroups)
+  : JobConf(jobConfig)
+  , Jobs(jobs)
+  , VideoTaskGroups(videoTaskGroups)
+  , ListenSocket(ToHandle(InvalidSocket)) {}
+
+ControlServer::~ControlServer() {
+    Stop();
+}
+
+bool ControlServer::Start(uint16_t port) {
+    Stop();
+
+#ifdef BUILD_FOR_WINDOWS
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        return false;
+    }
+#endif
+
+    SocketT listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenSocket == InvalidSocket) {
+#ifdef BUILD_FOR_WINDOWS
+        WSACleanup();
+#endif
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listenSocket,
+               SOL_SOCKET,
+               SO_REUSEADDR,
+               reinterpret_cast<const char*>(&reuse),
+               static_cast<int>(sizeof(reuse)));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listenSocket, 8) != 0) {
+        CloseSocket(listenSocket);
+#ifdef BUILD_FOR_WINDOWS
+        WSACleanup();
+#endif
+        return false;
+    }
+
+    ListenSocket = ToHandle(listenSocket);
+    Port = port;
+    Stopping.store(false);
+    Thread = std::thread(std::bind(&ControlServer::ThreadFunc, this));
+    return true;
+}
+
+void ControlServer::Stop() {
+    if (!Thread.joinable()) {
+        return;
+    }
+    Stopping.store(true);
+    Thread.join();
+    CloseSocket(ToSocket(ListenSocket));
+    ListenSocket = ToHandle(InvalidSocket);
+#ifdef BUILD_FOR_WINDOWS
+    WSACleanup();
+#endif
+}
+
+void ControlServer::ThreadFunc() {
+    HyoutaUtils::SetThreadName("ControlServer");
+    const SocketT listenSocket = ToSocket(ListenSocket);
+    while (!Stopping.load()) {
+        // wake up every now and then to check whether we should stop
+        if (!WaitForReadable(listenSocket, 500)) {
+            continue;
+        }
+        SocketT connection = accept(listenSocket, nullptr, nullptr);
+        if (connection == InvalidSocket) {
+            continue;
+        }
+        try {
+            HandleConnection(ToHandle(connection));
+        } catch (...) {
+        }
+        CloseSocket(connection);
+    }
+}
+
+void ControlServer::HandleConnection(uintptr_t connectionHandle) {
+    const SocketT connection = ToSocket(connectionHandle);
+
+    // don't let a client that never finishes its request block everyone else
+    SetReceiveTimeout(connection, 5000);
+    auto request = ReceiveRequest(connection);
+    if (!request) {
+        SendResponse(connection, MakeJsonError(400, "Bad Request", "malformed request"));
+        return;
+    }
+
+    if (!IsAllowedHost(request->Host, Port)) {
+        SendResponse(connection, MakeJsonError(403, "Forbidden", "unexpected host"));
+        return;
+    }
+
+    if (request->Path == "/metrics") {
+        if (request->Method != "GET") {
+            SendResponse(connection, MakeJsonError(405, "Method Not Allowed", "use GET"));
+            return;
+        }
+        SendResponse(connection,
+                     HttpResponse{.ContentType = "text/plain; version=0.0.4; charset=utf-8",
+                                  .Body = FormatPrometheusMetrics(JobConf, Jobs, VideoTaskGroups)});
+        return;
+    }
+
+    if (request->Path == "/api/enqueue" || request->Path == "/api/cancel") {
+        if (request->Method != "POST") {
+            SendResponse(connection, MakeJsonError(405, "Method Not Allowed", "use POST"));
+            return;
+        }
+
+        // browsers send an Origin with every cross-origin POST, and can only send a JSON
+        // content type after a preflight we never answer, so this keeps websites out
+        if (request->Origin) {
+            SendResponse(connection, MakeJsonError(403, "Forbidden", "cross-origin request"));
+            return;
+        }
+        if (!IsJsonContentType(request->ContentType)) {
+            SendResponse(connection,
+                         MakeJsonError(415, "Unsupported Media Type", "use application/json"));
+            return;
+        }
+        SendResponse(
+            connection,
+            HandleJobRequest(Jobs, VideoTaskGroups, *request, request->Path == "/api/enqueue"));
+        return;
+    }
+
+    SendResponse(connection, MakeJsonError(404, "Not Found", "unknown path"));
+}
+} // namespace VodArchiver
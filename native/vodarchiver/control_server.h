@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace VodArchiver {
+struct JobConfig;
+struct JobList;
+struct VideoTaskGroup;
+
+// Optional HTTP endpoint on the loopback interface for monitoring and remote control.
+//   GET  /metrics      everything we count, in the Prometheus text format
+//   POST /api/enqueue  {"service": "Twitch", "id": "1234", "startImmediately": false}
+//   POST /api/cancel   {"service": "Twitch", "id": "1234"}, stops the job if it's running and
+//                      removes it from the queue
+// Requests are handled one at a time on a single thread. There's no authentication, so this must
+// never listen on anything but localhost. Requests must name us as 127.0.0.1:<port> or
+// localhost:<port> in their Host, and the POST endpoints also reject anything with an Origin or a
+// Content-Type other than application/json, so websites can't reach them from the browser.
+struct ControlServer {
+    // The task groups must not be added or removed while the server is running.
+    ControlServer(JobConfig& jobConfig,
+                  JobList& jobs,
+                  std::vector<std::unique_ptr<VideoTaskGroup>>& videoTaskGroups);
+    ControlServer(const ControlServer& other) = delete;
+    ControlServer(ControlServer&& other) = delete;
+    ControlServer& operator=(const ControlServer& other) = delete;
+    ControlServer& operator=(ControlServer&& other) = delete;
+    ~ControlServer();
+
+    // Starts listening on 127.0.0.1 at the given port. Returns false if that didn't work.
+    bool Start(uint16_t port);
+
+    // Stops listening and waits for the current request to finish.
+    void Stop();
+
+private:
+    void ThreadFunc();
+    void HandleConnection(uintptr_t connection);
+
+    JobConfig& JobConf;
+    JobList& Jobs;
+    std::vector<std::unique_ptr<VideoTaskGroup>>& VideoTaskGroups;
+
+    uintptr_t ListenSocket; // SOCKET on Windows, file descriptor elsewhere
+    uint16_t Port = 0;
+    std::atomic<bool> Stopping = false;
+    std::thread Thread;
+};
+
+// The response body for GET /metrics.
+std::string FormatPrometheusMetrics(JobConfig& jobConfig,
+                                    JobList& jobs,
+                                    std::vector<std::unique_ptr<VideoTaskGroup>>& videoTaskGroups);
+} // namespace VodArchiver
@@ -1,14 +1,22 @@
 #include "curl_util.h"
 
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <format>
 #include <limits>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "util/scope.h"
+#include "util/text.h"
+
+#include "host_rate_limiter.h"
+#include "metrics.h"
+#include "task_cancellation.h"
 
 // this includes windows.h on windows for some stupid reason...
 #define WIN32_LEAN_AND_MEAN
@@ -77,9 +85,130 @@ static size_t WriteToVectorCallback(char* ptr, size_t size, size_t nmemb, void*
     return size * nmemb;
 }
 
+static size_t WriteHeaderCallback(char* ptr, size_t size, size_t nitems, void* userdata) {
+    if (userdata == nullptr) {
+        return 0;
+    }
+
+    try {
+        auto* headers = static_cast<std::vector<std::pair<std::string, std::string>>*>(userdata);
+        std::string_view line(ptr, size * nitems);
+        if (line.starts_with("HTTP/")) {
+            // status line of a new response, eg. after following a redirect
+            headers->clear();
+        } else if (const size_t colon = line.find(':'); colon != std::string_view::npos) {
+            headers->emplace_back(HyoutaUtils::TextUtils::Trim(line.substr(0, colon)),
+                                  HyoutaUtils::TextUtils::Trim(line.substr(colon + 1)));
+        }
+    } catch (...) {
+        return 0;
+    }
+
+    return size * nitems;
+}
+
+std::optional<std::string_view> HttpResult::FindHeader(std::string_view name) const {
+    for (const auto& header : Headers) {
+        if (HyoutaUtils::TextUtils::CaseInsensitiveEquals(header.first, name)) {
+            return header.second;
+        }
+    }
+    return std::nullopt;
+}
+
+// Feeds the rate limit headers of a response into the fetch rate limiter.
+static void RecordRateLimits(CURL* handle, const HttpResult& result) {
+    using Clock = HostRateLimiter::Clock;
+    const auto info = ParseRateLimitHeaders(
+        result.ResponseCode,
+        result.Headers,
+        Clock::now(),
+        std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
+    if (!info.TooManyRequests && !info.RetryAfter && !(info.Remaining && info.Reset)) {
+        return;
+    }
+
+    char* effectiveUrl = nullptr;
+    if (curl_easy_getinfo(handle, CURLINFO_EFFECTIVE_URL, &effectiveUrl) != CURLE_OK
+        || effectiveUrl == nullptr) {
+        return;
+    }
+    CURLU* url = curl_url();
+    if (url == nullptr) {
+        return;
+    }
+    auto urlScope = HyoutaUtils::MakeScopeGuard([&]() { curl_url_cleanup(url); });
+    char* host = nullptr;
+    if (curl_url_set(url, CURLUPART_URL, effectiveUrl, 0) != CURLUE_OK
+        || curl_url_get(url, CURLUPART_HOST, &host, 0) != CURLUE_OK || host == nullptr) {
+        return;
+    }
+    std::string hostLower = HyoutaUtils::TextUtils::ToLower(host);
+    curl_free(host);
+
+    GetFetchRateLimiter().Update(hostLower, info, Clock::now());
+}
+
+// Like curl_easy_perform(), but returns CURLE_ABORTED_BY_CALLBACK as soon as the task is
+// cancelled. This drives the transfer through a multi handle so that the cancellation can wake up
+// curl_multi_poll() directly, instead of waiting for the next progress callback or timeout.
+static CURLcode PerformCancellable(CURL* handle, TaskCancellation* cancellationToken) {
+    if (cancellationToken == nullptr) {
+        return curl_easy_perform(handle);
+    }
+
+    CURLM* multi = curl_multi_init();
+    if (multi == nullptr) {
+        return CURLE_OUT_OF_MEMORY;
+    }
+    auto multiScope = HyoutaUtils::MakeScopeGuard([&]() { curl_multi_cleanup(multi); });
+    if (curl_multi_add_handle(multi, handle) != CURLM_OK) {
+        return CURLE_FAILED_INIT;
+    }
+    auto removeHandleScope =
+        HyoutaUtils::MakeScopeGuard([&]() { curl_multi_remove_handle(multi, handle); });
+    CancellationCallback wakeOnCancel(*cancellationToken, [&]() { curl_multi_wakeup(multi); });
+
+    while (true) {
+        if (cancellationToken->IsCancellationRequested()) {
+            return CURLE_ABORTED_BY_CALLBACK;
+        }
+
+        int stillRunning = 0;
+        if (curl_multi_perform(multi, &stillRunning) != CURLM_OK) {
+            return CURLE_FAILED_INIT;
+        }
+        if (stillRunning == 0) {
+            int messagesLeft = 0;
+            while (CURLMsg* message = curl_multi_info_read(multi, &messagesLeft)) {
+                if (message->msg == CURLMSG_DONE && message->easy_handle == handle) {
+                    return message->data.result;
+                }
+            }
+            return CURLE_FAILED_INIT;
+        }
+
+        if (curl_multi_poll(multi, nullptr, 0, 1000, nullptr) != CURLM_OK) {
+            return CURLE_FAILED_INIT;
+        }
+    }
+}
+
+static void RecordTransfer(CURLcode ec, const std::vector<char>& buffer) {
+    ArchiverMetrics& metrics = GetArchiverMetrics();
+    metrics.HttpRequests.fetch_add(1, std::memory_order_relaxed);
+    if (ec != CURLE_OK) {
+        metrics.HttpRequestsFailed.fetch_add(1, std::memory_order_relaxed);
+    }
+    metrics.HttpBytesReceived.fetch_add(buffer.size(), std::memory_order_relaxed);
+}
+
 std::optional<HttpResult> GetFromUrlToMemory(const std::string& url,
                                              const std::vector<std::string>& headers,
-                                             const std::vector<Range>& ranges) {
+                                             const std::vector<Range>& ranges,
+                                             TaskCancellation* cancellationToken) {
     CURL* handle = curl_easy_init();
     if (handle == nullptr) {
         return std::nullopt;
@@ -87,10 +216,13 @@ std::optional<HttpResult> GetFromUrlToMemory(const std::string& url,
     auto handleScope = HyoutaUtils::MakeScopeGuard([&]() { curl_easy_cleanup(handle); });
 
     std::vector<char> buffer;
+    std::vector<std::pair<std::string, std::string>> responseHeaders;
     curl_easy_setopt(handle, CURLOPT_HTTPGET, 1);
     curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
     curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteToVectorCallback);
     curl_easy_setopt(handle, CURLOPT_WRITEDATA, &buffer);
+    curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, WriteHeaderCallback);
+    curl_easy_setopt(handle, CURLOPT_HEADERDATA, &responseHeaders);
     curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, CURLFOLLOW_ALL);
     curl_easy_setopt(handle, CURLOPT_LOW_SPEED_TIME, 60L);
     curl_easy_setopt(handle, CURLOPT_LOW_SPEED_LIMIT, 1L);
@@ -120,7 +252,8 @@ std::optional<HttpResult> GetFromUrlToMemory(const std::string& url,
         curl_easy_setopt(handle, CURLOPT_RANGE, rangesString.c_str());
     }
 
-    CURLcode ec = curl_easy_perform(handle);
+    CURLcode ec = PerformCancellable(handle, cancellationToken);
+    RecordTransfer(ec, buffer);
     if (ec != CURLE_OK) {
         return std::nullopt;
     }
@@ -131,10 +264,16 @@ std::optional<HttpResult> GetFromUrlToMemory(const std::string& url,
         return std::nullopt;
     }
 
-    return HttpResult{.ResponseCode = responseCode, .Data = std::move(buffer)};
+    HttpResult result{.ResponseCode = responseCode,
+                      .Data = std::move(buffer),
+                      .Headers = std::move(responseHeaders)};
+    RecordRateLimits(handle, result);
+    return result;
 }
 
-std::optional<HttpResult> PostFormFromUrlToMemory(const std::string& url, std::string_view data) {
+std::optional<HttpResult> PostFormFromUrlToMemory(const std::string& url,
+                                                  std::string_view data,
+                                                  TaskCancellation* cancellationToken) {
     CURL* handle = curl_easy_init();
     if (handle == nullptr) {
         return std::nullopt;
@@ -142,16 +281,20 @@ std::optional<HttpResult> PostFormFromUrlToMemory(const std::string& url, std::s
     auto handleScope = HyoutaUtils::MakeScopeGuard([&]() { curl_easy_cleanup(handle); });
 
     std::vector<char> buffer;
+    std::vector<std::pair<std::string, std::string>> responseHeaders;
     curl_easy_setopt(handle, CURLOPT_HTTPPOST, 1);
     curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
     curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, data.size());
     curl_easy_setopt(handle, CURLOPT_POSTFIELDS, data.data());
     curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteToVectorCallback);
     curl_easy_setopt(handle, CURLOPT_WRITEDATA, &buffer);
+    curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, WriteHeaderCallback);
+    curl_easy_setopt(handle, CURLOPT_HEADERDATA, &responseHeaders);
     curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, CURLFOLLOW_ALL);
     curl_easy_setopt(handle, CURLOPT_LOW_SPEED_TIME, 60L);
     curl_easy_setopt(handle, CURLOPT_LOW_SPEED_LIMIT, 1L);
-    CURLcode ec = curl_easy_perform(handle);
+    CURLcode ec = PerformCancellable(handle, cancellationToken);
+    RecordTransfer(ec, buffer);
     if (ec != CURLE_OK) {
         return std::nullopt;
     }
@@ -162,6 +305,10 @@ std::optional<HttpResult> PostFormFromUrlToMemory(const std::string& url, std::s
         return std::nullopt;
     }
 
-    return HttpResult{.ResponseCode = responseCode, .Data = std::move(buffer)};
+    HttpResult result{.ResponseCode = responseCode,
+                      .Data = std::move(buffer),
+                      .Headers = std::move(responseHeaders)};
+    RecordRateLimits(handle, result);
+    return result;
 }
 } // namespace VodArchiver::curl
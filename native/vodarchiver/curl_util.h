@@ -4,8 +4,11 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "task_cancellation.h"
+
 namespace VodArchiver::curl {
 bool InitCurl();
 void DeinitCurl();
@@ -14,14 +17,28 @@ std::optional<std::string> UrlEscape(std::string_view str);
 struct HttpResult {
     long ResponseCode;
     std::vector<char> Data;
+
+    // Name and value of every header of the final response, in the order they were received.
+    std::vector<std::pair<std::string, std::string>> Headers;
+
+    // Case-insensitive. If the header appears more than once this is the first one.
+    std::optional<std::string_view> FindHeader(std::string_view name) const;
 };
 struct Range {
     size_t Start;
     size_t End;
 };
+
+// Rate limit headers in the response (Retry-After, Ratelimit-Remaining/Reset and their X-
+// variants) are passed on to GetFetchRateLimiter() for the host that answered.
+// If a cancellationToken is given, the transfer is aborted as soon as the task is cancelled and
+// nullopt is returned.
 std::optional<HttpResult>
     GetFromUrlToMemory(const std::string& url,
                        const std::vector<std::string>& headers = std::vector<std::string>(),
-                       const std::vector<Range>& ranges = std::vector<Range>());
-std::optional<HttpResult> PostFormFromUrlToMemory(const std::string& url, std::string_view data);
+                       const std::vector<Range>& ranges = std::vector<Range>(),
+                       TaskCancellation* cancellationToken = nullptr);
+std::optional<HttpResult> PostFormFromUrlToMemory(const std::string& url,
+                                                  std::string_view data,
+                                                  TaskCancellation* cancellationToken = nullptr);
 } // namespace VodArchiver::curl
@@ -1,27 +1,184 @@
 #include "disk_lock.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <format>
+#include <initializer_list>
+#include <iterator>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
+#include "metrics.h"
+#include "system_util.h"
 #include "task_cancellation.h"
 
 namespace VodArchiver {
-DiskLock::DiskLock(std::unique_lock<std::recursive_timed_mutex> lock) : Lock(std::move(lock)) {}
+DiskLock::DiskLock(DiskMutex* mutex, std::vector<std::string> devices)
+  : Mutex(mutex), Devices(std::move(devices)) {}
 
-DiskLock::~DiskLock() = default;
+DiskLock::~DiskLock() {
+    if (Mutex != nullptr && !Devices.empty()) {
+        Mutex->Release(Devices);
+    }
+}
 
-DiskLock DiskMutex::WaitForFreeSlot(TaskCancellation& cancellationToken) {
-    // TODO: Is there a better way to do this? Waiting for a mutex to become available but observing
-    // a cancellation signal?
-    std::unique_lock<std::recursive_timed_mutex> lock(Mutex, std::defer_lock);
-    while (true) {
-        if (lock.try_lock_for(std::chrono::milliseconds(500))) {
-            return DiskLock(std::move(lock));
-        }
+DiskLock DiskMutex::WaitForFreeSlot(std::initializer_list<std::string_view> paths,
+                                    TaskCancellation& cancellationToken) {
+    // paths we can't resolve share one slot pool, that's what everything used to do anyway
+    std::vector<std::string> devices;
+    for (std::string_view path : paths) {
+        devices.push_back(GetStorageDeviceIdAtPath(path).value_or(std::string()));
+    }
+
+    std::sort(devices.begin(), devices.end());
+    devices.erase(std::unique(devices.begin(), devices.end()), devices.end());
+
+    CancellationCallback wakeOnCancel(cancellationToken, [this]() {
+        std::lock_guard lock(Mutex);
+        SlotReleased.notify_all();
+    });
+
+    // queue up on all devices at once and only take the slots once we can have all of them, so
+    // we never sit on one device's slot while waiting for another. since everyone queues up on
+    // all their devices at the same time, the queues of different devices can't disagree on who's
+    // first, which would deadlock
+    std::unique_lock lock(Mutex);
+    std::vector<std::pair<Device*, uint64_t>> tickets;
+    tickets.reserve(devices.size());
+    for (const std::string& deviceId : devices) {
+        Device& device = Devices[deviceId];
+        const uint64_t ticket = device.NextTicket++;
+        device.Queue.push_back(ticket);
+        tickets.emplace_back(&device, ticket);
+    }
+
+    const auto waitStart = std::chrono::steady_clock::now();
+    SlotReleased.wait(lock, [&]() {
         if (cancellationToken.IsCancellationRequested()) {
-            return DiskLock(std::unique_lock<std::recursive_timed_mutex>());
+            return true;
+        }
+        for (const auto& [device, ticket] : tickets) {
+            if (device->Queue.front() != ticket || device->SlotsInUse >= GetSlotsNoLock(*device)) {
+                return false;
+            }
+        }
+        return true;
+    });
+    const auto waited = std::chrono::steady_clock::now() - waitStart;
+
+    const bool cancelled = cancellationToken.IsCancellationRequested();
+    for (const auto& [device, ticket] : tickets) {
+        std::erase(device->Queue, ticket);
+        if (!cancelled) {
+            ++device->SlotsInUse;
+            ++device->Acquisitions;
+            device->TotalWaitTime += waited;
+            device->LongestWaitTime = std::max(device->LongestWaitTime, waited);
+        }
+    }
+    lock.unlock();
+
+    // we were first in line on some devices, so whoever is next there may be able to go now
+    SlotReleased.notify_all();
+
+    if (cancelled) {
+        return DiskLock(nullptr, {});
+    }
+    GetArchiverMetrics().DiskSlotWaitSeconds.Observe(waited);
+    return DiskLock(this, std::move(devices));
+}
+
+void DiskMutex::SetDefaultSlotsPerDevice(uint32_t slots) {
+    {
+        std::lock_guard lock(Mutex);
+        DefaultSlotsPerDevice = std::max(slots, 1u);
+    }
+    SlotReleased.notify_all();
+}
+
+void DiskMutex::SetSlotsForDevice(const std::string& deviceId, uint32_t slots) {
+    {
+        std::lock_guard lock(Mutex);
+        Devices[deviceId].Slots = slots;
+    }
+    SlotReleased.notify_all();
+}
+
+void DiskMutex::SetSlotsForDeviceAtPath(std::string_view path, uint32_t slots) {
+    SetSlotsForDevice(GetStorageDeviceIdAtPath(path).value_or(std::string()), slots);
+}
+
+std::vector<DiskDeviceStatistics> DiskMutex::GetStatistics() {
+    std::vector<DiskDeviceStatistics> result;
+    std::lock_guard lock(Mutex);
+    result.reserve(Devices.size());
+    for (const auto& [deviceId, device] : Devices) {
+        result.push_back(DiskDeviceStatistics{
+            .DeviceId = deviceId,
+            .Slots = GetSlotsNoLock(device),
+            .SlotsInUse = device.SlotsInUse,
+            .Waiting = static_cast<uint32_t>(device.Queue.size()),
+            .Acquisitions = device.Acquisitions,
+            .TotalWaitTime = device.TotalWaitTime,
+            .LongestWaitTime = device.LongestWaitTime,
+        });
+    }
+    std::sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.DeviceId < rhs.DeviceId;
+    });
+    return result;
+}
+
+uint32_t DiskMutex::GetSlotsNoLock(const Device& device) const {
+    return device.Slots != 0 ? device.Slots : DefaultSlotsPerDevice;
+}
+
+void DiskMutex::ReleaseNoLock(const std::vector<std::string>& devices) {
+    for (const std::string& deviceId : devices) {
+        auto it = Devices.find(deviceId);
+        if (it != Devices.end() && it->second.SlotsInUse > 0) {
+            --it->second.SlotsInUse;
+        }
+    }
+}
+
+void DiskMutex::Release(const std::vector<std::string>& devices) {
+    {
+        std::lock_guard lock(Mutex);
+        ReleaseNoLock(devices);
+    }
+    SlotReleased.notify_all();
+}
+
+std::string FormatDiskStatistics(const std::vector<DiskDeviceStatistics>& statistics) {
+    std::string result;
+    for (const DiskDeviceStatistics& s : statistics) {
+        // only devices that are contended right now are interesting
+        if (s.Waiting == 0) {
+            continue;
+        }
+        const double average = s.Acquisitions == 0
+                                   ? 0.0
+                                   : std::chrono::duration<double>(s.TotalWaitTime).count()
+                                         / static_cast<double>(s.Acquisitions);
+        const double longest = std::chrono::duration<double>(s.LongestWaitTime).count();
+        if (!result.empty()) {
+            result.append(", ");
         }
+        std::format_to(std::back_inserter(result),
+                       "{}: {}/{} busy, {} waiting, wait avg {:.1f}s max {:.1f}s",
+                       s.DeviceId.empty() ? std::string_view("unknown") : s.DeviceId,
+                       s.SlotsInUse,
+                       s.Slots,
+                       s.Waiting,
+                       average,
+                       longest);
     }
+    return result;
 }
 } // namespace VodArchiver
@@ -1,6 +1,14 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <initializer_list>
 #include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "task_cancellation.h"
 
@@ -14,16 +22,69 @@ struct DiskLock {
     ~DiskLock();
 
 private:
-    DiskLock(std::unique_lock<std::recursive_timed_mutex> lock);
+    DiskLock(DiskMutex* mutex, std::vector<std::string> devices);
 
-    std::unique_lock<std::recursive_timed_mutex> Lock;
+    DiskMutex* Mutex;
+    std::vector<std::string> Devices; // one slot held on each of these
 
     friend struct DiskMutex;
 };
+
+struct DiskDeviceStatistics {
+    std::string DeviceId;
+    uint32_t Slots = 0;
+    uint32_t SlotsInUse = 0;
+    uint32_t Waiting = 0;
+
+    // over all slots handed out so far
+    uint64_t Acquisitions = 0;
+    std::chrono::steady_clock::duration TotalWaitTime{};
+    std::chrono::steady_clock::duration LongestWaitTime{};
+};
+
+// Limits how many expensive disk operations (combining, remuxing, splitting, moving between
+// volumes) run at the same time on each physical storage device, so jobs don't slow each other to
+// a crawl by seeking all over the same hard drive, while jobs on unrelated devices don't wait on
+// each other at all.
 struct DiskMutex {
-    DiskLock WaitForFreeSlot(TaskCancellation& cancellationToken);
+    // Waits for a free slot on every device the given paths are on, then takes them. Waiters on a
+    // device are served in order of arrival. Returns a lock holding nothing if cancelled.
+    DiskLock WaitForFreeSlot(std::initializer_list<std::string_view> paths,
+                             TaskCancellation& cancellationToken);
+
+    // Slots for devices without an explicit setting.
+    void SetDefaultSlotsPerDevice(uint32_t slots);
+    void SetSlotsForDevice(const std::string& deviceId, uint32_t slots);
+    void SetSlotsForDeviceAtPath(std::string_view path, uint32_t slots);
+
+    std::vector<DiskDeviceStatistics> GetStatistics();
 
 private:
-    std::recursive_timed_mutex Mutex;
+    struct Device {
+        uint32_t Slots = 0; // 0 for the default
+        uint32_t SlotsInUse = 0;
+
+        // tickets of the threads waiting for this device, first come first serve
+        std::vector<uint64_t> Queue;
+        uint64_t NextTicket = 0;
+
+        uint64_t Acquisitions = 0;
+        std::chrono::steady_clock::duration TotalWaitTime{};
+        std::chrono::steady_clock::duration LongestWaitTime{};
+    };
+
+    uint32_t GetSlotsNoLock(const Device& device) const;
+    void ReleaseNoLock(const std::vector<std::string>& devices);
+    void Release(const std::vector<std::string>& devices);
+
+    std::mutex Mutex;
+    std::condition_variable SlotReleased;
+    std::unordered_map<std::string, Device> Devices;
+    uint32_t DefaultSlotsPerDevice = 1;
+
+    friend struct DiskLock;
 };
+
+// Describes the devices that currently have jobs waiting for them, or returns an empty string.
+std::string FormatDiskStatistics(const std::vector<DiskDeviceStatistics>& statistics);
 } // namespace VodArchiver
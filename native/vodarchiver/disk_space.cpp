@@ -0,0 +1,112 @@
+#include "disk_space.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "metrics.h"
+#include "system_util.h"
+#include "task_cancellation.h"
+
+namespace VodArchiver {
+DiskSpaceReservation::DiskSpaceReservation(DiskSpaceLedger* ledger,
+                                           std::string volumeId,
+                                           uint64_t bytes)
+  : Ledger(ledger), VolumeId(std::move(volumeId)), Bytes(bytes) {}
+
+DiskSpaceReservation::DiskSpaceReservation(DiskSpaceReservation&& other)
+  : Ledger(other.Ledger), VolumeId(std::move(other.VolumeId)), Bytes(other.Bytes) {
+    other.Ledger = nullptr;
+    other.Bytes = 0;
+}
+
+DiskSpaceReservation::~DiskSpaceReservation() {
+    if (Ledger != nullptr) {
+        Ledger->Release(VolumeId, Bytes);
+    }
+}
+
+DiskSpaceReservation DiskSpaceLedger::Reserve(
+    std::string_view path,
+    uint64_t bytes,
+    const std::function<uint64_t()>& getMinimumFreeSpace,
+    TaskCancellation& cancellationToken,
+    const std::function<void(std::string status)>& setStatusCallback) {
+    std::optional<std::string> volumeId = GetVolumeIdAtPath(path);
+    if (!volumeId) {
+        return DiskSpaceReservation();
+    }
+
+    // while stalled, measure every so often even if none of our own jobs released anything, so
+    // that space freed up by something else (like the user deleting files) is noticed too
+    static constexpr auto MaximumMeasurementAge = std::chrono::seconds(10);
+
+    CancellationCallback wakeOnCancel(cancellationToken, [this]() {
+        std::lock_guard lock(Mutex);
+        SpaceReleased.notify_all();
+    });
+
+    const auto waitStart = std::chrono::steady_clock::now();
+    bool reportedStall = false;
+    std::unique_lock lock(Mutex);
+    while (true) {
+        if (cancellationToken.IsCancellationRequested()) {
+            return DiskSpaceReservation();
+        }
+
+        Volume& volume = Volumes[*volumeId];
+        if (volume.NeedsMeasure
+            || std::chrono::steady_clock::now() - volume.MeasuredAt >= MaximumMeasurementAge) {
+            // don't hold the lock for this, network drives may take a while to answer
+            lock.unlock();
+            std::optional<uint64_t> freeSpace = GetFreeDiskSpaceAtPath(path);
+            lock.lock();
+            if (!freeSpace) {
+                return DiskSpaceReservation();
+            }
+            volume.MeasuredFreeBytes = *freeSpace;
+            volume.MeasuredAt = std::chrono::steady_clock::now();
+            volume.NeedsMeasure = false;
+        }
+
+        if (volume.MeasuredFreeBytes > getMinimumFreeSpace() + volume.ReservedBytes + bytes) {
+            volume.ReservedBytes += bytes;
+            GetArchiverMetrics().DiskSpaceWaitSeconds.Observe(std::chrono::steady_clock::now()
+                                                              - waitStart);
+            return DiskSpaceReservation(this, std::move(*volumeId), bytes);
+        }
+
+        if (!reportedStall) {
+            reportedStall = true;
+            lock.unlock();
+            setStatusCallback("Not enough free space, stalling...");
+            lock.lock();
+            continue;
+        }
+
+        SpaceReleased.wait_for(lock, MaximumMeasurementAge);
+    }
+}
+
+void DiskSpaceLedger::Release(const std::string& volumeId, uint64_t bytes) {
+    {
+        std::lock_guard lock(Mutex);
+        auto it = Volumes.find(volumeId);
+        if (it == Volumes.end()) {
+            return;
+        }
+        Volume& volume = it->second;
+        volume.ReservedBytes = bytes < volume.ReservedBytes ? (volume.ReservedBytes - bytes) : 0;
+
+        // the write this was reserved for is done or was aborted, so the real free space has
+        // changed in a way we can't predict
+        volume.NeedsMeasure = true;
+    }
+    SpaceReleased.notify_all();
+}
+} // namespace VodArchiver
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "task_cancellation.h"
+
+namespace VodArchiver {
+struct DiskSpaceLedger;
+
+// Space set aside on a volume for a write that is about to happen or is in progress.
+// The space is given back to the ledger when this is destroyed.
+struct DiskSpaceReservation {
+    DiskSpaceReservation() = default;
+    DiskSpaceReservation(const DiskSpaceReservation& other) = delete;
+    DiskSpaceReservation(DiskSpaceReservation&& other);
+    DiskSpaceReservation& operator=(const DiskSpaceReservation& other) = delete;
+    DiskSpaceReservation& operator=(DiskSpaceReservation&& other) = delete;
+    ~DiskSpaceReservation();
+
+private:
+    DiskSpaceReservation(DiskSpaceLedger* ledger, std::string volumeId, uint64_t bytes);
+
+    DiskSpaceLedger* Ledger = nullptr;
+    std::string VolumeId;
+    uint64_t Bytes = 0;
+
+    friend struct DiskSpaceLedger;
+};
+
+// Keeps track of the free space of every volume jobs write to, and of how much of that space
+// running jobs have already promised to fill. This makes sure two jobs that each would fit on
+// their own don't both start writing and together push the volume below the minimum free space.
+struct DiskSpaceLedger {
+    // Waits until 'bytes' can be written to the volume containing 'path' while leaving at least
+    // getMinimumFreeSpace() bytes free after all other reservations on that volume are filled, then
+    // reserves them. setStatusCallback is invoked once if this has to wait.
+    // Returns an empty reservation if cancelled, or if the free space of the volume can't be
+    // determined, in which case the write is allowed to go ahead.
+    DiskSpaceReservation Reserve(std::string_view path,
+                                 uint64_t bytes,
+                                 const std::function<uint64_t()>& getMinimumFreeSpace,
+                                 TaskCancellation& cancellationToken,
+                                 const std::function<void(std::string status)>& setStatusCallback);
+
+private:
+    struct Volume {
+        // Free space as reported by the OS. This still includes space that's reserved but already
+        // partially written to, so it errs on the side of stalling a bit too long.
+        uint64_t MeasuredFreeBytes = 0;
+        std::chrono::steady_clock::time_point MeasuredAt{};
+        bool NeedsMeasure = true;
+
+        uint64_t ReservedBytes = 0;
+    };
+
+    void Release(const std::string& volumeId, uint64_t bytes);
+
+    std::mutex Mutex;
+    std::condition_variable SpaceReleased;
+    std::unordered_map<std::string, Volume> Volumes;
+
+    friend struct DiskSpaceReservation;
+};
+} // namespace VodArchiver
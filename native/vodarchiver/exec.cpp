@@ -1,6 +1,7 @@
 #include "exec.h"
 
 #include <format>
+#include <optional>
 #include <string>
 #include <thread>
 #include <vector>
@@ -9,6 +10,9 @@
 #include "util/text.h"
 #include "util/thread.h"
 
+#include "process_governor.h"
+#include "task_cancellation.h"
+
 #ifdef BUILD_FOR_WINDOWS
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
@@ -16,12 +20,35 @@
 #include <array>
 #include <fcntl.h>
 #include <poll.h>
+#include <sched.h>
+#include <signal.h>
 #include <spawn.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #endif
 
 namespace VodArchiver {
+int RunProgram(const std::string& programName,
+               const std::vector<std::string>& args,
+               const std::function<void(std::string_view)>& stdOutRedirect,
+               const std::function<void(std::string_view)>& stdErrRedirect) {
+    return RunProgram(programName,
+                      args,
+                      stdOutRedirect,
+                      stdErrRedirect,
+                      AcquireProcessSlot(ProcessClass::Interactive));
+}
+
+int RunProgram(const std::string& programName,
+               const std::vector<std::string>& args,
+               const std::function<void(std::string_view)>& stdOutRedirect,
+               const std::function<void(std::string_view)>& stdErrRedirect,
+               const ProcessSlot& slot) {
+    return RunProgram(programName, args, stdOutRedirect, stdErrRedirect, slot, nullptr);
+}
+
 #ifdef BUILD_FOR_WINDOWS
 void AppendArgEscaped(std::string& s, std::string_view arg) {
     s.push_back('"');
@@ -194,7 +221,9 @@ void RedirectOutput(HANDLE handle, const std::function<void(std::string_view)>&
 int RunProgram(const std::string& programName,
                const std::vector<std::string>& args,
                const std::function<void(std::string_view)>& stdOutRedirect,
-               const std::function<void(std::string_view)>& stdErrRedirect) {
+               const std::function<void(std::string_view)>& stdErrRedirect,
+               const ProcessSlot& slot,
+               TaskCancellation* cancellationToken) {
     auto wideProgName =
         HyoutaUtils::TextUtils::Utf8ToWString(programName.data(), programName.size());
     if (!wideProgName.has_value()) {
@@ -260,13 +289,26 @@ int RunProgram(const std::string& programName,
     startupinfo.hStdInput = INVALID_HANDLE_VALUE;
     startupinfo.dwFlags = STARTF_FORCEOFFFEEDBACK | STARTF_USESTDHANDLES;
     PROCESS_INFORMATION processinfo{};
+    // same order as the nice values on Linux, so remuxes and splits still get ahead of encodes
+    DWORD priorityClass = IDLE_PRIORITY_CLASS;
+    switch (slot.Class) {
+        case ProcessClass::Interactive: priorityClass = NORMAL_PRIORITY_CLASS; break;
+        case ProcessClass::Io: priorityClass = BELOW_NORMAL_PRIORITY_CLASS; break;
+        case ProcessClass::Bulk: priorityClass = IDLE_PRIORITY_CLASS; break;
+    }
+    DWORD_PTR affinityMask = 0;
+    for (uint32_t cpu : slot.Cpus) {
+        if (cpu < sizeof(DWORD_PTR) * 8) {
+            affinityMask |= (static_cast<DWORD_PTR>(1) << cpu);
+        }
+    }
     if (!CreateProcessWithExplicitHandles(wideProgName->c_str(),
                                           wideArgsString->data(),
                                           nullptr,
                                           nullptr,
                                           TRUE,
-                                          CREATE_UNICODE_ENVIRONMENT | IDLE_PRIORITY_CLASS
-                                              | CREATE_NO_WINDOW,
+                                          CREATE_UNICODE_ENVIRONMENT | priorityClass
+                                              | CREATE_NO_WINDOW | CREATE_SUSPENDED,
                                           nullptr,
                                           nullptr,
                                           &startupinfo,
@@ -279,6 +321,39 @@ int RunProgram(const std::string& programName,
         CloseHandle(processinfo.hThread);
         CloseHandle(processinfo.hProcess);
     });
+    if (affinityMask != 0) {
+        // failure here is harmless, the process just runs on any CPU
+        SetProcessAffinityMask(processinfo.hProcess, affinityMask);
+    }
+
+    // put the process in a job so that cancelling also kills anything it spawned itself, like the
+    // ffmpeg started by yt-dlp, which would otherwise keep our output pipes open
+    HANDLE job = nullptr;
+    auto closeJob = HyoutaUtils::MakeScopeGuard([&]() {
+        if (job != nullptr) {
+            CloseHandle(job);
+        }
+    });
+    std::optional<CancellationCallback> killOnCancel;
+    if (cancellationToken != nullptr) {
+        job = CreateJobObjectW(nullptr, nullptr);
+        if (job != nullptr && !AssignProcessToJobObject(job, processinfo.hProcess)) {
+            CloseHandle(job);
+            job = nullptr;
+        }
+        const auto kill = [&]() {
+            if (job != nullptr) {
+                TerminateJobObject(job, 1);
+            } else {
+                TerminateProcess(processinfo.hProcess, 1);
+            }
+        };
+        killOnCancel.emplace(*cancellationToken, kill);
+        if (cancellationToken->IsCancellationRequested()) {
+            kill();
+        }
+    }
+    ResumeThread(processinfo.hThread);
     CloseHandle(handleStdOutWrite);
     handleStdOutWrite = nullptr;
     CloseHandle(handleStdErrWrite);
@@ -304,6 +379,9 @@ int RunProgram(const std::string& programName,
     });
 
     WaitForSingleObject(processinfo.hProcess, INFINITE);
+    if (cancellationToken != nullptr && cancellationToken->IsCancellationRequested()) {
+        return -1;
+    }
     DWORD rv = 0;
     if (!GetExitCodeProcess(processinfo.hProcess, &rv)) {
         return -1;
@@ -311,11 +389,82 @@ int RunProgram(const std::string& programName,
     return static_cast<int>(rv);
 }
 #else
+static constexpr int IoPrioWhoProcess = 1;
+static constexpr int IoPrioClassBestEffort = 2;
+static constexpr int IoPrioClassShift = 13;
+
+static bool SlotNeedsSpawnThread(const ProcessSlot& slot) {
+    return slot.Class == ProcessClass::Bulk || !slot.Cpus.empty() || slot.Nice != 0
+           || slot.IoPriority >= 0;
+}
+
+// Applies the slot's scheduling parameters to the calling thread. posix_spawn has no attributes
+// for CPU affinity, nice value or I/O priority, and glibc rejects SCHED_BATCH as a spawn policy,
+// but the child inherits all of these from the spawning thread.
+static void ApplySlotToCurrentThread(const ProcessSlot& slot) {
+    if (slot.Class == ProcessClass::Bulk) {
+        // bulk work runs as SCHED_BATCH so the kernel favors throughput over latency
+        struct sched_param param {};
+        param.sched_priority = 0;
+        sched_setscheduler(0, SCHED_BATCH, &param);
+    }
+    if (!slot.Cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (uint32_t cpu : slot.Cpus) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+    if (slot.Nice != 0) {
+        // on Linux the nice value is per thread, so this doesn't affect the rest of the process
+        setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), slot.Nice);
+    }
+    if (slot.IoPriority >= 0) {
+        syscall(SYS_ioprio_set,
+                IoPrioWhoProcess,
+                0,
+                (IoPrioClassBestEffort << IoPrioClassShift) | slot.IoPriority);
+    }
+}
+
+static int SpawnProcess(pid_t* child_pid,
+                        const std::string& programName,
+                        const posix_spawn_file_actions_t* file_actions,
+                        const posix_spawnattr_t* attributes,
+                        char* const* arg_pointers,
+                        const ProcessSlot& slot) {
+    if (!SlotNeedsSpawnThread(slot)) {
+        return posix_spawnp(
+            child_pid, programName.c_str(), file_actions, attributes, arg_pointers, nullptr);
+    }
+
+    // an unprivileged thread can't lower its nice value again, so spawn from a throwaway thread
+    // instead of restoring our own settings afterwards
+    int result = -1;
+    std::thread spawnThread([&]() {
+        HyoutaUtils::SetThreadName("SpawnThread");
+        ApplySlotToCurrentThread(slot);
+        result = posix_spawnp(
+            child_pid, programName.c_str(), file_actions, attributes, arg_pointers, nullptr);
+    });
+    spawnThread.join();
+    return result;
+}
+
 int RunProgram(const std::string& programName,
                const std::vector<std::string>& args,
                const std::function<void(std::string_view)>& stdOutRedirect,
-               const std::function<void(std::string_view)>& stdErrRedirect) {
+               const std::function<void(std::string_view)>& stdErrRedirect,
+               const ProcessSlot& slot,
+               TaskCancellation* cancellationToken) {
     pid_t child_pid = 0;
+
+    // the child stays a zombie until we waitpid() below, so its pid can't be reused while this
+    // may still send it a signal
+    std::optional<CancellationCallback> killOnCancel;
     {
         std::array<int, 2> stdout_pipe{};
         std::array<int, 2> stderr_pipe{};
@@ -343,19 +492,27 @@ int RunProgram(const std::string& programName,
             }
             arg_pointers.push_back(nullptr);
             {
-                // make two pipes that redirect the stdout and stderr of the child process to us
-                if (pipe2(stdout_pipe.data(), O_NONBLOCK | O_CLOEXEC) != 0) {
+                // make two pipes that redirect the stdout and stderr of the child process to us.
+                // only our read end is non-blocking, the child should block when we're not
+                // reading fast enough instead of getting write errors
+                if (pipe2(stdout_pipe.data(), O_CLOEXEC) != 0) {
                     return -1;
                 }
                 stdout_pipe_initialized = true;
                 auto stdout_pipe_1_guard =
                     HyoutaUtils::MakeScopeGuard([&]() { close(stdout_pipe[1]); });
-                if (pipe2(stderr_pipe.data(), O_NONBLOCK | O_CLOEXEC) != 0) {
+                if (fcntl(stdout_pipe[0], F_SETFL, O_NONBLOCK) != 0) {
+                    return -1;
+                }
+                if (pipe2(stderr_pipe.data(), O_CLOEXEC) != 0) {
                     return -1;
                 }
                 stderr_pipe_initialized = true;
                 auto stderr_pipe_1_guard =
                     HyoutaUtils::MakeScopeGuard([&]() { close(stderr_pipe[1]); });
+                if (fcntl(stderr_pipe[0], F_SETFL, O_NONBLOCK) != 0) {
+                    return -1;
+                }
 
                 // set up the write end of the pipes as the child's stdout and stderr
                 posix_spawn_file_actions_t file_actions;
@@ -373,13 +530,42 @@ int RunProgram(const std::string& programName,
                     return -1;
                 }
 
+                posix_spawnattr_t attributes;
+                if (posix_spawnattr_init(&attributes) != 0) {
+                    return -1;
+                }
+                auto attributes_guard =
+                    HyoutaUtils::MakeScopeGuard([&]() { posix_spawnattr_destroy(&attributes); });
+
+                // the daemon blocks the termination signals in all of its threads to wait for them
+                // with sigwait(), don't pass that on to the child
+                short spawnFlags = POSIX_SPAWN_SETSIGMASK;
+                sigset_t childSignalMask;
+                sigemptyset(&childSignalMask);
+                if (posix_spawnattr_setsigmask(&attributes, &childSignalMask) != 0) {
+                    return -1;
+                }
+
+                // a cancellable child gets its own process group, so that cancelling also kills
+                // anything it spawned itself, like the ffmpeg started by yt-dlp, which would
+                // otherwise keep our output pipes open
+                if (cancellationToken != nullptr) {
+                    spawnFlags |= POSIX_SPAWN_SETPGROUP;
+                    if (posix_spawnattr_setpgroup(&attributes, 0) != 0) {
+                        return -1;
+                    }
+                }
+                if (posix_spawnattr_setflags(&attributes, spawnFlags) != 0) {
+                    return -1;
+                }
+
                 // spawn the child process
-                if (posix_spawnp(&child_pid,
-                                 programName.c_str(),
+                if (SpawnProcess(&child_pid,
+                                 programName,
                                  &file_actions,
-                                 nullptr,
+                                 &attributes,
                                  arg_pointers.data(),
-                                 nullptr)
+                                 slot)
                     != 0) {
                     return -1;
                 }
@@ -389,6 +575,13 @@ int RunProgram(const std::string& programName,
             }
         }
 
+        if (cancellationToken != nullptr) {
+            killOnCancel.emplace(*cancellationToken, [&]() { kill(-child_pid, SIGKILL); });
+            if (cancellationToken->IsCancellationRequested()) {
+                kill(-child_pid, SIGKILL);
+            }
+        }
+
         // now poll and read the redirected stdout/stderr until they're closed from the other side
         std::array<struct pollfd, 2> pollfds{};
         pollfds[0].fd = stdout_pipe[0];
@@ -460,6 +653,8 @@ int RunProgram(const std::string& programName,
         }
     }
 
+    killOnCancel.reset();
+
     // wait for process to exit and get its exit status
     int exit_status = -1;
     if (waitpid(child_pid, &exit_status, 0) == -1) {
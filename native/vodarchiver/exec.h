@@ -5,9 +5,28 @@
 #include <string_view>
 #include <vector>
 
+#include "process_governor.h"
+#include "task_cancellation.h"
+
 namespace VodArchiver {
+// Runs the program as ProcessClass::Interactive.
 int RunProgram(const std::string& programName,
                const std::vector<std::string>& args,
                const std::function<void(std::string_view)>& stdOutRedirect,
                const std::function<void(std::string_view)>& stdErrRedirect);
+
+// Runs the program with the CPUs and priorities of the given slot.
+int RunProgram(const std::string& programName,
+               const std::vector<std::string>& args,
+               const std::function<void(std::string_view)>& stdOutRedirect,
+               const std::function<void(std::string_view)>& stdErrRedirect,
+               const ProcessSlot& slot);
+
+// As above, but kills the program as soon as the task is cancelled, which returns -1.
+int RunProgram(const std::string& programName,
+               const std::vector<std::string>& args,
+               const std::function<void(std::string_view)>& stdOutRedirect,
+               const std::function<void(std::string_view)>& stdErrRedirect,
+               const ProcessSlot& slot,
+               TaskCancellation* cancellationToken);
 } // namespace VodArchiver
@@ -1,5 +1,6 @@
 #include "ffmpeg_util.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <string_view>
@@ -181,4 +182,55 @@ std::optional<FFProbeResult> FFMpegProbe(const std::string& filename) {
         .Streams = std::move(streams),
     };
 }
+
+std::optional<std::vector<TimeSpan>> FFMpegProbeKeyframes(const std::string& filename) {
+    std::vector<TimeSpan> keyframes;
+    std::string pending;
+    auto parseLine = [&](std::string_view line) {
+        // each line looks like '12.345000,K__', non-keyframes have a '_' instead of the 'K'
+        auto split = HyoutaUtils::TextUtils::Split(HyoutaUtils::TextUtils::Trim(line), ",");
+        if (split.size() >= 2 && split[1].starts_with('K')) {
+            if (auto ts = TimeSpan::ParseFromSeconds(split[0])) {
+                keyframes.push_back(*ts);
+            }
+        }
+    };
+    int retval = RunProgram(
+        "ffprobe.exe",
+        {{"-v",
+          "error",
+          "-select_streams",
+          "v:0",
+          "-show_entries",
+          "packet=pts_time,flags",
+          "-of",
+          "csv=p=0",
+          filename}},
+        [&](std::string_view sv) {
+            // the output for long videos is large, so parse it as it comes in
+            pending.append(sv);
+            size_t start = 0;
+            while (true) {
+                size_t end = pending.find('\n', start);
+                if (end == std::string::npos) {
+                    break;
+                }
+                parseLine(std::string_view(pending).substr(start, end - start));
+                start = end + 1;
+            }
+            pending.erase(0, start);
+        },
+        [&](std::string_view) {},
+        AcquireProcessSlot(ProcessClass::Io));
+    if (retval != 0) {
+        return std::nullopt;
+    }
+    if (!pending.empty()) {
+        parseLine(pending);
+    }
+
+    // packets are in decode order, which is not necessarily presentation order
+    std::sort(keyframes.begin(), keyframes.end());
+    return keyframes;
+}
 } // namespace VodArchiver
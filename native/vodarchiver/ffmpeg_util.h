@@ -26,4 +26,8 @@ struct FFProbeResult {
 };
 
 std::optional<FFProbeResult> FFMpegProbe(const std::string& filename);
+
+// Returns the presentation timestamps of all keyframes in the first video stream, sorted.
+// This only demuxes the file, but it still has to read the whole thing.
+std::optional<std::vector<TimeSpan>> FFMpegProbeKeyframes(const std::string& filename);
 } // namespace VodArchiver
@@ -0,0 +1,392 @@
+#include "gui_directory_listing.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "util/file.h"
+#include "util/text.h"
+#include "util/thread.h"
+
+#ifndef BUILD_FOR_WINDOWS
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace VodArchiver::GUI {
+namespace {
+// how often entries found so far are handed to the GUI while a directory is being enumerated
+static constexpr auto PublishInterval = std::chrono::milliseconds(100);
+
+#ifndef BUILD_FOR_WINDOWS
+// how many complete listings are kept around, each one costs an inotify watch
+static constexpr size_t MaxCachedDirectories = 32;
+
+// Complete listings of recently visited directories. Every cached directory is watched with inotify
+// and its listing is dropped as soon as anything is added, removed or renamed in it, so a cached
+// listing is never stale.
+struct DirectoryCache {
+    DirectoryCache() = default;
+    DirectoryCache(const DirectoryCache& other) = delete;
+    DirectoryCache(DirectoryCache&& other) = delete;
+    DirectoryCache& operator=(const DirectoryCache& other) = delete;
+    DirectoryCache& operator=(DirectoryCache&& other) = delete;
+    ~DirectoryCache() {
+        if (InotifyFd != -1) {
+            close(InotifyFd);
+        }
+    }
+
+    std::shared_ptr<const std::vector<FileEntry>> Find(const std::filesystem::path& directory) {
+        std::lock_guard lock(Mutex);
+        ProcessEventsNoLock();
+        for (CachedDirectory& d : Directories) {
+            if (d.Path == directory && d.Entries) {
+                d.LastUse = ++UseCounter;
+                return d.Entries;
+            }
+        }
+        return nullptr;
+    }
+
+    // Must be called before the directory is enumerated, so that changes during the enumeration
+    // prevent the result from being cached.
+    void Watch(const std::filesystem::path& directory) {
+        std::lock_guard lock(Mutex);
+        ProcessEventsNoLock();
+        if (InotifyFd == -1) {
+            InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (InotifyFd == -1) {
+                return;
+            }
+        }
+        const int wd = inotify_add_watch(InotifyFd,
+                                         directory.c_str(),
+                                         IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                                             | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+        if (wd == -1) {
+            return;
+        }
+
+        // watching the same directory again returns the existing descriptor
+        auto it = std::find_if(Directories.begin(),
+                               Directories.end(),
+                               [&](const CachedDirectory& d) { return d.WatchDescriptor == wd; });
+        if (it == Directories.end()) {
+            if (Directories.size() >= MaxCachedDirectories) {
+                EvictLeastRecentlyUsedNoLock();
+            }
+            it = Directories.insert(Directories.end(), CachedDirectory{.Path = directory});
+            it->WatchDescriptor = wd;
+        }
+        it->Changed = false;
+        it->LastUse = ++UseCounter;
+    }
+
+    void Store(const std::filesystem::path& directory,
+               std::shared_ptr<const std::vector<FileEntry>> entries) {
+        std::lock_guard lock(Mutex);
+        ProcessEventsNoLock();
+        for (CachedDirectory& d : Directories) {
+            if (d.Path == directory && !d.Changed) {
+                d.Entries = std::move(entries);
+                return;
+            }
+        }
+    }
+
+private:
+    struct CachedDirectory {
+        std::filesystem::path Path;
+        int WatchDescriptor = -1;
+        bool Changed = false; // since Watch() was called
+        uint64_t LastUse = 0;
+        std::shared_ptr<const std::vector<FileEntry>> Entries;
+    };
+
+    void ProcessEventsNoLock() {
+        if (InotifyFd == -1) {
+            return;
+        }
+        alignas(inotify_event) std::array<char, 4096> buffer;
+        while (true) {
+            const ssize_t length = read(InotifyFd, buffer.data(), buffer.size());
+            if (length <= 0) {
+                return;
+            }
+            for (size_t offset = 0; offset < static_cast<size_t>(length);) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+                offset += sizeof(inotify_event) + event->len;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    // we don't know what changed, so assume everything did
+                    for (CachedDirectory& d : Directories) {
+                        d.Changed = true;
+                        d.Entries.reset();
+                    }
+                    continue;
+                }
+                auto it = std::find_if(
+                    Directories.begin(), Directories.end(), [&](const CachedDirectory& d) {
+                        return d.WatchDescriptor == event->wd;
+                    });
+                if (it == Directories.end()) {
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    // the watch is gone, either because we removed it or the directory is gone
+                    Directories.erase(it);
+                    continue;
+                }
+                it->Changed = true;
+                it->Entries.reset();
+            }
+        }
+    }
+
+    void EvictLeastRecentlyUsedNoLock() {
+        auto it = std::min_element(
+            Directories.begin(),
+            Directories.end(),
+            [](const CachedDirectory& lhs, const CachedDirectory& rhs) {
+                return lhs.LastUse < rhs.LastUse;
+            });
+        if (it != Directories.end()) {
+            inotify_rm_watch(InotifyFd, it->WatchDescriptor);
+            Directories.erase(it);
+        }
+    }
+
+    std::mutex Mutex;
+    int InotifyFd = -1;
+    uint64_t UseCounter = 0;
+    std::vector<CachedDirectory> Directories;
+};
+
+static DirectoryCache& GetDirectoryCache() {
+    static DirectoryCache cache;
+    return cache;
+}
+#endif
+
+static bool IsRoot(const std::filesystem::path& p) {
+#ifdef BUILD_FOR_WINDOWS
+    return p.empty();
+#else
+    return p == u8"/";
+#endif
+}
+
+static void MergeSortedBatch(std::vector<FileEntry>& entries, std::vector<FileEntry>& batch) {
+    std::sort(batch.begin(), batch.end(), FileEntryLess);
+    const size_t middle = entries.size();
+    entries.insert(entries.end(),
+                   std::make_move_iterator(batch.begin()),
+                   std::make_move_iterator(batch.end()));
+    std::inplace_merge(entries.begin(), entries.begin() + middle, entries.end(), FileEntryLess);
+    batch.clear();
+}
+} // namespace
+
+bool FileEntryLess(const FileEntry& lhs, const FileEntry& rhs) {
+    if (lhs.Type != rhs.Type) {
+        return lhs.Type < rhs.Type;
+    }
+    return HyoutaUtils::TextUtils::CaseInsensitiveCompare(lhs.Filename, rhs.Filename) < 0;
+}
+
+DirectoryListing::DirectoryListing(std::filesystem::path directory,
+                                   std::string filter,
+                                   std::function<void()> onChanged)
+  : Directory(std::move(directory)), Filter(std::move(filter)), OnChanged(std::move(onChanged)) {
+    Current.Entries = std::make_shared<const std::vector<FileEntry>>();
+    Thread = std::thread(std::bind(&DirectoryListing::ThreadFunc, this));
+}
+
+DirectoryListing::~DirectoryListing() {
+    {
+        std::lock_guard lock(Mutex);
+        Stopping.store(true);
+    }
+    CondVar.notify_all();
+    Thread.join();
+}
+
+DirectoryListing::Snapshot DirectoryListing::GetSnapshot() const {
+    std::lock_guard lock(Mutex);
+    return Current;
+}
+
+void DirectoryListing::RequestFileSizes(std::vector<std::string> filenames) {
+    if (filenames.empty()) {
+        return;
+    }
+    {
+        std::lock_guard lock(Mutex);
+        for (std::string& f : filenames) {
+            FileSizeRequests.push_back(std::move(f));
+        }
+    }
+    CondVar.notify_all();
+}
+
+std::vector<std::pair<std::string, uint64_t>> DirectoryListing::TakeFileSizes() {
+    std::vector<std::pair<std::string, uint64_t>> results;
+    std::lock_guard lock(Mutex);
+    results.swap(FileSizeResults);
+    return results;
+}
+
+void DirectoryListing::ThreadFunc() {
+    HyoutaUtils::SetThreadName("DirectoryListing");
+
+    std::vector<FileEntry> filtered;
+    const bool isRoot = IsRoot(Directory);
+    if (!isRoot) {
+        filtered.push_back(FileEntry{.Filename = "..", .Type = FileEntryType::GoUpDirectory});
+    }
+
+#ifdef BUILD_FOR_WINDOWS
+    if (isRoot) {
+        // On Windows we need to special-case the root and list the drives.
+        for (const std::string& drive : HyoutaUtils::IO::GetLogicalDrives()) {
+            filtered.push_back(FileEntry{.Filename = drive, .Type = FileEntryType::Drive});
+        }
+        Publish(filtered, true, false);
+        ServeFileSizeRequests();
+        return;
+    }
+#else
+    std::shared_ptr<const std::vector<FileEntry>> cached = GetDirectoryCache().Find(Directory);
+    if (cached) {
+        for (const FileEntry& e : *cached) {
+            if (e.Type == FileEntryType::Directory || Filter.empty()
+                || HyoutaUtils::TextUtils::CaseInsensitiveGlobMatches(e.Filename, Filter)) {
+                filtered.push_back(e);
+            }
+        }
+        Publish(filtered, true, false);
+        ServeFileSizeRequests();
+        return;
+    }
+    GetDirectoryCache().Watch(Directory);
+#endif
+
+    std::vector<FileEntry> all;
+    const bool success = Enumerate(all, filtered);
+    if (Stopping.load()) {
+        return;
+    }
+    Publish(filtered, true, !success);
+#ifndef BUILD_FOR_WINDOWS
+    if (success) {
+        GetDirectoryCache().Store(Directory,
+                                  std::make_shared<const std::vector<FileEntry>>(std::move(all)));
+    }
+#endif
+    ServeFileSizeRequests();
+}
+
+bool DirectoryListing::Enumerate(std::vector<FileEntry>& all, std::vector<FileEntry>& filtered) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(Directory, ec);
+    if (ec) {
+        return false;
+    }
+
+    std::vector<FileEntry> batch;
+    auto lastPublish = std::chrono::steady_clock::now();
+    while (it != std::filesystem::directory_iterator()) {
+        if (Stopping.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        // this only needs a stat() for symlinks, the type of everything else comes with the entry
+        const bool isDirectory = it->is_directory(ec);
+        if (!ec) {
+            FileEntry e{.Filename = HyoutaUtils::IO::FilesystemPathToUtf8(it->path().filename()),
+                        .Type = isDirectory ? FileEntryType::Directory : FileEntryType::File};
+            if (isDirectory || Filter.empty()
+                || HyoutaUtils::TextUtils::CaseInsensitiveGlobMatches(e.Filename, Filter)) {
+                batch.push_back(e);
+            }
+            all.push_back(std::move(e));
+        }
+        it.increment(ec);
+        if (ec) {
+            return false;
+        }
+
+        if (!batch.empty() && std::chrono::steady_clock::now() - lastPublish >= PublishInterval) {
+            MergeSortedBatch(filtered, batch);
+            Publish(filtered, false, false);
+            lastPublish = std::chrono::steady_clock::now();
+        }
+    }
+
+    MergeSortedBatch(filtered, batch);
+    std::sort(all.begin(), all.end(), FileEntryLess);
+    return true;
+}
+
+void DirectoryListing::Publish(const std::vector<FileEntry>& entries, bool done, bool failed) {
+    auto published = std::make_shared<std::vector<FileEntry>>(entries);
+    for (size_t i = 0; i < published->size(); ++i) {
+        (*published)[i].Id = static_cast<int>(i);
+    }
+    {
+        std::lock_guard lock(Mutex);
+        ++Current.Version;
+        Current.Entries = std::move(published);
+        Current.Done = done;
+        Current.Failed = failed;
+    }
+    if (OnChanged) {
+        OnChanged();
+    }
+}
+
+void DirectoryListing::ServeFileSizeRequests() {
+    std::unique_lock lock(Mutex);
+    while (true) {
+        CondVar.wait(lock, [&] { return Stopping.load() || !FileSizeRequests.empty(); });
+        if (Stopping.load()) {
+            return;
+        }
+        std::vector<std::string> requests = std::move(FileSizeRequests);
+        FileSizeRequests.clear();
+        lock.unlock();
+
+        std::vector<std::pair<std::string, uint64_t>> results;
+        results.reserve(requests.size());
+        for (std::string& filename : requests) {
+            if (Stopping.load(std::memory_order_relaxed)) {
+                return;
+            }
+            std::error_code ec;
+            const auto size = std::filesystem::file_size(
+                Directory / HyoutaUtils::IO::FilesystemPathFromUtf8(filename), ec);
+            results.emplace_back(std::move(filename), ec ? 0 : static_cast<uint64_t>(size));
+        }
+
+        lock.lock();
+        for (auto& r : results) {
+            FileSizeResults.push_back(std::move(r));
+        }
+        lock.unlock();
+        if (OnChanged) {
+            OnChanged();
+        }
+        lock.lock();
+    }
+}
+} // namespace VodArchiver::GUI
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace VodArchiver::GUI {
+enum class FileEntryType : int {
+    GoUpDirectory = -2,
+    Drive = -1, // Windows only
+    Directory = 0,
+    File = 1,
+};
+
+struct FileEntry {
+    std::string Filename;
+    FileEntryType Type;
+    int Id = 0; // position in the listing it was published in
+};
+
+// Parent directory first, then drives, directories and files, each by name.
+bool FileEntryLess(const FileEntry& lhs, const FileEntry& rhs);
+
+// Lists a directory on a background thread. Entries show up in sorted batches while the
+// enumeration is still running, so the caller can display them immediately instead of waiting for
+// a slow disk. File sizes aren't part of the listing since they'd need one stat() per file, they
+// have to be requested individually with RequestFileSizes().
+// On Linux, complete listings are cached per directory until inotify reports a change in it, so
+// going back to a directory doesn't need to enumerate it again.
+struct DirectoryListing {
+    // onChanged is called from the background thread whenever new data is available.
+    DirectoryListing(std::filesystem::path directory,
+                     std::string filter,
+                     std::function<void()> onChanged);
+    DirectoryListing(const DirectoryListing& other) = delete;
+    DirectoryListing(DirectoryListing&& other) = delete;
+    DirectoryListing& operator=(const DirectoryListing& other) = delete;
+    DirectoryListing& operator=(DirectoryListing&& other) = delete;
+    ~DirectoryListing(); // stops the background thread
+
+    struct Snapshot {
+        uint64_t Version = 0;
+        std::shared_ptr<const std::vector<FileEntry>> Entries;
+        bool Done = false;   // the enumeration finished, no more entries will show up
+        bool Failed = false; // the directory couldn't be read
+    };
+    Snapshot GetSnapshot() const;
+
+    // Sizes are looked up in the background, fetch them with TakeFileSizes() once they're ready.
+    void RequestFileSizes(std::vector<std::string> filenames);
+    std::vector<std::pair<std::string, uint64_t>> TakeFileSizes();
+
+private:
+    void ThreadFunc();
+    bool Enumerate(std::vector<FileEntry>& all, std::vector<FileEntry>& filtered);
+    void Publish(const std::vector<FileEntry>& entries, bool done, bool failed);
+    void ServeFileSizeRequests();
+
+    std::filesystem::path Directory;
+    std::string Filter;
+    std::function<void()> OnChanged;
+
+    mutable std::mutex Mutex;
+    std::condition_variable CondVar;
+    Snapshot Current;
+    std::vector<std::string> FileSizeRequests;
+    std::vector<std::pair<std::string, uint64_t>> FileSizeResults;
+
+    // only changed while holding the Mutex, but may be read without it
+    std::atomic<bool> Stopping = false;
+    std::thread Thread;
+};
+} // namespace VodArchiver::GUI
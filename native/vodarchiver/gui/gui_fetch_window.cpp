@@ -28,19 +28,27 @@
 #include "vodarchiver_imgui_utils.h"
 
 namespace VodArchiver::GUI {
-static FetchReturnValue
-    RunFetchTask(JobConfig* jobConfig, IUserInfo* userInfo, size_t offset, bool flat) {
+static FetchReturnValue RunFetchTask(JobConfig* jobConfig,
+                                     IUserInfo* userInfo,
+                                     const std::string& cursor,
+                                     bool flat) {
     HyoutaUtils::SetThreadName("GuiFetch");
     if (userInfo == nullptr) {
         return FetchReturnValue{.Success = false, .HasMore = false};
     }
     try {
-        return userInfo->Fetch(*jobConfig, offset, flat);
+        return userInfo->Fetch(*jobConfig, cursor, flat);
     } catch (...) {
         return FetchReturnValue{.Success = false, .HasMore = false};
     }
 }
 
+static void NotifyUserInfosChanged(GuiState& state) {
+    for (auto& group : state.FetchTaskGroups) {
+        group->NotifyUserInfosChanged();
+    }
+}
+
 void FetchWindow::Cleanup(GuiState& state) {
     state.WindowIdsFetchWindow.ReturnId(WindowId);
 }
@@ -51,7 +59,11 @@ FetchWindow::FetchWindow(GuiState& state)
                               WindowIdString.size(),
                               WindowTitle,
                               sizeof(WindowTitle)))
-  , FetchTask(RunFetchTask) {}
+  , FetchTask([&state](JobConfig* jobConfig, IUserInfo* userInfo, std::string cursor, bool flat) {
+      auto result = RunFetchTask(jobConfig, userInfo, cursor, flat);
+      state.RequestRedraw();
+      return result;
+  }) {}
 
 FetchWindow::~FetchWindow() = default;
 
@@ -199,14 +211,14 @@ bool FetchWindow::RenderFrame(GuiState& state) {
                 FetchIsNewUser = true;
             }
 
-            FetchTask.Engage(&state.JobConf, userInfoToFetch, FetchTaskOffset, FlatCheckbox);
+            FetchTask.Engage(&state.JobConf, userInfoToFetch, FetchTaskCursor, FlatCheckbox);
         }
     }
 
     if (FetchTask.ResultAvailable()) {
         auto rv = FetchTask.FetchResultAndDisengage();
         if (rv.Success && !rv.Videos.empty()) {
-            FetchTaskOffset += rv.VideoCountThisFetch;
+            FetchTaskCursor = std::move(rv.NextCursor);
             for (auto& v : rv.Videos) {
                 FetchedItems.push_back(std::move(v));
             }
@@ -215,10 +227,13 @@ bool FetchWindow::RenderFrame(GuiState& state) {
 
         if (rv.Success && FetchIsNewUser && SaveCheckbox && FetchTaskActiveUserInfo != nullptr) {
             // we need to save this to the presets
-            std::lock_guard lock(state.UserInfosLock);
-            state.UserInfos.push_back(FetchTaskActiveUserInfo->Clone());
-            SelectedPreset = (state.UserInfos.size() - 1);
-            FetchIsNewUser = false;
+            {
+                std::lock_guard lock(state.UserInfosLock);
+                state.UserInfos.push_back(FetchTaskActiveUserInfo->Clone());
+                SelectedPreset = (state.UserInfos.size() - 1);
+                FetchIsNewUser = false;
+            }
+            NotifyUserInfosChanged(state);
         }
 
         if (rv.Success && FetchTaskActiveUserInfo && FetchTaskActiveUserInfo->Persistable) {
@@ -230,7 +245,7 @@ bool FetchWindow::RenderFrame(GuiState& state) {
     if (ImGui::Button("Clear") && !FetchTask.Engaged()) {
         FetchedItems.clear();
         FetchTaskActiveUserInfo.reset();
-        FetchTaskOffset = 0;
+        FetchTaskCursor.clear();
         FetchHasMore = false;
         FetchIsNewUser = false;
     }
@@ -581,6 +596,7 @@ bool FetchWindow::RenderFrame(GuiState& state) {
             autoDownloadChanged = (autoDownloadPrevious != *autoDownloadFlagPtr);
         }
         if (autoDownloadChanged) {
+            NotifyUserInfosChanged(state);
             state.SaveThread->RequestSaveUsers();
         }
     }
@@ -38,10 +38,10 @@ private:
 
     std::vector<std::unique_ptr<IVideoInfo>> FetchedItems;
     std::unique_ptr<IUserInfo> FetchTaskActiveUserInfo;
-    size_t FetchTaskOffset = 0;
+    std::string FetchTaskCursor;
     bool FetchHasMore = false;
     bool FetchIsNewUser = false;
-    BackgroundTask<FetchReturnValue, JobConfig*, IUserInfo*, size_t, bool> FetchTask;
+    BackgroundTask<FetchReturnValue, JobConfig*, IUserInfo*, std::string, bool> FetchTask;
     TaskCancellation FetchTaskCancellation;
     TaskReportingFromThread FetchTaskReporting;
 
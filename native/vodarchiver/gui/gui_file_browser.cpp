@@ -10,10 +10,14 @@
 #include <optional>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "imgui.h"
 #include "misc/cpp/imgui_stdlib.h"
 
+#include "gui_directory_listing.h"
 #include "gui_state.h"
 #include "util/file.h"
 #include "util/scope.h"
@@ -31,20 +35,6 @@
 namespace VodArchiver::GUI {
 namespace {
 static constexpr size_t INVALID_INDEX = std::numeric_limits<size_t>::max();
-
-enum class FileEntryType : int {
-    GoUpDirectory = -2,
-    Drive = -1, // Windows only
-    Directory = 0,
-    File = 1,
-};
-
-struct FileEntry {
-    std::string Filename;
-    uint64_t Filesize;
-    FileEntryType Type;
-    int Id;
-};
 } // namespace
 
 struct FileBrowser::Impl {
@@ -60,9 +50,27 @@ struct FileBrowser::Impl {
     bool UseNativeDialogIfAvailable;
     bool LastDirectoryChangeByKeyboardOrController;
 
-    std::optional<std::vector<FileEntry>> FilesInCurrentDirectory;
+    // filled in the background, nullptr until the directory is requested
+    std::unique_ptr<DirectoryListing> Listing;
+    uint64_t ListingVersion;
+    bool ListingInitialSelectionDone;
+    std::shared_ptr<const std::vector<FileEntry>> FilesInCurrentDirectory;
+    std::unordered_map<std::string, uint64_t> FileSizes;
+    std::unordered_set<std::string> RequestedFileSizes;
     ImGuiSelectionBasicStorage SelectionStorage;
 
+    void ResetListing() {
+        Listing.reset();
+        ListingVersion = 0;
+        ListingInitialSelectionDone = false;
+        FilesInCurrentDirectory = std::make_shared<const std::vector<FileEntry>>();
+        FileSizes.clear();
+        RequestedFileSizes.clear();
+        SelectionStorage.Clear();
+    }
+
+    void ApplyListingSnapshot(std::shared_ptr<const std::vector<FileEntry>> entries);
+
     std::vector<std::string> SelectedPaths;
 };
 
@@ -114,20 +122,43 @@ void FileBrowser::Reset(FileBrowserMode mode,
         PImpl->CurrentFilterIndex = INVALID_INDEX;
     }
     PImpl->DefaultExtension = std::string(defaultExtension);
-    PImpl->FilesInCurrentDirectory.reset();
-    PImpl->SelectionStorage.Clear();
+    PImpl->ResetListing();
     PImpl->PromptForOverwrite = promptForOverwrite;
     PImpl->Multiselect = multiselect;
     PImpl->UseNativeDialogIfAvailable = !useCustomFileBrowser;
     PImpl->LastDirectoryChangeByKeyboardOrController = false;
 }
 
-static bool IsRoot(const std::filesystem::path& p) {
-#ifdef BUILD_FOR_WINDOWS
-    return p.empty();
-#else
-    return p == u8"/";
-#endif
+void FileBrowser::Impl::ApplyListingSnapshot(
+    std::shared_ptr<const std::vector<FileEntry>> entries) {
+    // entries may have been inserted anywhere, so carry the selection over by name
+    std::vector<FileEntry> selected;
+    void* it = nullptr;
+    ImGuiID id;
+    while (SelectionStorage.GetNextSelectedItem(&it, &id)) {
+        if (id < FilesInCurrentDirectory->size()) {
+            selected.push_back((*FilesInCurrentDirectory)[id]);
+        }
+    }
+    SelectionStorage.Clear();
+    FilesInCurrentDirectory = std::move(entries);
+    for (const FileEntry& e : selected) {
+        auto pos = std::lower_bound(
+            FilesInCurrentDirectory->begin(), FilesInCurrentDirectory->end(), e, FileEntryLess);
+        if (pos != FilesInCurrentDirectory->end() && pos->Filename == e.Filename) {
+            SelectionStorage.SetItemSelected((ImGuiID)pos->Id, true);
+        }
+    }
+
+    if (!ListingInitialSelectionDone && FilesInCurrentDirectory->size() > 0) {
+        ListingInitialSelectionDone = true;
+        SelectionStorage.SetItemSelected((ImGuiID)0, true);
+
+        if (LastDirectoryChangeByKeyboardOrController) {
+            Filename = (*FilesInCurrentDirectory)[0].Filename;
+        }
+        LastDirectoryChangeByKeyboardOrController = false;
+    }
 }
 
 FileBrowserResult FileBrowser::RenderFrame(GuiState& state, std::string_view title) {
@@ -366,86 +397,25 @@ FileBrowserResult FileBrowser::RenderFrame(GuiState& state, std::string_view tit
 #endif
     }
 
-    if (!PImpl->FilesInCurrentDirectory) {
+    if (!PImpl->Listing) {
         // fill files
-        PImpl->SelectionStorage.Clear();
-        PImpl->FilesInCurrentDirectory.emplace();
-
-        const bool isRoot = IsRoot(*PImpl->CurrentDirectory);
-        if (!isRoot) {
-            auto& upDir = PImpl->FilesInCurrentDirectory->emplace_back();
-            upDir.Filename = "..";
-            upDir.Filesize = 0;
-            upDir.Type = FileEntryType::GoUpDirectory;
-        }
-
-#ifdef BUILD_FOR_WINDOWS
-        if (isRoot) {
-            // On Windows we need to special-case the root and list the drives.
-            for (const std::string& drive : HyoutaUtils::IO::GetLogicalDrives()) {
-                auto& e = PImpl->FilesInCurrentDirectory->emplace_back();
-                e.Filename = drive;
-                e.Type = FileEntryType::Drive;
-                e.Filesize = static_cast<uint64_t>(0);
-            }
-        } else {
-#endif
-            std::error_code ec;
-            std::filesystem::directory_iterator it(*PImpl->CurrentDirectory, ec);
-            if (ec) {
-                // not sure what we do here?
-                return FileBrowserResult::Canceled;
-            }
-            while (it != std::filesystem::directory_iterator()) {
-                const bool isDirectory = it->is_directory(ec);
-                if (!ec) {
-                    std::string filename =
-                        HyoutaUtils::IO::FilesystemPathToUtf8(it->path().filename());
-                    if (isDirectory || PImpl->CurrentFilter.empty()
-                        || HyoutaUtils::TextUtils::CaseInsensitiveGlobMatches(
-                            filename, PImpl->CurrentFilter)) {
-                        auto& e = PImpl->FilesInCurrentDirectory->emplace_back();
-                        e.Filename = std::move(filename);
-                        e.Type = isDirectory ? FileEntryType::Directory : FileEntryType::File;
-                        e.Filesize = (e.Type == FileEntryType::File)
-                                         ? static_cast<uint64_t>(it->file_size(ec))
-                                         : static_cast<uint64_t>(0);
-                    }
-                }
-                it.increment(ec);
-                if (ec) {
-                    // not sure what we do here?
-                    return FileBrowserResult::Canceled;
-                }
-            }
-#ifdef BUILD_FOR_WINDOWS
+        PImpl->ResetListing();
+        PImpl->Listing = std::make_unique<DirectoryListing>(
+            *PImpl->CurrentDirectory, PImpl->CurrentFilter, [&state] { state.RequestRedraw(); });
+    }
+    {
+        DirectoryListing::Snapshot snapshot = PImpl->Listing->GetSnapshot();
+        if (snapshot.Failed) {
+            // not sure what we do here?
+            return FileBrowserResult::Canceled;
         }
-#endif
-
-        std::stable_sort(PImpl->FilesInCurrentDirectory->begin(),
-                         PImpl->FilesInCurrentDirectory->end(),
-                         [](const FileEntry& lhs, const FileEntry& rhs) {
-                             if (lhs.Type != rhs.Type) {
-                                 return lhs.Type < rhs.Type;
-                             }
-                             return HyoutaUtils::TextUtils::CaseInsensitiveCompare(lhs.Filename,
-                                                                                   rhs.Filename)
-                                    < 0;
-                         });
-
-        for (size_t i = 0; i < PImpl->FilesInCurrentDirectory->size(); ++i) {
-            (*PImpl->FilesInCurrentDirectory)[i].Id = static_cast<int>(i);
+        if (snapshot.Version != PImpl->ListingVersion) {
+            PImpl->ListingVersion = snapshot.Version;
+            PImpl->ApplyListingSnapshot(std::move(snapshot.Entries));
         }
-
-        if (PImpl->FilesInCurrentDirectory->size() > 0) {
-            PImpl->SelectionStorage.SetItemSelected((ImGuiID)0, true);
-
-            if (PImpl->LastDirectoryChangeByKeyboardOrController) {
-                PImpl->Filename = (*PImpl->FilesInCurrentDirectory)[0].Filename;
-            }
+        for (auto& size : PImpl->Listing->TakeFileSizes()) {
+            PImpl->FileSizes.insert_or_assign(std::move(size.first), size.second);
         }
-
-        PImpl->LastDirectoryChangeByKeyboardOrController = false;
     }
 
     bool double_clicked = false;
@@ -472,6 +442,7 @@ FileBrowserResult FileBrowser::RenderFrame(GuiState& state, std::string_view tit
         ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthStretch, 0.10f);
         ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthStretch, 0.20f);
 
+        std::vector<std::string> fileSizeRequests;
         ImGuiListClipper clipper;
         clipper.Begin(PImpl->FilesInCurrentDirectory->size());
         if (ms_io->RangeSrcItem != -1)
@@ -528,7 +499,13 @@ FileBrowserResult FileBrowser::RenderFrame(GuiState& state, std::string_view tit
                 ImGui::TextUnformatted(type.data(), type.data() + type.size());
                 ImGui::TableNextColumn();
                 if (entry.Type == FileEntryType::File) {
-                    ImGui::Text("%" PRIu64 " bytes", entry.Filesize);
+                    // only looked up for rows that are actually shown
+                    auto size = PImpl->FileSizes.find(entry.Filename);
+                    if (size != PImpl->FileSizes.end()) {
+                        ImGui::Text("%" PRIu64 " bytes", size->second);
+                    } else if (PImpl->RequestedFileSizes.insert(entry.Filename).second) {
+                        fileSizeRequests.push_back(entry.Filename);
+                    }
                 }
 
                 ImGui::PopID();
@@ -536,6 +513,7 @@ FileBrowserResult FileBrowser::RenderFrame(GuiState& state, std::string_view tit
         }
 
         ImGui::EndTable();
+        PImpl->Listing->RequestFileSizes(std::move(fileSizeRequests));
 
         // Apply multi-select requests
         ms_io = ImGui::EndMultiSelect();
@@ -573,7 +551,7 @@ FileBrowserResult FileBrowser::RenderFrame(GuiState& state, std::string_view tit
             if (ImGui::Selectable(PImpl->Filters[n].Name.c_str(), is_selected)) {
                 PImpl->CurrentFilter = PImpl->Filters[n].Filter;
                 PImpl->CurrentFilterIndex = n;
-                PImpl->FilesInCurrentDirectory.reset();
+                PImpl->ResetListing();
             }
             if (is_selected) {
                 ImGui::SetItemDefaultFocus();
@@ -607,7 +585,7 @@ FileBrowserResult FileBrowser::RenderFrame(GuiState& state, std::string_view tit
         if (PImpl->Filename == ".."
             && *PImpl->CurrentDirectory == PImpl->CurrentDirectory->root_path()) {
             PImpl->CurrentDirectory.emplace();
-            PImpl->FilesInCurrentDirectory.reset();
+            PImpl->ResetListing();
             PImpl->Filename.clear();
         } else {
 #endif
@@ -627,7 +605,7 @@ FileBrowserResult FileBrowser::RenderFrame(GuiState& state, std::string_view tit
                     if (fileStatus.type() == std::filesystem::file_type::directory) {
                         // enter this directory
                         PImpl->CurrentDirectory = std::move(path);
-                        PImpl->FilesInCurrentDirectory.reset();
+                        PImpl->ResetListing();
                         PImpl->Filename.clear();
                     } else {
                         // treat this as the result
@@ -649,7 +627,7 @@ FileBrowserResult FileBrowser::RenderFrame(GuiState& state, std::string_view tit
                 if (PImpl->Filename.find('*') != std::string::npos) {
                     PImpl->CurrentFilter = PImpl->Filename;
                     PImpl->CurrentFilterIndex = INVALID_INDEX;
-                    PImpl->FilesInCurrentDirectory.reset();
+                    PImpl->ResetListing();
                 }
             }
 #ifdef BUILD_FOR_WINDOWS
@@ -681,7 +659,7 @@ FileBrowserResult FileBrowser::RenderFrame(GuiState& state, std::string_view tit
 #ifdef BUILD_FOR_WINDOWS
                         }
 #endif
-                        PImpl->FilesInCurrentDirectory.reset();
+                        PImpl->ResetListing();
                         PImpl->Filename.clear();
                         PImpl->LastDirectoryChangeByKeyboardOrController = enter_pressed;
                     } else if (entry.Type == FileEntryType::Directory) {
@@ -690,14 +668,14 @@ FileBrowserResult FileBrowser::RenderFrame(GuiState& state, std::string_view tit
                             (*PImpl->CurrentDirectory)
                             / std::u8string_view((const char8_t*)entry.Filename.data(),
                                                  entry.Filename.size());
-                        PImpl->FilesInCurrentDirectory.reset();
+                        PImpl->ResetListing();
                         PImpl->Filename.clear();
                         PImpl->LastDirectoryChangeByKeyboardOrController = enter_pressed;
                     } else if (entry.Type == FileEntryType::Drive) {
                         // enter drive
                         PImpl->CurrentDirectory = std::u8string_view(
                             (const char8_t*)entry.Filename.data(), entry.Filename.size());
-                        PImpl->FilesInCurrentDirectory.reset();
+                        PImpl->ResetListing();
                         PImpl->Filename.clear();
                         PImpl->LastDirectoryChangeByKeyboardOrController = enter_pressed;
                     } else if (entry.Type == FileEntryType::File) {
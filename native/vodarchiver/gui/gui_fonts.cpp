@@ -1,9 +1,26 @@
 #include "gui_fonts.h"
 
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
 #include "imgui.h"
 
+#include "util/file.h"
+#include "util/hash/sha1.h"
+#include "util/thread.h"
+
 #include "gui_state.h"
 #include "vodarchiver/decompress_helper.h"
+#include "vodarchiver/log_buffer.h"
 
 namespace {
 static constexpr char CuprumFontData[] = {
@@ -17,14 +34,110 @@ static constexpr size_t NotoSansJpFontLength = sizeof(NotoSansJpFontData);
 } // namespace
 
 namespace VodArchiver {
+static std::optional<std::vector<char>> ReadFontCache(const std::string& path,
+                                                      const HyoutaUtils::Hash::SHA1& hash) {
+    HyoutaUtils::IO::File file(std::string_view(path), HyoutaUtils::IO::OpenMode::Read);
+    if (!file.IsOpen()) {
+        return std::nullopt;
+    }
+    auto length = file.GetLength();
+    if (!length || *length <= hash.Hash.size()) {
+        return std::nullopt;
+    }
+    std::array<char, 20> cachedHash;
+    if (file.Read(cachedHash.data(), cachedHash.size()) != cachedHash.size()
+        || cachedHash != hash.Hash) {
+        return std::nullopt;
+    }
+    std::vector<char> data(static_cast<size_t>(*length - hash.Hash.size()));
+    if (file.Read(data.data(), data.size()) != data.size()) {
+        return std::nullopt;
+    }
+    return data;
+}
+
+static void WriteFontCache(const std::string& path,
+                           const HyoutaUtils::Hash::SHA1& hash,
+                           const std::vector<char>& font) {
+    std::unique_ptr<char[]> data(new (std::nothrow) char[hash.Hash.size() + font.size()]);
+    if (!data) {
+        return;
+    }
+    std::memcpy(data.get(), hash.Hash.data(), hash.Hash.size());
+    std::memcpy(data.get() + hash.Hash.size(), font.data(), font.size());
+    HyoutaUtils::IO::WriteFileAtomic(
+        std::string_view(path), data.get(), hash.Hash.size() + font.size());
+}
+
+static std::optional<std::vector<char>>
+    LoadEmbeddedFont(std::string_view name,
+                     const char* embeddedData,
+                     size_t embeddedLength,
+                     const std::optional<std::string>& cacheFolder) {
+    const auto start = std::chrono::steady_clock::now();
+    std::string cachePath;
+    HyoutaUtils::Hash::SHA1 hash{};
+    std::optional<std::vector<char>> font;
+    if (cacheFolder) {
+        cachePath = *cacheFolder;
+        HyoutaUtils::IO::AppendPathElement(cachePath, std::format("{}.fontcache", name));
+        hash = HyoutaUtils::Hash::CalculateSHA1(embeddedData, embeddedLength);
+        font = ReadFontCache(cachePath, hash);
+    }
+    const bool fromCache = font.has_value();
+    if (!fromCache) {
+        font = SenLib::DecompressFromBuffer(embeddedData, embeddedLength);
+        if (font && cacheFolder) {
+            WriteFontCache(cachePath, hash, *font);
+        }
+    }
+
+    const auto duration = std::chrono::steady_clock::now() - start;
+    GetLogBuffer().Append(
+        LogSource::General,
+        LogSeverity::Info,
+        std::format("Startup: {} {} in {} ms",
+                    fromCache ? "Read cached" : "Decompressed",
+                    name,
+                    std::chrono::duration_cast<std::chrono::milliseconds>(duration).count()));
+    return font;
+}
+
+FontDataLoader::FontDataLoader(std::optional<std::string> cacheFolder)
+  : CacheFolder(std::move(cacheFolder)) {
+    Thread = std::thread(std::bind(&FontDataLoader::ThreadFunc, this));
+}
+
+FontDataLoader::~FontDataLoader() {
+    Wait();
+}
+
+void FontDataLoader::Wait() {
+    if (Thread.joinable()) {
+        Thread.join();
+    }
+}
+
+void FontDataLoader::ThreadFunc() {
+    HyoutaUtils::SetThreadName("FontDataLoader");
+    Cuprum = LoadEmbeddedFont("Cuprum", CuprumFontData, CuprumFontLength, CacheFolder);
+    NotoSansJp =
+        LoadEmbeddedFont("NotoSansJP", NotoSansJpFontData, NotoSansJpFontLength, CacheFolder);
+}
+
 void LoadFonts(ImGuiIO& io, GuiState& state) {
-    static std::optional<std::vector<char>> cuprum =
-        SenLib::DecompressFromBuffer(CuprumFontData, CuprumFontLength);
-    static std::optional<std::vector<char>> noto =
-        SenLib::DecompressFromBuffer(NotoSansJpFontData, NotoSansJpFontLength);
+    if (!state.FontData) {
+        state.FontData = std::make_unique<FontDataLoader>(std::nullopt);
+    }
+    state.FontData->Wait();
+    auto& cuprum = state.FontData->GetCuprum();
+    auto& noto = state.FontData->GetNotoSansJp();
 
     io.Fonts->Clear();
 
+    // glyphs are rasterized into the atlas the first time they're drawn, so there's no need to
+    // build anything here. this matters for the japanese font in particular, which has thousands
+    // of glyphs of which we usually need a handful.
     ImFontConfig config;
     config.FontDataOwnedByAtlas = false;
     if (cuprum) {
@@ -39,10 +152,7 @@ void LoadFonts(ImGuiIO& io, GuiState& state) {
         io.Fonts->AddFontFromMemoryTTF(noto->data(),
                                        static_cast<int>(noto->size()),
                                        static_cast<int>(20),
-                                       &config,
-                                       io.Fonts->GetGlyphRangesJapanese());
+                                       &config);
     }
-
-    io.Fonts->Build();
 }
 } // namespace VodArchiver
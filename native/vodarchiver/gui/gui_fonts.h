@@ -1,9 +1,46 @@
 #pragma once
 
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
 struct ImGuiIO;
 
 namespace VodArchiver {
 struct GuiState;
 
+// Gets the embedded fonts ready on a background thread, so that the LZMA decompression overlaps
+// with loading the job list. If a cache folder is given, the decompressed fonts are stored there
+// together with a hash of the embedded data, and later launches just read them back.
+struct FontDataLoader {
+    explicit FontDataLoader(std::optional<std::string> cacheFolder);
+    FontDataLoader(const FontDataLoader& other) = delete;
+    FontDataLoader(FontDataLoader&& other) = delete;
+    FontDataLoader& operator=(const FontDataLoader& other) = delete;
+    FontDataLoader& operator=(FontDataLoader&& other) = delete;
+    ~FontDataLoader();
+
+    // Blocks until the fonts are loaded. Only call from the thread that owns the loader.
+    void Wait();
+
+    // The data stays valid for as long as the loader exists. Call Wait() first.
+    std::optional<std::vector<char>>& GetCuprum() {
+        return Cuprum;
+    }
+    std::optional<std::vector<char>>& GetNotoSansJp() {
+        return NotoSansJp;
+    }
+
+private:
+    void ThreadFunc();
+
+    std::optional<std::string> CacheFolder;
+    std::optional<std::vector<char>> Cuprum;
+    std::optional<std::vector<char>> NotoSansJp;
+    std::thread Thread;
+};
+
+// Uses state.FontData if it has been created, otherwise loads the fonts on the spot.
 void LoadFonts(ImGuiIO& io, GuiState& state);
 } // namespace VodArchiver
@@ -0,0 +1,153 @@
+#include "gui_job_table_model.h"
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/thread.h"
+#include "vodarchiver/job_handling.h"
+#include "vodarchiver/time_types.h"
+#include "vodarchiver/trigram_index.h"
+#include "vodarchiver/videoinfo/i-video-info.h"
+#include "vodarchiver/videojobs/i-video-job.h"
+
+namespace VodArchiver::GUI {
+// how long jobs may go unobserved if nobody asks for an update explicitly
+static constexpr auto PollInterval = std::chrono::milliseconds(100);
+
+static std::shared_ptr<const JobTableRow> BuildRow(IVideoJob& job, uint32_t index) {
+    auto row = std::make_shared<JobTableRow>();
+    row->Job = &job;
+    row->Index = index;
+
+    std::lock_guard lock(job.DataLock);
+    row->JobVersion = job.Version.load(std::memory_order_acquire);
+    row->Status = job.JobStatus.load();
+    row->HasBeenValidated = job.HasBeenValidated;
+    row->Notes = job.Notes;
+    row->TextStatus = job.TextStatus;
+    if (IVideoInfo* vi = job.VideoInfo.get()) {
+        std::array<char, 256> buffer;
+        row->Service = vi->GetService();
+        row->VideoRecordingState = vi->GetVideoRecordingState();
+        row->Timestamp = vi->GetVideoTimestamp();
+        row->Duration = vi->GetVideoLength();
+        row->VideoId = std::string(vi->GetVideoId(buffer));
+        row->Username = std::string(vi->GetUsername(buffer));
+        row->Title = std::string(vi->GetVideoTitle(buffer));
+        row->Game = std::string(vi->GetVideoGame(buffer));
+    }
+
+    std::array<char, 24> buffer;
+    row->TimestampText = std::string(DateTimeToStringForGui(row->Timestamp, buffer));
+    row->DurationText = std::string(TimeSpanToStringForGui(row->Duration, buffer));
+    return row;
+}
+
+JobTableModel::JobTableModel(JobList& jobs, std::function<void()> onPublished)
+  : Jobs(jobs)
+  , OnPublished(std::move(onPublished))
+  , Snapshot(std::make_shared<const JobTableSnapshot>()) {
+    // publish the initial state right away so the first frame doesn't show an empty table
+    Update();
+    Thread = std::thread(std::bind(&JobTableModel::ThreadFunc, this));
+}
+
+JobTableModel::~JobTableModel() {
+    {
+        std::lock_guard lock(Mutex);
+        Finishing = true;
+    }
+    CondVar.notify_all();
+    Thread.join();
+}
+
+std::shared_ptr<const JobTableSnapshot> JobTableModel::GetSnapshot() const {
+    return Snapshot.load();
+}
+
+void JobTableModel::RequestUpdate() {
+    {
+        std::lock_guard lock(Mutex);
+        UpdateRequested = true;
+    }
+    CondVar.notify_all();
+}
+
+std::vector<uint32_t> JobTableModel::Search(std::string_view text) const {
+    std::shared_lock lock(SearchIndexLock);
+    return SearchIndex.Search(text);
+}
+
+void JobTableModel::ThreadFunc() {
+    HyoutaUtils::SetThreadName("JobTableModel");
+    while (true) {
+        {
+            std::unique_lock lock(Mutex);
+            CondVar.wait_for(lock, PollInterval, [&] { return UpdateRequested || Finishing; });
+            if (Finishing) {
+                return;
+            }
+            UpdateRequested = false;
+        }
+
+        Update();
+    }
+}
+
+void JobTableModel::Update() {
+    {
+        // the JobsLock is only needed to pick up new jobs
+        std::lock_guard lock(Jobs.JobsLock);
+        const size_t count = Jobs.JobsVector.size();
+        KnownJobs.reserve(count);
+        for (size_t i = KnownJobs.size(); i < count; ++i) {
+            KnownJobs.push_back(Jobs.JobsVector[i].get());
+        }
+    }
+
+    std::vector<uint32_t> changed;
+    Rows.reserve(KnownJobs.size());
+    for (size_t i = 0; i < KnownJobs.size(); ++i) {
+        IVideoJob& job = *KnownJobs[i];
+        if (i < Rows.size()) {
+            if (Rows[i]->JobVersion == job.Version.load(std::memory_order_acquire)) {
+                continue;
+            }
+            Rows[i] = BuildRow(job, static_cast<uint32_t>(i));
+        } else {
+            Rows.push_back(BuildRow(job, static_cast<uint32_t>(i)));
+        }
+        changed.push_back(static_cast<uint32_t>(i));
+    }
+
+    if (changed.empty() && LastSnapshotVersion != 0) {
+        return;
+    }
+
+    if (!changed.empty()) {
+        std::lock_guard lock(SearchIndexLock);
+        for (uint32_t i : changed) {
+            const JobTableRow& row = *Rows[i];
+            const std::array<std::string_view, 4> fields{
+                row.Username, row.VideoId, row.Title, row.Game};
+            SearchIndex.Set(i, fields);
+        }
+    }
+
+    auto snapshot = std::make_shared<JobTableSnapshot>();
+    snapshot->Version = ++LastSnapshotVersion;
+    snapshot->Rows = Rows;
+    Snapshot.store(std::move(snapshot));
+
+    if (OnPublished) {
+        OnPublished();
+    }
+}
+} // namespace VodArchiver::GUI
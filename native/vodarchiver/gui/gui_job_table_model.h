@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../time_types.h"
+#include "../trigram_index.h"
+#include "../videoinfo/i-video-info.h"
+#include "../videojobs/i-video-job.h"
+
+namespace VodArchiver {
+struct JobList;
+}
+
+namespace VodArchiver::GUI {
+// Everything the job table shows about a single job, copied out of the job so that the table can be
+// drawn, filtered and sorted without locking anything. Immutable once published.
+struct JobTableRow {
+    // Only for acting on the job, eg. enqueueing it. Reading its data still needs the DataLock.
+    IVideoJob* Job = nullptr;
+
+    uint32_t Index = 0;      // in JobList::JobsVector
+    uint64_t JobVersion = 0; // IVideoJob::Version this row was built from
+
+    StreamService Service = StreamService::Unknown;
+    VideoJobStatus Status = VideoJobStatus::NotStarted;
+    RecordingState VideoRecordingState = RecordingState::Unknown;
+    bool HasBeenValidated = false;
+    DateTime Timestamp{.Internal = 0};
+    TimeSpan Duration{.Ticks = 0};
+
+    std::string VideoId;
+    std::string Username;
+    std::string Title;
+    std::string Game;
+    std::string Notes;
+    std::string TextStatus;
+    std::string TimestampText;
+    std::string DurationText;
+};
+
+struct JobTableSnapshot {
+    // increases with every published snapshot
+    uint64_t Version = 0;
+
+    // one row per job, in the same order as JobList::JobsVector. rows that didn't change are shared
+    // with the previous snapshot
+    std::vector<std::shared_ptr<const JobTableRow>> Rows;
+};
+
+// Watches the JobList on a background thread and publishes a new JobTableSnapshot whenever a job is
+// added or changed. Only the rows of jobs whose Version changed are rebuilt.
+// This relies on the JobList never removing or reordering jobs, only appending new ones.
+struct JobTableModel {
+    // onPublished is called on the model thread after each new snapshot.
+    JobTableModel(JobList& jobs, std::function<void()> onPublished);
+    JobTableModel(const JobTableModel& other) = delete;
+    JobTableModel(JobTableModel&& other) = delete;
+    JobTableModel& operator=(const JobTableModel& other) = delete;
+    JobTableModel& operator=(JobTableModel&& other) = delete;
+    ~JobTableModel();
+
+    // The most recently published snapshot, never null. Doesn't wait for any job or the JobsLock.
+    std::shared_ptr<const JobTableSnapshot> GetSnapshot() const;
+
+    // Look for changes right away instead of at the next regular poll, eg. after the GUI changed a
+    // job itself.
+    void RequestUpdate();
+
+    // Indices of all jobs whose username, video ID, title or game contain the text, ignoring case.
+    // The index is updated before each snapshot is published, so it may already know about jobs or
+    // changes that the caller's snapshot doesn't have yet.
+    std::vector<uint32_t> Search(std::string_view text) const;
+
+private:
+    void ThreadFunc();
+    void Update();
+
+    JobList& Jobs;
+    std::function<void()> OnPublished;
+
+    // only accessed by the model thread
+    std::vector<IVideoJob*> KnownJobs;
+    std::vector<std::shared_ptr<const JobTableRow>> Rows;
+    uint64_t LastSnapshotVersion = 0;
+
+    std::atomic<std::shared_ptr<const JobTableSnapshot>> Snapshot;
+
+    mutable std::shared_mutex SearchIndexLock;
+    TrigramIndex SearchIndex;
+
+    std::mutex Mutex;
+    std::condition_variable CondVar;
+    bool UpdateRequested = false;
+    bool Finishing = false;
+    std::thread Thread;
+};
+} // namespace VodArchiver::GUI
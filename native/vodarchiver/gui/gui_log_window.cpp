@@ -2,28 +2,48 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iterator>
 #include <string>
 
 #include "imgui.h"
 
 #include "util/scope.h"
 
+#include "../log_buffer.h"
 #include "gui_state.h"
 #include "gui_window.h"
 #include "window_id_management.h"
 
 namespace VodArchiver::GUI {
+static void FormatLogRecord(std::string& out, const LogRecord& record) {
+    std::array<char, 24> timestamp;
+    std::format_to(std::back_inserter(out),
+                   "{} [{}] {}",
+                   DateTimeToStringForGui(record.Timestamp, timestamp),
+                   LogSourceToString(record.Source),
+                   record.Message);
+}
+
+static ImVec4 GetLogSeverityColor(LogSeverity severity) {
+    switch (severity) {
+        case LogSeverity::Warning: return ImVec4(1.0f, 0.8f, 0.3f, 1.0f);
+        case LogSeverity::Error: return ImVec4(1.0f, 0.4f, 0.4f, 1.0f);
+        default: return ImGui::GetStyle().Colors[ImGuiCol_Text];
+    }
+}
+
 void LogWindow::Cleanup(GuiState& state) {
-    state.WindowIdsSettingsWindow.ReturnId(WindowId);
+    state.WindowIdsLogWindow.ReturnId(WindowId);
 }
 
-LogWindow::LogWindow(GuiState& state, std::string logMessage)
-  : WindowId(GenerateWindowId(state.WindowIdsSettingsWindow,
+LogWindow::LogWindow(GuiState& state)
+  : WindowId(GenerateWindowId(state.WindowIdsLogWindow,
                               WindowIdString.data(),
                               WindowIdString.size(),
                               WindowTitle,
-                              sizeof(WindowTitle)))
-  , LogMessage(std::move(logMessage)) {}
+                              sizeof(WindowTitle))) {}
 
 LogWindow::~LogWindow() = default;
 
@@ -38,19 +58,61 @@ bool LogWindow::RenderFrame(GuiState& state) {
     }
 
     static constexpr char closeLabel[] = "Close";
+    static constexpr char copyLabel[] = "Copy All";
     auto closeTextSize = ImGui::CalcTextSize(closeLabel, nullptr, true);
     float closeButtonWidth = closeTextSize.x + (ImGui::GetStyle().FramePadding.x * 2.0f);
     float closeButtonHeight = closeTextSize.y + (ImGui::GetStyle().FramePadding.y * 2.0f);
 
-    ImGui::InputTextMultiline("##Text",
-                              LogMessage.data(),
-                              LogMessage.size() + 1,
-                              ImVec2(-FLT_MIN,
-                                     ImGui::GetContentRegionAvail().y
-                                         - (closeButtonHeight + ImGui::GetStyle().ItemSpacing.y)),
-                              ImGuiInputTextFlags_ReadOnly);
+    // records can be overwritten at any time, so only the visible ones are read, every frame
+    LogBuffer& buffer = GetLogBuffer();
+    const uint64_t begin = buffer.GetBegin();
+    const uint64_t end = buffer.GetEnd();
+    LogRecord record;
+    if (ImGui::BeginChild("##Log",
+                          ImVec2(-FLT_MIN,
+                                 ImGui::GetContentRegionAvail().y
+                                     - (closeButtonHeight + ImGui::GetStyle().ItemSpacing.y)),
+                          ImGuiChildFlags_FrameStyle,
+                          ImGuiWindowFlags_HorizontalScrollbar)) {
+        // keep following new records as long as the view is scrolled to the bottom
+        const bool atBottom = ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+
+        std::string line;
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(end - begin));
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                line.clear();
+                if (buffer.Read(begin + static_cast<uint64_t>(i), record) == LogReadResult::Ok) {
+                    FormatLogRecord(line, record);
+                    ImGui::PushStyleColor(ImGuiCol_Text, GetLogSeverityColor(record.Severity));
+                    ImGui::TextUnformatted(line.data(), line.data() + line.size());
+                    ImGui::PopStyleColor();
+                } else {
+                    ImGui::TextUnformatted("...");
+                }
+            }
+        }
+        clipper.End();
+
+        if (atBottom) {
+            ImGui::SetScrollHereY(1.0f);
+        }
+    }
+    ImGui::EndChild();
 
     {
+        if (ImGui::Button(copyLabel)) {
+            std::string text;
+            for (uint64_t i = begin; i < end; ++i) {
+                if (buffer.Read(i, record) == LogReadResult::Ok) {
+                    FormatLogRecord(text, record);
+                    text.push_back('\n');
+                }
+            }
+            ImGui::SetClipboardText(text.c_str());
+        }
+        ImGui::SameLine();
         ImGui::SetCursorPosX(ImGui::GetCursorPosX() + ImGui::GetContentRegionAvail().x
                              - closeButtonWidth);
         if (ImGui::Button(closeLabel)) {
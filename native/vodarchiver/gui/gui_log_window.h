@@ -2,7 +2,6 @@
 
 #include <array>
 #include <cstddef>
-#include <string>
 
 #include "gui_state.h"
 #include "gui_window.h"
@@ -10,7 +9,7 @@
 
 namespace VodArchiver::GUI {
 struct LogWindow : public VodArchiver::GUI::Window {
-    LogWindow(GuiState& state, std::string logMessage);
+    LogWindow(GuiState& state);
     LogWindow(const LogWindow& other) = delete;
     LogWindow(LogWindow&& other) = delete;
     LogWindow& operator=(const LogWindow& other) = delete;
@@ -24,7 +23,5 @@ private:
     static constexpr char WindowTitle[] = "Log";
     std::array<char, GetWindowIdBufferLength(sizeof(WindowTitle))> WindowIdString;
     size_t WindowId;
-
-    std::string LogMessage;
 };
 } // namespace VodArchiver::GUI
@@ -46,7 +46,25 @@ SettingsWindow::SettingsWindow(GuiState& state)
                      AbsoluteMinimumFreeSpace.size() - 1,
                      "{}",
                      state.GuiSettings.AbsoluteMinimumFreeSpaceBytes);
+    std::format_to_n(ReencodeParallelProcesses.data(),
+                     ReencodeParallelProcesses.size() - 1,
+                     "{}",
+                     state.GuiSettings.ReencodeParallelProcesses);
+    std::format_to_n(DiskIOSlotsPerDevice.data(),
+                     DiskIOSlotsPerDevice.size() - 1,
+                     "{}",
+                     state.GuiSettings.DiskIOSlotsPerDevice);
+    std::format_to_n(StallTimeoutMinutes.data(),
+                     StallTimeoutMinutes.size() - 1,
+                     "{}",
+                     state.GuiSettings.StallTimeoutMinutes);
+    std::format_to_n(ControlServerPort.data(),
+                     ControlServerPort.size() - 1,
+                     "{}",
+                     state.GuiSettings.ControlServerPort);
     UseCustomPersistentDataLocation = state.GuiSettings.UseCustomPersistentDataPath;
+    WriteLogFile = state.GuiSettings.WriteLogFile;
+    SaveJobsAsSnapshot = state.GuiSettings.SaveJobsAsSnapshot;
 }
 
 SettingsWindow::~SettingsWindow() = default;
@@ -158,6 +176,69 @@ bool SettingsWindow::RenderFrame(GuiState& state) {
             AbsoluteMinimumFreeSpaceEdited = true;
         }
 
+        ImGui::TableNextColumn();
+        ImGui::AlignTextToFramePadding();
+        ImGui::TextUnformatted("Parallel Reencode Processes:");
+        ImGui::TableNextColumn();
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        if (ImGui::InputText("##ReencodeParallelProcesses",
+                             ReencodeParallelProcesses.data(),
+                             ReencodeParallelProcesses.size(),
+                             ImGuiInputTextFlags_ElideLeft)) {
+            ReencodeParallelProcessesEdited = true;
+        }
+
+        ImGui::TableNextColumn();
+        ImGui::AlignTextToFramePadding();
+        ImGui::TextUnformatted("Disk IO Operations per Drive:");
+        ImGui::TableNextColumn();
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        if (ImGui::InputText("##DiskIOSlotsPerDevice",
+                             DiskIOSlotsPerDevice.data(),
+                             DiskIOSlotsPerDevice.size(),
+                             ImGuiInputTextFlags_ElideLeft)) {
+            DiskIOSlotsPerDeviceEdited = true;
+        }
+
+        ImGui::TableNextColumn();
+        ImGui::AlignTextToFramePadding();
+        ImGui::TextUnformatted("Stall Timeout (minutes, 0 = off):");
+        ImGui::TableNextColumn();
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        if (ImGui::InputText("##StallTimeoutMinutes",
+                             StallTimeoutMinutes.data(),
+                             StallTimeoutMinutes.size(),
+                             ImGuiInputTextFlags_ElideLeft)) {
+            StallTimeoutMinutesEdited = true;
+        }
+
+        ImGui::TableNextColumn();
+        ImGui::AlignTextToFramePadding();
+        ImGui::TextUnformatted("Control/Metrics Port (0 = off, needs restart):");
+        ImGui::TableNextColumn();
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        if (ImGui::InputText("##ControlServerPort",
+                             ControlServerPort.data(),
+                             ControlServerPort.size(),
+                             ImGuiInputTextFlags_ElideLeft)) {
+            ControlServerPortEdited = true;
+        }
+
+        ImGui::TableNextColumn();
+        ImGui::TableNextColumn();
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        if (ImGui::Checkbox("Write Log to File (needs restart)", &WriteLogFile)) {
+            WriteLogFileEdited = true;
+        }
+
+        ImGui::TableNextColumn();
+        ImGui::TableNextColumn();
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        if (ImGui::Checkbox("Save Job List as Binary Snapshot (faster startup)",
+                            &SaveJobsAsSnapshot)) {
+            SaveJobsAsSnapshotEdited = true;
+        }
+
         ImGui::EndTable();
     }
 
@@ -215,17 +296,46 @@ bool SettingsWindow::RenderFrame(GuiState& state) {
                     state.GuiSettings.AbsoluteMinimumFreeSpaceBytes = *p;
                 }
             }
+            if (ReencodeParallelProcessesEdited) {
+                auto p = HyoutaUtils::NumberUtils::ParseUInt32(
+                    HyoutaUtils::TextUtils::StripToNull(ReencodeParallelProcesses));
+                if (p && *p >= 1) {
+                    state.GuiSettings.ReencodeParallelProcesses = *p;
+                }
+            }
+            if (DiskIOSlotsPerDeviceEdited) {
+                auto p = HyoutaUtils::NumberUtils::ParseUInt32(
+                    HyoutaUtils::TextUtils::StripToNull(DiskIOSlotsPerDevice));
+                if (p && *p >= 1) {
+                    state.GuiSettings.DiskIOSlotsPerDevice = *p;
+                }
+            }
+            if (StallTimeoutMinutesEdited) {
+                auto p = HyoutaUtils::NumberUtils::ParseUInt32(
+                    HyoutaUtils::TextUtils::StripToNull(StallTimeoutMinutes));
+                if (p) {
+                    state.GuiSettings.StallTimeoutMinutes = *p;
+                }
+            }
+            if (ControlServerPortEdited) {
+                auto p = HyoutaUtils::NumberUtils::ParseUInt32(
+                    HyoutaUtils::TextUtils::StripToNull(ControlServerPort));
+                if (p && *p <= 65535) {
+                    state.GuiSettings.ControlServerPort = *p;
+                }
+            }
+            if (WriteLogFileEdited) {
+                state.GuiSettings.WriteLogFile = WriteLogFile;
+            }
+            if (SaveJobsAsSnapshotEdited) {
+                state.GuiSettings.SaveJobsAsSnapshot = SaveJobsAsSnapshot;
+            }
 
-            std::lock_guard lock(state.JobConf.Mutex);
-            state.JobConf.TargetFolderPath = GetTargetFolderPath(state.GuiSettings);
-            state.JobConf.TempFolderPath = GetTempFolderPath(state.GuiSettings);
-            state.JobConf.TwitchClientId = state.GuiSettings.TwitchClientId;
-            state.JobConf.TwitchClientSecret = state.GuiSettings.TwitchClientSecret;
-            state.JobConf.VodXmlPath = GetVodXmlPath(state.GuiSettings);
-            state.JobConf.UserInfoXmlPath = GetUserInfoXmlPath(state.GuiSettings);
-            state.JobConf.MinimumFreeSpaceBytes = state.GuiSettings.MinimumFreeSpaceBytes;
-            state.JobConf.AbsoluteMinimumFreeSpaceBytes =
-                state.GuiSettings.AbsoluteMinimumFreeSpaceBytes;
+            ApplyUserSettingsToJobConfig(state.GuiSettings, state.JobConf);
+            if (SaveJobsAsSnapshotEdited && state.SaveThread) {
+                // rewrite the job list in the new format right away
+                state.SaveThread->RequestSaveJobs();
+            }
 
             open = false;
         }
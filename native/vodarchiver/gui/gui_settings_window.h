@@ -32,7 +32,13 @@ private:
     std::array<char, 128> TwitchClientSecret{};
     std::array<char, 24> MinimumFreeSpace{};
     std::array<char, 24> AbsoluteMinimumFreeSpace{};
+    std::array<char, 24> ReencodeParallelProcesses{};
+    std::array<char, 24> DiskIOSlotsPerDevice{};
+    std::array<char, 24> StallTimeoutMinutes{};
+    std::array<char, 24> ControlServerPort{};
     bool UseCustomPersistentDataLocation = false;
+    bool WriteLogFile = false;
+    bool SaveJobsAsSnapshot = false;
 
     bool TargetFolderPathEdited = false;
     bool TempFolderPathEdited = false;
@@ -42,5 +48,11 @@ private:
     bool TwitchClientSecretEdited = false;
     bool MinimumFreeSpaceEdited = false;
     bool AbsoluteMinimumFreeSpaceEdited = false;
+    bool ReencodeParallelProcessesEdited = false;
+    bool DiskIOSlotsPerDeviceEdited = false;
+    bool StallTimeoutMinutesEdited = false;
+    bool ControlServerPortEdited = false;
+    bool WriteLogFileEdited = false;
+    bool SaveJobsAsSnapshotEdited = false;
 };
 } // namespace VodArchiver::GUI
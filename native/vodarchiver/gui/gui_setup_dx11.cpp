@@ -234,9 +234,32 @@ int VodArchiver::RunGuiDX11(
     g_WindowMoved = true; // init the DPI and style stuff
 
     // Main loop
+    // Only draws while something happens: on input, when another thread requests a redraw, and at
+    // a low rate when idle. Otherwise the thread sleeps in MsgWaitForMultipleObjectsEx().
     state.CurrentDpi = -1.0f;
+    state.SetRenderLoopWakeFunction([hwnd] { ::PostMessageW(hwnd, WM_NULL, 0, 0); });
+    int extraFrames = FramesAfterInput;
     bool done = false;
     while (!done) {
+        if (extraFrames > 0) {
+            --extraFrames;
+            state.ConsumeRedrawRequest();
+        } else {
+            const double timeout = (io.BackendFlags & ImGuiBackendFlags_HasGamepad) != 0
+                                       ? GamepadPollIntervalSeconds
+                                       : IdleRedrawIntervalSeconds;
+            const DWORD result = ::MsgWaitForMultipleObjectsEx(0,
+                                                               nullptr,
+                                                               static_cast<DWORD>(timeout * 1000.0),
+                                                               QS_ALLINPUT,
+                                                               MWMO_INPUTAVAILABLE);
+            const bool redrawRequested = state.ConsumeRedrawRequest();
+            if (result == WAIT_OBJECT_0 && !redrawRequested) {
+                // there's a message and it's not (only) our wakeup, so this was input
+                extraFrames = FramesAfterInput - 1;
+            }
+        }
+
         // Poll and handle messages (inputs, window resize, etc.)
         // See the WndProc() function below for our to dispatch events to the Win32 backend.
         MSG msg;
@@ -252,7 +275,8 @@ int VodArchiver::RunGuiDX11(
         // Handle window being minimized or screen locked
         if (g_SwapChainOccluded
             && g_pSwapChain->Present(0, DXGI_PRESENT_TEST) == DXGI_STATUS_OCCLUDED) {
-            ::Sleep(10);
+            // nothing to draw, wait for the next message
+            extraFrames = 0;
             continue;
         }
         g_SwapChainOccluded = false;
@@ -315,6 +339,11 @@ int VodArchiver::RunGuiDX11(
             io.WantSaveIniSettings = false;
         }
 
+        // keep drawing while the user is dragging something or typing
+        if (ImGui::IsAnyItemActive() && extraFrames == 0) {
+            extraFrames = 1;
+        }
+
         // Rendering
         ImGui::Render();
         const float clear_color_with_alpha[4] = {backgroundColor.x * backgroundColor.w,
@@ -331,6 +360,7 @@ int VodArchiver::RunGuiDX11(
         g_SwapChainOccluded = (hr == DXGI_STATUS_OCCLUDED);
     }
 
+    state.SetRenderLoopWakeFunction(nullptr);
     saveIniCallback(io, state);
 
     // Cleanup
@@ -511,6 +511,10 @@ int VodArchiver::RunGuiGlfwVulkan(
     state.CurrentDpi = -1.0f; // init the DPI and style stuff
 
     // Main loop
+    // Only draws while something happens: on input, when another thread requests a redraw, and at
+    // a low rate when idle. Otherwise the thread sleeps in glfwWaitEventsTimeout().
+    state.SetRenderLoopWakeFunction([] { glfwPostEmptyEvent(); });
+    int extraFrames = FramesAfterInput;
     while (!glfwWindowShouldClose(window)) {
         // Poll and handle events (inputs, window resize, etc.)
         // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui
@@ -521,7 +525,22 @@ int VodArchiver::RunGuiGlfwVulkan(
         // application, or clear/overwrite your copy of the keyboard data. Generally you may always
         // pass all inputs to dear imgui, and hide them from your application based on those two
         // flags.
-        glfwPollEvents();
+        if (extraFrames > 0) {
+            --extraFrames;
+            glfwPollEvents();
+            state.ConsumeRedrawRequest();
+        } else {
+            const double timeout = (io.BackendFlags & ImGuiBackendFlags_HasGamepad) != 0
+                                       ? GamepadPollIntervalSeconds
+                                       : IdleRedrawIntervalSeconds;
+            const double waitStart = glfwGetTime();
+            glfwWaitEventsTimeout(timeout);
+            const bool redrawRequested = state.ConsumeRedrawRequest();
+            if (!redrawRequested && (glfwGetTime() - waitStart) < timeout) {
+                // woke up early without anyone asking for it, so this was input
+                extraFrames = FramesAfterInput - 1;
+            }
+        }
 
         // Resize swap chain?
         int fb_width, fb_height;
@@ -543,7 +562,8 @@ int VodArchiver::RunGuiGlfwVulkan(
             g_SwapChainRebuild = false;
         }
         if (glfwGetWindowAttrib(window, GLFW_ICONIFIED) != 0) {
-            ImGui_ImplGlfw_Sleep(10);
+            // nothing to draw, wait for the next event
+            extraFrames = 0;
             continue;
         }
         float newDpiX = 0.0f;
@@ -581,6 +601,11 @@ int VodArchiver::RunGuiGlfwVulkan(
             io.WantSaveIniSettings = false;
         }
 
+        // keep drawing while the user is dragging something or typing
+        if (ImGui::IsAnyItemActive() && extraFrames == 0) {
+            extraFrames = 1;
+        }
+
         // Rendering
         ImGui::Render();
         ImDrawData* draw_data = ImGui::GetDrawData();
@@ -596,6 +621,7 @@ int VodArchiver::RunGuiGlfwVulkan(
         }
     }
 
+    state.SetRenderLoopWakeFunction(nullptr);
     saveIniCallback(io, state);
 
     // Cleanup
@@ -1,5 +1,7 @@
 #include "gui_state.h"
 
+#include <functional>
+#include <mutex>
 #include <vector>
 
 #include "gui_window.h"
@@ -8,5 +10,25 @@
 #include "../videojobs/i-video-job.h"
 
 namespace VodArchiver {
+void GuiState::RequestRedraw() {
+    if (RedrawRequested.exchange(true, std::memory_order_acq_rel)) {
+        // the loop hasn't picked up the previous request yet, it will see this one too
+        return;
+    }
+    std::lock_guard lock(RenderLoopWakeLock);
+    if (RenderLoopWake) {
+        RenderLoopWake();
+    }
+}
+
+bool GuiState::ConsumeRedrawRequest() {
+    return RedrawRequested.exchange(false, std::memory_order_acq_rel);
+}
+
+void GuiState::SetRenderLoopWakeFunction(std::function<void()> wake) {
+    std::lock_guard lock(RenderLoopWakeLock);
+    RenderLoopWake = std::move(wake);
+}
+
 GuiState::~GuiState() = default;
 } // namespace VodArchiver
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -7,12 +9,16 @@
 
 #include "imgui.h"
 
+#include "../background_save_thread.h"
+#include "../control_server.h"
 #include "../job_config.h"
 #include "../job_handling.h"
+#include "../log_buffer.h"
 #include "../task_cancellation.h"
 #include "../tasks/fetch-task-group.h"
 #include "../tasks/video-task-group.h"
-#include "background_save_thread.h"
+#include "gui_fonts.h"
+#include "gui_job_table_model.h"
 #include "gui_user_settings.h"
 #include "window_id_management.h"
 
@@ -24,6 +30,16 @@ namespace VodArchiver {
 struct IVideoJob;
 struct IUserInfo;
 
+// The longest the render loop sleeps when nothing happens, so that progress text still moves.
+static constexpr double IdleRedrawIntervalSeconds = 0.5;
+
+// Gamepads don't generate events, so while one is connected the loop has to poll it this often.
+static constexpr double GamepadPollIntervalSeconds = 1.0 / 30.0;
+
+// Frames drawn after input before the render loop sleeps again. imgui sometimes needs a few frames
+// to settle, eg. for popups opening or hover states.
+static constexpr int FramesAfterInput = 3;
+
 struct GuiState {
     // A Window may add new windows to this vector at any time, but not remove or modify any.
     std::vector<std::unique_ptr<GUI::Window>> Windows;
@@ -40,8 +56,14 @@ struct GuiState {
 
     float CurrentDpi = 0.0f;
 
+    // Started early during startup, consumed by LoadFonts().
+    std::unique_ptr<FontDataLoader> FontData;
+
     JobList Jobs;
 
+    // What the main window shows of the Jobs, updated in the background.
+    std::unique_ptr<GUI::JobTableModel> JobTable;
+
     std::recursive_mutex UserInfosLock;
     std::vector<std::unique_ptr<IUserInfo>> UserInfos;
 
@@ -51,11 +73,30 @@ struct GuiState {
 
     VodArchiver::JobConfig JobConf;
 
-    std::recursive_mutex FetchTaskStatusMessageLock;
-    std::string FetchTaskStatusMessages;
+    std::unique_ptr<VodArchiver::BackgroundSaveThread> SaveThread;
+    std::unique_ptr<VodArchiver::ControlServer> Control;
 
-    std::unique_ptr<VodArchiver::GUI::BackgroundSaveThread> SaveThread;
+    // Copies the log to disk if enabled in the settings.
+    std::unique_ptr<VodArchiver::LogFileWriter> LogWriter;
+
+    // The render loop sleeps while nothing happens. Anything that changes what the GUI shows from
+    // outside of the GUI thread should call RequestRedraw(). It's cheap, and repeated requests
+    // before the next frame are coalesced into one wakeup. Changes that nobody reports still show
+    // up with the next idle redraw.
+    void RequestRedraw();
+
+    // For the render loop: Returns whether a redraw was requested since the last call.
+    bool ConsumeRedrawRequest();
+
+    // For the render loop: Sets how to interrupt its wait from another thread. Pass nullptr when
+    // the loop ends.
+    void SetRenderLoopWakeFunction(std::function<void()> wake);
 
     ~GuiState();
+
+private:
+    std::atomic<bool> RedrawRequested = false;
+    std::mutex RenderLoopWakeLock;
+    std::function<void()> RenderLoopWake;
 };
 } // namespace VodArchiver
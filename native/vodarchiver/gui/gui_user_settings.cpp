@@ -3,12 +3,14 @@
 #include <algorithm>
 #include <array>
 #include <filesystem>
+#include <mutex>
 #include <span>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include "../common_paths.h"
+#include "../job_config.h"
 
 #include "util/file.h"
 #include "util/ini.h"
@@ -107,6 +109,36 @@ bool LoadUserSettingsFromIni(GuiUserSettings& settings, const HyoutaUtils::Ini::
             HyoutaUtils::NumberUtils::ParseUInt64(absMinimumFreeSpaceBytes->Value)
                 .value_or(52428800u);
     }
+    auto* reencodeParallelProcesses = ini.FindValue("VodArchiver", "ReencodeParallelProcesses");
+    if (reencodeParallelProcesses) {
+        settings.ReencodeParallelProcesses =
+            HyoutaUtils::NumberUtils::ParseUInt32(reencodeParallelProcesses->Value).value_or(1);
+    }
+    auto* diskIOSlotsPerDevice = ini.FindValue("VodArchiver", "DiskIOSlotsPerDevice");
+    if (diskIOSlotsPerDevice) {
+        settings.DiskIOSlotsPerDevice =
+            HyoutaUtils::NumberUtils::ParseUInt32(diskIOSlotsPerDevice->Value).value_or(1);
+    }
+    auto* stallTimeoutMinutes = ini.FindValue("VodArchiver", "StallTimeoutMinutes");
+    if (stallTimeoutMinutes) {
+        settings.StallTimeoutMinutes =
+            HyoutaUtils::NumberUtils::ParseUInt32(stallTimeoutMinutes->Value).value_or(30);
+    }
+    auto* controlServerPort = ini.FindValue("VodArchiver", "ControlServerPort");
+    if (controlServerPort) {
+        auto port = HyoutaUtils::NumberUtils::ParseUInt32(controlServerPort->Value);
+        settings.ControlServerPort = (port && *port <= 65535) ? *port : 0;
+    }
+    auto* writeLogFile = ini.FindValue("VodArchiver", "WriteLogFile");
+    if (writeLogFile) {
+        settings.WriteLogFile =
+            HyoutaUtils::TextUtils::CaseInsensitiveEquals(writeLogFile->Value, "true");
+    }
+    auto* saveJobsAsSnapshot = ini.FindValue("VodArchiver", "SaveJobsAsSnapshot");
+    if (saveJobsAsSnapshot) {
+        settings.SaveJobsAsSnapshot =
+            HyoutaUtils::TextUtils::CaseInsensitiveEquals(saveJobsAsSnapshot->Value, "true");
+    }
     return true;
 }
 
@@ -144,6 +176,12 @@ bool WriteUserSettingsToIni(const GuiUserSettings& settings, HyoutaUtils::Ini::I
     ini.SetUInt64("VodArchiver", "MinimumFreeSpaceBytes", settings.MinimumFreeSpaceBytes);
     ini.SetUInt64(
         "VodArchiver", "AbsoluteMinimumFreeSpaceBytes", settings.AbsoluteMinimumFreeSpaceBytes);
+    ini.SetUInt64("VodArchiver", "ReencodeParallelProcesses", settings.ReencodeParallelProcesses);
+    ini.SetUInt64("VodArchiver", "DiskIOSlotsPerDevice", settings.DiskIOSlotsPerDevice);
+    ini.SetUInt64("VodArchiver", "StallTimeoutMinutes", settings.StallTimeoutMinutes);
+    ini.SetUInt64("VodArchiver", "ControlServerPort", settings.ControlServerPort);
+    ini.SetBool("VodArchiver", "WriteLogFile", settings.WriteLogFile);
+    ini.SetBool("VodArchiver", "SaveJobsAsSnapshot", settings.SaveJobsAsSnapshot);
     return true;
 }
 
@@ -187,7 +225,28 @@ std::string GetVodXmlPath(const GuiUserSettings& settings) {
     return GetPersistentDataPath(settings, "downloads.bin");
 }
 
+std::string GetVodSnapshotPath(const GuiUserSettings& settings) {
+    return GetPersistentDataPath(settings, "downloads.snapshot");
+}
+
 std::string GetUserInfoXmlPath(const GuiUserSettings& settings) {
     return GetPersistentDataPath(settings, "users.xml");
 }
+
+void ApplyUserSettingsToJobConfig(const GuiUserSettings& settings, JobConfig& jobConfig) {
+    std::lock_guard lock(jobConfig.Mutex);
+    jobConfig.TargetFolderPath = GetTargetFolderPath(settings);
+    jobConfig.TempFolderPath = GetTempFolderPath(settings);
+    jobConfig.TwitchClientId = settings.TwitchClientId;
+    jobConfig.TwitchClientSecret = settings.TwitchClientSecret;
+    jobConfig.VodXmlPath = GetVodXmlPath(settings);
+    jobConfig.VodSnapshotPath = GetVodSnapshotPath(settings);
+    jobConfig.UserInfoXmlPath = GetUserInfoXmlPath(settings);
+    jobConfig.SaveJobsAsSnapshot = settings.SaveJobsAsSnapshot;
+    jobConfig.MinimumFreeSpaceBytes = settings.MinimumFreeSpaceBytes;
+    jobConfig.AbsoluteMinimumFreeSpaceBytes = settings.AbsoluteMinimumFreeSpaceBytes;
+    jobConfig.ReencodeParallelProcesses = settings.ReencodeParallelProcesses;
+    jobConfig.StallTimeoutMinutes = settings.StallTimeoutMinutes;
+    jobConfig.ExpensiveDiskIO.SetDefaultSlotsPerDevice(settings.DiskIOSlotsPerDevice);
+}
 } // namespace VodArchiver
@@ -10,6 +10,8 @@ struct IniWriter;
 } // namespace HyoutaUtils::Ini
 
 namespace VodArchiver {
+struct JobConfig;
+
 enum class GuiUserSettings_UseCustomFileBrowser : uint8_t {
     Auto,
     Always,
@@ -31,7 +33,13 @@ struct GuiUserSettings {
     std::string TwitchClientSecret;
     uint64_t MinimumFreeSpaceBytes = 5368709120u;
     uint64_t AbsoluteMinimumFreeSpaceBytes = 52428800u;
+    uint32_t ReencodeParallelProcesses = 1;
+    uint32_t DiskIOSlotsPerDevice = 1;
+    uint32_t StallTimeoutMinutes = 30;
+    uint32_t ControlServerPort = 0; // 0 to not run the control server
     bool UseCustomPersistentDataPath = false;
+    bool WriteLogFile = false;
+    bool SaveJobsAsSnapshot = false; // see JobSnapshot, older versions can only read the XML
 };
 
 void InitGuiUserSettings(GuiUserSettings& settings);
@@ -46,5 +54,9 @@ const std::string& GetTempFolderPath(const GuiUserSettings& settings);
 const std::string& GetPersistentDataPath(const GuiUserSettings& settings);
 std::string GetPersistentDataPath(const GuiUserSettings& settings, std::string_view file);
 std::string GetVodXmlPath(const GuiUserSettings& settings);
+std::string GetVodSnapshotPath(const GuiUserSettings& settings);
 std::string GetUserInfoXmlPath(const GuiUserSettings& settings);
+
+// Copies everything the jobs care about over to the JobConfig, takes the JobConfig::Mutex.
+void ApplyUserSettingsToJobConfig(const GuiUserSettings& settings, JobConfig& jobConfig);
 } // namespace VodArchiver
@@ -16,6 +16,7 @@
 #include "imgui.h"
 
 #include "gui_fetch_window.h"
+#include "gui_job_table_model.h"
 #include "gui_log_window.h"
 #include "gui_settings_window.h"
 #include "gui_state.h"
@@ -27,11 +28,70 @@
 #include "util/system.h"
 #include "util/text.h"
 #include "vodarchiver/common_paths.h"
+#include "vodarchiver/disk_lock.h"
+#include "vodarchiver/job_progress.h"
+#include "vodarchiver/log_buffer.h"
 #include "vodarchiver/videojobs/i-video-job.h"
 #include "vodarchiver_imgui_utils.h"
 #include "vodarchiver_version.h"
 
 namespace VodArchiver::GUI {
+enum ColumnIDs {
+    ColumnID_Index = 0,
+    ColumnID_Valid,
+    ColumnID_Service,
+    ColumnID_VideoID,
+    ColumnID_Username,
+    ColumnID_Title,
+    ColumnID_Game,
+    ColumnID_Timestamp,
+    ColumnID_Duration,
+    ColumnID_RecordingState,
+    ColumnID_Notes,
+    ColumnID_Status,
+    ColumnID_Actions,
+    ColumnIDCount
+};
+
+// Strict weak ordering of two rows by a single column, for sorting the table.
+static bool RowLess(const JobTableRow& lhs, const JobTableRow& rhs, int columnId) {
+    switch (columnId) {
+        case ColumnID_Index: return lhs.Index < rhs.Index;
+        case ColumnID_Service: return lhs.Service < rhs.Service;
+        case ColumnID_VideoID: return lhs.VideoId < rhs.VideoId;
+        case ColumnID_Username: return lhs.Username < rhs.Username;
+        case ColumnID_Title: return lhs.Title < rhs.Title;
+        case ColumnID_Game: return lhs.Game < rhs.Game;
+        case ColumnID_Timestamp: return lhs.Timestamp < rhs.Timestamp;
+        case ColumnID_Duration: return lhs.Duration < rhs.Duration;
+        case ColumnID_RecordingState: return lhs.VideoRecordingState < rhs.VideoRecordingState;
+        case ColumnID_Notes: return lhs.Notes < rhs.Notes;
+        case ColumnID_Status: return lhs.Status < rhs.Status;
+        default: return false;
+    }
+}
+
+// Full ordering of the rows for the given sort spec. Rows that are equal in all sorted columns keep
+// their job order, so that the result doesn't depend on the order rows were inserted in.
+template<typename SortSpecT>
+static bool ItemLess(const SortSpecT& sortSpec, const JobTableRow& lhs, const JobTableRow& rhs) {
+    for (const auto& key : sortSpec) {
+        if (RowLess(lhs, rhs, key.ColumnId)) {
+            return !key.Descending;
+        }
+        if (RowLess(rhs, lhs, key.ColumnId)) {
+            return key.Descending;
+        }
+    }
+    return lhs.Index < rhs.Index;
+}
+
+// Below this many rows a rebuild isn't worth starting threads for.
+static constexpr size_t MinRowsPerRebuildThread = 4096;
+
+// Up to this many changed rows are inserted one by one, more are sorted and merged in as a batch.
+static constexpr size_t MaxSingleInsertRows = 16;
+
 VodArchiverMainWindow::VodArchiverMainWindow() {
     // turn off finished/dead by default
     FilterJobStatus |= static_cast<uint32_t>(1u << static_cast<uint32_t>(VideoJobStatus::Finished));
@@ -120,7 +180,7 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
                 } else {
                     FilterStreamService |= static_cast<uint32_t>(1u << i);
                 }
-                ItemsNeedFilter = true;
+                ItemsNeedRebuild = true;
             }
             ImGui::PopID();
         }
@@ -139,7 +199,7 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
                 } else {
                     FilterJobStatus |= static_cast<uint32_t>(1u << i);
                 }
-                ItemsNeedFilter = true;
+                ItemsNeedRebuild = true;
             }
             ImGui::PopID();
         }
@@ -151,7 +211,7 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
     ImGui::SameLine();
 
     if (ImGui::InputText("##FilterString", FilterTextfield.data(), FilterTextfield.size())) {
-        ItemsNeedFilter = true;
+        ItemsNeedRebuild = true;
     }
 
     ImGui::Spacing();
@@ -164,8 +224,6 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
     }
 
     {
-        std::lock_guard lock(state.Jobs.JobsLock);
-
         static constexpr ImGuiTableFlags flags =
             ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Hideable
             | ImGuiTableFlags_Sortable | ImGuiTableFlags_SortMulti | ImGuiTableFlags_RowBg
@@ -173,23 +231,6 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
             | ImGuiTableFlags_SizingFixedFit;
         static constexpr ImGuiTableColumnFlags columns_base_flags = ImGuiTableColumnFlags_None;
 
-        enum ColumnIDs {
-            ColumnID_Index = 0,
-            ColumnID_Valid,
-            ColumnID_Service,
-            ColumnID_VideoID,
-            ColumnID_Username,
-            ColumnID_Title,
-            ColumnID_Game,
-            ColumnID_Timestamp,
-            ColumnID_Duration,
-            ColumnID_RecordingState,
-            ColumnID_Notes,
-            ColumnID_Status,
-            ColumnID_Actions,
-            ColumnIDCount
-        };
-
         // Submit table
         if (ImGui::BeginTable("JobTable", ColumnIDCount, flags, ImVec2(0.0f, -28.0f), 0.0f)) {
             // Declare columns
@@ -220,278 +261,33 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
             ImGui::TableSetupColumn("Actions", columns_base_flags, 0.0f, ColumnID_Actions);
             ImGui::TableSetupScrollFreeze(0, 1);
 
-            // Update item list if we changed the number of items.
-            // We also need to rebuild from scratch if the filter changed, since the list may now
-            // include items that were previously filtered out.
-            size_t items_count = state.Jobs.JobsVector.size();
-            std::vector<uint32_t>& items = ItemIndices;
-            if (ItemCountLastSeen != items_count || ItemsNeedFilter) {
-                items.resize(items_count);
-                for (size_t n = 0; n < items_count; ++n) {
-                    items[n] = static_cast<uint32_t>(n);
-                }
-                ItemCountLastSeen = items_count;
-                ItemsNeedSort = true;
-                ItemsNeedFilter = true;
-            }
-
-            if (ItemsNeedFilter) {
-                // filtering happens in-place, this is safe because out_idx is always <= i
-                size_t out_idx = 0;
-                for (size_t i = 0; i < items.size(); ++i) {
-                    const uint32_t ID = items[i];
-                    IVideoJob* item = state.Jobs.JobsVector[ID].get();
-                    if (PassFilter(item)) {
-                        items[out_idx] = ID;
-                        ++out_idx;
-                    }
-                }
-                items.resize(out_idx);
-
-                ItemsNeedFilter = false;
-            }
-
-            // Sort our data if sort specs have been changed!
             ImGuiTableSortSpecs* sort_specs = ImGui::TableGetSortSpecs();
             if (sort_specs && sort_specs->SpecsDirty) {
-                ItemsNeedSort = true;
-            }
-            if (sort_specs && ItemsNeedSort && items.size() > 1) {
-                for (int spec = (sort_specs->SpecsCount - 1); spec >= 0; --spec) {
-                    switch (sort_specs->Specs[spec].ColumnUserID) {
-                        case ColumnID_Index:
-                            if (sort_specs->Specs[spec].SortDirection
-                                == ImGuiSortDirection_Ascending) {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        return lhs < rhs;
-                                    });
-                            } else {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        return lhs > rhs;
-                                    });
-                            }
-                            break;
-                        case ColumnID_Service:
-                            if (sort_specs->Specs[spec].SortDirection
-                                == ImGuiSortDirection_Ascending) {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        return l->VideoInfo->GetService()
-                                               < r->VideoInfo->GetService();
-                                    });
-                            } else {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        return l->VideoInfo->GetService()
-                                               > r->VideoInfo->GetService();
-                                    });
-                            }
-                            break;
-                        case ColumnID_VideoID:
-                            if (sort_specs->Specs[spec].SortDirection
-                                == ImGuiSortDirection_Ascending) {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        std::array<char, 256> buffer1;
-                                        std::array<char, 256> buffer2;
-                                        return l->VideoInfo->GetVideoId(buffer1)
-                                               < r->VideoInfo->GetVideoId(buffer2);
-                                    });
-                            } else {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        std::array<char, 256> buffer1;
-                                        std::array<char, 256> buffer2;
-                                        return l->VideoInfo->GetVideoId(buffer1)
-                                               > r->VideoInfo->GetVideoId(buffer2);
-                                    });
-                            }
-                            break;
-                        case ColumnID_Username:
-                            if (sort_specs->Specs[spec].SortDirection
-                                == ImGuiSortDirection_Ascending) {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        std::array<char, 256> buffer1;
-                                        std::array<char, 256> buffer2;
-                                        return l->VideoInfo->GetUsername(buffer1)
-                                               < r->VideoInfo->GetUsername(buffer2);
-                                    });
-                            } else {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        std::array<char, 256> buffer1;
-                                        std::array<char, 256> buffer2;
-                                        return l->VideoInfo->GetUsername(buffer1)
-                                               > r->VideoInfo->GetUsername(buffer2);
-                                    });
-                            }
-                            break;
-                        case ColumnID_Title:
-                            if (sort_specs->Specs[spec].SortDirection
-                                == ImGuiSortDirection_Ascending) {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        std::array<char, 256> buffer1;
-                                        std::array<char, 256> buffer2;
-                                        return l->VideoInfo->GetVideoTitle(buffer1)
-                                               < r->VideoInfo->GetVideoTitle(buffer2);
-                                    });
-                            } else {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        std::array<char, 256> buffer1;
-                                        std::array<char, 256> buffer2;
-                                        return l->VideoInfo->GetVideoTitle(buffer1)
-                                               > r->VideoInfo->GetVideoTitle(buffer2);
-                                    });
-                            }
-                            break;
-                        case ColumnID_Game:
-                            if (sort_specs->Specs[spec].SortDirection
-                                == ImGuiSortDirection_Ascending) {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        std::array<char, 256> buffer1;
-                                        std::array<char, 256> buffer2;
-                                        return l->VideoInfo->GetVideoGame(buffer1)
-                                               < r->VideoInfo->GetVideoGame(buffer2);
-                                    });
-                            } else {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        std::array<char, 256> buffer1;
-                                        std::array<char, 256> buffer2;
-                                        return l->VideoInfo->GetVideoGame(buffer1)
-                                               > r->VideoInfo->GetVideoGame(buffer2);
-                                    });
-                            }
-                            break;
-                        case ColumnID_Timestamp:
-                            if (sort_specs->Specs[spec].SortDirection
-                                == ImGuiSortDirection_Ascending) {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        return l->VideoInfo->GetVideoTimestamp()
-                                               < r->VideoInfo->GetVideoTimestamp();
-                                    });
-                            } else {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        return l->VideoInfo->GetVideoTimestamp()
-                                               > r->VideoInfo->GetVideoTimestamp();
-                                    });
-                            }
-                            break;
-                        case ColumnID_Duration:
-                            if (sort_specs->Specs[spec].SortDirection
-                                == ImGuiSortDirection_Ascending) {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        return l->VideoInfo->GetVideoLength()
-                                               < r->VideoInfo->GetVideoLength();
-                                    });
-                            } else {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        return l->VideoInfo->GetVideoLength()
-                                               > r->VideoInfo->GetVideoLength();
-                                    });
-                            }
-                            break;
-                        case ColumnID_RecordingState:
-                            if (sort_specs->Specs[spec].SortDirection
-                                == ImGuiSortDirection_Ascending) {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        return l->VideoInfo->GetVideoRecordingState()
-                                               < r->VideoInfo->GetVideoRecordingState();
-                                    });
-                            } else {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        return l->VideoInfo->GetVideoRecordingState()
-                                               > r->VideoInfo->GetVideoRecordingState();
-                                    });
-                            }
-                            break;
-                        case ColumnID_Notes:
-                            if (sort_specs->Specs[spec].SortDirection
-                                == ImGuiSortDirection_Ascending) {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        return l->Notes < r->Notes;
-                                    });
-                            } else {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        return l->Notes > r->Notes;
-                                    });
-                            }
-                            break;
-                        case ColumnID_Status:
-                            if (sort_specs->Specs[spec].SortDirection
-                                == ImGuiSortDirection_Ascending) {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        return l->JobStatus < r->JobStatus;
-                                    });
-                            } else {
-                                std::stable_sort(
-                                    items.begin(), items.end(), [&](int lhs, int rhs) -> bool {
-                                        IVideoJob* l = state.Jobs.JobsVector[lhs].get();
-                                        IVideoJob* r = state.Jobs.JobsVector[rhs].get();
-                                        return l->JobStatus > r->JobStatus;
-                                    });
-                            }
-                            break;
-                        default: break;
-                    }
+                SortSpec.clear();
+                for (int spec = 0; spec < sort_specs->SpecsCount; ++spec) {
+                    SortSpec.push_back(SortKey{
+                        .ColumnId = static_cast<int>(sort_specs->Specs[spec].ColumnUserID),
+                        .Descending =
+                            sort_specs->Specs[spec].SortDirection != ImGuiSortDirection_Ascending});
                 }
                 sort_specs->SpecsDirty = false;
-                ItemsNeedSort = false;
+                ItemsNeedRebuild = true;
             }
 
+            // Everything below works on this snapshot, so nothing here ever waits for a job.
+            // Only a changed filter or sort order needs a full pass over all jobs, new snapshots
+            // usually just add or change a handful of rows.
+            auto snapshot = state.JobTable->GetSnapshot();
+            if (ItemsNeedRebuild) {
+                RebuildItems(*snapshot, *state.JobTable);
+                ItemsNeedRebuild = false;
+            } else if (CurrentSnapshot != snapshot) {
+                UpdateItems(*CurrentSnapshot, *snapshot);
+            }
+            CurrentSnapshot = std::move(snapshot);
+            const auto& rows = CurrentSnapshot->Rows;
+            const std::vector<uint32_t>& items = ItemIndices;
+
             ImGui::TableHeadersRow();
 
             ImGuiListClipper clipper;
@@ -499,7 +295,8 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
             while (clipper.Step()) {
                 for (int row_n = clipper.DisplayStart; row_n < clipper.DisplayEnd; ++row_n) {
                     const uint32_t ID = items[row_n];
-                    IVideoJob* item = state.Jobs.JobsVector[ID].get();
+                    const JobTableRow& row = *rows[ID];
+                    IVideoJob* job = row.Job;
 
                     ImGui::PushID(ID);
                     ImGui::TableNextRow(ImGuiTableRowFlags_None, 0.0f);
@@ -508,91 +305,94 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
                         ImGui::Text("%d", ID);
                     }
                     if (ImGui::TableSetColumnIndex(ColumnID_Valid)) {
-                        ImGui::Text("%s", item->HasBeenValidated ? "true" : "false");
+                        ImGui::Text("%s", row.HasBeenValidated ? "true" : "false");
                     }
                     if (ImGui::TableSetColumnIndex(ColumnID_Service)) {
-                        std::string_view sv = StreamServiceToString(item->VideoInfo->GetService());
+                        std::string_view sv = StreamServiceToString(row.Service);
                         ImGui::TextUnformatted(sv.data(), sv.data() + sv.size());
                     }
                     if (ImGui::TableSetColumnIndex(ColumnID_VideoID)) {
-                        std::array<char, 256> buffer;
-                        std::string_view s = item->VideoInfo->GetVideoId(buffer);
+                        const std::string& s = row.VideoId;
                         ImGui::TextUnformatted(s.data(), s.data() + s.size());
                     }
                     if (ImGui::TableSetColumnIndex(ColumnID_Username)) {
-                        std::array<char, 256> buffer;
-                        std::string_view s = item->VideoInfo->GetUsername(buffer);
+                        const std::string& s = row.Username;
                         ImGui::TextUnformatted(s.data(), s.data() + s.size());
                     }
                     if (ImGui::TableSetColumnIndex(ColumnID_Title)) {
-                        std::array<char, 256> buffer;
-                        std::string_view s = item->VideoInfo->GetVideoTitle(buffer);
+                        const std::string& s = row.Title;
                         ImGui::TextUnformatted(s.data(), s.data() + s.size());
                     }
                     if (ImGui::TableSetColumnIndex(ColumnID_Game)) {
-                        std::array<char, 256> buffer;
-                        std::string_view s = item->VideoInfo->GetVideoGame(buffer);
+                        const std::string& s = row.Game;
                         ImGui::TextUnformatted(s.data(), s.data() + s.size());
                     }
                     if (ImGui::TableSetColumnIndex(ColumnID_Timestamp)) {
-                        std::array<char, 24> buffer;
-                        std::string_view s =
-                            DateTimeToStringForGui(item->VideoInfo->GetVideoTimestamp(), buffer);
+                        const std::string& s = row.TimestampText;
                         ImGui::TextUnformatted(s.data(), s.data() + s.size());
                     }
                     if (ImGui::TableSetColumnIndex(ColumnID_Duration)) {
-                        std::array<char, 24> buffer;
-                        std::string_view s =
-                            TimeSpanToStringForGui(item->VideoInfo->GetVideoLength(), buffer);
+                        const std::string& s = row.DurationText;
                         ImGui::TextUnformatted(s.data(), s.data() + s.size());
                     }
                     if (ImGui::TableSetColumnIndex(ColumnID_RecordingState)) {
-                        std::string_view s =
-                            RecordingStateToString(item->VideoInfo->GetVideoRecordingState());
+                        std::string_view s = RecordingStateToString(row.VideoRecordingState);
                         ImGui::TextUnformatted(s.data(), s.data() + s.size());
                     }
                     if (ImGui::TableSetColumnIndex(ColumnID_Notes)) {
-                        const std::string& s = item->Notes;
+                        const std::string& s = row.Notes;
                         ImGui::TextUnformatted(s.data(), s.data() + s.size());
                     }
                     if (ImGui::TableSetColumnIndex(ColumnID_Status)) {
-                        const std::string& s = item->TextStatus;
+                        const std::string& s = row.TextStatus;
                         ImGui::TextUnformatted(s.data(), s.data() + s.size());
+                        // progress is atomic, so this can always show the live value
+                        JobProgressSnapshot progress = SampleJobProgress(job->Progress);
+                        if (progress.Kind != JobProgressKind::None) {
+                            std::string p = FormatJobProgress(progress);
+                            ImGui::SameLine();
+                            ImGui::TextUnformatted(p.data(), p.data() + p.size());
+                        }
                     }
                     if (ImGui::TableSetColumnIndex(ColumnID_Actions)) {
                         if (ImGui::SmallButton("...##JobActionsPopupButton")) {
                             ImGui::OpenPopup("JobActionsPopup");
                         }
                         if (ImGui::BeginPopup("JobActionsPopup")) {
-                            auto service = item->VideoInfo->GetService();
+                            // unlike the table itself the actions need the current state of the job
+                            std::lock_guard jobLock(job->DataLock);
+                            const VideoJobStatus status = job->JobStatus.load();
+                            auto service = row.Service;
                             auto is_in_queue = [&]() -> bool {
                                 for (auto& g : state.VideoTaskGroups) {
                                     if (g->GetService() == service) {
-                                        return g->IsInQueue(item);
+                                        return g->IsInQueue(job);
                                     }
                                 }
                                 return false;
                             };
 
-                            IUserInputRequest* uir = item->GetUserInputRequest();
+                            IUserInputRequest* uir = job->GetUserInputRequest();
                             if (uir) {
                                 if (ImGui::BeginMenu(uir->GetQuestion().c_str())) {
                                     for (auto& option : uir->GetOptions()) {
                                         if (ImGui::MenuItem(option.c_str())) {
                                             uir->SelectOption(option);
+                                            job->MarkChanged();
+                                            state.JobTable->RequestUpdate();
                                         }
                                     }
                                     ImGui::EndMenu();
                                 }
                             }
 
-                            if (item->JobStatus == VideoJobStatus::NotStarted
-                                || item->JobStatus == VideoJobStatus::Dead) {
+                            if (status == VideoJobStatus::NotStarted
+                                || status == VideoJobStatus::Dead) {
                                 if (is_in_queue()) {
                                     if (ImGui::Selectable("Dequeue")) {
                                         for (auto& g : state.VideoTaskGroups) {
                                             if (g->GetService() == service) {
-                                                g->Dequeue(item);
+                                                g->Dequeue(job);
                                                 break;
                                             }
                                         }
@@ -601,7 +401,7 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
                                     if (ImGui::Selectable("Enqueue")) {
                                         for (auto& g : state.VideoTaskGroups) {
                                             if (g->GetService() == service) {
-                                                g->Enqueue(item);
+                                                g->Enqueue(job);
                                                 break;
                                             }
                                         }
@@ -610,42 +410,42 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
                                 if (ImGui::Selectable("Download now")) {
                                     for (auto& g : state.VideoTaskGroups) {
                                         if (g->GetService() == service) {
-                                            g->Enqueue(item, true);
+                                            g->Enqueue(job, true);
                                             break;
                                         }
                                     }
                                 }
                             }
                             if (ImGui::Selectable("Copy Video ID")) {
-                                std::array<char, 256> buffer;
-                                std::string_view id = item->VideoInfo->GetVideoId(buffer);
-                                ImGui::SetClipboardText(id.data());
+                                ImGui::SetClipboardText(row.VideoId.c_str());
                             }
                             if (ImGui::Selectable("Copy Output Filename")) {
-                                std::string fn = item->GenerateOutputFilename();
+                                std::string fn = job->GenerateOutputFilename();
                                 ImGui::SetClipboardText(fn.c_str());
                             }
                             if (ImGui::Selectable("Copy Status")) {
-                                const std::string& status = item->TextStatus;
-                                ImGui::SetClipboardText(status.c_str());
+                                const std::string& textStatus = job->TextStatus;
+                                ImGui::SetClipboardText(textStatus.c_str());
                             }
-                            if (item->JobStatus == VideoJobStatus::Running) {
+                            if (status == VideoJobStatus::Running) {
                                 if (ImGui::Selectable("Stop")) {
                                     for (auto& g : state.VideoTaskGroups) {
                                         if (g->GetService() == service) {
-                                            g->CancelJob(item);
+                                            g->CancelJob(job);
                                             break;
                                         }
                                     }
                                 }
                             }
-                            if (item->JobStatus == VideoJobStatus::NotStarted) {
+                            if (status == VideoJobStatus::NotStarted) {
                                 if (ImGui::Selectable("Kill")) {
-                                    item->JobStatus = VideoJobStatus::Dead;
-                                    item->TextStatus = "[Manually killed] " + item->TextStatus;
+                                    job->JobStatus = VideoJobStatus::Dead;
+                                    job->TextStatus = "[Manually killed] " + job->TextStatus;
+                                    job->MarkChanged();
+                                    state.JobTable->RequestUpdate();
                                 }
                             }
-                            if (item->JobStatus != VideoJobStatus::Running) {
+                            if (status != VideoJobStatus::Running) {
                                 if (ImGui::Selectable("Remove")) {
                                     // TODO: Figure out a way to do this thread-safely...
                                 }
@@ -665,27 +465,46 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
     // bottom bar
 
     if (ImGui::Button("Log")) {
-        std::string msg;
-        {
-            std::lock_guard lock(state.FetchTaskStatusMessageLock);
-            msg = state.FetchTaskStatusMessages;
-        }
-        state.Windows.emplace_back(std::make_unique<GUI::LogWindow>(state, std::move(msg)));
+        state.Windows.emplace_back(std::make_unique<GUI::LogWindow>(state));
     }
 
     ImGui::SameLine();
     {
-        std::lock_guard lock(state.FetchTaskStatusMessageLock);
-        auto pos = state.FetchTaskStatusMessages.rfind('\n');
-        const char* str = state.FetchTaskStatusMessages.c_str();
-        if (pos != std::string::npos) {
-            str = (&state.FetchTaskStatusMessages[pos]) + 1;
+        LogBuffer& log = GetLogBuffer();
+        const uint64_t end = log.GetEnd();
+        LogRecord record;
+        if (end > 0 && log.Read(end - 1, record) == LogReadResult::Ok) {
+            ImGui::TextUnformatted(record.Message.data(),
+                                   record.Message.data() + record.Message.size());
+        } else {
+            ImGui::TextUnformatted("");
         }
-        ImGui::TextUnformatted(
-            str, state.FetchTaskStatusMessages.data() + state.FetchTaskStatusMessages.size());
     }
 
     ImGui::SameLine();
+    {
+        JobProgressThroughput throughput;
+        for (auto& g : state.VideoTaskGroups) {
+            g->AccumulateThroughput(throughput);
+        }
+        std::string s = FormatJobProgressThroughput(throughput);
+        if (!s.empty()) {
+            ImGui::TextUnformatted(" | ");
+            ImGui::SameLine();
+            ImGui::TextUnformatted(s.data(), s.data() + s.size());
+            ImGui::SameLine();
+        }
+    }
+    {
+        std::string s = FormatDiskStatistics(state.JobConf.ExpensiveDiskIO.GetStatistics());
+        if (!s.empty()) {
+            ImGui::TextUnformatted(" | Disk IO ");
+            ImGui::SameLine();
+            ImGui::TextUnformatted(s.data(), s.data() + s.size());
+            ImGui::SameLine();
+        }
+    }
+
     {
         static constexpr char queueSettingsLabel[] = "Queue Settings...";
         static constexpr char whenFinishedLabel[] = "when downloads are finished";
@@ -702,18 +521,21 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
         }
         if (ImGui::BeginPopup("QueueSettingsPopup")) {
             if (ImGui::Selectable("Enqueue all", false, ImGuiSelectableFlags_DontClosePopups)) {
-                std::lock_guard lock(state.Jobs.JobsLock);
-                for (auto& job : state.Jobs.JobsVector) {
-                    if (job->JobStatus == VideoJobStatus::NotStarted) {
-                        StreamService service = job->VideoInfo->GetService();
+                std::vector<std::vector<IVideoJob*>> jobsPerGroup(state.VideoTaskGroups.size());
+                for (const auto& row : state.JobTable->GetSnapshot()->Rows) {
+                    if (row->Job->JobStatus == VideoJobStatus::NotStarted) {
+                        const StreamService service = row->Service;
                         if (static_cast<int>(service) >= 0
                             && static_cast<size_t>(static_cast<int>(service))
-                                   < state.VideoTaskGroups.size()) {
-                            state.VideoTaskGroups[static_cast<size_t>(static_cast<int>(service))]
-                                ->Enqueue(job.get());
+                                   < jobsPerGroup.size()) {
+                            jobsPerGroup[static_cast<size_t>(static_cast<int>(service))].push_back(
+                                row->Job);
                         }
                     }
                 }
+                for (size_t i = 0; i < jobsPerGroup.size(); ++i) {
+                    state.VideoTaskGroups[i]->EnqueueBulk(jobsPerGroup[i]);
+                }
             }
             if (ImGui::BeginMenu("Enqueue only...")) {
                 ImGui::PushID("EnqueueOnlyOptions");
@@ -721,13 +543,14 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
                     ImGui::PushID(i);
                     std::string_view ss = StreamServiceToString(static_cast<StreamService>(i));
                     if (ImGui::Selectable(ss.data(), false, ImGuiSelectableFlags_DontClosePopups)) {
-                        std::lock_guard lock(state.Jobs.JobsLock);
-                        for (auto& job : state.Jobs.JobsVector) {
-                            if (job->JobStatus == VideoJobStatus::NotStarted
-                                && job->VideoInfo->GetService() == static_cast<StreamService>(i)) {
-                                state.VideoTaskGroups[i]->Enqueue(job.get());
+                        std::vector<IVideoJob*> jobs;
+                        for (const auto& row : state.JobTable->GetSnapshot()->Rows) {
+                            if (row->Job->JobStatus == VideoJobStatus::NotStarted
+                                && row->Service == static_cast<StreamService>(i)) {
+                                jobs.push_back(row->Job);
                             }
                         }
+                        state.VideoTaskGroups[i]->EnqueueBulk(jobs);
                     }
                     ImGui::PopID();
                 }
@@ -791,12 +614,119 @@ bool VodArchiverMainWindow::RenderContents(GuiState& state) {
     return true;
 }
 
-bool VodArchiverMainWindow::PassFilter(IVideoJob* item) const {
-    assert(item != nullptr);
-    assert(item->VideoInfo != nullptr);
+void VodArchiverMainWindow::RebuildItems(const JobTableSnapshot& snapshot,
+                                         const JobTableModel& model) {
+    const auto& rows = snapshot.Rows;
+    auto less = [&](uint32_t lhs, uint32_t rhs) {
+        return ItemLess(SortSpec, *rows[lhs], *rows[rhs]);
+    };
+
+    // with a search text only the jobs the index found need to be looked at. PassFilter() still
+    // checks them against the snapshot, since the index may have seen newer data
+    std::optional<std::vector<uint32_t>> candidates;
+    std::string_view textFilter = HyoutaUtils::TextUtils::StripToNull(FilterTextfield);
+    if (!textFilter.empty()) {
+        candidates = model.Search(textFilter);
+        std::erase_if(*candidates, [&](uint32_t id) { return id >= rows.size(); });
+    }
+
+    // filter and sort contiguous chunks of the rows on separate threads, then merge the results
+    const size_t count = candidates ? candidates->size() : rows.size();
+    const size_t chunkCount = std::clamp<size_t>(
+        count / MinRowsPerRebuildThread, 1, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::vector<uint32_t>> chunks(chunkCount);
+    auto processChunk = [&](size_t c) {
+        std::vector<uint32_t>& chunk = chunks[c];
+        const size_t end = count * (c + 1) / chunkCount;
+        for (size_t i = count * c / chunkCount; i < end; ++i) {
+            const uint32_t id = candidates ? (*candidates)[i] : static_cast<uint32_t>(i);
+            if (PassFilter(*rows[id])) {
+                chunk.push_back(id);
+            }
+        }
+        std::sort(chunk.begin(), chunk.end(), less);
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(chunkCount - 1);
+    for (size_t c = 1; c < chunkCount; ++c) {
+        threads.emplace_back(processChunk, c);
+    }
+    processChunk(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    ItemIndices.clear();
+    for (const auto& chunk : chunks) {
+        const size_t middle = ItemIndices.size();
+        ItemIndices.insert(ItemIndices.end(), chunk.begin(), chunk.end());
+        std::inplace_merge(ItemIndices.begin(),
+                           ItemIndices.begin() + static_cast<std::ptrdiff_t>(middle),
+                           ItemIndices.end(),
+                           less);
+    }
+}
+
+void VodArchiverMainWindow::UpdateItems(const JobTableSnapshot& previous,
+                                        const JobTableSnapshot& snapshot) {
+    const auto& oldRows = previous.Rows;
+    const auto& rows = snapshot.Rows;
+
+    // unchanged rows are shared between snapshots, so a pointer comparison is enough here
+    std::vector<uint32_t> changed;
+    bool anyExistingChanged = false;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (i >= oldRows.size()) {
+            changed.push_back(static_cast<uint32_t>(i));
+        } else if (oldRows[i] != rows[i]) {
+            changed.push_back(static_cast<uint32_t>(i));
+            anyExistingChanged = true;
+        }
+    }
+    if (changed.empty()) {
+        return;
+    }
+
+    // a changed row may now sort differently or not pass the filter anymore, so take it out first
+    if (anyExistingChanged) {
+        std::vector<bool> isChanged(rows.size(), false);
+        for (uint32_t id : changed) {
+            isChanged[id] = true;
+        }
+        std::erase_if(ItemIndices, [&](uint32_t id) { return isChanged[id]; });
+    }
+
+    std::vector<uint32_t> added;
+    for (uint32_t id : changed) {
+        if (PassFilter(*rows[id])) {
+            added.push_back(id);
+        }
+    }
+
+    // the remaining items all refer to rows that are identical in both snapshots, so they are
+    // still correctly ordered for the new one
+    auto less = [&](uint32_t lhs, uint32_t rhs) {
+        return ItemLess(SortSpec, *rows[lhs], *rows[rhs]);
+    };
+    if (added.size() <= MaxSingleInsertRows) {
+        for (uint32_t id : added) {
+            ItemIndices.insert(std::upper_bound(ItemIndices.begin(), ItemIndices.end(), id, less),
+                               id);
+        }
+    } else {
+        std::sort(added.begin(), added.end(), less);
+        const size_t middle = ItemIndices.size();
+        ItemIndices.insert(ItemIndices.end(), added.begin(), added.end());
+        std::inplace_merge(ItemIndices.begin(),
+                           ItemIndices.begin() + static_cast<std::ptrdiff_t>(middle),
+                           ItemIndices.end(),
+                           less);
+    }
+}
 
+bool VodArchiverMainWindow::PassFilter(const JobTableRow& row) const {
     if (FilterStreamService != 0) {
-        StreamService service = item->VideoInfo->GetService();
+        StreamService service = row.Service;
         if (service < StreamService::COUNT
             && (FilterStreamService & (1u << static_cast<uint32_t>(service))) != 0) {
             return false;
@@ -804,7 +734,7 @@ bool VodArchiverMainWindow::PassFilter(IVideoJob* item) const {
     }
 
     if (FilterJobStatus != 0) {
-        VideoJobStatus status = item->JobStatus;
+        VideoJobStatus status = row.Status;
         if (status < VideoJobStatus::COUNT
             && (FilterJobStatus & (1u << static_cast<uint32_t>(status))) != 0) {
             return false;
@@ -813,15 +743,11 @@ bool VodArchiverMainWindow::PassFilter(IVideoJob* item) const {
 
     std::string_view textFilter = HyoutaUtils::TextUtils::StripToNull(FilterTextfield);
     if (!textFilter.empty()) {
-        std::array<char, 256> buffer;
-        bool containsAny = HyoutaUtils::TextUtils::CaseInsensitiveContains(
-                               item->VideoInfo->GetUsername(buffer), textFilter)
-                           || HyoutaUtils::TextUtils::CaseInsensitiveContains(
-                               item->VideoInfo->GetVideoId(buffer), textFilter)
-                           || HyoutaUtils::TextUtils::CaseInsensitiveContains(
-                               item->VideoInfo->GetVideoTitle(buffer), textFilter)
-                           || HyoutaUtils::TextUtils::CaseInsensitiveContains(
-                               item->VideoInfo->GetVideoGame(buffer), textFilter);
+        bool containsAny =
+            HyoutaUtils::TextUtils::CaseInsensitiveContains(row.Username, textFilter)
+            || HyoutaUtils::TextUtils::CaseInsensitiveContains(row.VideoId, textFilter)
+            || HyoutaUtils::TextUtils::CaseInsensitiveContains(row.Title, textFilter)
+            || HyoutaUtils::TextUtils::CaseInsensitiveContains(row.Game, textFilter);
         if (!containsAny) {
             return false;
         }
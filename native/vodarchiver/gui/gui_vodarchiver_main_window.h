@@ -8,12 +8,9 @@
 #include <vector>
 
 #include "gui_file_browser.h"
+#include "gui_job_table_model.h"
 #include "gui_window.h"
 
-namespace VodArchiver {
-struct IVideoJob;
-}
-
 namespace VodArchiver::GUI {
 struct VodArchiverMainWindow : public VodArchiver::GUI::Window {
     VodArchiverMainWindow();
@@ -30,12 +27,26 @@ private:
     bool RenderContents(GuiState& state);
     bool HasPendingWindowRequest() const;
 
-    bool PassFilter(IVideoJob* item) const;
+    bool PassFilter(const JobTableRow& row) const;
+
+    // Filters and sorts all rows of the snapshot from scratch.
+    void RebuildItems(const JobTableSnapshot& snapshot, const JobTableModel& model);
+
+    // Moves only the rows that differ between the two snapshots to their new place in the order.
+    void UpdateItems(const JobTableSnapshot& previous, const JobTableSnapshot& snapshot);
+
+    struct SortKey {
+        int ColumnId;
+        bool Descending;
+    };
+
+    // The snapshot the current ItemIndices refer to.
+    std::shared_ptr<const JobTableSnapshot> CurrentSnapshot;
 
+    // Indices of the rows that pass the filter, ordered by SortSpec.
     std::vector<uint32_t> ItemIndices;
-    size_t ItemCountLastSeen = 0;
-    bool ItemsNeedSort = false;
-    bool ItemsNeedFilter = false;
+    std::vector<SortKey> SortSpec;
+    bool ItemsNeedRebuild = true;
 
     // bit index == enum index, 0 means visible, 1 means not visible
     uint32_t FilterStreamService = 0;
@@ -1,6 +1,8 @@
 #include "main_gui.h"
 
 #include <bit>
+#include <chrono>
+#include <format>
 #include <string_view>
 
 #include "imgui.h"
@@ -16,6 +18,7 @@
 #include "vodarchiver/common_paths.h"
 #include "vodarchiver/curl_util.h"
 #include "vodarchiver/job_handling.h"
+#include "vodarchiver/log_buffer.h"
 #include "vodarchiver/userinfo/serialization.h"
 #include "vodarchiver/videojobs/serialization.h"
 #include "vodarchiver_version.h"
@@ -27,6 +30,28 @@
 #endif
 
 namespace VodArchiver {
+// the log file and the one before it together stay below twice this
+static constexpr uint64_t MaxLogFileSize = 16 * 1024 * 1024;
+
+// Logs how long each part of the startup took.
+struct StartupTimer {
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point PhaseStart = Start;
+
+    void EndPhase(std::string_view name) {
+        const auto now = std::chrono::steady_clock::now();
+        GetLogBuffer().Append(
+            LogSource::General,
+            LogSeverity::Info,
+            std::format(
+                "Startup: {} took {} ms ({} ms total)",
+                name,
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - PhaseStart).count(),
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - Start).count()));
+        PhaseStart = now;
+    }
+};
+
 static bool RenderFrame(ImGuiIO& io, GuiState& state) {
     size_t windowCount = state.Windows.size();
     for (size_t i = 0; i < windowCount;) {
@@ -48,6 +73,7 @@ static bool RenderFrame(ImGuiIO& io, GuiState& state) {
 }
 
 int RunGui(int argc, char** argvUtf8) {
+    StartupTimer startupTimer;
     VodArchiver::curl::InitCurl();
     auto curlCleanup = HyoutaUtils::MakeScopeGuard([]() { VodArchiver::curl::DeinitCurl(); });
 
@@ -66,34 +92,46 @@ int RunGui(int argc, char** argvUtf8) {
         VodArchiver::LoadUserSettingsFromIni(state.GuiSettings, userIniPath);
     }
 
+    // this runs in parallel with loading the jobs and users below
+    state.FontData = std::make_unique<FontDataLoader>(guiSettingsFolder);
+    startupTimer.EndPhase("Loading settings");
+
     {
-        auto jobs = ParseJobsFromFile(GetVodXmlPath(state.GuiSettings));
+        const std::string xmlPath = GetVodXmlPath(state.GuiSettings);
+        const std::string snapshotPath = GetVodSnapshotPath(state.GuiSettings);
+        auto jobs = ParseJobsFromFile(ChooseJobStoreFile(
+            xmlPath,
+            snapshotPath,
+            state.GuiSettings.SaveJobsAsSnapshot ? JobStoreFormat::Snapshot
+                                                 : JobStoreFormat::Xml));
         if (jobs) {
-            state.Jobs.JobsVector = std::move(*jobs);
+            std::lock_guard lock(state.Jobs.JobsLock);
+            SetJobsNoLock(state.Jobs, std::move(*jobs));
         }
     }
+    startupTimer.EndPhase("Loading jobs");
     {
         auto userinfos = ParseUserInfosFromFile(GetUserInfoXmlPath(state.GuiSettings));
         if (userinfos) {
             state.UserInfos = std::move(*userinfos);
         }
     }
-    {
-        std::lock_guard lock(state.JobConf.Mutex);
-        state.JobConf.TargetFolderPath = GetTargetFolderPath(state.GuiSettings);
-        state.JobConf.TempFolderPath = GetTempFolderPath(state.GuiSettings);
-        state.JobConf.TwitchClientId = state.GuiSettings.TwitchClientId;
-        state.JobConf.TwitchClientSecret = state.GuiSettings.TwitchClientSecret;
-        state.JobConf.VodXmlPath = GetVodXmlPath(state.GuiSettings);
-        state.JobConf.UserInfoXmlPath = GetUserInfoXmlPath(state.GuiSettings);
-        state.JobConf.MinimumFreeSpaceBytes = state.GuiSettings.MinimumFreeSpaceBytes;
-        state.JobConf.AbsoluteMinimumFreeSpaceBytes =
-            state.GuiSettings.AbsoluteMinimumFreeSpaceBytes;
-
-        state.JobConf.JobsLock = &state.Jobs.JobsLock;
+    startupTimer.EndPhase("Loading users");
+    if (state.GuiSettings.WriteLogFile) {
+        const std::string& folder = GetPersistentDataPath(state.GuiSettings);
+        HyoutaUtils::IO::CreateDirectory(std::string_view(folder));
+        state.LogWriter = std::make_unique<LogFileWriter>(
+            GetLogBuffer(),
+            GetPersistentDataPath(state.GuiSettings, "vodarchiver.log"),
+            MaxLogFileSize);
     }
 
-    state.SaveThread = std::make_unique<VodArchiver::GUI::BackgroundSaveThread>(state);
+    ApplyUserSettingsToJobConfig(state.GuiSettings, state.JobConf);
+    state.JobTable =
+        std::make_unique<GUI::JobTableModel>(state.Jobs, [&state] { state.RequestRedraw(); });
+
+    state.SaveThread = std::make_unique<VodArchiver::BackgroundSaveThread>(
+        state.JobConf, state.Jobs, state.UserInfosLock, state.UserInfos);
 
     for (int s = static_cast<int>(StreamService::Unknown);
          s < static_cast<int>(StreamService::COUNT);
@@ -116,17 +154,16 @@ int RunGui(int argc, char** argvUtf8) {
                 &state.UserInfos,
                 &state.JobConf,
                 &state.CancellationToken,
-                [&](std::unique_ptr<IVideoInfo> info) {
-                    return CreateAndEnqueueJob(state.Jobs, std::move(info), [&](IVideoJob* newJob) {
-                        AddJobToTaskGroupIfAutoenqueue(state.VideoTaskGroups, newJob);
-                    });
+                [&](std::vector<std::unique_ptr<IVideoInfo>> infos) {
+                    return CreateAndEnqueueJobs(
+                        state.Jobs, std::move(infos), [&](IVideoJob* newJob) {
+                            AddJobToTaskGroupIfAutoenqueue(state.VideoTaskGroups, newJob);
+                        });
                 },
+                [&](const IVideoInfo& info) { return IsVideoKnown(state.Jobs, info); },
                 [&](std::string_view msg) {
-                    // FIXME: This needs a cap. Or maybe we don't store these at all and just throw
-                    // them to stdout?
-                    std::lock_guard lock(state.FetchTaskStatusMessageLock);
-                    state.FetchTaskStatusMessages.push_back('\n');
-                    state.FetchTaskStatusMessages += msg;
+                    GetLogBuffer().Append(LogSource::Fetch, LogSeverity::Info, msg);
+                    state.RequestRedraw();
                 },
                 [&]() { state.SaveThread->RequestSaveJobs(); },
                 [&]() { state.SaveThread->RequestSaveUsers(); },
@@ -144,7 +181,31 @@ int RunGui(int argc, char** argvUtf8) {
         make_fetch_task_group({{ServiceVideoCategoryType::FFMpegJob}});
     }
 
+    if (state.GuiSettings.ControlServerPort != 0) {
+        state.Control = std::make_unique<VodArchiver::ControlServer>(
+            state.JobConf, state.Jobs, state.VideoTaskGroups);
+        if (!state.Control->Start(static_cast<uint16_t>(state.GuiSettings.ControlServerPort))) {
+            state.Control.reset();
+        }
+    }
+
     state.Windows.emplace_back(std::make_unique<GUI::VodArchiverMainWindow>());
+    startupTimer.EndPhase("Starting task groups");
+
+    const auto load_fonts = [&](ImGuiIO& io, GuiState& state) -> void {
+        startupTimer.EndPhase("Creating the window");
+        LoadFonts(io, state);
+        startupTimer.EndPhase("Loading fonts");
+    };
+    bool firstFrame = true;
+    const auto render_frame = [&](ImGuiIO& io, GuiState& state) -> bool {
+        const bool result = RenderFrame(io, state);
+        if (firstFrame) {
+            firstFrame = false;
+            startupTimer.EndPhase("First frame");
+        }
+        return result;
+    };
 
     const auto load_imgui_ini = [&](ImGuiIO& io, GuiState& state) -> void {
         if (!guiSettingsFolder) {
@@ -189,21 +250,22 @@ int RunGui(int argc, char** argvUtf8) {
     int rv = RunGuiDX11(state,
                         wstr ? wstr->c_str() : L"VodArchiver",
                         backgroundColor,
-                        LoadFonts,
-                        RenderFrame,
+                        load_fonts,
+                        render_frame,
                         load_imgui_ini,
                         save_imgui_ini);
 #else
     int rv = RunGuiGlfwVulkan(state,
                               windowTitle.data(),
                               backgroundColor,
-                              LoadFonts,
-                              RenderFrame,
+                              load_fonts,
+                              render_frame,
                               load_imgui_ini,
                               save_imgui_ini);
 #endif
 
     // Stop everything that's still running.
+    state.Control.reset();
     state.CancellationToken.CancelTask();
     for (size_t i = state.FetchTaskGroups.size(); i > 0; --i) {
         auto& g = state.FetchTaskGroups[i - 1];
@@ -213,6 +275,7 @@ int RunGui(int argc, char** argvUtf8) {
         auto& g = state.VideoTaskGroups[i - 1];
         g.reset();
     }
+    state.JobTable.reset();
 
     // If any windows haven't cleaned up yet do that.
     for (size_t i = state.Windows.size(); i > 0; --i) {
@@ -231,12 +294,17 @@ int RunGui(int argc, char** argvUtf8) {
     }
     {
         std::lock_guard lock(state.Jobs.JobsLock);
-        WriteJobsToFile(state.Jobs.JobsVector, GetVodXmlPath(state.GuiSettings));
+        WriteJobStore(state.Jobs.JobsVector,
+                      GetVodXmlPath(state.GuiSettings),
+                      GetVodSnapshotPath(state.GuiSettings),
+                      state.GuiSettings.SaveJobsAsSnapshot ? JobStoreFormat::Snapshot
+                                                           : JobStoreFormat::Xml);
     }
     if (guiSettingsFolder) {
         HyoutaUtils::IO::CreateDirectory(std::string_view(*guiSettingsFolder));
         VodArchiver::WriteUserSettingsToIni(state.GuiSettings, userIniPath);
     }
+    state.LogWriter.reset();
     return rv;
 }
 } // namespace VodArchiver
@@ -0,0 +1,186 @@
+#include "host_rate_limiter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "util/number.h"
+#include "util/text.h"
+#include "util/xorshift.h"
+
+namespace VodArchiver {
+// the spacing of fetch requests to a host that hasn't told us anything about its limits yet
+static constexpr auto DefaultFetchInterval = std::chrono::seconds(20);
+static constexpr auto MinFetchInterval = std::chrono::milliseconds(250);
+static constexpr auto MaxFetchInterval = std::chrono::minutes(15);
+static constexpr auto MaxFetchJitter = std::chrono::seconds(10);
+
+// hosts that never tell us about their limits start out slower instead. youtube.com is only ever
+// talked to through yt-dlp, whose responses we don't see, so its spacing never adapts and stays at
+// what the fetcher has always used. archive.org doesn't send rate limit headers.
+static constexpr std::pair<std::string_view, std::chrono::seconds> QuietHostFetchIntervals[] = {
+    {"www.youtube.com", std::chrono::seconds(155)},
+    {"archive.org", std::chrono::seconds(60)},
+};
+
+HostRateLimiter::HostRateLimiter(Clock::duration defaultInterval,
+                                 Clock::duration minInterval,
+                                 Clock::duration maxInterval,
+                                 Clock::duration maxJitter,
+                                 uint32_t rngSeed)
+  : DefaultInterval(defaultInterval)
+  , MinInterval(minInterval)
+  , MaxInterval(maxInterval)
+  , MaxJitter(maxJitter)
+  , RNG(rngSeed) {}
+
+HostRateLimiter::~HostRateLimiter() = default;
+
+HostRateLimiter::HostState& HostRateLimiter::GetHostNoLock(std::string_view host) {
+    auto it = Hosts.find(std::string(host));
+    if (it == Hosts.end()) {
+        it = Hosts.emplace(std::string(host), HostState{.Interval = DefaultInterval}).first;
+    }
+    return it->second;
+}
+
+void HostRateLimiter::SetIntervalNoLock(HostState& state, Clock::duration interval) {
+    state.Interval = interval;
+    if (state.LastSlot != Clock::time_point{}) {
+        state.NextSlot = state.LastSlot + interval;
+    }
+}
+
+HostRateLimiter::Clock::time_point HostRateLimiter::Reserve(std::string_view host,
+                                                            Clock::time_point now) {
+    if (host.empty()) {
+        return now;
+    }
+
+    std::lock_guard lock(Mutex);
+    HostState& state = GetHostNoLock(host);
+    const Clock::time_point slot = std::max({now, state.NextSlot, state.HoldUntil});
+    const Clock::duration maxJitter = std::min(MaxJitter, state.Interval / 2);
+    Clock::duration jitter{};
+    if (maxJitter.count() > 0) {
+        const uint64_t r = (static_cast<uint64_t>(RNG()) << 32) | static_cast<uint64_t>(RNG());
+        jitter = Clock::duration(
+            static_cast<Clock::rep>(r % static_cast<uint64_t>(maxJitter.count())));
+    }
+    state.LastSlot = slot;
+    state.NextSlot = slot + state.Interval + jitter;
+    return slot;
+}
+
+void HostRateLimiter::Update(std::string_view host,
+                             const RateLimitInfo& info,
+                             Clock::time_point now) {
+    if (host.empty()) {
+        return;
+    }
+
+    std::lock_guard lock(Mutex);
+    HostState& state = GetHostNoLock(host);
+    if (info.Remaining && info.Reset) {
+        if (*info.Remaining > 0) {
+            const Clock::duration untilReset = std::max(*info.Reset - now, Clock::duration{});
+            SetIntervalNoLock(
+                state, std::clamp(untilReset / *info.Remaining, MinInterval, MaxInterval));
+        } else {
+            state.HoldUntil = std::max(state.HoldUntil, *info.Reset);
+        }
+    }
+    if (info.TooManyRequests) {
+        SetIntervalNoLock(state, std::clamp(state.Interval * 2, DefaultInterval, MaxInterval));
+        state.HoldUntil = std::max(state.HoldUntil, now + state.Interval);
+    }
+    if (info.RetryAfter) {
+        state.HoldUntil = std::max(state.HoldUntil, now + *info.RetryAfter);
+    }
+}
+
+void HostRateLimiter::SetInterval(std::string_view host, Clock::duration interval) {
+    if (host.empty()) {
+        return;
+    }
+
+    std::lock_guard lock(Mutex);
+    GetHostNoLock(host).Interval = interval;
+}
+
+HostRateLimiter::Clock::duration HostRateLimiter::GetInterval(std::string_view host) {
+    if (host.empty()) {
+        return Clock::duration{};
+    }
+
+    std::lock_guard lock(Mutex);
+    return GetHostNoLock(host).Interval;
+}
+
+static HostRateLimiter& CreateFetchRateLimiter() {
+    static HostRateLimiter limiter(
+        DefaultFetchInterval,
+        MinFetchInterval,
+        MaxFetchInterval,
+        MaxFetchJitter,
+        static_cast<uint32_t>(HostRateLimiter::Clock::now().time_since_epoch().count()));
+    for (const auto& [host, interval] : QuietHostFetchIntervals) {
+        limiter.SetInterval(host, interval);
+    }
+    return limiter;
+}
+
+HostRateLimiter& GetFetchRateLimiter() {
+    static HostRateLimiter& limiter = CreateFetchRateLimiter();
+    return limiter;
+}
+
+static std::optional<int64_t>
+    FindIntegerHeader(std::span<const std::pair<std::string, std::string>> headers,
+                      std::string_view name,
+                      std::string_view alternativeName = {}) {
+    const std::pair<std::string, std::string>* alternative = nullptr;
+    for (const auto& header : headers) {
+        if (HyoutaUtils::TextUtils::CaseInsensitiveEquals(header.first, name)) {
+            return HyoutaUtils::NumberUtils::ParseInt64(header.second);
+        }
+        if (alternative == nullptr && !alternativeName.empty()
+            && HyoutaUtils::TextUtils::CaseInsensitiveEquals(header.first, alternativeName)) {
+            alternative = &header;
+        }
+    }
+    if (alternative == nullptr) {
+        return std::nullopt;
+    }
+    return HyoutaUtils::NumberUtils::ParseInt64(alternative->second);
+}
+
+HostRateLimiter::RateLimitInfo
+    ParseRateLimitHeaders(long responseCode,
+                          std::span<const std::pair<std::string, std::string>> headers,
+                          HostRateLimiter::Clock::time_point now,
+                          int64_t unixTimeNow) {
+    // anything below this is too early to be a sensible unix timestamp (it's in 2001)
+    static constexpr int64_t MinResetTimestamp = 1'000'000'000;
+
+    HostRateLimiter::RateLimitInfo info;
+    info.TooManyRequests = (responseCode == 429);
+    if (auto retryAfter = FindIntegerHeader(headers, "Retry-After")) {
+        // this can also be a HTTP date, but nobody we talk to sends that
+        info.RetryAfter = std::chrono::seconds(*retryAfter);
+    }
+    info.Remaining = FindIntegerHeader(headers, "Ratelimit-Remaining", "X-Ratelimit-Remaining");
+    if (auto reset = FindIntegerHeader(headers, "Ratelimit-Reset", "X-Ratelimit-Reset")) {
+        const int64_t secondsUntilReset =
+            *reset < MinResetTimestamp ? *reset : *reset - unixTimeNow;
+        info.Reset = now + std::chrono::seconds(secondsUntilReset);
+    }
+    return info;
+}
+} // namespace VodArchiver
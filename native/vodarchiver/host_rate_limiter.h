@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "util/xorshift.h"
+
+namespace VodArchiver {
+// Spaces out requests to the same host. Every request reserves a slot first and waits until the
+// slot starts; slots for one host are handed out in reservation order, at least the host's interval
+// plus a random jitter apart. Requests to different hosts don't affect each other.
+// The interval adapts to what the host reports about its rate limits, see Update().
+// Safe to use from multiple threads.
+struct HostRateLimiter {
+    using Clock = std::chrono::steady_clock;
+
+    // What a response said about the host's rate limit.
+    struct RateLimitInfo {
+        bool TooManyRequests = false; // HTTP 429
+        std::optional<Clock::duration> RetryAfter;
+        std::optional<int64_t> Remaining;       // requests left until the budget resets
+        std::optional<Clock::time_point> Reset; // when the budget resets
+    };
+
+    // Hosts start out at defaultInterval. Adapting never leaves [minInterval, maxInterval], and
+    // defaultInterval must be inside that range.
+    // The jitter added to a slot is at most maxJitter and at most half the interval.
+    HostRateLimiter(Clock::duration defaultInterval,
+                    Clock::duration minInterval,
+                    Clock::duration maxInterval,
+                    Clock::duration maxJitter,
+                    uint32_t rngSeed);
+    HostRateLimiter(const HostRateLimiter& other) = delete;
+    HostRateLimiter(HostRateLimiter&& other) = delete;
+    HostRateLimiter& operator=(const HostRateLimiter& other) = delete;
+    HostRateLimiter& operator=(HostRateLimiter&& other) = delete;
+    ~HostRateLimiter();
+
+    // Returns the time at which the caller may send its request. An empty host is never limited.
+    Clock::time_point Reserve(std::string_view host, Clock::time_point now);
+
+    // Adapts the host's interval to a response. With a known remaining budget and reset time the
+    // remaining requests are spread evenly until the reset, so a host with plenty of budget left is
+    // queried quickly and one that's running low gets slowed down. A 429 doubles the interval, and
+    // Retry-After or an exhausted budget hold back all further slots until that time.
+    void Update(std::string_view host, const RateLimitInfo& info, Clock::time_point now);
+
+    // Changes the spacing of future slots for a host. Slots that were already reserved stay as is.
+    void SetInterval(std::string_view host, Clock::duration interval);
+    Clock::duration GetInterval(std::string_view host);
+
+private:
+    struct HostState {
+        Clock::time_point LastSlot{};
+        Clock::time_point NextSlot{};
+        Clock::time_point HoldUntil{}; // from Retry-After or an exhausted budget
+        Clock::duration Interval{};
+    };
+    HostState& GetHostNoLock(std::string_view host);
+    void SetIntervalNoLock(HostState& state, Clock::duration interval);
+
+    Clock::duration DefaultInterval;
+    Clock::duration MinInterval;
+    Clock::duration MaxInterval;
+    Clock::duration MaxJitter;
+
+    std::mutex Mutex;
+    HyoutaUtils::RNG::xorshift RNG;
+    std::unordered_map<std::string, HostState> Hosts;
+};
+
+// Reads the rate limit headers of an HTTP response, matching header names case-insensitively.
+// Ratelimit-Reset is sent as seconds until the reset by some servers and as a unix timestamp by
+// others; values too small to be a timestamp of this century are taken as seconds.
+// unixTimeNow is the same instant as now, in seconds since the unix epoch.
+HostRateLimiter::RateLimitInfo
+    ParseRateLimitHeaders(long responseCode,
+                          std::span<const std::pair<std::string, std::string>> headers,
+                          HostRateLimiter::Clock::time_point now,
+                          int64_t unixTimeNow);
+
+// The limiter all fetches go through, so that fetch task groups that hit the same host share it.
+// HTTP responses received through curl_util update it automatically. Hosts known not to report
+// their limits start out with a more conservative interval than the rest.
+HostRateLimiter& GetFetchRateLimiter();
+} // namespace VodArchiver
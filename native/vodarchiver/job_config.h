@@ -1,10 +1,12 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 #include <string>
 
 #include "disk_lock.h"
+#include "disk_space.h"
 
 namespace VodArchiver {
 // config data that the user may change at any time through the GUI
@@ -15,17 +17,31 @@ struct JobConfig {
     std::string TwitchClientId;
     std::string TwitchClientSecret;
     std::string VodXmlPath;
+    std::string VodSnapshotPath;
     std::string UserInfoXmlPath;
+    bool SaveJobsAsSnapshot = false; // save to VodSnapshotPath instead of VodXmlPath
     uint64_t MinimumFreeSpaceBytes = 0;
     uint64_t AbsoluteMinimumFreeSpaceBytes = 0;
 
-    // things below this line do not require holding the Mutex
+    // number of ffmpeg processes a single reencode job may run concurrently, 1 disables the
+    // chunked encode mode entirely
+    uint32_t ReencodeParallelProcesses = 1;
+
+    // running jobs that report no progress for this long are cancelled and retried later, 0 turns
+    // the watchdog off
+    uint32_t StallTimeoutMinutes = 30;
 
-    // pointer to JobList::JobsLock
-    std::recursive_mutex* JobsLock;
+    // things below this line do not require holding the Mutex
 
-    // global disk IO locking so multiple threads don't slow eachother to a crawl by accessing the
-    // same hard drive at the same time
+    // per-device disk IO slots so multiple threads don't slow eachother to a crawl by accessing
+    // the same hard drive at the same time
     DiskMutex ExpensiveDiskIO;
+
+    // free space bookkeeping for the target and temp volumes, see ReserveDiskSpace()
+    DiskSpaceLedger FreeSpace;
+
+    // how many reencode jobs the FFMpegJob task group runs side by side, set by that task group.
+    // the CPUs are split between this many jobs, see AcquireProcessSlot()
+    std::atomic<uint32_t> BulkJobConcurrency = 1;
 };
 } // namespace VodArchiver
@@ -1,6 +1,8 @@
 #include "job_handling.h"
 
+#include <cstddef>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -11,6 +13,7 @@
 #include "vodarchiver/videojobs/generic-file-job.h"
 #include "vodarchiver/videojobs/hitbox-video-job.h"
 #include "vodarchiver/videojobs/i-video-job.h"
+#include "vodarchiver/videojobs/job_snapshot.h"
 #include "vodarchiver/videojobs/twitch-chat-replay-job.h"
 #include "vodarchiver/videojobs/twitch-video-job.h"
 #include "vodarchiver/videojobs/youtube-video-job.h"
@@ -100,6 +103,102 @@ bool CreateAndEnqueueJob(JobList& jobs,
     return EnqueueJob(jobs, std::move(job), enqueueCallback);
 }
 
+size_t CreateAndEnqueueJobs(JobList& jobs,
+                            std::vector<std::unique_ptr<IVideoInfo>> infos,
+                            const std::function<void(IVideoJob* job)>& enqueueCallback) {
+    // the JobsLock is recursive, so this just keeps everyone else out until the batch is done
+    std::lock_guard lock(jobs.JobsLock);
+    size_t created = 0;
+    for (auto& info : infos) {
+        if (CreateAndEnqueueJob(jobs, std::move(info), enqueueCallback)) {
+            ++created;
+        }
+    }
+    return created;
+}
+
+std::string MakeKnownVideoKey(StreamService service, std::string_view videoId) {
+    std::string key;
+    key.reserve(videoId.size() + 1);
+    key.push_back(static_cast<char>(service));
+    key.append(videoId);
+    return key;
+}
+
+static std::string MakeKnownVideoKey(const IVideoInfo& info) {
+    std::array<char, 256> buffer;
+    return MakeKnownVideoKey(info.GetService(), info.GetVideoId(buffer));
+}
+
+void SetJobsNoLock(JobList& jobs, std::vector<std::unique_ptr<IVideoJob>> newJobs) {
+    jobs.JobsVector = std::move(newJobs);
+    jobs.Dormant = DormantJobList();
+    jobs.KnownVideos.clear();
+    jobs.KnownVideos.reserve(jobs.JobsVector.size());
+    for (auto& job : jobs.JobsVector) {
+        std::lock_guard lock(job->DataLock);
+        if (job->VideoInfo) {
+            jobs.KnownVideos.insert(MakeKnownVideoKey(*job->VideoInfo));
+        }
+    }
+}
+
+void SetJobsFromSnapshotNoLock(JobList& jobs,
+                               std::shared_ptr<const JobSnapshot> snapshot,
+                               std::string_view filename) {
+    std::vector<std::unique_ptr<IVideoJob>> awake;
+    std::vector<size_t> dormant;
+    for (size_t i = 0; i < snapshot->GetJobCount(); ++i) {
+        if (snapshot->GetJobStatus(i) == VideoJobStatus::Finished && snapshot->GetService(i)
+            && snapshot->IsJobIntact(i)) {
+            dormant.push_back(i);
+            continue;
+        }
+        auto job = snapshot->DecodeJob(i);
+        if (!job) {
+            LogDamagedJob(*snapshot, i, filename);
+            continue;
+        }
+        if (job->JobStatus == VideoJobStatus::Running) {
+            job->JobStatus = VideoJobStatus::NotStarted;
+        }
+        awake.emplace_back(std::move(job));
+    }
+
+    SetJobsNoLock(jobs, std::move(awake));
+    jobs.KnownVideos.reserve(jobs.JobsVector.size() + dormant.size());
+    for (size_t index : dormant) {
+        jobs.KnownVideos.insert(
+            MakeKnownVideoKey(*snapshot->GetService(index), snapshot->GetVideoId(index)));
+    }
+    jobs.Dormant.Snapshot = std::move(snapshot);
+    jobs.Dormant.Indices = std::move(dormant);
+}
+
+IVideoJob* WakeDormantJobNoLock(JobList& jobs, StreamService service, std::string_view id) {
+    auto& indices = jobs.Dormant.Indices;
+    for (auto it = indices.begin(); it != indices.end(); ++it) {
+        const JobSnapshot& snapshot = *jobs.Dormant.Snapshot;
+        if (snapshot.GetService(*it) != service || snapshot.GetVideoId(*it) != id) {
+            continue;
+        }
+        auto job = snapshot.DecodeJob(*it);
+        if (!job) {
+            return nullptr;
+        }
+        indices.erase(it);
+        IVideoJob* jobptr = job.get();
+        jobs.JobsVector.push_back(std::move(job));
+        return jobptr;
+    }
+    return nullptr;
+}
+
+// must hold the JobsLock when calling this!
+static bool ContainsJobForVideo(JobList& jobs, const IVideoInfo& info) {
+    return jobs.KnownVideos.contains(MakeKnownVideoKey(info));
+}
+
 bool EnqueueJob(JobList& jobs,
                 std::unique_ptr<IVideoJob> job,
                 const std::function<void(IVideoJob* job)>& enqueueCallback) {
@@ -109,26 +208,18 @@ bool EnqueueJob(JobList& jobs,
         return false;
     }
 
+    // nobody else knows about this job yet, so there's no need to hold its DataLock
+    std::string key = MakeKnownVideoKey(*newVideoInfo);
+    job->SetStatus("Waiting...");
+
     {
         std::lock_guard lock(jobs.JobsLock);
 
-        // TODO? C# used a Set here for faster lookup.
-        // Not sure if this is actually needed though, we'll see...
-
         // see if this job is already in the list, if yes we don't do anything
-        std::array<char, 256> buffer1;
-        std::array<char, 256> buffer2;
-        for (size_t i = 0; i < jobs.JobsVector.size(); ++i) {
-            auto& j = jobs.JobsVector[i];
-            IVideoInfo* vi = j->VideoInfo.get();
-            if (vi && vi->GetService() == newVideoInfo->GetService()
-                && vi->GetVideoId(buffer1) == newVideoInfo->GetVideoId(buffer2)) {
-                // already in list
-                return false;
-            }
+        if (!jobs.KnownVideos.insert(std::move(key)).second) {
+            return false;
         }
 
-        job->SetStatus("Waiting...");
         IVideoJob* jobptr = job.get();
         jobs.JobsVector.push_back(std::move(job));
 
@@ -140,11 +231,21 @@ bool EnqueueJob(JobList& jobs,
     return true;
 }
 
+bool IsVideoKnown(JobList& jobs, const IVideoInfo& info) {
+    std::lock_guard lock(jobs.JobsLock);
+    return ContainsJobForVideo(jobs, info);
+}
+
 void AddJobToTaskGroupIfAutoenqueue(std::vector<std::unique_ptr<VideoTaskGroup>>& videoTaskGroups,
                                     IVideoJob* job) {
+    StreamService service;
+    {
+        std::lock_guard lock(job->DataLock);
+        service = job->VideoInfo->GetService();
+    }
     for (size_t i = 0; i < videoTaskGroups.size(); ++i) {
         auto& g = videoTaskGroups[i];
-        if (g && g->GetService() == job->VideoInfo->GetService()) {
+        if (g && g->GetService() == service) {
             if (g->IsAutoEnqueue()) {
                 g->Enqueue(job);
             }
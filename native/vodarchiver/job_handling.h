@@ -1,25 +1,54 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
 #include "vodarchiver/tasks/video-task-group.h"
 #include "vodarchiver/videoinfo/i-video-info.h"
 #include "vodarchiver/videojobs/i-video-job.h"
+#include "vodarchiver/videojobs/job_snapshot.h"
 
 namespace VodArchiver {
 struct JobList {
+    // Guards JobsVector and KnownVideos, but not the jobs themselves, see IVideoJob::DataLock.
     std::recursive_mutex JobsLock;
 
     // this is a bit of a threading mess and C# handled this by being garbage collected, so DO NOT
     // DELETE anything in this vector, jobs have to stay alive once they're in here for the rest of
     // the program. we'll see later if we can fix this...
     std::vector<std::unique_ptr<IVideoJob>> JobsVector;
+
+    // Finished jobs that were loaded from a snapshot are left undecoded in the mapped file until
+    // something actually asks for them, see WakeDormantJobNoLock(). They're not in JobsVector but
+    // they are in KnownVideos. Also guarded by the JobsLock.
+    DormantJobList Dormant;
+
+    // service and video ID of every job in JobsVector and Dormant, see MakeKnownVideoKey()
+    std::unordered_set<std::string> KnownVideos;
 };
 
+std::string MakeKnownVideoKey(StreamService service, std::string_view videoId);
+
+// Replaces the whole list, for when it's loaded from disk. Must hold the JobsLock, and no job of
+// the previous list may still be in use anywhere.
+void SetJobsNoLock(JobList& jobs, std::vector<std::unique_ptr<IVideoJob>> newJobs);
+
+// Same as SetJobsNoLock() but only decodes the jobs that aren't finished yet, the rest stays
+// dormant. Damaged jobs are logged and left out.
+void SetJobsFromSnapshotNoLock(JobList& jobs,
+                               std::shared_ptr<const JobSnapshot> snapshot,
+                               std::string_view filename);
+
+// Decodes the dormant job for this video and moves it into JobsVector. Returns nullptr if there is
+// no such dormant job. Must hold the JobsLock.
+IVideoJob* WakeDormantJobNoLock(JobList& jobs, StreamService service, std::string_view id);
+
 // note for all of these: JobsLock will be held when enqueueCallback is called
 bool CreateAndEnqueueJob(JobList& jobs,
                          std::unique_ptr<IVideoInfo> info,
@@ -29,11 +58,19 @@ bool CreateAndEnqueueJob(JobList& jobs,
                          std::string id,
                          std::unique_ptr<IVideoInfo> info,
                          const std::function<void(IVideoJob* job)>& enqueueCallback);
+// Creates jobs for a whole batch of videos while holding the JobsLock only once. Returns how many
+// of them were new.
+size_t CreateAndEnqueueJobs(JobList& jobs,
+                            std::vector<std::unique_ptr<IVideoInfo>> infos,
+                            const std::function<void(IVideoJob* job)>& enqueueCallback);
 bool EnqueueJob(JobList& jobs,
                 std::unique_ptr<IVideoJob> job,
                 const std::function<void(IVideoJob* job)>& enqueueCallback);
 
-// must hold the JobsLock when calling this!
+// returns true if there already is a job for this video, takes the JobsLock
+bool IsVideoKnown(JobList& jobs, const IVideoInfo& info);
+
+// must not hold the DataLock of any job other than this one when calling this!
 void AddJobToTaskGroupIfAutoenqueue(std::vector<std::unique_ptr<VideoTaskGroup>>& videoTaskGroups,
                                     IVideoJob* job);
 } // namespace VodArchiver
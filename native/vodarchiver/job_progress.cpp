@@ -0,0 +1,333 @@
+#include "job_progress.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "util/number.h"
+#include "util/text.h"
+
+#include "time_types.h"
+
+namespace VodArchiver {
+static int64_t SteadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void JobProgress::Begin(JobProgressKind kind, int64_t totalDurationUs) {
+    int64_t now = SteadyNowMs();
+    Kind.store(JobProgressKind::None, std::memory_order_relaxed);
+    StartTimeMs.store(now, std::memory_order_relaxed);
+    LastUpdateTimeMs.store(now, std::memory_order_relaxed);
+    TotalDurationUs.store(totalDurationUs, std::memory_order_relaxed);
+    OutTimeUs.store(0, std::memory_order_relaxed);
+    Frame.store(0, std::memory_order_relaxed);
+    Fps.store(0.0, std::memory_order_relaxed);
+    Speed.store(0.0, std::memory_order_relaxed);
+    TotalSizeBytes.store(0, std::memory_order_relaxed);
+    ExpectedSizeBytes.store(0, std::memory_order_relaxed);
+    BytesPerSecond.store(0.0, std::memory_order_relaxed);
+    ReportedEtaSeconds.store(-1, std::memory_order_relaxed);
+    LastHeartbeatTimeMs.store(now, std::memory_order_relaxed);
+    Kind.store(kind, std::memory_order_release);
+}
+
+void JobProgress::End() {
+    Kind.store(JobProgressKind::None, std::memory_order_release);
+    Heartbeat();
+}
+
+void JobProgress::Heartbeat() {
+    LastHeartbeatTimeMs.store(SteadyNowMs(), std::memory_order_relaxed);
+}
+
+JobIdleWait::JobIdleWait(JobProgress& progress) : Progress(&progress) {
+    Progress->IdleWaits.fetch_add(1, std::memory_order_relaxed);
+}
+
+JobIdleWait::~JobIdleWait() {
+    Finish();
+}
+
+void JobIdleWait::Finish() {
+    if (Progress != nullptr) {
+        Progress->Heartbeat();
+        Progress->IdleWaits.fetch_sub(1, std::memory_order_relaxed);
+        Progress = nullptr;
+    }
+}
+
+bool IsJobProgressStalled(const JobProgress& progress, int64_t timeoutMs) {
+    if (progress.IdleWaits.load(std::memory_order_relaxed) != 0) {
+        return false;
+    }
+    return SteadyNowMs() - progress.LastHeartbeatTimeMs.load(std::memory_order_relaxed)
+           >= timeoutMs;
+}
+
+JobProgressSnapshot SampleJobProgress(const JobProgress& progress) {
+    JobProgressSnapshot s;
+    s.Kind = progress.Kind.load(std::memory_order_acquire);
+    if (s.Kind == JobProgressKind::None) {
+        return s;
+    }
+
+    int64_t now = SteadyNowMs();
+    s.ElapsedSeconds =
+        static_cast<double>(now - progress.StartTimeMs.load(std::memory_order_relaxed)) / 1000.0;
+    s.SecondsSinceLastUpdate =
+        static_cast<double>(now - progress.LastUpdateTimeMs.load(std::memory_order_relaxed))
+        / 1000.0;
+    s.TotalDurationUs = progress.TotalDurationUs.load(std::memory_order_relaxed);
+    s.OutTimeUs = progress.OutTimeUs.load(std::memory_order_relaxed);
+    s.Frame = progress.Frame.load(std::memory_order_relaxed);
+    s.Fps = progress.Fps.load(std::memory_order_relaxed);
+    s.Speed = progress.Speed.load(std::memory_order_relaxed);
+    s.TotalSizeBytes = progress.TotalSizeBytes.load(std::memory_order_relaxed);
+    s.ExpectedSizeBytes = progress.ExpectedSizeBytes.load(std::memory_order_relaxed);
+    s.BytesPerSecond = progress.BytesPerSecond.load(std::memory_order_relaxed);
+
+    if (s.Kind == JobProgressKind::Encode) {
+        if (s.TotalDurationUs > 0 && s.OutTimeUs >= 0) {
+            s.Fraction = static_cast<double>(s.OutTimeUs) / static_cast<double>(s.TotalDurationUs);
+            if (s.Fraction > 1.0) {
+                s.Fraction = 1.0;
+            }
+
+            // ffmpeg's speed is averaged over the whole run, so it's a decent predictor
+            double speed = s.Speed;
+            if (speed <= 0.0 && s.ElapsedSeconds > 0.0) {
+                speed = (static_cast<double>(s.OutTimeUs) / 1000000.0) / s.ElapsedSeconds;
+            }
+            if (speed > 0.0) {
+                int64_t remainingUs = s.TotalDurationUs - s.OutTimeUs;
+                if (remainingUs > 0) {
+                    s.EtaSeconds = static_cast<int64_t>(
+                        (static_cast<double>(remainingUs) / 1000000.0) / speed);
+                } else {
+                    s.EtaSeconds = 0;
+                }
+            }
+        }
+    } else if (s.Kind == JobProgressKind::Download) {
+        if (s.ExpectedSizeBytes > 0) {
+            s.Fraction =
+                static_cast<double>(s.TotalSizeBytes) / static_cast<double>(s.ExpectedSizeBytes);
+            if (s.Fraction > 1.0) {
+                s.Fraction = 1.0;
+            }
+        }
+        s.EtaSeconds = progress.ReportedEtaSeconds.load(std::memory_order_relaxed);
+        if (s.EtaSeconds < 0 && s.ExpectedSizeBytes > s.TotalSizeBytes && s.BytesPerSecond > 0.0) {
+            s.EtaSeconds = static_cast<int64_t>(
+                static_cast<double>(s.ExpectedSizeBytes - s.TotalSizeBytes) / s.BytesPerSecond);
+        }
+    }
+
+    return s;
+}
+
+static std::string_view FormatSeconds(int64_t seconds, std::array<char, 24>& buffer) {
+    return TimeSpanToStringForGui(TimeSpan::FromIntegerSeconds(seconds), buffer);
+}
+
+static std::string FormatBytes(double bytes) {
+    if (bytes >= 1024.0 * 1024.0 * 1024.0) {
+        return std::format("{:.2f} GiB", bytes / (1024.0 * 1024.0 * 1024.0));
+    }
+    if (bytes >= 1024.0 * 1024.0) {
+        return std::format("{:.1f} MiB", bytes / (1024.0 * 1024.0));
+    }
+    return std::format("{:.0f} KiB", bytes / 1024.0);
+}
+
+std::string FormatJobProgress(const JobProgressSnapshot& snapshot) {
+    std::string result;
+    std::array<char, 24> buffer;
+    if (snapshot.Kind == JobProgressKind::Encode) {
+        result.append(FormatSeconds(snapshot.OutTimeUs / 1000000, buffer));
+        if (snapshot.TotalDurationUs > 0) {
+            result.append(" / ");
+            result.append(FormatSeconds(snapshot.TotalDurationUs / 1000000, buffer));
+        }
+        if (snapshot.Fraction >= 0.0) {
+            result.append(std::format(" ({:.1f}%)", snapshot.Fraction * 100.0));
+        }
+        result.append(std::format(", {:.1f} fps, {:.2f}x, {}",
+                                  snapshot.Fps,
+                                  snapshot.Speed,
+                                  FormatBytes(static_cast<double>(snapshot.TotalSizeBytes))));
+    } else if (snapshot.Kind == JobProgressKind::Download) {
+        result.append(FormatBytes(static_cast<double>(snapshot.TotalSizeBytes)));
+        if (snapshot.ExpectedSizeBytes > 0) {
+            result.append(" / ");
+            result.append(FormatBytes(static_cast<double>(snapshot.ExpectedSizeBytes)));
+        }
+        if (snapshot.Fraction >= 0.0) {
+            result.append(std::format(" ({:.1f}%)", snapshot.Fraction * 100.0));
+        }
+        result.append(std::format(", {}/s", FormatBytes(snapshot.BytesPerSecond)));
+    } else {
+        return result;
+    }
+
+    if (snapshot.EtaSeconds >= 0) {
+        result.append(", ETA ");
+        result.append(FormatSeconds(snapshot.EtaSeconds, buffer));
+    }
+    return result;
+}
+
+void JobProgressThroughput::Add(const JobProgressSnapshot& snapshot) {
+    if (snapshot.Kind == JobProgressKind::Encode) {
+        ++EncodeJobs;
+        EncodeFps += snapshot.Fps;
+        EncodeSpeed += snapshot.Speed;
+    } else if (snapshot.Kind == JobProgressKind::Download) {
+        ++DownloadJobs;
+        DownloadBytesPerSecond += snapshot.BytesPerSecond;
+    }
+}
+
+std::string FormatJobProgressThroughput(const JobProgressThroughput& throughput) {
+    std::string result;
+    if (throughput.EncodeJobs > 0) {
+        result.append(std::format("{} encoding at {:.1f} fps ({:.2f}x)",
+                                  throughput.EncodeJobs,
+                                  throughput.EncodeFps,
+                                  throughput.EncodeSpeed));
+    }
+    if (throughput.DownloadJobs > 0) {
+        if (!result.empty()) {
+            result.append(", ");
+        }
+        result.append(std::format("{} downloading at {}/s",
+                                  throughput.DownloadJobs,
+                                  FormatBytes(throughput.DownloadBytesPerSecond)));
+    }
+    return result;
+}
+
+// Splits off all complete lines in pending+data and calls parseLine for each, keeping the
+// incomplete remainder in pending.
+template<typename ParseLineT>
+static void FeedLines(std::string& pending, std::string_view data, ParseLineT&& parseLine) {
+    while (!data.empty()) {
+        size_t pos = data.find_first_of("\r\n");
+        if (pos == std::string_view::npos) {
+            pending.append(data);
+            return;
+        }
+        if (pending.empty()) {
+            parseLine(data.substr(0, pos));
+        } else {
+            pending.append(data.substr(0, pos));
+            parseLine(std::string_view(pending));
+            pending.clear();
+        }
+        data = data.substr(pos + 1);
+    }
+}
+
+FFMpegProgressParser::FFMpegProgressParser(JobProgress& progress) : Progress(progress) {}
+
+void FFMpegProgressParser::Feed(std::string_view data) {
+    FeedLines(Pending, data, [&](std::string_view line) { ParseLine(line); });
+}
+
+void FFMpegProgressParser::ParseLine(std::string_view line) {
+    auto eq = line.find('=');
+    if (eq == std::string_view::npos) {
+        return;
+    }
+    std::string_view key = HyoutaUtils::TextUtils::Trim(line.substr(0, eq));
+    std::string_view value = HyoutaUtils::TextUtils::Trim(line.substr(eq + 1));
+
+    // ffmpeg prints 'N/A' for anything it doesn't know yet, which simply fails to parse here
+    if (key == "frame") {
+        if (auto v = HyoutaUtils::NumberUtils::ParseUInt64(value)) {
+            Progress.Frame.store(*v, std::memory_order_relaxed);
+        }
+    } else if (key == "fps") {
+        if (auto v = HyoutaUtils::NumberUtils::ParseDouble(value)) {
+            Progress.Fps.store(*v, std::memory_order_relaxed);
+        }
+    } else if (key == "total_size") {
+        if (auto v = HyoutaUtils::NumberUtils::ParseUInt64(value)) {
+            Progress.TotalSizeBytes.store(*v, std::memory_order_relaxed);
+        }
+    } else if (key == "out_time_us") {
+        if (auto v = HyoutaUtils::NumberUtils::ParseInt64(value)) {
+            Progress.OutTimeUs.store(*v, std::memory_order_relaxed);
+        }
+    } else if (key == "speed") {
+        if (value.ends_with('x')) {
+            value = value.substr(0, value.size() - 1);
+        }
+        if (auto v = HyoutaUtils::NumberUtils::ParseDouble(value)) {
+            Progress.Speed.store(*v, std::memory_order_relaxed);
+        }
+    } else if (key == "progress") {
+        // marks the end of one block of values
+        Progress.LastUpdateTimeMs.store(SteadyNowMs(), std::memory_order_relaxed);
+        Progress.Heartbeat();
+    }
+}
+
+YtDlpProgressParser::YtDlpProgressParser(JobProgress& progress) : Progress(progress) {}
+
+void YtDlpProgressParser::Feed(std::string_view data) {
+    FeedLines(Pending, data, [&](std::string_view line) { ParseLine(line); });
+}
+
+void YtDlpProgressParser::ParseLine(std::string_view line) {
+    static constexpr std::string_view marker = "[vodarchiver-progress]";
+    line = HyoutaUtils::TextUtils::Trim(line);
+    if (!line.starts_with(marker)) {
+        return;
+    }
+    line = line.substr(marker.size());
+
+    std::array<std::string_view, 5> fields;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        line = HyoutaUtils::TextUtils::Trim(line);
+        size_t pos = line.find(' ');
+        fields[i] = line.substr(0, pos);
+        line = pos == std::string_view::npos ? std::string_view() : line.substr(pos);
+    }
+
+    // yt-dlp may print integral values as floats, so parse everything as double
+    auto parse = [](std::string_view sv) -> std::optional<double> {
+        auto v = HyoutaUtils::NumberUtils::ParseDouble(sv);
+        if (v && *v >= 0.0) {
+            return v;
+        }
+        return std::nullopt;
+    };
+    if (auto v = parse(fields[0])) {
+        Progress.TotalSizeBytes.store(static_cast<uint64_t>(*v), std::memory_order_relaxed);
+    }
+    if (auto v = parse(fields[1])) {
+        Progress.ExpectedSizeBytes.store(static_cast<uint64_t>(*v), std::memory_order_relaxed);
+    } else if (auto e = parse(fields[2])) {
+        Progress.ExpectedSizeBytes.store(static_cast<uint64_t>(*e), std::memory_order_relaxed);
+    }
+    if (auto v = parse(fields[3])) {
+        Progress.BytesPerSecond.store(*v, std::memory_order_relaxed);
+    }
+    if (auto v = parse(fields[4])) {
+        Progress.ReportedEtaSeconds.store(static_cast<int64_t>(*v), std::memory_order_relaxed);
+    } else {
+        Progress.ReportedEtaSeconds.store(-1, std::memory_order_relaxed);
+    }
+    Progress.LastUpdateTimeMs.store(SteadyNowMs(), std::memory_order_relaxed);
+    Progress.Heartbeat();
+}
+} // namespace VodArchiver
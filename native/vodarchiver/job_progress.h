@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace VodArchiver {
+enum class JobProgressKind : uint8_t {
+    None,     // no external tool is currently reporting progress
+    Encode,   // ffmpeg, reported via '-progress pipe:1'
+    Download, // yt-dlp, reported via YtDlpProgressTemplate
+};
+
+// Structured progress of an external tool invoked by a job.
+// This is written by the job thread while the tool is running and may be sampled at any time from
+// any other thread. Every field is an independent atomic, so neither side needs to hold the
+// DataLock of the job. A reader may see a mix of two consecutive updates, which is fine for display
+// purposes.
+struct JobProgress {
+    JobProgress() = default;
+    JobProgress(const JobProgress& other) = delete;
+    JobProgress(JobProgress&& other) = delete;
+    JobProgress& operator=(const JobProgress& other) = delete;
+    JobProgress& operator=(JobProgress&& other) = delete;
+    ~JobProgress() = default;
+
+    // Resets all fields and marks the start of a new tool invocation.
+    // totalDurationUs is the length of the encode input in microseconds, or 0 if unknown.
+    void Begin(JobProgressKind kind, int64_t totalDurationUs = 0);
+    void End();
+
+    // Marks that the job is still doing something. Unlike the fields below this is also kept up to
+    // date between tool invocations, the VideoTaskGroup watchdog cancels jobs that go too long
+    // without one.
+    void Heartbeat();
+    std::atomic<int64_t> LastHeartbeatTimeMs = 0; // steady clock
+
+    // Non-zero while the job is deliberately waiting, eg. for a free disk IO slot, see JobIdleWait.
+    std::atomic<uint32_t> IdleWaits = 0;
+
+    std::atomic<JobProgressKind> Kind = JobProgressKind::None;
+    std::atomic<int64_t> StartTimeMs = 0; // steady clock
+    std::atomic<int64_t> LastUpdateTimeMs = 0;
+
+    // encode
+    std::atomic<int64_t> TotalDurationUs = 0;
+    std::atomic<int64_t> OutTimeUs = 0;
+    std::atomic<uint64_t> Frame = 0;
+    std::atomic<double> Fps = 0.0;
+    std::atomic<double> Speed = 0.0; // multiple of realtime
+
+    // both; for encodes this is the size of the output file so far
+    std::atomic<uint64_t> TotalSizeBytes = 0;
+
+    // download
+    std::atomic<uint64_t> ExpectedSizeBytes = 0;
+    std::atomic<double> BytesPerSecond = 0.0;
+    std::atomic<int64_t> ReportedEtaSeconds = -1;
+};
+
+// Exempts a job from the watchdog while it waits on something that may legitimately take hours,
+// like other jobs freeing up disk space. Counts as a heartbeat when it ends.
+struct JobIdleWait {
+    explicit JobIdleWait(JobProgress& progress);
+    JobIdleWait(const JobIdleWait& other) = delete;
+    JobIdleWait(JobIdleWait&& other) = delete;
+    JobIdleWait& operator=(const JobIdleWait& other) = delete;
+    JobIdleWait& operator=(JobIdleWait&& other) = delete;
+    ~JobIdleWait();
+
+    // Ends the wait early, for when the object has to outlive the wait itself.
+    void Finish();
+
+private:
+    JobProgress* Progress;
+};
+
+// True if the job has neither sent a heartbeat nor been in an idle wait for at least timeoutMs.
+bool IsJobProgressStalled(const JobProgress& progress, int64_t timeoutMs);
+
+// A consistent-enough copy of a JobProgress plus derived values.
+struct JobProgressSnapshot {
+    JobProgressKind Kind = JobProgressKind::None;
+    double ElapsedSeconds = 0.0;
+    double SecondsSinceLastUpdate = 0.0;
+
+    int64_t TotalDurationUs = 0;
+    int64_t OutTimeUs = 0;
+    uint64_t Frame = 0;
+    double Fps = 0.0;
+    double Speed = 0.0;
+    uint64_t TotalSizeBytes = 0;
+    uint64_t ExpectedSizeBytes = 0;
+    double BytesPerSecond = 0.0;
+
+    double Fraction = -1.0;  // 0 to 1, or negative if unknown
+    int64_t EtaSeconds = -1; // negative if unknown
+};
+
+JobProgressSnapshot SampleJobProgress(const JobProgress& progress);
+std::string FormatJobProgress(const JobProgressSnapshot& snapshot);
+
+// Sum over all currently reporting jobs, for capacity planning.
+struct JobProgressThroughput {
+    uint32_t EncodeJobs = 0;
+    double EncodeFps = 0.0;
+    double EncodeSpeed = 0.0; // seconds of video encoded per second
+    uint32_t DownloadJobs = 0;
+    double DownloadBytesPerSecond = 0.0;
+
+    void Add(const JobProgressSnapshot& snapshot);
+};
+
+std::string FormatJobProgressThroughput(const JobProgressThroughput& throughput);
+
+// Feed this the stdout of 'ffmpeg -progress pipe:1 -nostats'. It's fine to split the input at
+// arbitrary positions.
+struct FFMpegProgressParser {
+    explicit FFMpegProgressParser(JobProgress& progress);
+
+    void Feed(std::string_view data);
+
+private:
+    void ParseLine(std::string_view line);
+
+    JobProgress& Progress;
+    std::string Pending;
+};
+
+// Pass this to yt-dlp as '--progress-template' together with '--newline'. Every download progress
+// line will then contain, separated by spaces: marker, downloaded bytes, total bytes, estimated
+// total bytes, speed in bytes per second and eta in seconds. yt-dlp prints 'NA' for unknown values.
+static constexpr std::string_view YtDlpProgressTemplate =
+    "download:[vodarchiver-progress] %(progress.downloaded_bytes)s %(progress.total_bytes)s "
+    "%(progress.total_bytes_estimate)s %(progress.speed)s %(progress.eta)s";
+
+// Feed this the stdout of yt-dlp invoked with YtDlpProgressTemplate. Lines that don't match the
+// template are ignored.
+struct YtDlpProgressParser {
+    explicit YtDlpProgressParser(JobProgress& progress);
+
+    void Feed(std::string_view data);
+
+private:
+    void ParseLine(std::string_view line);
+
+    JobProgress& Progress;
+    std::string Pending;
+};
+} // namespace VodArchiver
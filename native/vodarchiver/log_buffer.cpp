@@ -0,0 +1,209 @@
+#include "log_buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "util/file.h"
+#include "util/logger.h"
+#include "util/thread.h"
+
+#include "time_types.h"
+
+namespace VodArchiver {
+// how much the process keeps in memory, at roughly 270 bytes per record
+static constexpr size_t DefaultLogCapacity = 4096;
+
+// how often the LogFileWriter looks for new records
+static constexpr auto LogFileWriteInterval = std::chrono::seconds(1);
+
+std::string_view LogSourceToString(LogSource source) {
+    switch (source) {
+        case LogSource::General: return "General";
+        case LogSource::Fetch: return "Fetch";
+        case LogSource::Job: return "Job";
+        default: return "Unknown";
+    }
+}
+
+std::string_view LogSeverityToString(LogSeverity severity) {
+    switch (severity) {
+        case LogSeverity::Info: return "Info";
+        case LogSeverity::Warning: return "Warning";
+        case LogSeverity::Error: return "Error";
+        default: return "Unknown";
+    }
+}
+
+LogBuffer::LogBuffer(size_t capacity)
+  : Capacity(capacity), Slots(std::make_unique<Slot[]>(capacity)) {
+    assert(capacity != 0 && (capacity & (capacity - 1)) == 0);
+}
+
+LogBuffer::~LogBuffer() = default;
+
+void LogBuffer::Append(LogSource source, LogSeverity severity, std::string_view message) {
+    const uint64_t index = NextIndex.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = Slots[index & (Capacity - 1)];
+
+    // the slot is ours once the record one lap earlier is completely written. this can only ever
+    // wait when more than Capacity threads are appending at the same moment
+    const uint64_t previous = index >= Capacity ? ((index - Capacity) * 2 + 2) : 0;
+    uint64_t expected = previous;
+    while (!slot.Sequence.compare_exchange_weak(
+        expected, index * 2 + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        expected = previous;
+        std::this_thread::yield();
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const size_t length = std::min(message.size(), MaxMessageLength);
+    slot.Timestamp.store(DateTime::UtcNow().Internal, std::memory_order_relaxed);
+    slot.Meta.store(static_cast<uint32_t>(source) | (static_cast<uint32_t>(severity) << 8)
+                        | (static_cast<uint32_t>(length) << 16),
+                    std::memory_order_relaxed);
+    for (size_t i = 0; i < length; i += 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, message.data() + i, std::min<size_t>(8, length - i));
+        slot.Text[i / 8].store(word, std::memory_order_relaxed);
+    }
+
+    slot.Sequence.store(index * 2 + 2, std::memory_order_release);
+}
+
+LogReadResult LogBuffer::Read(uint64_t index, LogRecord& record) const {
+    const Slot& slot = Slots[index & (Capacity - 1)];
+    const uint64_t done = index * 2 + 2;
+    const uint64_t before = slot.Sequence.load(std::memory_order_acquire);
+    if (before < done) {
+        return LogReadResult::NotWrittenYet;
+    }
+    if (before > done) {
+        return LogReadResult::Overwritten;
+    }
+
+    const uint64_t timestamp = slot.Timestamp.load(std::memory_order_relaxed);
+    const uint32_t meta = slot.Meta.load(std::memory_order_relaxed);
+    const size_t length = std::min<size_t>(meta >> 16, MaxMessageLength);
+    std::array<char, MaxMessageLength> text;
+    for (size_t i = 0; i < length; i += 8) {
+        const uint64_t word = slot.Text[i / 8].load(std::memory_order_relaxed);
+        std::memcpy(text.data() + i, &word, std::min<size_t>(8, length - i));
+    }
+
+    // if a writer started on this slot while we were copying the copy may be torn
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.Sequence.load(std::memory_order_relaxed) != before) {
+        return LogReadResult::Overwritten;
+    }
+
+    record.Timestamp = DateTime{.Internal = timestamp};
+    record.Source = static_cast<LogSource>(meta & 0xff);
+    record.Severity = static_cast<LogSeverity>((meta >> 8) & 0xff);
+    record.Message.assign(text.data(), length);
+    return LogReadResult::Ok;
+}
+
+LogBuffer& GetLogBuffer() {
+    static LogBuffer buffer(DefaultLogCapacity);
+    return buffer;
+}
+
+LogFileWriter::LogFileWriter(LogBuffer& buffer, std::string path, uint64_t maxFileSize)
+  : Buffer(buffer)
+  , Path(std::move(path))
+  , MaxFileSize(maxFileSize)
+  , NextIndex(buffer.GetBegin()) {
+    StartNewFile();
+    Thread = std::thread(std::bind(&LogFileWriter::ThreadFunc, this));
+}
+
+LogFileWriter::~LogFileWriter() {
+    {
+        std::lock_guard lock(Mutex);
+        Stopping = true;
+    }
+    CondVar.notify_all();
+    Thread.join();
+}
+
+void LogFileWriter::ThreadFunc() {
+    HyoutaUtils::SetThreadName("LogFileWriter");
+    while (true) {
+        bool stopping;
+        {
+            std::unique_lock lock(Mutex);
+            CondVar.wait_for(lock, LogFileWriteInterval, [&] { return Stopping; });
+            stopping = Stopping;
+        }
+
+        WriteNewRecords();
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void LogFileWriter::WriteNewRecords() {
+    const uint64_t end = Buffer.GetEnd();
+    uint64_t lost = 0;
+    if (NextIndex < Buffer.GetBegin()) {
+        lost = Buffer.GetBegin() - NextIndex;
+        NextIndex = Buffer.GetBegin();
+    }
+
+    LogRecord record;
+    std::string line;
+    while (NextIndex < end) {
+        const LogReadResult result = Buffer.Read(NextIndex, record);
+        if (result == LogReadResult::NotWrittenYet) {
+            // pick it and everything after it up next time
+            break;
+        }
+        ++NextIndex;
+        if (result == LogReadResult::Overwritten) {
+            ++lost;
+            continue;
+        }
+
+        line.clear();
+        if (lost != 0) {
+            std::format_to(std::back_inserter(line), "[{} log messages lost]\n", lost);
+            lost = 0;
+        }
+        std::array<char, 24> timestamp;
+        std::format_to(std::back_inserter(line),
+                       "{} [{}] {}: {}\n",
+                       DateTimeToStringForGui(record.Timestamp, timestamp),
+                       LogSourceToString(record.Source),
+                       LogSeverityToString(record.Severity),
+                       record.Message);
+        if (FileSize + line.size() > MaxFileSize) {
+            StartNewFile();
+        }
+        Log.Log(line);
+        FileSize += line.size();
+    }
+}
+
+void LogFileWriter::StartNewFile() {
+    Log = HyoutaUtils::Logger();
+    std::string previousPath = Path + ".1";
+    HyoutaUtils::IO::Move(Path, previousPath, true);
+    Log = HyoutaUtils::Logger(
+        HyoutaUtils::IO::File(std::string_view(Path), HyoutaUtils::IO::OpenMode::Write));
+    FileSize = 0;
+}
+} // namespace VodArchiver
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "util/logger.h"
+
+#include "time_types.h"
+
+namespace VodArchiver {
+enum class LogSource : uint8_t {
+    General,
+    Fetch,
+    Job,
+    COUNT,
+};
+std::string_view LogSourceToString(LogSource source);
+
+enum class LogSeverity : uint8_t {
+    Info,
+    Warning,
+    Error,
+    COUNT,
+};
+std::string_view LogSeverityToString(LogSeverity severity);
+
+struct LogRecord {
+    DateTime Timestamp{.Internal = 0};
+    LogSource Source = LogSource::General;
+    LogSeverity Severity = LogSeverity::Info;
+    std::string Message;
+};
+
+enum class LogReadResult : uint8_t {
+    Ok,
+    NotWrittenYet, // the record is still being appended, try again later
+    Overwritten,   // the record was too old and has been replaced by a newer one
+};
+
+// Fixed-capacity ring of the most recent log records. Appending never takes a lock, so it's fine to
+// call from any fetch or job thread. When the ring is full the oldest records are overwritten, so
+// memory use stays the same no matter how long the program runs.
+// Readers don't remove anything, records are addressed by an index that keeps increasing with
+// every appended record. Use a LogFileWriter to keep records that fall out of the ring.
+struct LogBuffer {
+    // Longer messages are cut off.
+    static constexpr size_t MaxMessageLength = 248;
+
+    // capacity must be a power of two
+    explicit LogBuffer(size_t capacity);
+    LogBuffer(const LogBuffer& other) = delete;
+    LogBuffer(LogBuffer&& other) = delete;
+    LogBuffer& operator=(const LogBuffer& other) = delete;
+    LogBuffer& operator=(LogBuffer&& other) = delete;
+    ~LogBuffer();
+
+    void Append(LogSource source, LogSeverity severity, std::string_view message);
+
+    // The index the next appended record will get. Records before this may still be incomplete.
+    uint64_t GetEnd() const {
+        return NextIndex.load(std::memory_order_acquire);
+    }
+
+    // The oldest index that may still be readable.
+    uint64_t GetBegin() const {
+        const uint64_t end = GetEnd();
+        return end > Capacity ? (end - Capacity) : 0;
+    }
+
+    size_t GetCapacity() const {
+        return Capacity;
+    }
+
+    LogReadResult Read(uint64_t index, LogRecord& record) const;
+
+private:
+    struct Slot {
+        // 2 * index + 1 while the record for index is being written, 2 * index + 2 once it's done.
+        // readers check this before and after copying a record to detect concurrent overwrites.
+        std::atomic<uint64_t> Sequence = 0;
+        std::atomic<uint64_t> Timestamp = 0;
+        std::atomic<uint32_t> Meta = 0; // source, severity and message length
+        std::array<std::atomic<uint64_t>, MaxMessageLength / 8> Text{};
+    };
+
+    size_t Capacity;
+    std::unique_ptr<Slot[]> Slots;
+    std::atomic<uint64_t> NextIndex = 0;
+};
+
+// The log everything in the process writes to.
+LogBuffer& GetLogBuffer();
+
+// Copies everything appended to a LogBuffer into a text file on a background thread, so the log
+// survives records falling out of the ring. An existing file is moved to <path>.1 at startup, and
+// the same happens whenever the file grows beyond maxFileSize.
+struct LogFileWriter {
+    LogFileWriter(LogBuffer& buffer, std::string path, uint64_t maxFileSize);
+    LogFileWriter(const LogFileWriter& other) = delete;
+    LogFileWriter(LogFileWriter&& other) = delete;
+    LogFileWriter& operator=(const LogFileWriter& other) = delete;
+    LogFileWriter& operator=(LogFileWriter&& other) = delete;
+    ~LogFileWriter(); // writes out everything that's left
+
+private:
+    void ThreadFunc();
+    void WriteNewRecords();
+    void StartNewFile();
+
+    LogBuffer& Buffer;
+    std::string Path;
+    uint64_t MaxFileSize;
+
+    // only accessed by the writer thread after construction
+    HyoutaUtils::Logger Log;
+    uint64_t FileSize = 0;
+    uint64_t NextIndex;
+
+    std::mutex Mutex;
+    std::condition_variable CondVar;
+    bool Stopping = false;
+    std::thread Thread;
+};
+} // namespace VodArchiver
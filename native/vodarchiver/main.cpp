@@ -8,6 +8,8 @@
 #include "util/text.h"
 
 #include "cli_tool.h"
+#include "main_convert_jobs.h"
+#include "main_daemon.h"
 
 #ifdef BUILD_FOR_WINDOWS
 #define WIN32_LEAN_AND_MEAN
@@ -21,6 +23,12 @@ static constexpr auto CliTools = {
     CliTool{.Name = "GUI",
             .ShortDescription = "Start the interactive GUI.",
             .Function = VodArchiver::RunGui},
+    CliTool{.Name = "Daemon",
+            .ShortDescription = "Run fetches and jobs in the background without the GUI.",
+            .Function = VodArchiver::RunDaemon},
+    CliTool{.Name = "ConvertJobs",
+            .ShortDescription = "Convert the job list between the XML and snapshot formats.",
+            .Function = VodArchiver::RunConvertJobs},
 };
 } // namespace VodArchiver
 
@@ -0,0 +1,74 @@
+#include "main_convert_jobs.h"
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "util/args.h"
+#include "util/text.h"
+
+#include "videojobs/job_snapshot.h"
+#include "videojobs/serialization.h"
+
+namespace VodArchiver {
+static constexpr HyoutaUtils::Arg Arg_Format{
+    .Type = HyoutaUtils::ArgTypes::String,
+    .ShortKey = "f",
+    .LongKey = "format",
+    .Argument = "FORMAT",
+    .Description = "Format to write, 'xml' or 'snapshot'. Defaults to whichever format the input "
+                   "is not in."};
+static constexpr auto Arg_Array = {&Arg_Format};
+static constexpr HyoutaUtils::Args Args(
+    "vodarchiver ConvertJobs",
+    "INPUT OUTPUT",
+    "Converts a job list (downloads.bin or downloads.snapshot) between the XML format and the "
+    "binary snapshot format. Don't run this on the files of a running instance.",
+    Arg_Array);
+
+int RunConvertJobs(int argc, char** argvUtf8) {
+    auto parseResult = Args.Parse(argc, argvUtf8);
+    if (parseResult.IsError()) {
+        printf("Argument error: %s\n\n\n", parseResult.GetErrorValue().c_str());
+        Args.PrintUsage();
+        return -1;
+    }
+    const auto& args = parseResult.GetSuccessValue();
+    if (args.FreeArguments.size() != 2) {
+        Args.PrintUsage();
+        return -1;
+    }
+    const std::string inputPath(args.FreeArguments[0]);
+    const std::string outputPath(args.FreeArguments[1]);
+
+    JobStoreFormat format =
+        IsJobSnapshotFile(inputPath) ? JobStoreFormat::Xml : JobStoreFormat::Snapshot;
+    if (auto* formatName = args.TryGetString(&Arg_Format)) {
+        if (HyoutaUtils::TextUtils::CaseInsensitiveEquals(*formatName, "xml")) {
+            format = JobStoreFormat::Xml;
+        } else if (HyoutaUtils::TextUtils::CaseInsensitiveEquals(*formatName, "snapshot")) {
+            format = JobStoreFormat::Snapshot;
+        } else {
+            printf("Unknown format: %.*s\n",
+                   static_cast<int>(formatName->size()),
+                   formatName->data());
+            return -1;
+        }
+    }
+
+    auto jobs = ParseJobsFromFile(inputPath);
+    if (!jobs) {
+        printf("Failed to read jobs from %s\n", inputPath.c_str());
+        return -1;
+    }
+    if (!WriteJobsToFile(*jobs, outputPath, format)) {
+        printf("Failed to write jobs to %s\n", outputPath.c_str());
+        return -1;
+    }
+    printf("Wrote %zu jobs to %s as %s.\n",
+           jobs->size(),
+           outputPath.c_str(),
+           format == JobStoreFormat::Xml ? "XML" : "snapshot");
+    return 0;
+}
+} // namespace VodArchiver
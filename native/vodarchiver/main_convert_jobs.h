@@ -0,0 +1,5 @@
+#pragma once
+
+namespace VodArchiver {
+int RunConvertJobs(int argc, char** argvUtf8);
+} // namespace VodArchiver
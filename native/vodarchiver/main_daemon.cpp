@@ -0,0 +1,374 @@
+#include "main_daemon.h"
+
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/args.h"
+#include "util/file.h"
+#include "util/scope.h"
+
+#include "background_save_thread.h"
+#include "common_paths.h"
+#include "control_server.h"
+#include "curl_util.h"
+#include "gui/gui_user_settings.h"
+#include "job_config.h"
+#include "job_handling.h"
+#include "task_cancellation.h"
+#include "tasks/fetch-task-group.h"
+#include "tasks/video-task-group.h"
+#include "time_types.h"
+#include "userinfo/i-user-info.h"
+#include "userinfo/serialization.h"
+#include "videojobs/i-video-job.h"
+#include "videojobs/job_snapshot.h"
+#include "videojobs/serialization.h"
+
+#ifdef BUILD_FOR_WINDOWS
+#include <condition_variable>
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+namespace VodArchiver {
+static constexpr HyoutaUtils::Arg Arg_Settings{
+    .Type = HyoutaUtils::ArgTypes::String,
+    .ShortKey = "s",
+    .LongKey = "settings",
+    .Argument = "PATH",
+    .Description = "Settings file to use instead of the one of the GUI. Give every instance on the "
+                   "same machine its own file with its own persistent data path."};
+static constexpr HyoutaUtils::Arg Arg_NoEnqueue{
+    .Type = HyoutaUtils::ArgTypes::Flag,
+    .ShortKey = "",
+    .LongKey = "no-enqueue",
+    .Argument = "",
+    .Description = "Don't run any jobs, only fetch new videos."};
+static constexpr HyoutaUtils::Arg Arg_ControlPort{
+    .Type = HyoutaUtils::ArgTypes::UInt64,
+    .ShortKey = "",
+    .LongKey = "control-port",
+    .Argument = "PORT",
+    .Description = "Serve metrics and accept enqueue/cancel requests on this port on localhost. "
+                   "Overrides the port from the settings file, 0 turns it off."};
+static constexpr auto Arg_Array = {&Arg_Settings, &Arg_NoEnqueue, &Arg_ControlPort};
+static constexpr HyoutaUtils::Args Args(
+    "vodarchiver Daemon",
+    "",
+    "Runs all fetches and jobs without the GUI until interrupted via Ctrl+C or SIGTERM.",
+    Arg_Array);
+
+namespace {
+// The parts of GuiState that the task groups need. Declared so that the members are destroyed in a
+// safe order, though RunDaemon() tears down the task groups explicitly anyway.
+struct DaemonState {
+    GuiUserSettings Settings;
+    JobList Jobs;
+    std::recursive_mutex UserInfosLock;
+    std::vector<std::unique_ptr<IUserInfo>> UserInfos;
+    JobConfig JobConf;
+    TaskCancellation CancellationToken;
+    std::unique_ptr<BackgroundSaveThread> SaveThread;
+    std::vector<std::unique_ptr<VideoTaskGroup>> VideoTaskGroups;
+    std::vector<std::unique_ptr<FetchTaskGroup>> FetchTaskGroups;
+    std::unique_ptr<ControlServer> Control;
+    std::mutex StatusMessageLock;
+};
+} // namespace
+
+#ifdef BUILD_FOR_WINDOWS
+namespace {
+struct ShutdownSignal {
+    std::mutex Mutex;
+    std::condition_variable CondVar;
+    bool Requested = false;
+    bool Finished = false;
+};
+} // namespace
+
+static ShutdownSignal& GetShutdownSignal() {
+    static ShutdownSignal shutdown;
+    return shutdown;
+}
+
+static BOOL WINAPI ConsoleCtrlHandler(DWORD ctrlType) {
+    ShutdownSignal& shutdown = GetShutdownSignal();
+    std::unique_lock lock(shutdown.Mutex);
+    shutdown.Requested = true;
+    shutdown.CondVar.notify_all();
+
+    // for these the process is terminated as soon as we return, so hold on until the jobs are saved
+    if (ctrlType == CTRL_CLOSE_EVENT || ctrlType == CTRL_LOGOFF_EVENT
+        || ctrlType == CTRL_SHUTDOWN_EVENT) {
+        shutdown.CondVar.wait(lock, [&] { return shutdown.Finished; });
+    }
+    return TRUE;
+}
+#endif
+
+static void PrintStatusMessage(DaemonState& state, std::string_view msg) {
+    std::lock_guard lock(state.StatusMessageLock);
+    printf("%.*s\n", static_cast<int>(msg.size()), msg.data());
+    fflush(stdout);
+}
+
+static void EnqueueAllNotStartedJobs(DaemonState& state) {
+    std::lock_guard lock(state.Jobs.JobsLock);
+    std::vector<std::vector<IVideoJob*>> jobsPerGroup(state.VideoTaskGroups.size());
+    for (auto& job : state.Jobs.JobsVector) {
+        if (job->JobStatus == VideoJobStatus::NotStarted) {
+            size_t service;
+            {
+                std::lock_guard jobLock(job->DataLock);
+                service = static_cast<size_t>(job->VideoInfo->GetService());
+            }
+            if (service < jobsPerGroup.size()) {
+                jobsPerGroup[service].push_back(job.get());
+            }
+        }
+    }
+    for (size_t i = 0; i < jobsPerGroup.size(); ++i) {
+        state.VideoTaskGroups[i]->EnqueueBulk(jobsPerGroup[i]);
+    }
+}
+
+int RunDaemon(int argc, char** argvUtf8) {
+    auto parseResult = Args.Parse(argc, argvUtf8);
+    if (parseResult.IsError()) {
+        printf("Argument error: %s\n\n\n", parseResult.GetErrorValue().c_str());
+        Args.PrintUsage();
+        return -1;
+    }
+    const auto& args = parseResult.GetSuccessValue();
+    if (!args.FreeArguments.empty()) {
+        Args.PrintUsage();
+        return -1;
+    }
+
+    std::string iniPath;
+    if (auto* settingsPath = args.TryGetString(&Arg_Settings)) {
+        iniPath = std::string(*settingsPath);
+    } else {
+        std::optional<std::string> guiSettingsFolder =
+            CommonPaths::GetLocalVodArchiverGuiSettingsFolder();
+        if (!guiSettingsFolder) {
+            printf("Could not determine settings folder, use --settings.\n");
+            return -1;
+        }
+        iniPath = std::move(*guiSettingsFolder);
+        iniPath.append("/gui.ini");
+    }
+
+    // The termination signals are waited for synchronously in this thread, so they have to be
+    // blocked before any other thread is started, as those inherit the signal mask.
+#ifdef BUILD_FOR_WINDOWS
+    if (!SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE)) {
+        printf("Failed to install console control handler.\n");
+        return -1;
+    }
+#else
+    sigset_t terminationSignals;
+    sigemptyset(&terminationSignals);
+    sigaddset(&terminationSignals, SIGINT);
+    sigaddset(&terminationSignals, SIGTERM);
+    sigaddset(&terminationSignals, SIGHUP);
+    if (pthread_sigmask(SIG_BLOCK, &terminationSignals, nullptr) != 0) {
+        printf("Failed to block termination signals.\n");
+        return -1;
+    }
+#endif
+
+    VodArchiver::curl::InitCurl();
+    auto curlCleanup = HyoutaUtils::MakeScopeGuard([]() { VodArchiver::curl::DeinitCurl(); });
+
+    DaemonState state;
+    InitGuiUserSettings(state.Settings);
+    if (!LoadUserSettingsFromIni(state.Settings, iniPath)) {
+        printf("Failed to load settings from %s, using defaults.\n", iniPath.c_str());
+    }
+
+    const std::string vodXmlPath = GetVodXmlPath(state.Settings);
+    const std::string vodSnapshotPath = GetVodSnapshotPath(state.Settings);
+    const std::string userInfoXmlPath = GetUserInfoXmlPath(state.Settings);
+    const std::string vodLoadPath(ChooseJobStoreFile(
+        vodXmlPath,
+        vodSnapshotPath,
+        state.Settings.SaveJobsAsSnapshot ? JobStoreFormat::Snapshot : JobStoreFormat::Xml));
+    {
+        // finished jobs are never looked at again unless someone asks for them through the control
+        // server, so they stay in the mapped snapshot instead of being decoded. this relies on the
+        // mapping outliving the file being replaced by the next save, which Windows doesn't allow.
+        bool loaded = false;
+#ifndef BUILD_FOR_WINDOWS
+        if (IsJobSnapshotFile(vodLoadPath)) {
+            auto snapshot = std::make_shared<JobSnapshot>();
+            if (snapshot->Open(vodLoadPath)) {
+                std::lock_guard lock(state.Jobs.JobsLock);
+                SetJobsFromSnapshotNoLock(state.Jobs, std::move(snapshot), vodLoadPath);
+                loaded = true;
+            }
+        }
+#endif
+        if (!loaded) {
+            auto jobs = ParseJobsFromFile(vodLoadPath);
+            if (jobs) {
+                std::lock_guard lock(state.Jobs.JobsLock);
+                SetJobsNoLock(state.Jobs, std::move(*jobs));
+            }
+        }
+    }
+    {
+        auto userinfos = ParseUserInfosFromFile(userInfoXmlPath);
+        if (userinfos) {
+            state.UserInfos = std::move(*userinfos);
+        }
+    }
+    printf("Loaded %zu jobs from %s\n",
+           state.Jobs.JobsVector.size() + state.Jobs.Dormant.Indices.size(),
+           vodLoadPath.c_str());
+    printf("Loaded %zu users from %s\n", state.UserInfos.size(), userInfoXmlPath.c_str());
+    fflush(stdout);
+
+    ApplyUserSettingsToJobConfig(state.Settings, state.JobConf);
+
+    state.SaveThread = std::make_unique<BackgroundSaveThread>(
+        state.JobConf, state.Jobs, state.UserInfosLock, state.UserInfos);
+
+    const bool enqueue = !args.IsFlagSet(&Arg_NoEnqueue);
+    for (int s = static_cast<int>(StreamService::Unknown);
+         s < static_cast<int>(StreamService::COUNT);
+         ++s) {
+        state.VideoTaskGroups.emplace_back(std::make_unique<VideoTaskGroup>(
+            static_cast<StreamService>(s),
+            [&]() { state.SaveThread->RequestSaveJobs(); },
+            []() {},
+            &state.JobConf,
+            &state.CancellationToken));
+        state.VideoTaskGroups.back()->SetAutoEnqueue(enqueue);
+    }
+    if (enqueue) {
+        EnqueueAllNotStartedJobs(state);
+    }
+
+    {
+        uint32_t rngSeed = static_cast<uint32_t>(DateTime::UtcNow().GetTicks()
+                                                 / (DateTime::TICKS_PER_SECOND / 1000));
+        auto make_fetch_task_group = [&](std::vector<ServiceVideoCategoryType> services) {
+            state.FetchTaskGroups.emplace_back(std::make_unique<FetchTaskGroup>(
+                std::move(services),
+                &state.UserInfosLock,
+                &state.UserInfos,
+                &state.JobConf,
+                &state.CancellationToken,
+                [&](std::vector<std::unique_ptr<IVideoInfo>> infos) {
+                    return CreateAndEnqueueJobs(
+                        state.Jobs, std::move(infos), [&](IVideoJob* newJob) {
+                            AddJobToTaskGroupIfAutoenqueue(state.VideoTaskGroups, newJob);
+                        });
+                },
+                [&](const IVideoInfo& info) { return IsVideoKnown(state.Jobs, info); },
+                [&](std::string_view msg) { PrintStatusMessage(state, msg); },
+                [&]() { state.SaveThread->RequestSaveJobs(); },
+                [&]() { state.SaveThread->RequestSaveUsers(); },
+                rngSeed));
+            rngSeed = std::rotr(rngSeed, 3);
+            ++rngSeed;
+        };
+        make_fetch_task_group({{ServiceVideoCategoryType::TwitchRecordings,
+                                ServiceVideoCategoryType::TwitchHighlights}});
+        make_fetch_task_group({{ServiceVideoCategoryType::YoutubeUser,
+                                ServiceVideoCategoryType::YoutubeChannel,
+                                ServiceVideoCategoryType::YoutubePlaylist,
+                                ServiceVideoCategoryType::YoutubeUrl}});
+        make_fetch_task_group({{ServiceVideoCategoryType::RssFeed}});
+        make_fetch_task_group({{ServiceVideoCategoryType::FFMpegJob}});
+    }
+
+    uint64_t controlPort = state.Settings.ControlServerPort;
+    if (auto* port = args.TryGetUInt64(&Arg_ControlPort)) {
+        controlPort = *port;
+    }
+    if (controlPort > 65535) {
+        PrintStatusMessage(state, "Invalid control port, not starting the control server.");
+    } else if (controlPort != 0) {
+        state.Control =
+            std::make_unique<ControlServer>(state.JobConf, state.Jobs, state.VideoTaskGroups);
+        if (state.Control->Start(static_cast<uint16_t>(controlPort))) {
+            PrintStatusMessage(
+                state, std::format("Control server listening on 127.0.0.1:{}.", controlPort));
+        } else {
+            state.Control.reset();
+            PrintStatusMessage(
+                state, std::format("Failed to start control server on port {}.", controlPort));
+        }
+    }
+
+    PrintStatusMessage(state, "Running, interrupt to stop.");
+
+    // Nothing to do on this thread until we're told to stop.
+#ifdef BUILD_FOR_WINDOWS
+    {
+        ShutdownSignal& shutdown = GetShutdownSignal();
+        std::unique_lock lock(shutdown.Mutex);
+        shutdown.CondVar.wait(lock, [&] { return shutdown.Requested; });
+    }
+#else
+    while (true) {
+        int receivedSignal = 0;
+        if (sigwait(&terminationSignals, &receivedSignal) == 0) {
+            break;
+        }
+    }
+#endif
+
+    PrintStatusMessage(state, "Stopping, waiting for running jobs to cancel...");
+
+    // Stop everything that's still running.
+    state.Control.reset();
+    state.CancellationToken.CancelTask();
+    for (size_t i = state.FetchTaskGroups.size(); i > 0; --i) {
+        state.FetchTaskGroups[i - 1].reset();
+    }
+    for (size_t i = state.VideoTaskGroups.size(); i > 0; --i) {
+        state.VideoTaskGroups[i - 1].reset();
+    }
+    state.SaveThread.reset();
+
+    {
+        std::lock_guard lock(state.UserInfosLock);
+        WriteUserInfosToFile(state.UserInfos, userInfoXmlPath);
+    }
+    {
+        std::lock_guard lock(state.Jobs.JobsLock);
+        WriteJobStore(state.Jobs.JobsVector,
+                      vodXmlPath,
+                      vodSnapshotPath,
+                      state.Settings.SaveJobsAsSnapshot ? JobStoreFormat::Snapshot
+                                                        : JobStoreFormat::Xml,
+                      &state.Jobs.Dormant);
+    }
+    PrintStatusMessage(state, "Stopped.");
+
+#ifdef BUILD_FOR_WINDOWS
+    {
+        ShutdownSignal& shutdown = GetShutdownSignal();
+        std::lock_guard lock(shutdown.Mutex);
+        shutdown.Finished = true;
+        shutdown.CondVar.notify_all();
+    }
+#endif
+    return 0;
+}
+} // namespace VodArchiver
@@ -0,0 +1,78 @@
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+#include "util/file.h"
+
+#ifdef BUILD_FOR_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace VodArchiver {
+MappedFile::MappedFile() = default;
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(std::string_view path) {
+    Close();
+
+    HyoutaUtils::IO::File file(path, HyoutaUtils::IO::OpenMode::Read);
+    if (!file.IsOpen()) {
+        return false;
+    }
+    std::optional<uint64_t> length = file.GetLength();
+    if (!length || *length == 0 || *length > std::numeric_limits<size_t>::max()) {
+        return false;
+    }
+
+#ifdef BUILD_FOR_WINDOWS
+    HANDLE fileHandle = static_cast<HANDLE>(file.ReleaseHandle());
+    HANDLE mapping = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(fileHandle);
+    if (mapping == nullptr) {
+        return false;
+    }
+
+    // the view keeps the mapping alive on its own
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr) {
+        return false;
+    }
+#else
+    int fd = file.ReleaseHandle();
+    void* view = mmap(nullptr, static_cast<size_t>(*length), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+#endif
+
+    Data = static_cast<const char*>(view);
+    Size = static_cast<size_t>(*length);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (Data == nullptr) {
+        return;
+    }
+#ifdef BUILD_FOR_WINDOWS
+    UnmapViewOfFile(Data);
+#else
+    munmap(const_cast<char*>(Data), Size);
+#endif
+    Data = nullptr;
+    Size = 0;
+}
+} // namespace VodArchiver
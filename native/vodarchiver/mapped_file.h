@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace VodArchiver {
+// Read-only view of a whole file mapped into memory. Pages are only read from disk once they're
+// actually accessed, so opening even a large file is cheap.
+// The file must not be truncated by anyone while it's mapped. On Windows it also can't be replaced
+// by a Rename() while mapped, so don't keep a mapping around longer than needed.
+struct MappedFile {
+    MappedFile();
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile(MappedFile&& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+    MappedFile& operator=(MappedFile&& other) = delete;
+    ~MappedFile();
+
+    // Fails for empty files, those can't be mapped.
+    bool Open(std::string_view path);
+    void Close();
+
+    bool IsOpen() const {
+        return Data != nullptr;
+    }
+
+    const char* GetData() const {
+        return Data;
+    }
+
+    size_t GetSize() const {
+        return Size;
+    }
+
+private:
+    const char* Data = nullptr;
+    size_t Size = 0;
+};
+} // namespace VodArchiver
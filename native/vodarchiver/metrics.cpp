@@ -0,0 +1,103 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace VodArchiver {
+// waiting for the disk can take anywhere from nothing to hours
+static constexpr std::array<double, 9> WaitSecondsBuckets = {
+    0.1, 1.0, 10.0, 60.0, 300.0, 900.0, 1800.0, 3600.0, 14400.0};
+static constexpr std::array<double, 9> SaveSecondsBuckets = {
+    0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 5.0, 30.0};
+
+MetricsHistogram::MetricsHistogram(std::span<const double> upperBounds)
+  : UpperBounds(upperBounds.subspan(0, std::min(upperBounds.size(), MaxBuckets))) {}
+
+void MetricsHistogram::Observe(double value) {
+    const auto it = std::lower_bound(UpperBounds.begin(), UpperBounds.end(), value);
+    const size_t bucket = static_cast<size_t>(it - UpperBounds.begin());
+    Counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    Sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+void MetricsHistogram::Observe(std::chrono::steady_clock::duration duration) {
+    Observe(std::chrono::duration<double>(duration).count());
+}
+
+ArchiverMetrics::ArchiverMetrics()
+  : DiskSlotWaitSeconds(WaitSecondsBuckets)
+  , DiskSpaceWaitSeconds(WaitSecondsBuckets)
+  , JobsSaveSeconds(SaveSecondsBuckets)
+  , UsersSaveSeconds(SaveSecondsBuckets) {}
+
+ArchiverMetrics& GetArchiverMetrics() {
+    static ArchiverMetrics metrics;
+    return metrics;
+}
+
+void AppendPrometheusHeader(std::string& out,
+                            std::string_view name,
+                            std::string_view type,
+                            std::string_view help) {
+    std::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+}
+
+void AppendPrometheusSample(std::string& out,
+                            std::string_view name,
+                            std::string_view labels,
+                            double value) {
+    if (labels.empty()) {
+        std::format_to(std::back_inserter(out), "{} {}\n", name, value);
+    } else {
+        std::format_to(std::back_inserter(out), "{}{{{}}} {}\n", name, labels, value);
+    }
+}
+
+void AppendPrometheusHistogram(std::string& out,
+                               std::string_view name,
+                               std::string_view labels,
+                               const MetricsHistogram& histogram) {
+    const std::string bucketName = std::format("{}_bucket", name);
+    const std::string_view separator = labels.empty() ? "" : ",";
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i <= histogram.UpperBounds.size(); ++i) {
+        cumulative += histogram.Counts[i].load(std::memory_order_relaxed);
+        const std::string le = i < histogram.UpperBounds.size()
+                                   ? std::format("{}", histogram.UpperBounds[i])
+                                   : std::string("+Inf");
+        AppendPrometheusSample(out,
+                               bucketName,
+                               std::format("{}{}le=\"{}\"", labels, separator, le),
+                               static_cast<double>(cumulative));
+    }
+    AppendPrometheusSample(
+        out, std::format("{}_sum", name), labels, histogram.Sum.load(std::memory_order_relaxed));
+    AppendPrometheusSample(
+        out, std::format("{}_count", name), labels, static_cast<double>(cumulative));
+}
+
+std::string PrometheusLabel(std::string_view key, std::string_view value) {
+    std::string result;
+    result.reserve(key.size() + value.size() + 3);
+    result.append(key);
+    result.append("=\"");
+    for (char c : value) {
+        switch (c) {
+            case '\\': result.append("\\\\"); break;
+            case '"': result.append("\\\""); break;
+            case '\n': result.append("\\n"); break;
+            default: result.push_back(c); break;
+        }
+    }
+    result.push_back('"');
+    return result;
+}
+} // namespace VodArchiver
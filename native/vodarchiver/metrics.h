@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace VodArchiver {
+// Counts observations into fixed buckets, to be exported as a Prometheus histogram.
+// Every field is an independent atomic, so this may be updated from any thread without locking.
+struct MetricsHistogram {
+    static constexpr size_t MaxBuckets = 15;
+
+    // upperBounds must be sorted and outlive the histogram, a +Inf bucket is added implicitly
+    explicit MetricsHistogram(std::span<const double> upperBounds);
+    MetricsHistogram(const MetricsHistogram& other) = delete;
+    MetricsHistogram(MetricsHistogram&& other) = delete;
+    MetricsHistogram& operator=(const MetricsHistogram& other) = delete;
+    MetricsHistogram& operator=(MetricsHistogram&& other) = delete;
+    ~MetricsHistogram() = default;
+
+    void Observe(double value);
+    void Observe(std::chrono::steady_clock::duration duration); // in seconds
+
+    std::span<const double> UpperBounds;
+    std::array<std::atomic<uint64_t>, MaxBuckets + 1> Counts{}; // per bucket, not cumulative
+    std::atomic<double> Sum = 0.0;
+};
+
+// Process wide counters for things that aren't owned by any object we could ask instead.
+struct ArchiverMetrics {
+    ArchiverMetrics();
+
+    // every HTTP request made through curl_util, and how many of those failed before getting any
+    // response at all (including cancellations)
+    std::atomic<uint64_t> HttpRequests = 0;
+    std::atomic<uint64_t> HttpRequestsFailed = 0;
+    std::atomic<uint64_t> HttpBytesReceived = 0;
+
+    std::atomic<uint64_t> TwitchSegmentsDownloaded = 0;
+
+    // how long jobs had to wait for DiskMutex slots and DiskSpaceLedger reservations
+    MetricsHistogram DiskSlotWaitSeconds;
+    MetricsHistogram DiskSpaceWaitSeconds;
+
+    // how long writing vods.xml and users.xml took
+    MetricsHistogram JobsSaveSeconds;
+    MetricsHistogram UsersSaveSeconds;
+};
+
+ArchiverMetrics& GetArchiverMetrics();
+
+// Helpers for the Prometheus text exposition format.
+// 'labels' is either empty or a comma separated list of label="value" pairs without braces.
+void AppendPrometheusHeader(std::string& out,
+                            std::string_view name,
+                            std::string_view type,
+                            std::string_view help);
+void AppendPrometheusSample(std::string& out,
+                            std::string_view name,
+                            std::string_view labels,
+                            double value);
+void AppendPrometheusHistogram(std::string& out,
+                               std::string_view name,
+                               std::string_view labels,
+                               const MetricsHistogram& histogram);
+
+// Returns key="value" with the value escaped as required.
+std::string PrometheusLabel(std::string_view key, std::string_view value);
+} // namespace VodArchiver
@@ -0,0 +1,167 @@
+#include "process_governor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef BUILD_FOR_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sched.h>
+#endif
+
+namespace VodArchiver {
+namespace {
+struct GovernorState {
+    std::mutex Mutex;
+    bool Initialized = false;
+
+    // CPUs that bulk processes may be placed on, and how many bulk processes currently use each.
+    std::vector<uint32_t> BulkCpus;
+    std::vector<uint32_t> BulkCpuUsage;
+    uint32_t ActiveBulkProcesses = 0;
+};
+} // namespace
+
+static GovernorState& GetGovernorState() {
+    static GovernorState state;
+    return state;
+}
+
+static std::vector<uint32_t> GetUsableCpus() {
+    std::vector<uint32_t> cpus;
+#ifdef BUILD_FOR_WINDOWS
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+        for (uint32_t i = 0; i < sizeof(DWORD_PTR) * 8; ++i) {
+            if (processMask & (static_cast<DWORD_PTR>(1) << i)) {
+                cpus.push_back(i);
+            }
+        }
+    }
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (uint32_t i = 0; i < CPU_SETSIZE; ++i) {
+            if (CPU_ISSET(i, &set)) {
+                cpus.push_back(i);
+            }
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        const uint32_t count = std::max(1u, std::thread::hardware_concurrency());
+        for (uint32_t i = 0; i < count; ++i) {
+            cpus.push_back(i);
+        }
+    }
+    return cpus;
+}
+
+static void InitializeGovernorState(GovernorState& state) {
+    std::vector<uint32_t> cpus = GetUsableCpus();
+
+    // keep the first CPU or two free of bulk work so probes, downloads and the GUI stay responsive
+    // while every other core is busy encoding
+    size_t reserved = 0;
+    if (cpus.size() >= 16) {
+        reserved = 2;
+    } else if (cpus.size() >= 4) {
+        reserved = 1;
+    }
+    state.BulkCpus.assign(cpus.begin() + static_cast<std::ptrdiff_t>(reserved), cpus.end());
+    state.BulkCpuUsage.assign(state.BulkCpus.size(), 0);
+    state.Initialized = true;
+}
+
+ProcessSlot::ProcessSlot(ProcessSlot&& other)
+  : Class(other.Class)
+  , Cpus(std::move(other.Cpus))
+  , ThreadCount(other.ThreadCount)
+  , Nice(other.Nice)
+  , IoPriority(other.IoPriority)
+  , OwnsCpus(other.OwnsCpus) {
+    other.Cpus.clear();
+    other.OwnsCpus = false;
+}
+
+ProcessSlot::~ProcessSlot() {
+    if (!OwnsCpus) {
+        return;
+    }
+
+    GovernorState& state = GetGovernorState();
+    std::lock_guard lock(state.Mutex);
+    for (uint32_t cpu : Cpus) {
+        for (size_t i = 0; i < state.BulkCpus.size(); ++i) {
+            if (state.BulkCpus[i] == cpu && state.BulkCpuUsage[i] > 0) {
+                --state.BulkCpuUsage[i];
+                break;
+            }
+        }
+    }
+    if (state.ActiveBulkProcesses > 0) {
+        --state.ActiveBulkProcesses;
+    }
+}
+
+ProcessSlot AcquireProcessSlot(ProcessClass processClass, uint32_t expectedConcurrent) {
+    ProcessSlot slot;
+    slot.Class = processClass;
+    switch (processClass) {
+        case ProcessClass::Interactive:
+            return slot;
+        case ProcessClass::Io:
+            slot.Nice = 5;
+            slot.IoPriority = 4;
+            return slot;
+        case ProcessClass::Bulk:
+            slot.Nice = 15;
+            slot.IoPriority = 7;
+            break;
+    }
+
+    GovernorState& state = GetGovernorState();
+    std::lock_guard lock(state.Mutex);
+    if (!state.Initialized) {
+        InitializeGovernorState(state);
+    }
+    const size_t poolSize = state.BulkCpus.size();
+    if (poolSize == 0) {
+        return slot;
+    }
+
+    const size_t sharers = std::max<size_t>(
+        {static_cast<size_t>(expectedConcurrent), state.ActiveBulkProcesses + 1, 1});
+    const size_t sliceSize = std::max<size_t>(poolSize / sharers, 1);
+
+    // pick the contiguous window with the lowest combined usage, earliest one on ties
+    size_t bestStart = 0;
+    uint64_t bestUsage = UINT64_MAX;
+    for (size_t start = 0; start + sliceSize <= poolSize; ++start) {
+        uint64_t usage = 0;
+        for (size_t i = start; i < start + sliceSize; ++i) {
+            usage += state.BulkCpuUsage[i];
+        }
+        if (usage < bestUsage) {
+            bestUsage = usage;
+            bestStart = start;
+        }
+    }
+
+    for (size_t i = bestStart; i < bestStart + sliceSize; ++i) {
+        ++state.BulkCpuUsage[i];
+        slot.Cpus.push_back(state.BulkCpus[i]);
+    }
+    ++state.ActiveBulkProcesses;
+    slot.ThreadCount = static_cast<uint32_t>(sliceSize);
+    slot.OwnsCpus = true;
+    return slot;
+}
+} // namespace VodArchiver
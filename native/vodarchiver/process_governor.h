@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace VodArchiver {
+enum class ProcessClass : uint8_t {
+    Interactive, // short metadata queries like ffprobe or 'yt-dlp -J' that something is waiting on
+    Io,          // disk or network bound work like downloading, remuxing or splitting
+    Bulk,        // long running CPU bound work like video encoding
+};
+
+// Scheduling parameters for a child process. Hold on to this for as long as the child is running,
+// its CPUs are considered busy until it's destroyed.
+struct ProcessSlot {
+    ProcessSlot(const ProcessSlot& other) = delete;
+    ProcessSlot(ProcessSlot&& other);
+    ProcessSlot& operator=(const ProcessSlot& other) = delete;
+    ProcessSlot& operator=(ProcessSlot&& other) = delete;
+    ~ProcessSlot();
+
+    ProcessClass Class = ProcessClass::Interactive;
+
+    // CPUs the child should be restricted to. Empty if it may run anywhere.
+    std::vector<uint32_t> Cpus;
+
+    // Worker thread count to pass to the child, eg. as ffmpeg '-threads'. 0 lets the tool decide.
+    uint32_t ThreadCount = 0;
+
+    // Linux nice value, 0 to 19.
+    int Nice = 0;
+
+    // Linux best-effort I/O priority, 0 (highest) to 7 (lowest), or -1 to inherit ours.
+    int IoPriority = -1;
+
+private:
+    ProcessSlot() = default;
+
+    bool OwnsCpus = false;
+
+    friend ProcessSlot AcquireProcessSlot(ProcessClass processClass, uint32_t expectedConcurrent);
+};
+
+// Picks scheduling parameters for a new child process of the given class.
+// Bulk processes get a contiguous window of the least loaded CPUs, leaving a CPU or two for
+// interactive work and the GUI on larger machines. The window is sized so that
+// 'expectedConcurrent' bulk processes can run side by side without oversubscribing, which lets
+// the caller launch a batch of encodes that don't fight each other for cores.
+ProcessSlot AcquireProcessSlot(ProcessClass processClass, uint32_t expectedConcurrent = 1);
+} // namespace VodArchiver
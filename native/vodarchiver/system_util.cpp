@@ -1,7 +1,11 @@
 #include "system_util.h"
 
+#include <climits>
 #include <cstdint>
+#include <cstdlib>
+#include <format>
 #include <optional>
+#include <string>
 #include <string_view>
 
 #include "util/file.h"
@@ -11,7 +15,9 @@
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 #else
+#include <sys/stat.h>
 #include <sys/statvfs.h>
+#include <sys/sysmacros.h>
 #endif
 
 namespace VodArchiver {
@@ -54,4 +60,76 @@ std::optional<uint64_t> GetFreeDiskSpaceAtPath(std::string_view path) {
     return result;
 #endif
 }
+
+std::optional<std::string> GetVolumeIdAtPath(std::string_view path) {
+#ifdef BUILD_FOR_WINDOWS
+    std::string_view p = path;
+    while (p.size() > 0 && !(p.back() == '/' || p.back() == '\\')) {
+        p = p.substr(0, p.size() - 1);
+    }
+    if (p.empty()) {
+        return std::nullopt;
+    }
+    auto wstr = HyoutaUtils::TextUtils::Utf8ToWString(p.data(), p.size());
+    if (!wstr) {
+        return std::nullopt;
+    }
+    std::wstring volumePath;
+    volumePath.resize(wstr->size() + 2);
+    if (!GetVolumePathNameW(
+            wstr->c_str(), volumePath.data(), static_cast<DWORD>(volumePath.size()))) {
+        return std::nullopt;
+    }
+    return HyoutaUtils::TextUtils::WStringToUtf8(volumePath.c_str(), wcslen(volumePath.c_str()));
+#else
+    std::string_view p = path;
+    while (p.size() > 0 && p.back() != '/') {
+        p = p.substr(0, p.size() - 1);
+    }
+    if (p.empty()) {
+        return std::nullopt;
+    }
+    std::string s(p);
+    struct stat buf{};
+    if (stat(s.c_str(), &buf) != 0) {
+        return std::nullopt;
+    }
+    return std::to_string(static_cast<uint64_t>(buf.st_dev));
+#endif
+}
+
+std::optional<std::string> GetStorageDeviceIdAtPath(std::string_view path) {
+#ifdef BUILD_FOR_WINDOWS
+    return GetVolumeIdAtPath(path);
+#else
+    std::string_view p = path;
+    while (p.size() > 0 && p.back() != '/') {
+        p = p.substr(0, p.size() - 1);
+    }
+    if (p.empty()) {
+        return std::nullopt;
+    }
+    std::string s(p);
+    struct stat buf{};
+    if (stat(s.c_str(), &buf) != 0) {
+        return std::nullopt;
+    }
+
+    // /sys/dev/block/<major>:<minor> links to the block device, and partitions are subfolders of
+    // the disk they're on. Anything not in there (tmpfs, network mounts, etc.) is its own device.
+    const unsigned int major = ::major(buf.st_dev);
+    const unsigned int minor = ::minor(buf.st_dev);
+    std::string sysfsPath = std::format("/sys/dev/block/{}:{}", major, minor);
+    char resolved[PATH_MAX];
+    if (realpath(sysfsPath.c_str(), resolved) == nullptr) {
+        return std::format("dev:{}:{}", major, minor);
+    }
+    std::string_view device(resolved);
+    struct stat partitionBuf{};
+    if (stat((std::string(device) + "/partition").c_str(), &partitionBuf) == 0) {
+        device = device.substr(0, device.rfind('/'));
+    }
+    return std::string(device.substr(device.rfind('/') + 1));
+#endif
+}
 } // namespace VodArchiver
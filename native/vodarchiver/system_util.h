@@ -2,8 +2,17 @@
 
 #include <cstdint>
 #include <optional>
+#include <string>
 #include <string_view>
 
 namespace VodArchiver {
 std::optional<uint64_t> GetFreeDiskSpaceAtPath(std::string_view path);
+
+// Returns a string that's identical for all paths on the same volume.
+std::optional<std::string> GetVolumeIdAtPath(std::string_view path);
+
+// Returns a string that's identical for all paths on the same physical storage device, as far as
+// that can be determined. Partitions of one disk map to the same device on Linux. Elsewhere, or
+// for volumes that aren't backed by a single block device, this is the same as the volume.
+std::optional<std::string> GetStorageDeviceIdAtPath(std::string_view path);
 } // namespace VodArchiver
@@ -2,7 +2,10 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <functional>
 #include <mutex>
+#include <utility>
 
 namespace VodArchiver {
 TaskCancellation::TaskCancellation() = default;
@@ -14,9 +17,17 @@ bool TaskCancellation::IsCancellationRequested() {
 }
 
 void TaskCancellation::CancelTask() {
-    std::lock_guard lock(Mutex);
-    CancellationRequested.store(true, std::memory_order_relaxed);
-    CancellationCondVar.notify_all();
+    {
+        std::lock_guard lock(Mutex);
+        CancellationRequested.store(true, std::memory_order_relaxed);
+        CancellationCondVar.notify_all();
+    }
+
+    // not under the Mutex, so callbacks may check IsCancellationRequested() themselves
+    std::lock_guard lock(CallbackMutex);
+    for (auto& callback : Callbacks) {
+        callback.second();
+    }
 }
 
 void TaskCancellation::Reset() {
@@ -30,4 +41,17 @@ bool TaskCancellation::DelayFor(std::chrono::nanoseconds ns) {
     return !CancellationCondVar.wait_until(
         lock, when, [&] { return CancellationRequested.load(std::memory_order_relaxed); });
 }
+
+CancellationCallback::CancellationCallback(TaskCancellation& cancellationToken,
+                                           std::function<void()> callback)
+  : Token(cancellationToken) {
+    std::lock_guard lock(Token.CallbackMutex);
+    Id = Token.NextCallbackId++;
+    Token.Callbacks.emplace_back(Id, std::move(callback));
+}
+
+CancellationCallback::~CancellationCallback() {
+    std::lock_guard lock(Token.CallbackMutex);
+    std::erase_if(Token.Callbacks, [&](const auto& callback) { return callback.first == Id; });
+}
 } // namespace VodArchiver
@@ -3,7 +3,11 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace VodArchiver {
 struct TaskCancellation {
@@ -25,5 +29,30 @@ private:
     std::mutex Mutex;
     std::condition_variable CancellationCondVar;
     std::atomic<bool> CancellationRequested = false;
+
+    // Guards Callbacks, and is held while they run so that unregistering one waits for it.
+    std::mutex CallbackMutex;
+    std::vector<std::pair<uint64_t, std::function<void()>>> Callbacks;
+    uint64_t NextCallbackId = 0;
+
+    friend struct CancellationCallback;
+};
+
+// Runs a callback on the thread that cancels the task, for as long as this object is alive.
+// This is for waking up waits on something other than the TaskCancellation itself. The callback
+// is not called if the task was already cancelled before this was constructed, so check for that
+// after constructing this and before waiting.
+// The callback must not construct or destroy a CancellationCallback for the same task.
+struct CancellationCallback {
+    CancellationCallback(TaskCancellation& cancellationToken, std::function<void()> callback);
+    CancellationCallback(const CancellationCallback& other) = delete;
+    CancellationCallback(CancellationCallback&& other) = delete;
+    CancellationCallback& operator=(const CancellationCallback& other) = delete;
+    CancellationCallback& operator=(CancellationCallback&& other) = delete;
+    ~CancellationCallback();
+
+private:
+    TaskCancellation& Token;
+    uint64_t Id;
 };
 } // namespace VodArchiver
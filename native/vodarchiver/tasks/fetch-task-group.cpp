@@ -8,27 +8,47 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <ratio>
 #include <string>
 #include <string_view>
 #include <thread>
 #include <vector>
 
+#include "util/hash/crc32.h"
 #include "util/scope.h"
 #include "util/thread.h"
 #include "util/xorshift.h"
 
+#include "vodarchiver/host_rate_limiter.h"
 #include "vodarchiver/job_config.h"
 #include "vodarchiver/task_cancellation.h"
 #include "vodarchiver/userinfo/i-user-info.h"
 
 namespace VodArchiver {
+// how often the listing of each user is fetched
+static constexpr int UserInfoRefreshHours = 7;
+
+// how many users of one group may be fetched at the same time. requests to the same host still
+// have to wait for the rate limiter, but the fetches of different hosts and the processing of the
+// results can overlap
+static constexpr size_t MaxConcurrentFetches = 4;
+
+// refreshes are moved earlier by up to this much
+static constexpr uint32_t MaxRefreshJitterSeconds = 10 * 60;
+
+using DateTimeTicks = std::chrono::duration<int64_t, std::ratio<1, DateTime::TICKS_PER_SECOND>>;
+
+// for keeping the schedule a min-heap on the due time
+static constexpr auto DueLater = [](const auto& lhs, const auto& rhs) { return lhs.Due > rhs.Due; };
+
 FetchTaskGroup::FetchTaskGroup(
     std::vector<ServiceVideoCategoryType> services,
     std::recursive_mutex* userInfosLock,
     std::vector<std::unique_ptr<IUserInfo>>* userInfos,
     JobConfig* jobConfig,
     TaskCancellation* cancellationToken,
-    std::function<bool(std::unique_ptr<IVideoInfo> info)> enqueueJobCallback,
+    std::function<size_t(std::vector<std::unique_ptr<IVideoInfo>> infos)> enqueueJobsCallback,
+    std::function<bool(const IVideoInfo& info)> isVideoKnownCallback,
     std::function<void(std::string_view msg)> addStatusMessageCallback,
     std::function<void()> saveVodsCallback,
     std::function<void()> saveUserInfosCallback,
@@ -39,152 +59,264 @@ FetchTaskGroup::FetchTaskGroup(
   , UserInfos(userInfos)
   , JobConf(jobConfig)
   , CancellationToken(cancellationToken)
-  , EnqueueJobCallback(std::move(enqueueJobCallback))
+  , EnqueueJobsCallback(std::move(enqueueJobsCallback))
+  , IsVideoKnownCallback(std::move(isVideoKnownCallback))
   , AddStatusMessageCallback(std::move(addStatusMessageCallback))
   , SaveVodsCallback(std::move(saveVodsCallback))
   , SaveUserInfosCallback(std::move(saveUserInfosCallback)) {
-    FetchRunnerThread = std::thread(std::bind(&FetchTaskGroup::RunFetchRunnerThreadFunc, this));
+    for (size_t i = 0; i < MaxConcurrentFetches; ++i) {
+        FetchWorkerThreads.emplace_back(
+            std::bind(&FetchTaskGroup::RunFetchWorkerThreadFunc, this, i));
+    }
 }
 
 FetchTaskGroup::~FetchTaskGroup() {
     CancellationToken->CancelTask();
-    WaitForFetchRunnerThreadToEnd();
+    WaitForFetchWorkerThreadsToEnd();
 }
 
-void FetchTaskGroup::RunFetchRunnerThreadFunc() {
+void FetchTaskGroup::NotifyUserInfosChanged() {
+    {
+        std::lock_guard lock(ScheduleMutex);
+        ScheduleNeedsRebuild = true;
+    }
+    ScheduleCondVar.notify_all();
+}
+
+// Incremental fetches stop at the newest video we already know about, so they miss anything that
+// shows up further down the listing, eg. videos that were private for a while. Every user gets a
+// full listing once a week to catch those. The week boundary is offset per user so that the full
+// listings of all users don't happen on the same day.
+static bool IsFullListingDue(IUserInfo& userInfo, DateTime now) {
+    if (userInfo.LastRefreshedOn.GetTicks() == 0) {
+        return true;
+    }
+
+    static constexpr uint64_t minutesPerWeek = 7 * 24 * 60;
+    static constexpr uint64_t ticksPerMinute =
+        60 * static_cast<uint64_t>(DateTime::TICKS_PER_SECOND);
+    static constexpr uint64_t ticksPerWeek = minutesPerWeek * ticksPerMinute;
+    const std::string id = userInfo.GetUserIdentifier();
+    crc_t crc = crc_init();
+    crc = crc_update(crc, id.data(), id.size());
+    crc = crc_finalize(crc);
+    const uint64_t offset = (static_cast<uint64_t>(crc) % minutesPerWeek) * ticksPerMinute;
+    return (userInfo.LastRefreshedOn.GetTicks() + offset) / ticksPerWeek
+           != (now.GetTicks() + offset) / ticksPerWeek;
+}
+
+void FetchTaskGroup::RunFetchWorkerThreadFunc(size_t workerIndex) {
     {
         std::string_view invalidServices = "None";
         std::string threadName = std::format(
-            "Fetch{}",
-            Services.empty() ? invalidServices : ServiceVideoCategoryTypeToString(Services[0]));
+            "Fetch{}{}",
+            Services.empty() ? invalidServices : ServiceVideoCategoryTypeToString(Services[0]),
+            workerIndex);
         HyoutaUtils::SetThreadName(threadName.c_str());
     }
 
-    while (true) {
-        if (!CancellationToken->DelayFor(std::chrono::seconds(3))) {
-            return;
+    // wakes up the wait for the next due fetch when shutting down
+    CancellationCallback wakeOnCancel(*CancellationToken, [this]() {
+        { std::lock_guard lock(ScheduleMutex); }
+        ScheduleCondVar.notify_all();
+    });
+
+    ScheduledFetch fetch;
+    while (TakeNextDueFetch(fetch)) {
+        const DateTime now = DateTime::UtcNow();
+        std::unique_ptr<IUserInfo> userInfoClone = nullptr;
+        size_t userInfoCloneIndex = 0;
+        {
+            std::lock_guard lock(*UserInfosLock);
+            for (size_t i = 0; i < UserInfos->size(); ++i) {
+                auto& u = (*UserInfos)[i];
+                if (u->AutoDownload && u->GetType() == fetch.Type
+                    && u->GetUserIdentifier() == fetch.UserIdentifier) {
+                    userInfoClone = u->Clone();
+                    userInfoCloneIndex = i;
+                    break;
+                }
+            }
+        }
+        if (userInfoClone == nullptr) {
+            // removed or no longer auto downloading, so drop it from the schedule
+            FinishFetch(std::move(fetch), false);
+            continue;
         }
 
         try {
-            std::unique_ptr<IUserInfo> userInfoClone = nullptr;
-            size_t userInfoCloneIndex = 0;
-            {
-                IUserInfo* earliestUserInfo = nullptr;
-                std::lock_guard lock(*UserInfosLock);
-                for (size_t i = 0; i < UserInfos->size(); ++i) {
-                    auto& u = (*UserInfos)[i];
-                    if (!u->AutoDownload) {
-                        continue;
-                    }
+            auto afterFetchScope = HyoutaUtils::MakeScopeGuard([&]() {
+                if (!CancellationToken->IsCancellationRequested()) {
+                    // try to write back the timestamp into the actual vector
+                    bool writtenBack = WriteBack(userInfoClone.get(), userInfoCloneIndex, now);
 
-                    auto us = u->GetType();
-                    if (std::any_of(Services.begin(),
-                                    Services.end(),
-                                    [&](ServiceVideoCategoryType t) { return us == t; })
-                        && (earliestUserInfo == nullptr
-                            || u->LastRefreshedOn < earliestUserInfo->LastRefreshedOn)) {
-                        earliestUserInfo = u.get();
-                        userInfoCloneIndex = i;
+                    // if we have updated the userinfo, request a save to disk
+                    if (writtenBack && userInfoClone->Persistable) {
+                        SaveUserInfosCallback();
                     }
                 }
-                if (earliestUserInfo != nullptr) {
-                    userInfoClone = earliestUserInfo->Clone();
-                }
-            }
-
-            if (userInfoClone != nullptr) {
-                DateTime earliestStartTime = userInfoClone->LastRefreshedOn.AddHours(7);
-                DateTime now = DateTime::UtcNow();
-                if (earliestStartTime <= now) {
-                    auto afterFetchScope = HyoutaUtils::MakeScopeGuard([&]() {
-                        if (!CancellationToken->IsCancellationRequested()) {
-                            // try to write back the timestamp into the actual vector
-                            bool writtenBack =
-                                WriteBack(userInfoClone.get(), userInfoCloneIndex, now);
-
-                            // if we have updated the userinfo, request a save to disk
-                            if (writtenBack && userInfoClone->Persistable) {
-                                SaveUserInfosCallback();
-                            }
-                        }
-                    });
-                    DoFetch(userInfoClone.get());
-                }
-            }
+            });
+            DoFetch(userInfoClone.get(),
+                    userInfoCloneIndex,
+                    !IsFullListingDue(*userInfoClone, now));
         } catch (const std::exception& ex) {
             AddStatusMessage(std::format("Error during fetch: {}", ex.what()));
         }
+
+        fetch.Due = now.AddHours(UserInfoRefreshHours);
+        FinishFetch(std::move(fetch), true);
     }
 }
 
-void FetchTaskGroup::DoFetch(IUserInfo* userInfo) {
-    std::vector<std::unique_ptr<IVideoInfo>> videos;
-
+bool FetchTaskGroup::TakeNextDueFetch(ScheduledFetch& fetch) {
+    std::unique_lock lock(ScheduleMutex);
     while (true) {
-        AddStatusMessage(std::format("Fetching {}...", userInfo->ToString()));
+        if (CancellationToken->IsCancellationRequested()) {
+            return false;
+        }
 
-        try {
-            FetchReturnValue fetchReturnValue;
-            size_t Offset = 0;
-            do {
-                {
-                    uint32_t min_wait_ms = 155000;
-                    uint32_t max_wait_ms = 195000;
-                    uint32_t wait_ms = min_wait_ms + (RNG() % (max_wait_ms - min_wait_ms));
-                    CancellationToken->DelayFor(std::chrono::milliseconds(wait_ms));
-                }
-                if (CancellationToken->IsCancellationRequested()) {
-                    break;
-                }
-                fetchReturnValue = userInfo->Fetch(*JobConf, Offset, true);
-                Offset += fetchReturnValue.VideoCountThisFetch;
-                if (fetchReturnValue.Success) {
-                    for (auto& v : fetchReturnValue.Videos) {
-                        videos.push_back(std::move(v));
-                    }
-                }
-            } while (fetchReturnValue.Success && fetchReturnValue.HasMore);
-            break;
-        } catch (const std::exception& ex) {
-            AddStatusMessage(std::format("Error during {}: {}", userInfo->ToString(), ex.what()));
-            break;
+        if (ScheduleNeedsRebuild) {
+            ScheduleNeedsRebuild = false;
+            std::vector<ScheduledFetch> fetches = CollectScheduledFetches();
+            std::erase_if(fetches, [&](const ScheduledFetch& f) {
+                return std::any_of(InFlight.begin(), InFlight.end(), [&](const ScheduledFetch& i) {
+                    return i.Type == f.Type && i.UserIdentifier == f.UserIdentifier;
+                });
+            });
+            Schedule = std::move(fetches);
+            std::make_heap(Schedule.begin(), Schedule.end(), DueLater);
+        }
+
+        if (Schedule.empty()) {
+            ScheduleCondVar.wait(lock);
+            continue;
+        }
+
+        const DateTime now = DateTime::UtcNow();
+        const DateTime due = Schedule.front().Due;
+        if (due <= now) {
+            std::pop_heap(Schedule.begin(), Schedule.end(), DueLater);
+            fetch = std::move(Schedule.back());
+            Schedule.pop_back();
+            InFlight.push_back(fetch);
+            return true;
         }
+
+        // sleep until the earliest fetch is due, unless something changes the schedule first
+        ScheduleCondVar.wait_for(lock, DateTimeTicks(due.GetTicks() - now.GetTicks()));
     }
+}
 
-    if (!CancellationToken->IsCancellationRequested()) {
-        uint32_t min_wait_ms = 55000;
-        uint32_t max_wait_ms = 95000;
-        uint32_t wait_ms = min_wait_ms + (RNG() % (max_wait_ms - min_wait_ms));
-        CancellationToken->DelayFor(std::chrono::milliseconds(wait_ms));
+void FetchTaskGroup::FinishFetch(ScheduledFetch fetch, bool reschedule) {
+    {
+        std::lock_guard lock(ScheduleMutex);
+        std::erase_if(InFlight, [&](const ScheduledFetch& i) {
+            return i.Type == fetch.Type && i.UserIdentifier == fetch.UserIdentifier;
+        });
+        if (reschedule && !ScheduleNeedsRebuild) {
+            // spread out users that were added at the same time so they don't stay in lockstep
+            const uint32_t jitter = RNG() % MaxRefreshJitterSeconds;
+            fetch.Due = fetch.Due.AddSeconds(-static_cast<int64_t>(jitter));
+            Schedule.push_back(std::move(fetch));
+            std::push_heap(Schedule.begin(), Schedule.end(), DueLater);
+        }
     }
-    AddStatusMessage(std::format("Fetched {} items from {}.", videos.size(), userInfo->ToString()));
 
-    bool createdAny = false;
-    for (auto& videoInfo : videos) {
-        // Console.WriteLine("Enqueueing " + videoInfo.Username + "/" + videoInfo.VideoId);
-        if (EnqueueJobCallback(std::move(videoInfo))) {
-            createdAny = true;
+    // another worker may be sleeping until a later due time than this one
+    ScheduleCondVar.notify_all();
+}
+
+std::vector<FetchTaskGroup::ScheduledFetch> FetchTaskGroup::CollectScheduledFetches() {
+    std::vector<ScheduledFetch> fetches;
+    std::lock_guard lock(*UserInfosLock);
+    for (auto& u : *UserInfos) {
+        if (!u->AutoDownload) {
+            continue;
         }
+
+        const ServiceVideoCategoryType type = u->GetType();
+        if (std::find(Services.begin(), Services.end(), type) != Services.end()) {
+            fetches.push_back(
+                ScheduledFetch{.Due = u->LastRefreshedOn.AddHours(UserInfoRefreshHours),
+                               .Type = type,
+                               .UserIdentifier = u->GetUserIdentifier()});
+        }
+    }
+    return fetches;
+}
+
+void FetchTaskGroup::DoFetch(IUserInfo* userInfo, size_t userInfoIndex, bool incremental) {
+    // a listing that got interrupted continues where it stopped instead of starting over
+    std::string cursor = userInfo->FetchResumeCursor;
+    if (!cursor.empty()) {
+        incremental = false;
+        AddStatusMessage(std::format("Fetching {} (resuming)...", userInfo->ToString()));
+    } else {
+        AddStatusMessage(std::format(
+            "Fetching {}{}...", userInfo->ToString(), incremental ? "" : " (full listing)"));
+    }
+
+    size_t fetchedCount = 0;
+    size_t createdCount = 0;
+    try {
+        FetchReturnValue fetchReturnValue;
+        do {
+            // every request needs a slot of its own, an incremental fetch may send several
+            if (incremental && cursor.empty()) {
+                fetchReturnValue = userInfo->FetchIncremental(
+                    *JobConf, IsVideoKnownCallback, [&]() { return WaitForRequestSlot(userInfo); });
+            } else {
+                if (!WaitForRequestSlot(userInfo)) {
+                    break;
+                }
+                fetchReturnValue = userInfo->Fetch(*JobConf, cursor, true);
+            }
+            if (!fetchReturnValue.Success) {
+                break;
+            }
+            cursor = fetchReturnValue.HasMore ? std::move(fetchReturnValue.NextCursor)
+                                              : std::string();
+
+            // enqueue right away so the downloads can start while the rest is still being listed
+            fetchedCount += fetchReturnValue.Videos.size();
+            if (!fetchReturnValue.Videos.empty()) {
+                createdCount += EnqueueJobsCallback(std::move(fetchReturnValue.Videos));
+            }
+
+            // no save is requested for this, it's written together with everything else once the
+            // listing is done, or when shutting down
+            WriteBackResumeCursor(userInfo, userInfoIndex, cursor);
+        } while (fetchReturnValue.HasMore);
+    } catch (const std::exception& ex) {
+        AddStatusMessage(std::format("Error during {}: {}", userInfo->ToString(), ex.what()));
     }
 
-    if (createdAny) {
+    AddStatusMessage(std::format("Fetched {} items from {}.", fetchedCount, userInfo->ToString()));
+
+    if (createdCount > 0) {
         SaveVodsCallback();
     }
 }
 
-bool FetchTaskGroup::WriteBack(IUserInfo* userInfo, size_t expectedIndex, DateTime now) {
+bool FetchTaskGroup::WaitForRequestSlot(IUserInfo* userInfo) {
+    const auto now = HostRateLimiter::Clock::now();
+    const auto slot = GetFetchRateLimiter().Reserve(userInfo->GetFetchHost(), now);
+    if (slot > now) {
+        return CancellationToken->DelayFor(slot - now);
+    }
+    return !CancellationToken->IsCancellationRequested();
+}
+
+IUserInfo* FetchTaskGroup::FindUserInfoNoLock(IUserInfo* userInfo, size_t expectedIndex) {
     ServiceVideoCategoryType type = userInfo->GetType();
     std::string uid = userInfo->GetUserIdentifier();
 
-    std::lock_guard lock(*UserInfosLock);
-
     // this only works if the index hasn't changed, but the vector
     // changes so rarely that it's always a good idea to try first
-    if (UserInfos->size() < expectedIndex) {
+    if (expectedIndex < UserInfos->size()) {
         auto& u = (*UserInfos)[expectedIndex];
         if (u->GetType() == type && u->GetUserIdentifier() == uid) {
-            u->LastRefreshedOn = now;
-            return true;
+            return u.get();
         }
     }
 
@@ -192,22 +324,42 @@ bool FetchTaskGroup::WriteBack(IUserInfo* userInfo, size_t expectedIndex, DateTi
     for (size_t i = 0; i < UserInfos->size(); ++i) {
         auto& u = (*UserInfos)[i];
         if (u->GetType() == type && u->GetUserIdentifier() == uid) {
-            u->LastRefreshedOn = now;
-            return true;
+            return u.get();
         }
     }
 
     // couldn't find it
+    return nullptr;
+}
+
+bool FetchTaskGroup::WriteBack(IUserInfo* userInfo, size_t expectedIndex, DateTime now) {
+    std::lock_guard lock(*UserInfosLock);
+    if (IUserInfo* u = FindUserInfoNoLock(userInfo, expectedIndex)) {
+        u->LastRefreshedOn = now;
+        return true;
+    }
     return false;
 }
 
+void FetchTaskGroup::WriteBackResumeCursor(IUserInfo* userInfo,
+                                           size_t expectedIndex,
+                                           const std::string& cursor) {
+    userInfo->FetchResumeCursor = cursor;
+    std::lock_guard lock(*UserInfosLock);
+    if (IUserInfo* u = FindUserInfoNoLock(userInfo, expectedIndex)) {
+        u->FetchResumeCursor = cursor;
+    }
+}
+
 void FetchTaskGroup::AddStatusMessage(std::string_view msg) {
     AddStatusMessageCallback(msg);
 }
 
-void FetchTaskGroup::WaitForFetchRunnerThreadToEnd() {
-    if (FetchRunnerThread.joinable()) {
-        FetchRunnerThread.join();
+void FetchTaskGroup::WaitForFetchWorkerThreadsToEnd() {
+    for (std::thread& thread : FetchWorkerThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
     }
 }
 } // namespace VodArchiver
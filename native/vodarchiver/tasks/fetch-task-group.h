@@ -1,9 +1,12 @@
 #pragma once
 
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <string_view>
 #include <thread>
 #include <vector>
@@ -16,38 +19,71 @@
 #include "vodarchiver/videoinfo/i-video-info.h"
 
 namespace VodArchiver {
+// Periodically fetches the video listings of all auto-downloading users of the given services.
+// Users are kept in a queue ordered by when their next refresh is due, and a few worker threads
+// take the due ones from it, so a user is refreshed close to its due time no matter how many users
+// there are. Requests to the same host are spaced out through GetFetchRateLimiter().
 struct FetchTaskGroup {
-    HyoutaUtils::RNG::xorshift RNG;
+    HyoutaUtils::RNG::xorshift RNG; // guarded by the ScheduleMutex
     std::vector<ServiceVideoCategoryType> Services;
     std::recursive_mutex* UserInfosLock = nullptr;
     std::vector<std::unique_ptr<IUserInfo>>* UserInfos = nullptr;
     JobConfig* JobConf = nullptr;
     TaskCancellation* CancellationToken = nullptr;
 
-    std::function<bool(std::unique_ptr<IVideoInfo> info)> EnqueueJobCallback;
+    std::function<size_t(std::vector<std::unique_ptr<IVideoInfo>> infos)> EnqueueJobsCallback;
+    std::function<bool(const IVideoInfo& info)> IsVideoKnownCallback;
     std::function<void(std::string_view msg)> AddStatusMessageCallback;
     std::function<void()> SaveVodsCallback;
     std::function<void()> SaveUserInfosCallback;
 
-    std::thread FetchRunnerThread;
+    std::vector<std::thread> FetchWorkerThreads;
 
     FetchTaskGroup(std::vector<ServiceVideoCategoryType> services,
                    std::recursive_mutex* userInfosLock,
                    std::vector<std::unique_ptr<IUserInfo>>* userInfos,
                    JobConfig* jobConfig,
                    TaskCancellation* cancellationToken,
-                   std::function<bool(std::unique_ptr<IVideoInfo> info)> enqueueJobCallback,
+                   std::function<size_t(std::vector<std::unique_ptr<IVideoInfo>> infos)>
+                       enqueueJobsCallback,
+                   std::function<bool(const IVideoInfo& info)> isVideoKnownCallback,
                    std::function<void(std::string_view msg)> addStatusMessageCallback,
                    std::function<void()> saveVodsCallback,
                    std::function<void()> saveUserInfosCallback,
                    uint32_t rngSeed);
     ~FetchTaskGroup();
 
+    // Call after adding users or changing their AutoDownload flag, so the schedule picks it up.
+    // Must not be called while holding the UserInfosLock.
+    void NotifyUserInfosChanged();
+
 private:
-    void RunFetchRunnerThreadFunc();
-    void DoFetch(IUserInfo* userInfo);
+    struct ScheduledFetch {
+        DateTime Due;
+        ServiceVideoCategoryType Type;
+        std::string UserIdentifier;
+    };
+
+    void RunFetchWorkerThreadFunc(size_t workerIndex);
+    bool TakeNextDueFetch(ScheduledFetch& fetch);
+    void FinishFetch(ScheduledFetch fetch, bool reschedule);
+    std::vector<ScheduledFetch> CollectScheduledFetches();
+    void DoFetch(IUserInfo* userInfo, size_t userInfoIndex, bool incremental);
+    bool WaitForRequestSlot(IUserInfo* userInfo);
+    IUserInfo* FindUserInfoNoLock(IUserInfo* userInfo, size_t expectedIndex);
     bool WriteBack(IUserInfo* userInfo, size_t expectedIndex, DateTime now);
+    void WriteBackResumeCursor(IUserInfo* userInfo,
+                               size_t expectedIndex,
+                               const std::string& cursor);
     void AddStatusMessage(std::string_view msg);
-    void WaitForFetchRunnerThreadToEnd();
+    void WaitForFetchWorkerThreadsToEnd();
+
+    // guards everything below. the UserInfosLock may be taken while holding this, not the other
+    // way around
+    std::mutex ScheduleMutex;
+    std::condition_variable ScheduleCondVar;
+    std::vector<ScheduledFetch> Schedule; // min-heap on Due
+    std::vector<ScheduledFetch> InFlight;
+    bool ScheduleNeedsRebuild = true;
 };
 } // namespace VodArchiver
@@ -1,5 +1,7 @@
 #include "video-task-group.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <format>
 #include <functional>
@@ -12,7 +14,10 @@
 #include "util/scope.h"
 #include "util/thread.h"
 
+#include "../job_progress.h"
+#include "../log_buffer.h"
 #include "../time_types.h"
+#include "../videoinfo/i-video-info.h"
 #include "../videojobs/i-video-job.h"
 
 // There's multiple threads involved here.
@@ -22,14 +27,16 @@
 // The JobRunnerThread may spawn an arbitrary amount of worker threads (stored as RunningVideoJob
 // objects in the RunningTasks vector) that will each run the RunJobThreadFunc.
 //
-// The worker threads are rather uninteresting. They only have access to the single job and the
-// locking constructs accessible through JobConfig and shouldn't cause any problems.
+// The worker threads are rather uninteresting. They only have access to the single job (guarded by
+// its DataLock) and the locking constructs accessible through JobConfig and shouldn't cause any
+// problems.
 //
 // The JobRunnerThread is somewhat tricky, since at any point some other thread may query job
 // states, enqueue new jobs, dequeue jobs, etc. So access to the data structures is synchronized
-// through the JobQueueLock. This needs to be safely entangled with the JobsLock that guards access
-// to the job data in the JobsList! In particular, the external caller may or may not already hold
-// the JobsLock when calling a function to access the job queue.
+// through the JobQueueLock. This needs to be safely entangled with the DataLock that guards access
+// to the data of each job! In particular, the external caller may or may not already hold the
+// DataLock of a job when calling a function to access the job queue, so the JobQueueLock must
+// always be taken last and nothing may try to lock a job while holding it.
 
 namespace VodArchiver {
 // This is the function called when a job is executed.
@@ -43,8 +50,9 @@ static void RunJobThreadFunc(RunningVideoJob* rvj) {
     TaskDoneEnum taskDoneEnum = TaskDoneEnum::FinishedWithError;
     auto scope = HyoutaUtils::MakeScopeGuard([&] { rvj->Done.store(taskDoneEnum); });
     if (rvj->Job != nullptr) {
-        std::unique_lock lock(*rvj->JobConf->JobsLock);
         IVideoJob& job = *rvj->Job;
+        std::unique_lock lock(job.DataLock);
+        auto markChanged = HyoutaUtils::MakeScopeGuard([&] { job.MarkChanged(); });
         bool wasDead = job.JobStatus == VideoJobStatus::Dead;
         try {
             if (job.JobStatus != VideoJobStatus::Finished) {
@@ -55,6 +63,9 @@ static void RunJobThreadFunc(RunningVideoJob* rvj) {
                     result = job.Run(*rvj->JobConf, rvj->CancellationToken);
                     lock.lock();
                 }
+                if (result == ResultType::Cancelled && rvj->CancelledByWatchdog.load()) {
+                    result = ResultType::Stalled;
+                }
                 if (result == ResultType::Success) {
                     job.JobFinishTimestamp = DateTime::UtcNow();
                     job.JobStatus = VideoJobStatus::Finished;
@@ -69,6 +80,10 @@ static void RunJobThreadFunc(RunningVideoJob* rvj) {
                     job.SetStatus("Cancelled during: " + job.TextStatus);
                 }
 
+                if (result == ResultType::Stalled) {
+                    job.SetStatus("Stalled during: " + job.TextStatus);
+                }
+
                 if (result == ResultType::TemporarilyUnavailable) {
                     job.SetStatus("Temporarily unavailable, retrying later.");
                 }
@@ -108,6 +123,14 @@ static size_t GetDefaultMaxJobs(StreamService service) {
     }
 }
 
+static size_t GetDefaultMaxDiskStageJobs(StreamService service) {
+    switch (service) {
+        case StreamService::Youtube: return 2;
+        case StreamService::Twitch: return 3;
+        default: return 1;
+    }
+}
+
 VideoTaskGroup::VideoTaskGroup(StreamService service,
                                std::function<void()> saveJobsDelegate,
                                std::function<void()> powerEventDelegate,
@@ -115,10 +138,14 @@ VideoTaskGroup::VideoTaskGroup(StreamService service,
                                TaskCancellation* cancellationToken)
   : Service(service)
   , MaxJobsRunningPerType(GetDefaultMaxJobs(service))
+  , MaxDiskStageJobsPerType(GetDefaultMaxDiskStageJobs(service))
   , JobConf(jobConfig)
   , CancellationToken(cancellationToken)
   , RequestSaveJobs(std::move(saveJobsDelegate))
   , RequestPowerEvent(std::move(powerEventDelegate)) {
+    if (service == StreamService::FFMpegJob && JobConf) {
+        JobConf->BulkJobConcurrency.store(static_cast<uint32_t>(MaxJobsRunningPerType));
+    }
     JobRunnerThread = std::thread(std::bind(&VideoTaskGroup::RunJobRunnerThreadFunc, this));
 }
 
@@ -169,9 +196,12 @@ void VideoTaskGroup::RunJobRunnerThreadFunc() {
                     auto rvj = std::make_unique<RunningVideoJob>();
                     rvj->Job = wvj->Job;
                     rvj->JobConf = this->JobConf;
+                    rvj->Priority = wvj->Priority;
                     rvj->LastSeenResult = wvj->LastSeenResult;
                     rvj->NumberOfTimesFinishedAsLastSeenResult =
                         wvj->NumberOfTimesFinishedAsLastSeenResult;
+                    rvj->Job->Progress.Heartbeat(); // start the watchdog clock fresh
+                    rvj->Job->ResourcePool.store(JobResourcePool::Network);
                     rvj->Task = std::thread(RunJobThreadFunc, rvj.get());
 
                     {
@@ -190,7 +220,10 @@ void VideoTaskGroup::RunJobRunnerThreadFunc() {
         } catch (...) {
         }
 
-        // TODO: murder tasks that are unresponsive
+        try {
+            CancelStalledTasks();
+        } catch (...) {
+        }
 
         try {
             ProcessFinishedTasks();
@@ -199,6 +232,23 @@ void VideoTaskGroup::RunJobRunnerThreadFunc() {
     }
 }
 
+static void LogJobResult(const IVideoJob& job, LogSeverity severity, std::string_view result) {
+    std::string msg;
+    {
+        std::lock_guard lock(job.DataLock);
+        if (job.VideoInfo) {
+            std::array<char, 256> buffer;
+            msg = std::format("{} {}: {}",
+                              StreamServiceToString(job.VideoInfo->GetService()),
+                              job.VideoInfo->GetVideoId(buffer),
+                              result);
+        } else {
+            msg = std::format("Unknown job: {}", result);
+        }
+    }
+    GetLogBuffer().Append(LogSource::Job, severity, msg);
+}
+
 void VideoTaskGroup::ProcessFinishedTasks() {
     while (true) {
         bool removedTask = false;
@@ -208,15 +258,20 @@ void VideoTaskGroup::ProcessFinishedTasks() {
                 // remove the task
                 std::unique_ptr<RunningVideoJob> task = std::move(*it);
                 RunningTasks.erase(it);
-                lock.unlock(); // unlock the queue to avoid deadlock with JobsLock
+                lock.unlock(); // unlock the queue to avoid deadlock with the DataLock
                 removedTask = true;
 
                 task->Task.join();
                 if (task->Done.load() == TaskDoneEnum::FinishedNormally) {
                     ResultType result = task->Result.load();
+                    if (result < ResultType::COUNT) {
+                        FinishedByResult[static_cast<size_t>(result)].fetch_add(
+                            1, std::memory_order_relaxed);
+                    }
                     const bool matchesLastResult = (result == task->LastSeenResult);
                     const uint32_t numberOfTimesFinishedAsLastResult =
                         matchesLastResult ? (task->NumberOfTimesFinishedAsLastSeenResult + 1) : 1;
+                    bool retried = false;
                     const auto reenqueue_at = [&](DateTime when) {
                         // re-enqueue with a future start time
                         auto wvj = std::make_unique<WaitingVideoJob>();
@@ -225,9 +280,13 @@ void VideoTaskGroup::ProcessFinishedTasks() {
                         wvj->NumberOfTimesFinishedAsLastSeenResult =
                             numberOfTimesFinishedAsLastResult;
                         wvj->EarliestPossibleStartTime = when;
+                        wvj->Priority = task->Priority;
+                        retried = true;
+                        RetriedByResult[static_cast<size_t>(result)].fetch_add(
+                            1, std::memory_order_relaxed);
 
                         std::lock_guard lock2(JobQueueLock);
-                        EnqueueNoLock(std::move(wvj));
+                        EnqueueNoLock(std::move(wvj), DateTime::UtcNow());
                     };
 
                     if (result == ResultType::TemporarilyUnavailable) {
@@ -241,6 +300,13 @@ void VideoTaskGroup::ProcessFinishedTasks() {
                             reenqueue_at(DateTime::UtcNow().AddMinutes(
                                 numberOfTimesFinishedAsLastResult * 3));
                         }
+                    } else if (result == ResultType::Stalled) {
+                        // probably a hung connection or child process. retry with exponential
+                        // backoff so a job that always hangs at the same spot doesn't hog a slot
+                        if (numberOfTimesFinishedAsLastResult <= 8) {
+                            reenqueue_at(DateTime::UtcNow().AddMinutes(
+                                5 << (numberOfTimesFinishedAsLastResult - 1)));
+                        }
                     } else if (result == ResultType::DubiousCombine) {
                         // twitch videos that just ended can end up in an inconsistent state where
                         // the metadata shows it as done (with the correct final time) but the vod
@@ -251,14 +317,29 @@ void VideoTaskGroup::ProcessFinishedTasks() {
                             reenqueue_at(DateTime::UtcNow().AddMinutes(6));
                         }
                     }
+
+                    const bool expected =
+                        (result == ResultType::Success || result == ResultType::Cancelled);
+                    LogJobResult(*task->Job,
+                                 expected  ? LogSeverity::Info
+                                 : retried ? LogSeverity::Warning
+                                           : LogSeverity::Error,
+                                 retried ? std::format("{}, will retry", ResultTypeToString(result))
+                                         : std::format("{}", ResultTypeToString(result)));
                 } else {
-                    std::lock_guard lock2(*JobConf->JobsLock);
+                    FinishedByResult[static_cast<size_t>(ResultType::Failure)].fetch_add(
+                        1, std::memory_order_relaxed);
+                    JobDataWriteLock lock2(*task->Job);
                     if (!task->ErrorString.empty()) {
                         task->Job->SetStatus("Failed via unexpected exception: "
                                              + task->ErrorString);
                     } else {
                         task->Job->SetStatus("Failed for unknown reasons.");
                     }
+                    LogJobResult(*task->Job,
+                                 LogSeverity::Error,
+                                 task->ErrorString.empty() ? std::string("Failed")
+                                                           : ("Failed: " + task->ErrorString));
                 }
 
                 RequestSaveJobs();
@@ -276,64 +357,220 @@ void VideoTaskGroup::ProcessFinishedTasks() {
     }
 }
 
-std::unique_ptr<WaitingVideoJob> VideoTaskGroup::DequeueVideoJobForTask() {
-    // JobsLock must be locked first to avoid deadlock!
-    std::lock_guard lock2(*JobConf->JobsLock);
+void VideoTaskGroup::CancelStalledTasks() {
+    uint32_t timeoutMinutes;
     {
-        std::lock_guard lock(JobQueueLock);
-        bool found = false;
-        size_t waitingJobIndex = 0;
-        {
-            const auto IsAllowedToStart = [](const WaitingVideoJob& wvj) -> bool {
-                return wvj.Job != nullptr && DateTime::UtcNow() >= wvj.EarliestPossibleStartTime
-                       && !wvj.Job->IsWaitingForUserInput();
-            };
-            for (size_t i = 0; i < WaitingJobs.size(); ++i) {
-                auto& wj = *WaitingJobs[i];
-                if (wj.StartImmediately
-                    || (RunningTasks.size() < MaxJobsRunningPerType && IsAllowedToStart(wj))) {
-                    waitingJobIndex = i;
-                    found = true;
-                    break;
-                }
-            }
+        std::lock_guard lock(JobConf->Mutex);
+        timeoutMinutes = JobConf->StallTimeoutMinutes;
+    }
+    if (timeoutMinutes == 0) {
+        return;
+    }
+    const int64_t timeoutMs = static_cast<int64_t>(timeoutMinutes) * 60 * 1000;
+
+    // only looks at the job's atomics, so there's no need to lock any job
+    std::lock_guard lock(JobQueueLock);
+    for (auto& rvj : RunningTasks) {
+        if (rvj->Job == nullptr || rvj->Done.load() != TaskDoneEnum::NotDone
+            || rvj->CancellationToken.IsCancellationRequested()) {
+            continue;
+        }
+
+        // a job waiting for the user is not stuck, the user is
+        if (rvj->Job->IsWaitingForUserInput()) {
+            rvj->Job->Progress.Heartbeat();
+            continue;
         }
 
-        if (found) {
-            std::unique_ptr<WaitingVideoJob> wvj = std::move(WaitingJobs[waitingJobIndex]);
-            WaitingJobs.erase(WaitingJobs.begin() + waitingJobIndex);
-            return wvj;
+        if (IsJobProgressStalled(rvj->Job->Progress, timeoutMs)) {
+            rvj->CancelledByWatchdog.store(true);
+            rvj->CancellationToken.CancelTask();
+        }
+    }
+}
+
+bool VideoTaskGroup::DelayedJobReferenceCompare::operator()(
+    const DelayedJobReference& lhs,
+    const DelayedJobReference& rhs) const {
+    // std::priority_queue puts the largest element on top, so this is inverted
+    return lhs.EarliestPossibleStartTime > rhs.EarliestPossibleStartTime;
+}
+
+bool VideoTaskGroup::ReadyJobReferenceCompare::operator()(const ReadyJobReference& lhs,
+                                                          const ReadyJobReference& rhs) const {
+    if (lhs.StartImmediately != rhs.StartImmediately) {
+        return rhs.StartImmediately;
+    }
+    if (lhs.Priority != rhs.Priority) {
+        return lhs.Priority < rhs.Priority;
+    }
+    return lhs.QueueOrder > rhs.QueueOrder;
+}
+
+std::unique_ptr<WaitingVideoJob> VideoTaskGroup::DequeueVideoJobForTask() {
+    std::lock_guard lock(JobQueueLock);
+
+    // move everything whose start time has come over to the ready queue
+    const DateTime now = DateTime::UtcNow();
+    while (!DelayedJobs.empty() && DelayedJobs.top().EarliestPossibleStartTime <= now) {
+        const DelayedJobReference ref = DelayedJobs.top();
+        DelayedJobs.pop();
+        if (WaitingVideoJob* wj = FindWaitingJobNoLock(ref.Job, ref.Generation)) {
+            ReadyJobs.push(ReadyJobReference{.StartImmediately = wj->StartImmediately,
+                                             .Priority = wj->Priority,
+                                             .QueueOrder = wj->QueueOrder,
+                                             .Job = wj->Job,
+                                             .Generation = wj->Generation});
+        }
+    }
+
+    // every job starts out in the network stage, so that's the slot it needs
+    const bool hasFreeSlot =
+        CountRunningTasksNoLock(JobResourcePool::Network) < MaxJobsRunningPerType
+        && CountRunningTasksNoLock(JobResourcePool::Disk) < MaxDiskStageJobsPerType;
+
+    // jobs that are waiting for the user are skipped, but must keep their place in the queue
+    std::vector<ReadyJobReference> skipped;
+    std::unique_ptr<WaitingVideoJob> result = nullptr;
+    while (!ReadyJobs.empty()) {
+        const ReadyJobReference ref = ReadyJobs.top();
+        WaitingVideoJob* wj = FindWaitingJobNoLock(ref.Job, ref.Generation);
+        if (wj == nullptr) {
+            ReadyJobs.pop();
+            continue;
+        }
+        if (!wj->StartImmediately) {
+            if (!hasFreeSlot) {
+                break;
+            }
+            if (wj->Job->IsWaitingForUserInput()) {
+                skipped.push_back(ref);
+                ReadyJobs.pop();
+                continue;
+            }
         }
+
+        ReadyJobs.pop();
+        auto it = WaitingJobs.find(ref.Job);
+        result = std::move(it->second);
+        WaitingJobs.erase(it);
+        break;
+    }
+    for (const ReadyJobReference& ref : skipped) {
+        ReadyJobs.push(ref);
     }
+    CompactQueuesIfStaleNoLock(now);
 
-    return nullptr;
+    return result;
 }
 
 void VideoTaskGroup::Enqueue(IVideoJob* job, bool startImmediately) {
+    auto wj = MakeWaitingJob(job, startImmediately, JobPriority::Normal);
+    std::lock_guard lock(JobQueueLock);
+    EnqueueNoLock(std::move(wj), DateTime::UtcNow());
+}
+
+void VideoTaskGroup::EnqueueBulk(std::span<IVideoJob* const> jobs, JobPriority priority) {
+    std::vector<std::unique_ptr<WaitingVideoJob>> waitingJobs;
+    waitingJobs.reserve(jobs.size());
+    for (IVideoJob* job : jobs) {
+        waitingJobs.emplace_back(MakeWaitingJob(job, false, priority));
+    }
+
     std::lock_guard lock(JobQueueLock);
-    EnqueueNoLock(job, startImmediately);
+    const DateTime now = DateTime::UtcNow();
+    WaitingJobs.reserve(WaitingJobs.size() + waitingJobs.size());
+    for (auto& wj : waitingJobs) {
+        EnqueueNoLock(std::move(wj), now);
+    }
 }
 
-void VideoTaskGroup::EnqueueNoLock(IVideoJob* job, bool startImmediately) {
+// Takes the DataLock of the job to ask it for its minimum priority, so this must not be called
+// while holding the JobQueueLock.
+std::unique_ptr<WaitingVideoJob>
+    VideoTaskGroup::MakeWaitingJob(IVideoJob* job, bool startImmediately, JobPriority priority) {
     auto wj = std::make_unique<WaitingVideoJob>();
     wj->Job = job;
     wj->StartImmediately = startImmediately;
-    EnqueueNoLock(std::move(wj));
+    {
+        std::lock_guard lock(job->DataLock);
+        wj->Priority = std::max(priority, job->GetMinimumPriority());
+    }
+    return wj;
 }
 
-void VideoTaskGroup::EnqueueNoLock(std::unique_ptr<WaitingVideoJob> wj) {
-    if (!CancellationToken->IsCancellationRequested()) {
-        if (IsJobWaitingNoLock(wj->Job)) {
-            for (auto& alreadyEnqueuedJob : WaitingJobs) {
-                if (alreadyEnqueuedJob->Job == wj->Job) {
-                    alreadyEnqueuedJob->EarliestPossibleStartTime = wj->EarliestPossibleStartTime;
-                    alreadyEnqueuedJob->StartImmediately = wj->StartImmediately;
-                }
-            }
-        } else if (!IsJobRunningNoLock(wj->Job)) {
-            WaitingJobs.emplace_back(std::move(wj));
+void VideoTaskGroup::EnqueueNoLock(std::unique_ptr<WaitingVideoJob> wj, DateTime now) {
+    if (CancellationToken->IsCancellationRequested()) {
+        return;
+    }
+
+    auto it = WaitingJobs.find(wj->Job);
+    if (it != WaitingJobs.end()) {
+        // already waiting, update the scheduling fields but keep the place in the queue
+        WaitingVideoJob& alreadyEnqueuedJob = *it->second;
+        const JobPriority priority = std::max(alreadyEnqueuedJob.Priority, wj->Priority);
+        if (alreadyEnqueuedJob.EarliestPossibleStartTime == wj->EarliestPossibleStartTime
+            && alreadyEnqueuedJob.StartImmediately == wj->StartImmediately
+            && alreadyEnqueuedJob.Priority == priority) {
+            return;
         }
+        alreadyEnqueuedJob.EarliestPossibleStartTime = wj->EarliestPossibleStartTime;
+        alreadyEnqueuedJob.StartImmediately = wj->StartImmediately;
+        alreadyEnqueuedJob.Priority = priority;
+        alreadyEnqueuedJob.Generation = NextGeneration++;
+        PushQueueReferencesNoLock(alreadyEnqueuedJob, now);
+        CompactQueuesIfStaleNoLock(now);
+        return;
+    }
+
+    if (IsJobRunningNoLock(wj->Job)) {
+        return;
+    }
+
+    wj->QueueOrder = NextQueueOrder++;
+    wj->Generation = NextGeneration++;
+    PushQueueReferencesNoLock(*wj, now);
+    WaitingJobs.emplace(wj->Job, std::move(wj));
+    CompactQueuesIfStaleNoLock(now);
+}
+
+void VideoTaskGroup::PushQueueReferencesNoLock(const WaitingVideoJob& wj, DateTime now) {
+    if (wj.StartImmediately || wj.EarliestPossibleStartTime <= now) {
+        ReadyJobs.push(ReadyJobReference{.StartImmediately = wj.StartImmediately,
+                                         .Priority = wj.Priority,
+                                         .QueueOrder = wj.QueueOrder,
+                                         .Job = wj.Job,
+                                         .Generation = wj.Generation});
+    } else {
+        DelayedJobs.push(DelayedJobReference{
+            .EarliestPossibleStartTime = wj.EarliestPossibleStartTime,
+            .Job = wj.Job,
+            .Generation = wj.Generation,
+        });
+    }
+}
+
+void VideoTaskGroup::CompactQueuesNoLock(DateTime now) {
+    // drop all stale references by rebuilding both queues from the waiting jobs
+    DelayedJobs = {};
+    ReadyJobs = {};
+    for (const auto& [job, wj] : WaitingJobs) {
+        PushQueueReferencesNoLock(*wj, now);
+    }
+}
+
+void VideoTaskGroup::CompactQueuesIfStaleNoLock(DateTime now) {
+    if (DelayedJobs.size() + ReadyJobs.size() > WaitingJobs.size() * 2 + 64) {
+        CompactQueuesNoLock(now);
+    }
+}
+
+WaitingVideoJob* VideoTaskGroup::FindWaitingJobNoLock(IVideoJob* job, uint64_t generation) {
+    auto it = WaitingJobs.find(job);
+    if (it == WaitingJobs.end() || it->second->Generation != generation) {
+        return nullptr;
     }
+    return it->second.get();
 }
 
 bool VideoTaskGroup::IsEmpty() {
@@ -345,13 +582,33 @@ bool VideoTaskGroup::IsEmptyNoLock() {
     return WaitingJobs.empty() && RunningTasks.empty();
 }
 
-bool VideoTaskGroup::IsJobWaitingNoLock(IVideoJob* job) {
-    for (auto& wj : WaitingJobs) {
-        if (wj->Job == job) {
-            return true;
+void VideoTaskGroup::AccumulateThroughput(JobProgressThroughput& throughput) {
+    // JobProgress is safe to read without the DataLock, so this doesn't need to take it
+    std::lock_guard lock(JobQueueLock);
+    for (auto& rvj : RunningTasks) {
+        if (rvj->Job != nullptr) {
+            throughput.Add(SampleJobProgress(rvj->Job->Progress));
         }
     }
-    return false;
+}
+
+VideoTaskGroupStatistics VideoTaskGroup::GetStatistics() {
+    VideoTaskGroupStatistics statistics;
+    {
+        std::lock_guard lock(JobQueueLock);
+        statistics.Waiting = WaitingJobs.size();
+        statistics.RunningNetwork = CountRunningTasksNoLock(JobResourcePool::Network);
+        statistics.RunningDisk = CountRunningTasksNoLock(JobResourcePool::Disk);
+    }
+    for (size_t i = 0; i < statistics.FinishedByResult.size(); ++i) {
+        statistics.FinishedByResult[i] = FinishedByResult[i].load(std::memory_order_relaxed);
+        statistics.RetriedByResult[i] = RetriedByResult[i].load(std::memory_order_relaxed);
+    }
+    return statistics;
+}
+
+bool VideoTaskGroup::IsJobWaitingNoLock(IVideoJob* job) {
+    return WaitingJobs.contains(job);
 }
 
 bool VideoTaskGroup::IsJobRunningNoLock(IVideoJob* job) {
@@ -367,6 +624,16 @@ bool VideoTaskGroup::IsJobWaitingOrRunningNoLock(IVideoJob* job) {
     return IsJobWaitingNoLock(job) || IsJobRunningNoLock(job);
 }
 
+size_t VideoTaskGroup::CountRunningTasksNoLock(JobResourcePool pool) {
+    size_t count = 0;
+    for (auto& rt : RunningTasks) {
+        if (rt->Job != nullptr && rt->Job->ResourcePool.load() == pool) {
+            ++count;
+        }
+    }
+    return count;
+}
+
 bool VideoTaskGroup::CancelJob(IVideoJob* job) {
     std::lock_guard lock(JobQueueLock);
     return CancelJobNoLock(job);
@@ -394,16 +661,12 @@ bool VideoTaskGroup::Dequeue(IVideoJob* job) {
 }
 
 bool VideoTaskGroup::DequeueNoLock(IVideoJob* job) {
-    bool found = false;
-    for (auto it = WaitingJobs.begin(); it != WaitingJobs.end();) {
-        if ((*it)->Job == job) {
-            it = WaitingJobs.erase(it);
-            found = true;
-        } else {
-            ++it;
-        }
+    // any references left in the queues are dropped once they reach the top, or when compacting
+    if (WaitingJobs.erase(job) == 0) {
+        return false;
     }
-    return found;
+    CompactQueuesIfStaleNoLock(DateTime::UtcNow());
+    return true;
 }
 
 void VideoTaskGroup::DequeueAll() {
@@ -413,5 +676,7 @@ void VideoTaskGroup::DequeueAll() {
 
 void VideoTaskGroup::DequeueAllNoLock() {
     WaitingJobs.clear();
+    DelayedJobs = {};
+    ReadyJobs = {};
 }
 } // namespace VodArchiver
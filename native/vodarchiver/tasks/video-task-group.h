@@ -1,15 +1,20 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <queue>
+#include <span>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "../job_config.h"
+#include "../job_progress.h"
 #include "../task_cancellation.h"
 #include "../time_types.h"
 #include "../videojobs/i-video-job.h"
@@ -30,6 +35,24 @@ struct WaitingVideoJob {
 
     // force-start this task ASAP, ignoring all other logic
     bool StartImmediately = false;
+
+    // jobs with a higher priority are started first, jobs of equal priority in QueueOrder
+    JobPriority Priority = JobPriority::Normal;
+    uint64_t QueueOrder = 0;
+
+    // changes whenever any of the scheduling fields above change, to tell apart stale references
+    // to this job in the queues of the VideoTaskGroup
+    uint64_t Generation = 0;
+};
+
+struct VideoTaskGroupStatistics {
+    size_t Waiting = 0;
+    size_t RunningNetwork = 0;
+    size_t RunningDisk = 0;
+
+    // since the task group was created
+    std::array<uint64_t, static_cast<size_t>(ResultType::COUNT)> FinishedByResult{};
+    std::array<uint64_t, static_cast<size_t>(ResultType::COUNT)> RetriedByResult{};
 };
 
 enum class TaskDoneEnum : uint8_t {
@@ -45,6 +68,10 @@ struct RunningVideoJob {
     std::thread Task;
     std::atomic<TaskDoneEnum> Done = TaskDoneEnum::NotDone;
     std::atomic<ResultType> Result = ResultType::Failure;
+    JobPriority Priority = JobPriority::Normal;
+
+    // set when the CancellationToken was triggered by the stall watchdog rather than the user
+    std::atomic<bool> CancelledByWatchdog = false;
 
     // see WaitingVideoJob
     std::atomic<ResultType> LastSeenResult = ResultType::Success;
@@ -62,12 +89,18 @@ struct VideoTaskGroup {
     ~VideoTaskGroup();
 
     void Enqueue(IVideoJob* job, bool startImmediately = false);
+    void EnqueueBulk(std::span<IVideoJob* const> jobs, JobPriority priority = JobPriority::Backlog);
     bool IsEmpty();
     bool CancelJob(IVideoJob* job);
     bool IsInQueue(IVideoJob* job);
     bool Dequeue(IVideoJob* job);
     void DequeueAll();
 
+    // Adds the current progress of all running jobs to the given throughput.
+    void AccumulateThroughput(JobProgressThroughput& throughput);
+
+    VideoTaskGroupStatistics GetStatistics();
+
     bool IsAutoEnqueue() const {
         return AutoEnqueue.load(std::memory_order_relaxed);
     }
@@ -83,30 +116,89 @@ struct VideoTaskGroup {
 private:
     void RunJobRunnerThreadFunc();
     void ProcessFinishedTasks();
+    void CancelStalledTasks();
     std::unique_ptr<WaitingVideoJob> DequeueVideoJobForTask();
 
-    void EnqueueNoLock(IVideoJob* job, bool startImmediately);
-    void EnqueueNoLock(std::unique_ptr<WaitingVideoJob> wj);
+    static std::unique_ptr<WaitingVideoJob>
+        MakeWaitingJob(IVideoJob* job, bool startImmediately, JobPriority priority);
+    void EnqueueNoLock(std::unique_ptr<WaitingVideoJob> wj, DateTime now);
+    void PushQueueReferencesNoLock(const WaitingVideoJob& wj, DateTime now);
+    void CompactQueuesNoLock(DateTime now);
+
+    // Call after every change to the queues or WaitingJobs. Compacts the queues once stale
+    // references make up most of them, so they don't grow without bound while jobs keep getting
+    // re-enqueued or dequeued without ever reaching the top.
+    void CompactQueuesIfStaleNoLock(DateTime now);
+    WaitingVideoJob* FindWaitingJobNoLock(IVideoJob* job, uint64_t generation);
     bool IsEmptyNoLock();
     bool CancelJobNoLock(IVideoJob* job);
     bool IsJobWaitingNoLock(IVideoJob* job);
     bool IsJobRunningNoLock(IVideoJob* job);
     bool IsJobWaitingOrRunningNoLock(IVideoJob* job);
+    size_t CountRunningTasksNoLock(JobResourcePool pool);
     bool DequeueNoLock(IVideoJob* job);
     void DequeueAllNoLock();
 
     StreamService Service = StreamService::Unknown;
     std::atomic<bool> AutoEnqueue = false;
 
-    // This mutex guards access to WaitingJobs and RunningTasks.
+    struct DelayedJobReference {
+        DateTime EarliestPossibleStartTime;
+        IVideoJob* Job;
+        uint64_t Generation;
+    };
+    struct ReadyJobReference {
+        bool StartImmediately;
+        JobPriority Priority;
+        uint64_t QueueOrder;
+        IVideoJob* Job;
+        uint64_t Generation;
+    };
+    struct DelayedJobReferenceCompare {
+        bool operator()(const DelayedJobReference& lhs, const DelayedJobReference& rhs) const;
+    };
+    struct ReadyJobReferenceCompare {
+        bool operator()(const ReadyJobReference& lhs, const ReadyJobReference& rhs) const;
+    };
+
+    // This mutex guards access to everything below up to and including RunningTasks.
     std::mutex JobQueueLock;
-    std::vector<std::unique_ptr<WaitingVideoJob>> WaitingJobs;
+
+    // All waiting jobs. DelayedJobs and ReadyJobs reference these by job and generation. They may
+    // hold stale references to jobs that have since been dequeued or re-enqueued, those are
+    // dropped when they reach the top.
+    std::unordered_map<IVideoJob*, std::unique_ptr<WaitingVideoJob>> WaitingJobs;
+
+    // waiting jobs that may not start yet, earliest start time on top
+    std::priority_queue<DelayedJobReference,
+                        std::vector<DelayedJobReference>,
+                        DelayedJobReferenceCompare>
+        DelayedJobs;
+
+    // waiting jobs that may start as soon as there's a free slot, next one to start on top
+    std::priority_queue<ReadyJobReference,
+                        std::vector<ReadyJobReference>,
+                        ReadyJobReferenceCompare>
+        ReadyJobs;
+
+    uint64_t NextQueueOrder = 0;
+    uint64_t NextGeneration = 0;
+
     std::vector<std::unique_ptr<RunningVideoJob>> RunningTasks;
 
+    // Running jobs are limited per JobResourcePool, so a job that is done downloading and waits
+    // for the disk doesn't keep the next download from starting. The disk limit only exists to
+    // stop finished downloads from piling up in the temp folder, the actual disk access is
+    // throttled by JobConfig::ExpensiveDiskIO.
     size_t MaxJobsRunningPerType = 0;
+    size_t MaxDiskStageJobsPerType = 0;
     JobConfig* JobConf = nullptr;
     TaskCancellation* CancellationToken = nullptr;
 
+    // indexed by ResultType, see VideoTaskGroupStatistics
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(ResultType::COUNT)> FinishedByResult{};
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(ResultType::COUNT)> RetriedByResult{};
+
     std::function<void()> RequestSaveJobs;
     std::function<void()> RequestPowerEvent;
 
@@ -0,0 +1,151 @@
+#include "trigram_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/text.h"
+
+namespace VodArchiver {
+static uint32_t MakeTrigram(const char* chars) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(chars[0]))
+           | (static_cast<uint32_t>(static_cast<uint8_t>(chars[1])) << 8)
+           | (static_cast<uint32_t>(static_cast<uint8_t>(chars[2])) << 16);
+}
+
+// sorted and without duplicates. trigrams that contain a field separator are left out since no
+// query can ever match them
+static std::vector<uint32_t> CollectTrigrams(std::string_view text) {
+    std::vector<uint32_t> trigrams;
+    if (text.size() < 3) {
+        return trigrams;
+    }
+    trigrams.reserve(text.size() - 2);
+    for (size_t i = 0; i + 3 <= text.size(); ++i) {
+        if (text[i] == '\0' || text[i + 1] == '\0' || text[i + 2] == '\0') {
+            continue;
+        }
+        trigrams.push_back(MakeTrigram(&text[i]));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+TrigramIndex::TrigramIndex() = default;
+
+TrigramIndex::~TrigramIndex() = default;
+
+void TrigramIndex::Set(uint32_t id, std::span<const std::string_view> fields) {
+    std::string text;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (i != 0) {
+            text.push_back('\0');
+        }
+        text.append(HyoutaUtils::TextUtils::ToLower(fields[i]));
+    }
+
+    if (id >= Documents.size()) {
+        Documents.resize(static_cast<size_t>(id) + 1);
+    } else if (Documents[id] == text) {
+        return;
+    }
+
+    std::vector<uint32_t> oldTrigrams = CollectTrigrams(Documents[id]);
+    std::vector<uint32_t> newTrigrams = CollectTrigrams(text);
+    Documents[id] = std::move(text);
+
+    std::vector<uint32_t> removed;
+    std::set_difference(oldTrigrams.begin(),
+                        oldTrigrams.end(),
+                        newTrigrams.begin(),
+                        newTrigrams.end(),
+                        std::back_inserter(removed));
+    for (uint32_t trigram : removed) {
+        auto it = Postings.find(trigram);
+        if (it == Postings.end()) {
+            continue;
+        }
+        std::vector<uint32_t>& ids = it->second;
+        auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+        if (pos != ids.end() && *pos == id) {
+            ids.erase(pos);
+        }
+        if (ids.empty()) {
+            Postings.erase(it);
+        }
+    }
+
+    std::vector<uint32_t> added;
+    std::set_difference(newTrigrams.begin(),
+                        newTrigrams.end(),
+                        oldTrigrams.begin(),
+                        oldTrigrams.end(),
+                        std::back_inserter(added));
+    for (uint32_t trigram : added) {
+        std::vector<uint32_t>& ids = Postings[trigram];
+
+        // documents are usually added in order, so this is almost always an append
+        if (ids.empty() || ids.back() < id) {
+            ids.push_back(id);
+        } else {
+            auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+            if (pos == ids.end() || *pos != id) {
+                ids.insert(pos, id);
+            }
+        }
+    }
+}
+
+std::vector<uint32_t> TrigramIndex::Search(std::string_view query) const {
+    const std::string needle = HyoutaUtils::TextUtils::ToLower(query);
+    std::vector<uint32_t> result;
+
+    if (needle.size() < 3) {
+        // too short to use the index, but these are rare and the documents are short
+        for (size_t i = 0; i < Documents.size(); ++i) {
+            if (Documents[i].find(needle) != std::string::npos) {
+                result.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        return result;
+    }
+
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (uint32_t trigram : CollectTrigrams(needle)) {
+        auto it = Postings.find(trigram);
+        if (it == Postings.end()) {
+            return result;
+        }
+        lists.push_back(&it->second);
+    }
+
+    // intersect starting from the rarest trigram so the candidate set shrinks as fast as possible
+    std::sort(lists.begin(), lists.end(), [](const auto* lhs, const auto* rhs) {
+        return lhs->size() < rhs->size();
+    });
+    std::vector<uint32_t> candidates = *lists[0];
+    std::vector<uint32_t> next;
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+        next.clear();
+        std::set_intersection(candidates.begin(),
+                              candidates.end(),
+                              lists[i]->begin(),
+                              lists[i]->end(),
+                              std::back_inserter(next));
+        candidates.swap(next);
+    }
+
+    // having all trigrams doesn't mean they appear in the right order, so check the actual text
+    for (uint32_t id : candidates) {
+        if (Documents[id].find(needle) != std::string::npos) {
+            result.push_back(id);
+        }
+    }
+    return result;
+}
+} // namespace VodArchiver
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace VodArchiver {
+// Inverted index from every three-character sequence to the documents containing it, for fast
+// case-insensitive substring search over many short texts. Case folding is ASCII only, matching
+// HyoutaUtils::TextUtils::CaseInsensitiveContains().
+// Documents are identified by small dense integers, eg. an index into the JobList.
+// Not thread-safe, callers need to synchronize access themselves.
+struct TrigramIndex {
+    TrigramIndex();
+    TrigramIndex(const TrigramIndex& other) = delete;
+    TrigramIndex(TrigramIndex&& other) = delete;
+    TrigramIndex& operator=(const TrigramIndex& other) = delete;
+    TrigramIndex& operator=(TrigramIndex&& other) = delete;
+    ~TrigramIndex();
+
+    // Adds the document or replaces its previous text. A match never spans two fields.
+    void Set(uint32_t id, std::span<const std::string_view> fields);
+
+    // All documents containing the query in any field, in ascending order.
+    std::vector<uint32_t> Search(std::string_view query) const;
+
+    size_t GetDocumentCount() const {
+        return Documents.size();
+    }
+
+private:
+    // case-folded fields separated by '\0', so that no trigram crosses from one field into another
+    std::vector<std::string> Documents;
+
+    // trigram -> sorted ids of the documents containing it
+    std::unordered_map<uint32_t, std::vector<uint32_t>> Postings;
+};
+} // namespace VodArchiver
@@ -6,6 +6,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "rapidjson/document.h"
@@ -371,14 +372,11 @@ static std::optional<TwitchVideo>
     return v;
 }
 
-static bool GetVideosInternal(TwitchVodFetchResult& r,
-                              int64_t channelId,
-                              bool highlights,
-                              int offset,
-                              int limit,
-                              const std::string& clientId,
-                              const std::string& clientSecret,
-                              const std::string& after) {
+std::optional<TwitchVodFetchResult> GetVideos(int64_t channelId,
+                                              bool highlights,
+                                              std::string_view after,
+                                              const std::string& clientId,
+                                              const std::string& clientSecret) {
     std::string url = std::format("{}videos?user_id={}&first={}&type={}{}{}",
                                   Helix,
                                   channelId,
@@ -388,64 +386,43 @@ static bool GetVideosInternal(TwitchVodFetchResult& r,
                                   after);
     auto result = Get(url, clientId, clientSecret);
     if (!result) {
-        return false;
+        return std::nullopt;
     }
 
-    std::string cursor;
-    {
-        rapidjson::Document json;
-        json.Parse<rapidjson::kParseFullPrecisionFlag | rapidjson::kParseNanAndInfFlag
-                       | rapidjson::kParseCommentsFlag,
-                   rapidjson::UTF8<char>>(result->data(), result->size());
-        if (json.HasParseError() || !json.IsObject()) {
-            return false;
-        }
-        const auto jo = json.GetObject();
-        const auto dataIt = jo.FindMember("data");
-        if (dataIt == jo.MemberEnd() || !dataIt->value.IsArray()) {
-            return false;
-        }
-        const auto array = dataIt->value.GetArray();
-        for (const auto& a : array) {
-            if (a.IsObject()) {
-                const auto o = a.GetObject();
-                auto video = VideoFromJson(o);
-                if (video) {
-                    r.Videos.push_back(std::move(*video));
-                }
-            }
-        }
+    rapidjson::Document json;
+    json.Parse<rapidjson::kParseFullPrecisionFlag | rapidjson::kParseNanAndInfFlag
+                   | rapidjson::kParseCommentsFlag,
+               rapidjson::UTF8<char>>(result->data(), result->size());
+    if (json.HasParseError() || !json.IsObject()) {
+        return std::nullopt;
+    }
+    const auto jo = json.GetObject();
+    const auto dataIt = jo.FindMember("data");
+    if (dataIt == jo.MemberEnd() || !dataIt->value.IsArray()) {
+        return std::nullopt;
+    }
 
-        const auto paginationIt = jo.FindMember("pagination");
-        if (paginationIt != jo.MemberEnd() && paginationIt->value.IsObject()) {
-            auto p = paginationIt->value.GetObject();
-            auto cursorIt = p.FindMember("cursor");
-            if (cursorIt != p.MemberEnd() && cursorIt->value.IsString()) {
-                cursor =
-                    std::string(cursorIt->value.GetString(), cursorIt->value.GetStringLength());
+    TwitchVodFetchResult r;
+    const auto array = dataIt->value.GetArray();
+    for (const auto& a : array) {
+        if (a.IsObject()) {
+            const auto o = a.GetObject();
+            auto video = VideoFromJson(o);
+            if (video) {
+                r.Videos.push_back(std::move(*video));
             }
         }
     }
 
-    if (!cursor.empty()) {
-        if (!GetVideosInternal(
-                r, channelId, highlights, offset, limit, clientId, clientSecret, cursor)) {
-            return false;
+    const auto paginationIt = jo.FindMember("pagination");
+    if (paginationIt != jo.MemberEnd() && paginationIt->value.IsObject()) {
+        auto p = paginationIt->value.GetObject();
+        auto cursorIt = p.FindMember("cursor");
+        if (cursorIt != p.MemberEnd() && cursorIt->value.IsString()) {
+            r.Cursor = std::string(cursorIt->value.GetString(), cursorIt->value.GetStringLength());
         }
     }
 
-    return true;
-}
-
-std::optional<TwitchVodFetchResult> GetVideos(int64_t channelId,
-                                              bool highlights,
-                                              int offset,
-                                              int limit,
-                                              const std::string& clientId,
-                                              const std::string& clientSecret) {
-    TwitchVodFetchResult r;
-    GetVideosInternal(r, channelId, highlights, offset, limit, clientId, clientSecret, "");
-    r.TotalVideoCount = 1; // TODO
     return r;
 }
 } // namespace VodArchiver::Twitch
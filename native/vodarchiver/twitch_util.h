@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "vodarchiver/videoinfo/i-video-info.h"
@@ -14,12 +15,14 @@ std::optional<int64_t> GetUserIdFromUsername(const std::string& username,
                                              const std::string& clientSecret);
 struct TwitchVodFetchResult {
     std::vector<TwitchVideo> Videos;
-    int64_t TotalVideoCount;
+
+    // Helix cursor of the next page, empty if this was the last one.
+    std::string Cursor;
 };
+// Fetches one page of videos. after is the Cursor of the previous page, or empty for the first.
 std::optional<TwitchVodFetchResult> GetVideos(int64_t channelId,
                                               bool highlights,
-                                              int offset,
-                                              int limit,
+                                              std::string_view after,
                                               const std::string& clientId,
                                               const std::string& clientSecret);
 } // namespace VodArchiver::Twitch
@@ -103,7 +103,8 @@ static std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
     return vi;
 }
 
-FetchReturnValue ArchiveOrgUserInfo::Fetch(JobConfig& jobConfig, size_t offset, bool flat) {
+FetchReturnValue
+    ArchiveOrgUserInfo::Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) {
     std::vector<std::unique_ptr<IVideoInfo>> videosToAdd;
     bool hasMore = true;
     long maxVideos = -1;
@@ -139,6 +140,7 @@ std::unique_ptr<IUserInfo> ArchiveOrgUserInfo::Clone() const {
     u->Persistable = this->Persistable;
     u->AutoDownload = this->AutoDownload;
     u->LastRefreshedOn = this->LastRefreshedOn;
+    u->FetchResumeCursor = this->FetchResumeCursor;
     u->Identifier = this->Identifier;
     return u;
 }
@@ -241,7 +241,8 @@ static std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
 }
 
 
-FetchReturnValue FFMpegJobUserInfo::Fetch(JobConfig& jobConfig, size_t offset, bool flat) {
+FetchReturnValue
+    FFMpegJobUserInfo::Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) {
     std::vector<std::unique_ptr<IVideoInfo>> videosToAdd;
     bool hasMore = true;
     int64_t maxVideos = -1;
@@ -277,6 +278,7 @@ std::unique_ptr<IUserInfo> FFMpegJobUserInfo::Clone() const {
     u->Persistable = this->Persistable;
     u->AutoDownload = this->AutoDownload;
     u->LastRefreshedOn = this->LastRefreshedOn;
+    u->FetchResumeCursor = this->FetchResumeCursor;
     u->Path = this->Path;
     u->Preset = this->Preset;
     return u;
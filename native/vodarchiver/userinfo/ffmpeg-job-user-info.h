@@ -13,7 +13,7 @@ struct FFMpegJobUserInfo final : public IUserInfo {
     ServiceVideoCategoryType GetType() override;
     std::string GetUserIdentifier() override;
 
-    FetchReturnValue Fetch(JobConfig& jobConfig, size_t offset, bool flat) override;
+    FetchReturnValue Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) override;
 
     std::unique_ptr<IUserInfo> Clone() const override;
 
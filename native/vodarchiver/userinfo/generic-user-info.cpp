@@ -11,7 +11,8 @@ std::string GenericUserInfo::GetUserIdentifier() {
     return Username;
 }
 
-FetchReturnValue GenericUserInfo::Fetch(JobConfig& jobConfig, size_t offset, bool flat) {
+FetchReturnValue
+    GenericUserInfo::Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) {
     return FetchReturnValue{.Success = false, .HasMore = false};
 }
 
@@ -20,6 +21,7 @@ std::unique_ptr<IUserInfo> GenericUserInfo::Clone() const {
     u->Persistable = this->Persistable;
     u->AutoDownload = this->AutoDownload;
     u->LastRefreshedOn = this->LastRefreshedOn;
+    u->FetchResumeCursor = this->FetchResumeCursor;
     u->Service = this->Service;
     u->UserID = this->UserID;
     u->Username = this->Username;
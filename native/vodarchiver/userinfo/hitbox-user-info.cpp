@@ -18,7 +18,8 @@ std::string HitboxUserInfo::GetUserIdentifier() {
     return Username;
 }
 
-FetchReturnValue HitboxUserInfo::Fetch(JobConfig& jobConfig, size_t offset, bool flat) {
+FetchReturnValue
+    HitboxUserInfo::Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) {
     return FetchReturnValue{.Success = false, .HasMore = false};
 }
 
@@ -27,6 +28,7 @@ std::unique_ptr<IUserInfo> HitboxUserInfo::Clone() const {
     u->Persistable = this->Persistable;
     u->AutoDownload = this->AutoDownload;
     u->LastRefreshedOn = this->LastRefreshedOn;
+    u->FetchResumeCursor = this->FetchResumeCursor;
     u->Username = this->Username;
     return u;
 }
@@ -1,7 +1,9 @@
 #include "i-user-info.h"
 
 #include <format>
+#include <functional>
 #include <optional>
+#include <string>
 #include <string_view>
 
 namespace VodArchiver {
@@ -48,6 +50,30 @@ std::optional<ServiceVideoCategoryType> ServiceVideoCategoryTypeFromString(std::
 
 IUserInfo::~IUserInfo() = default;
 
+FetchReturnValue
+    IUserInfo::FetchIncremental(JobConfig& jobConfig,
+                                const std::function<bool(const IVideoInfo& info)>& isKnown,
+                                const std::function<bool()>& waitForRequestSlot) {
+    if (!waitForRequestSlot()) {
+        return FetchReturnValue{.Success = false, .HasMore = false};
+    }
+    return Fetch(jobConfig, "", true);
+}
+
+std::string IUserInfo::GetFetchHost() {
+    switch (GetType()) {
+        case ServiceVideoCategoryType::TwitchRecordings:
+        case ServiceVideoCategoryType::TwitchHighlights: return "api.twitch.tv";
+        case ServiceVideoCategoryType::HitboxRecordings: return "api.hitbox.tv";
+        case ServiceVideoCategoryType::YoutubeUser:
+        case ServiceVideoCategoryType::YoutubeChannel:
+        case ServiceVideoCategoryType::YoutubePlaylist:
+        case ServiceVideoCategoryType::YoutubeUrl: return "www.youtube.com";
+        case ServiceVideoCategoryType::ArchiveOrg: return "archive.org";
+        default: return "";
+    }
+}
+
 std::string IUserInfo::ToString() {
     return std::format("{}: {}", ServiceVideoCategoryTypeToString(GetType()), GetUserIdentifier());
 }
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -34,6 +35,10 @@ struct FetchReturnValue {
     bool HasMore = false;
     int64_t TotalVideos = 0;
     int64_t VideoCountThisFetch = 0;
+
+    // Pass this to the next Fetch() to continue the listing. Only meaningful if HasMore is set.
+    std::string NextCursor;
+
     std::vector<std::unique_ptr<IVideoInfo>> Videos;
 };
 
@@ -44,12 +49,32 @@ struct IUserInfo {
     virtual std::string GetUserIdentifier() = 0;
     virtual std::string ToString();
 
-    virtual FetchReturnValue Fetch(JobConfig& jobConfig, size_t offset, bool flat) = 0;
+    // Fetches one page of the listing. cursor is empty for the first page, otherwise it's the
+    // NextCursor returned by the previous page.
+    virtual FetchReturnValue Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) = 0;
+
+    // Flat fetch of the first page that may skip older videos. isKnown tells whether a video has
+    // been seen before, and services that list newest first can stop listing once they reach one.
+    // waitForRequestSlot is called before every request this sends to the host and returns false
+    // if the fetch should give up instead.
+    // The default implementation is the same as Fetch(jobConfig, "", true).
+    virtual FetchReturnValue
+        FetchIncremental(JobConfig& jobConfig,
+                         const std::function<bool(const IVideoInfo& info)>& isKnown,
+                         const std::function<bool()>& waitForRequestSlot);
 
     virtual std::unique_ptr<IUserInfo> Clone() const = 0;
 
+    // The host a fetch talks to. Fetches for the same host share one rate limit. Empty if fetching
+    // doesn't contact a remote host. The default implementation picks the host by service.
+    virtual std::string GetFetchHost();
+
     bool Persistable = false;
     bool AutoDownload = false;
     DateTime LastRefreshedOn;
+
+    // Where the last full listing stopped if it didn't get to the end, so the next fetch can
+    // continue from there instead of starting over. Empty if there's nothing to resume.
+    std::string FetchResumeCursor;
 };
 } // namespace VodArchiver
@@ -5,12 +5,14 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "rapidxml/rapidxml.hpp"
 
 #include "util/number.h"
+#include "util/text.h"
 
 #include "vodarchiver/curl_util.h"
 #include "vodarchiver/videoinfo/generic-video-info.h"
@@ -30,6 +32,23 @@ std::string RssFeedUserInfo::GetUserIdentifier() {
     return Url;
 }
 
+std::string RssFeedUserInfo::GetFetchHost() {
+    // scheme://[user@]host[:port]/path, the port is left out to match what curl_util reports
+    std::string_view rest = Url;
+    if (const size_t scheme = rest.find("://"); scheme != std::string_view::npos) {
+        rest = rest.substr(scheme + 3);
+    }
+    rest = rest.substr(0, rest.find_first_of("/?#"));
+    if (const size_t at = rest.rfind('@'); at != std::string_view::npos) {
+        rest = rest.substr(at + 1);
+    }
+    if (const size_t colon = rest.rfind(':');
+        colon != std::string_view::npos && rest.find(']', colon) == std::string_view::npos) {
+        rest = rest.substr(0, colon);
+    }
+    return HyoutaUtils::TextUtils::ToLower(rest);
+}
+
 static std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
     GetMediaFromFeed(const std::string& url) {
     auto response = VodArchiver::curl::GetFromUrlToMemory(url);
@@ -128,7 +147,8 @@ static std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
     return media;
 }
 
-FetchReturnValue RssFeedUserInfo::Fetch(JobConfig& jobConfig, size_t offset, bool flat) {
+FetchReturnValue
+    RssFeedUserInfo::Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) {
     std::vector<std::unique_ptr<IVideoInfo>> videosToAdd;
     bool hasMore = true;
     int64_t maxVideos = -1;
@@ -164,6 +184,7 @@ std::unique_ptr<IUserInfo> RssFeedUserInfo::Clone() const {
     u->Persistable = this->Persistable;
     u->AutoDownload = this->AutoDownload;
     u->LastRefreshedOn = this->LastRefreshedOn;
+    u->FetchResumeCursor = this->FetchResumeCursor;
     u->Url = this->Url;
     return u;
 }
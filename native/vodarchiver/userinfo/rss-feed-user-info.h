@@ -12,8 +12,9 @@ struct RssFeedUserInfo final : public IUserInfo {
 
     ServiceVideoCategoryType GetType() override;
     std::string GetUserIdentifier() override;
+    std::string GetFetchHost() override;
 
-    FetchReturnValue Fetch(JobConfig& jobConfig, size_t offset, bool flat) override;
+    FetchReturnValue Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) override;
 
     std::unique_ptr<IUserInfo> Clone() const override;
 
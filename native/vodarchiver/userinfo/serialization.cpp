@@ -8,6 +8,7 @@
 #include <iterator>
 #include <memory>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <vector>
 
@@ -391,6 +392,7 @@ std::optional<std::vector<std::unique_ptr<IUserInfo>>>
              userInfoXml = userInfoXml->next_sibling()) {
             std::string_view name(userInfoXml->name(), userInfoXml->name_size());
             if (name == "UserInfo") {
+                const size_t parsedBefore = result.size();
                 if (auto* typeXml = userInfoXml->first_attribute("_type")) {
                     std::string_view value(typeXml->value(), typeXml->value_size());
                     if (value == "TwitchRecordings") {
@@ -467,6 +469,13 @@ std::optional<std::vector<std::unique_ptr<IUserInfo>>>
                         return std::nullopt;
                     }
                 }
+                if (result.size() > parsedBefore) {
+                    // optional for every type, older versions didn't write it
+                    if (auto* a = userInfoXml->first_attribute("fetchResumeCursor")) {
+                        result.back()->FetchResumeCursor =
+                            std::string(a->value(), a->value_size());
+                    }
+                }
             }
         }
     }
@@ -619,6 +628,10 @@ bool WriteUserInfosToFile(const std::vector<std::unique_ptr<IUserInfo>>& userInf
             if (!SerializeUserInfo(xml, *xmlUserInfo, *userInfo)) {
                 return false;
             }
+            if (!userInfo->FetchResumeCursor.empty()) {
+                xmlUserInfo->append_attribute(
+                    AllocateAttribute(xml, "fetchResumeCursor", userInfo->FetchResumeCursor));
+            }
             root->append_node(xmlUserInfo);
         }
         xml.append_node(root);
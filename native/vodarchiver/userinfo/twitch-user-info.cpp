@@ -27,11 +27,9 @@ std::string TwitchUserInfo::GetUserIdentifier() {
     return Username;
 }
 
-FetchReturnValue TwitchUserInfo::Fetch(JobConfig& jobConfig, size_t offset, bool flat) {
+FetchReturnValue
+    TwitchUserInfo::Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) {
     std::vector<std::unique_ptr<IVideoInfo>> videosToAdd;
-    bool hasMore = true;
-    int64_t maxVideos = -1;
-    int64_t currentVideos = -1;
 
     std::string twitchClientId;
     std::string twitchClientSecret;
@@ -50,14 +48,14 @@ FetchReturnValue TwitchUserInfo::Fetch(JobConfig& jobConfig, size_t offset, bool
     }
 
     auto broadcasts =
-        Twitch::GetVideos(*UserID, Highlights, offset, 25, twitchClientId, twitchClientSecret);
+        Twitch::GetVideos(*UserID, Highlights, cursor, twitchClientId, twitchClientSecret);
     if (!broadcasts) {
         return FetchReturnValue{.Success = false, .HasMore = false};
     }
-    hasMore = (offset + broadcasts->Videos.size()) < broadcasts->TotalVideoCount;
-    maxVideos = broadcasts->TotalVideoCount;
 
-    currentVideos = broadcasts->Videos.size();
+    // Helix doesn't tell the total, and it may hand out a cursor for a page that turns out empty
+    const int64_t currentVideos = static_cast<int64_t>(broadcasts->Videos.size());
+    const bool hasMore = !broadcasts->Cursor.empty() && currentVideos > 0;
     for (auto& v : broadcasts->Videos) {
         auto tv = std::make_unique<TwitchVideoInfo>();
         auto tc = std::make_unique<TwitchVideoInfo>();
@@ -69,18 +67,11 @@ FetchReturnValue TwitchUserInfo::Fetch(JobConfig& jobConfig, size_t offset, bool
         videosToAdd.push_back(std::move(tc));
     }
 
-    if (videosToAdd.size() <= 0) {
-        return FetchReturnValue{.Success = true,
-                                .HasMore = false,
-                                .TotalVideos = maxVideos,
-                                .VideoCountThisFetch = 0,
-                                .Videos = std::move(videosToAdd)};
-    }
-
     return FetchReturnValue{.Success = true,
                             .HasMore = hasMore,
-                            .TotalVideos = maxVideos,
+                            .TotalVideos = -1,
                             .VideoCountThisFetch = currentVideos,
+                            .NextCursor = hasMore ? std::move(broadcasts->Cursor) : std::string(),
                             .Videos = std::move(videosToAdd)};
 }
 
@@ -89,6 +80,7 @@ std::unique_ptr<IUserInfo> TwitchUserInfo::Clone() const {
     u->Persistable = this->Persistable;
     u->AutoDownload = this->AutoDownload;
     u->LastRefreshedOn = this->LastRefreshedOn;
+    u->FetchResumeCursor = this->FetchResumeCursor;
     u->Username = this->Username;
     u->UserID = this->UserID;
     u->Highlights = this->Highlights;
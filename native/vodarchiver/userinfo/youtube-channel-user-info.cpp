@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <format>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -25,7 +26,8 @@ std::string YoutubeChannelUserInfo::GetUserIdentifier() {
     return Channel;
 }
 
-FetchReturnValue YoutubeChannelUserInfo::Fetch(JobConfig& jobConfig, size_t offset, bool flat) {
+FetchReturnValue
+    YoutubeChannelUserInfo::Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) {
     std::vector<std::unique_ptr<IVideoInfo>> videosToAdd;
     bool hasMore = true;
     int64_t maxVideos = -1;
@@ -56,6 +58,23 @@ FetchReturnValue YoutubeChannelUserInfo::Fetch(JobConfig& jobConfig, size_t offs
                             .Videos = std::move(videosToAdd)};
 }
 
+FetchReturnValue YoutubeChannelUserInfo::FetchIncremental(
+    JobConfig& jobConfig,
+    const std::function<bool(const IVideoInfo& info)>& isKnown,
+    const std::function<bool()>& waitForRequestSlot) {
+    auto videos =
+        Youtube::RetrieveNewVideosFromChannel(Channel, Comment, isKnown, waitForRequestSlot);
+    if (!videos.has_value()) {
+        return FetchReturnValue{.Success = false, .HasMore = false};
+    }
+    const int64_t count = static_cast<int64_t>(videos->size());
+    return FetchReturnValue{.Success = true,
+                            .HasMore = false,
+                            .TotalVideos = -1,
+                            .VideoCountThisFetch = count,
+                            .Videos = std::move(*videos)};
+}
+
 std::string YoutubeChannelUserInfo::ToString() {
     if (!Comment.empty()) {
         return std::format(
@@ -72,6 +91,7 @@ std::unique_ptr<IUserInfo> YoutubeChannelUserInfo::Clone() const {
     u->Persistable = this->Persistable;
     u->AutoDownload = this->AutoDownload;
     u->LastRefreshedOn = this->LastRefreshedOn;
+    u->FetchResumeCursor = this->FetchResumeCursor;
     u->Channel = this->Channel;
     u->Comment = this->Comment;
     return u;
@@ -26,7 +26,8 @@ std::string YoutubePlaylistUserInfo::GetUserIdentifier() {
     return Playlist;
 }
 
-FetchReturnValue YoutubePlaylistUserInfo::Fetch(JobConfig& jobConfig, size_t offset, bool flat) {
+FetchReturnValue
+    YoutubePlaylistUserInfo::Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) {
     std::vector<std::unique_ptr<IVideoInfo>> videosToAdd;
     bool hasMore = true;
     int64_t maxVideos = -1;
@@ -73,6 +74,7 @@ std::unique_ptr<IUserInfo> YoutubePlaylistUserInfo::Clone() const {
     u->Persistable = this->Persistable;
     u->AutoDownload = this->AutoDownload;
     u->LastRefreshedOn = this->LastRefreshedOn;
+    u->FetchResumeCursor = this->FetchResumeCursor;
     u->Playlist = this->Playlist;
     u->Comment = this->Comment;
     return u;
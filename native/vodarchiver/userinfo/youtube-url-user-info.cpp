@@ -1,6 +1,7 @@
 #include "youtube-url-user-info.h"
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -24,7 +25,8 @@ std::string YoutubeUrlUserInfo::GetUserIdentifier() {
     return Url;
 }
 
-FetchReturnValue YoutubeUrlUserInfo::Fetch(JobConfig& jobConfig, size_t offset, bool flat) {
+FetchReturnValue
+    YoutubeUrlUserInfo::Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) {
     std::vector<std::unique_ptr<IVideoInfo>> videosToAdd;
     bool hasMore = true;
     int64_t maxVideos = -1;
@@ -55,11 +57,28 @@ FetchReturnValue YoutubeUrlUserInfo::Fetch(JobConfig& jobConfig, size_t offset,
                             .Videos = std::move(videosToAdd)};
 }
 
+FetchReturnValue YoutubeUrlUserInfo::FetchIncremental(
+    JobConfig& jobConfig,
+    const std::function<bool(const IVideoInfo& info)>& isKnown,
+    const std::function<bool()>& waitForRequestSlot) {
+    auto videos = Youtube::RetrieveNewVideosFromUrl(Url, isKnown, waitForRequestSlot);
+    if (!videos.has_value()) {
+        return FetchReturnValue{.Success = false, .HasMore = false};
+    }
+    const int64_t count = static_cast<int64_t>(videos->size());
+    return FetchReturnValue{.Success = true,
+                            .HasMore = false,
+                            .TotalVideos = -1,
+                            .VideoCountThisFetch = count,
+                            .Videos = std::move(*videos)};
+}
+
 std::unique_ptr<IUserInfo> YoutubeUrlUserInfo::Clone() const {
     auto u = std::make_unique<YoutubeUrlUserInfo>();
     u->Persistable = this->Persistable;
     u->AutoDownload = this->AutoDownload;
     u->LastRefreshedOn = this->LastRefreshedOn;
+    u->FetchResumeCursor = this->FetchResumeCursor;
     u->Url = this->Url;
     return u;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <string>
 
 #include "i-user-info.h"
@@ -15,7 +16,11 @@ struct YoutubeUserUserInfo final : public IUserInfo {
 
     std::unique_ptr<IUserInfo> Clone() const override;
 
-    FetchReturnValue Fetch(JobConfig& jobConfig, size_t offset, bool flat) override;
+    FetchReturnValue Fetch(JobConfig& jobConfig, std::string_view cursor, bool flat) override;
+    FetchReturnValue
+        FetchIncremental(JobConfig& jobConfig,
+                         const std::function<bool(const IVideoInfo& info)>& isKnown,
+                         const std::function<bool()>& waitForRequestSlot) override;
 
     std::string Username;
 };
@@ -1,16 +1,30 @@
 #include "ffmpeg-reencode-job.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <format>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <thread>
 #include <vector>
 
 #include "util/file.h"
+#include "util/number.h"
+#include "util/scope.h"
 #include "util/text.h"
+#include "util/thread.h"
 
 #include "vodarchiver/exec.h"
 #include "vodarchiver/ffmpeg_util.h"
+#include "vodarchiver/job_progress.h"
+#include "vodarchiver/process_governor.h"
+#include "vodarchiver/time_types.h"
 #include "vodarchiver/videoinfo/ffmpeg-reencode-job-video-info.h"
 #include "vodarchiver/videoinfo/generic-video-info.h"
 
@@ -22,37 +36,40 @@ bool FFMpegReencodeJob::IsWaitingForUserInput() const {
 }
 
 static bool Reencode(FFMpegReencodeJob& job,
-                     JobConfig& jobConfig,
                      const std::string& targetName,
                      const std::string& sourceName,
                      const std::string& tempName,
-                     const std::vector<std::string>& options) {
+                     const std::vector<std::string>& options,
+                     TimeSpan inputDuration,
+                     uint32_t concurrentJobs,
+                     TaskCancellation& cancellationToken) {
+    ProcessSlot slot = AcquireProcessSlot(ProcessClass::Bulk, concurrentJobs);
     std::vector<std::string> args;
+    args.push_back("-nostats");
+    args.push_back("-progress");
+    args.push_back("pipe:1");
     args.push_back("-i");
     args.push_back(sourceName);
+    if (slot.ThreadCount > 0) {
+        // before the user options so those can still override it
+        args.push_back("-threads");
+        args.push_back(std::format("{}", slot.ThreadCount));
+    }
     args.insert(args.end(), options.begin(), options.end());
     args.push_back(tempName);
 
-    std::string output;
+    // progress is reported lock-free through job.Progress, the GUI samples that on its own
+    static constexpr int64_t ticksPerMicrosecond = TimeSpan::TICKS_PER_SECOND / 1000000;
+    job.Progress.Begin(JobProgressKind::Encode, inputDuration.Ticks / ticksPerMicrosecond);
+    auto progressScope = HyoutaUtils::MakeScopeGuard([&]() { job.Progress.End(); });
+    FFMpegProgressParser parser(job.Progress);
     if (RunProgram(
             "ffmpeg_encode.exe",
             args,
+            [&](std::string_view sv) { parser.Feed(sv); },
             [](std::string_view sv) {},
-            [&](std::string_view sv) {
-                output.append(sv);
-
-                // only keep the last line
-                std::string_view trimmed = HyoutaUtils::TextUtils::Trim(output);
-                auto pos = trimmed.find_last_of("\r\n");
-                if (pos != std::string_view::npos) {
-                    output.assign(trimmed.substr(pos + 1));
-                }
-
-                {
-                    std::lock_guard lock(*jobConfig.JobsLock);
-                    job.TextStatus = output;
-                }
-            })
+            slot,
+            &cancellationToken)
         != 0) {
         return false;
     }
@@ -73,12 +90,475 @@ static std::string PathCombine(std::string_view lhs, std::string_view mhs, std::
     return result;
 }
 
+// Chunked encoding: A single libx264 process does not scale well past a handful of threads, so
+// for machines with many cores we instead split the video stream at keyframes, encode the chunks
+// as separate concurrent ffmpeg processes, and then losslessly concat the results together with
+// the audio from the source file. Jobs whose options or streams don't fit this scheme, see
+// GetChunkedEncodeOptions(), are always encoded in a single process.
+// The chunk boundaries are persisted in the chunk directory and every chunk is only moved to its
+// final name after it has been fully encoded, so an interrupted job resumes at chunk granularity.
+static constexpr int64_t MinimumChunkLengthSeconds = 120;
+static constexpr size_t ChunksPerProcess = 4;
+
+static std::string GetChunkFilename(size_t index, std::string_view ext) {
+    return std::format("chunk_{:04}{}", index, ext);
+}
+
+static std::string GetTempChunkFilename(size_t index, std::string_view ext) {
+    return std::format("chunk_{:04}_TEMP{}", index, ext);
+}
+
+// Returns the start times of the chunks. The first chunk always starts at 0, every other chunk
+// starts on a keyframe that is close to an evenly spaced split point.
+static std::vector<TimeSpan> PlanChunkStarts(const std::vector<TimeSpan>& keyframes,
+                                             TimeSpan duration,
+                                             size_t chunkCount) {
+    std::vector<TimeSpan> starts;
+    starts.push_back(TimeSpan());
+    for (size_t i = 1; i < chunkCount; ++i) {
+        TimeSpan target{.Ticks = (duration.Ticks / static_cast<int64_t>(chunkCount))
+                                 * static_cast<int64_t>(i)};
+        auto it = std::lower_bound(keyframes.begin(), keyframes.end(), target);
+        if (it == keyframes.end()) {
+            break;
+        }
+        if (*it <= starts.back() || (duration - *it) < TimeSpan::FromIntegerSeconds(1)) {
+            continue;
+        }
+        starts.push_back(*it);
+    }
+    return starts;
+}
+
+static std::optional<std::vector<TimeSpan>> ReadChunkPlan(const std::string& path) {
+    HyoutaUtils::IO::File f(std::string_view(path), HyoutaUtils::IO::OpenMode::Read);
+    if (!f.IsOpen()) {
+        return std::nullopt;
+    }
+    auto length = f.GetLength();
+    if (!length) {
+        return std::nullopt;
+    }
+    std::string data;
+    data.resize(*length);
+    if (f.Read(data.data(), data.size()) != data.size()) {
+        return std::nullopt;
+    }
+
+    std::vector<TimeSpan> starts;
+    for (std::string_view line : HyoutaUtils::TextUtils::Split(data, "\n")) {
+        line = HyoutaUtils::TextUtils::Trim(line);
+        if (line.empty()) {
+            continue;
+        }
+        auto ticks = HyoutaUtils::NumberUtils::ParseInt64(line);
+        if (!ticks) {
+            return std::nullopt;
+        }
+        starts.push_back(TimeSpan{.Ticks = *ticks});
+    }
+    if (starts.empty()) {
+        return std::nullopt;
+    }
+    return starts;
+}
+
+static bool WriteChunkPlan(const std::string& path, const std::vector<TimeSpan>& starts) {
+    std::string data;
+    for (const TimeSpan& ts : starts) {
+        data.append(std::format("{}\n", ts.Ticks));
+    }
+    return HyoutaUtils::IO::WriteFileAtomic(path, data.data(), data.size());
+}
+
+static void DeleteChunkDirectory(const std::string& chunkDir,
+                                 size_t chunkCount,
+                                 std::string_view ext) {
+    for (size_t i = 0; i < chunkCount; ++i) {
+        HyoutaUtils::IO::DeleteFile(
+            std::string_view(PathCombine(chunkDir, GetChunkFilename(i, ext))));
+        HyoutaUtils::IO::DeleteFile(
+            std::string_view(PathCombine(chunkDir, GetTempChunkFilename(i, ext))));
+    }
+    HyoutaUtils::IO::DeleteFile(std::string_view(PathCombine(chunkDir, "concat.txt")));
+    HyoutaUtils::IO::DeleteFile(std::string_view(PathCombine(chunkDir, "plan.txt")));
+    HyoutaUtils::IO::DeleteDirectory(std::string_view(chunkDir));
+}
+
+// The user options split up for the chunked mode: the video options go into every chunk encode,
+// the rest into the final combine, where the video is only copied.
+struct ChunkedEncodeOptions {
+    std::vector<std::string> Video;
+    std::vector<std::string> Combine;
+};
+
+// Only options that are known to be safe in either place are accepted, anything else (mappings,
+// filters that change the timing or the size, generic codec options that would also hit the audio,
+// ...) could make the chunked result differ from a regular encode. Such jobs are encoded in a
+// single process instead.
+// The source also has to have a stream layout where the explicit mapping of the combine picks the
+// same streams that ffmpeg would pick by default for a regular encode, so at most one audio stream
+// and no subtitles.
+static std::optional<ChunkedEncodeOptions>
+    GetChunkedEncodeOptions(const FFProbeResult& probe, const std::vector<std::string>& options) {
+    // each of these takes a value
+    static constexpr std::array<std::string_view, 19> videoOptions = {{
+        "-c:v",
+        "-codec:v",
+        "-vcodec",
+        "-preset",
+        "-crf",
+        "-qp",
+        "-b:v",
+        "-maxrate",
+        "-bufsize",
+        "-g",
+        "-keyint_min",
+        "-x264-params",
+        "-x264opts",
+        "-x265-params",
+        "-tune",
+        "-profile:v",
+        "-level",
+        "-pix_fmt",
+        "-threads",
+    }};
+    static constexpr std::array<std::string_view, 10> combineOptions = {{
+        "-c:a",
+        "-codec:a",
+        "-acodec",
+        "-b:a",
+        "-q:a",
+        "-ar",
+        "-ac",
+        "-max_muxing_queue_size",
+        "-movflags",
+        "-metadata",
+    }};
+    static constexpr std::array<std::string_view, 3> combineFlags = {{
+        "-an",
+        "-sn",
+        "-dn",
+    }};
+    auto contains = [](const auto& list, std::string_view option) {
+        return std::find(list.begin(), list.end(), option) != list.end();
+    };
+
+    size_t videoStreams = 0;
+    size_t audioStreams = 0;
+    size_t subtitleStreams = 0;
+    for (const FFProbeStream& stream : probe.Streams) {
+        if (stream.CodecType == "video") {
+            ++videoStreams;
+        } else if (stream.CodecType == "audio") {
+            ++audioStreams;
+        } else if (stream.CodecType == "subtitle") {
+            ++subtitleStreams;
+        }
+    }
+    if (videoStreams != 1 || audioStreams > 1 || subtitleStreams != 0) {
+        return std::nullopt;
+    }
+
+    ChunkedEncodeOptions result;
+    for (size_t i = 0; i < options.size(); ++i) {
+        const std::string& option = options[i];
+        if (contains(combineFlags, option)) {
+            result.Combine.push_back(option);
+            continue;
+        }
+        if (i + 1 >= options.size()) {
+            return std::nullopt;
+        }
+        if (contains(videoOptions, option)) {
+            result.Video.push_back(option);
+            result.Video.push_back(options[++i]);
+        } else if (contains(combineOptions, option)) {
+            result.Combine.push_back(option);
+            result.Combine.push_back(options[++i]);
+        } else {
+            return std::nullopt;
+        }
+    }
+    return result;
+}
+
+static ResultType ReencodeChunked(FFMpegReencodeJob& job,
+                                  TaskCancellation& cancellationToken,
+                                  const std::string& targetName,
+                                  const std::string& sourceName,
+                                  const std::string& tempName,
+                                  const std::string& chunkDir,
+                                  std::string_view ext,
+                                  const ChunkedEncodeOptions& options,
+                                  TimeSpan inputDuration,
+                                  size_t processCount,
+                                  uint32_t concurrentJobs) {
+    if (!HyoutaUtils::IO::CreateDirectory(std::string_view(chunkDir))) {
+        JobDataWriteLock lock(job);
+        job.TextStatus = "Internal error.";
+        return ResultType::Failure;
+    }
+
+    std::string planPath = PathCombine(chunkDir, "plan.txt");
+    auto starts = ReadChunkPlan(planPath);
+    if (!starts) {
+        {
+            JobDataWriteLock lock(job);
+            job.TextStatus = "Finding keyframes...";
+        }
+        auto keyframes = FFMpegProbeKeyframes(sourceName);
+        if (!keyframes) {
+            JobDataWriteLock lock(job);
+            job.TextStatus = "Keyframe probe failed.";
+            return ResultType::Failure;
+        }
+        size_t maxChunks = static_cast<size_t>(
+            inputDuration.Ticks / TimeSpan::FromIntegerSeconds(MinimumChunkLengthSeconds).Ticks);
+        size_t chunkCount = std::clamp(processCount * ChunksPerProcess, size_t(1), maxChunks);
+        starts = PlanChunkStarts(*keyframes, inputDuration, chunkCount);
+        if (!WriteChunkPlan(planPath, *starts)) {
+            JobDataWriteLock lock(job);
+            job.TextStatus = "Internal error.";
+            return ResultType::Failure;
+        }
+    }
+    const size_t chunkCount = starts->size();
+    auto getChunkLength = [&](size_t index) {
+        return (index + 1 < chunkCount ? (*starts)[index + 1] : inputDuration) - (*starts)[index];
+    };
+
+    if (cancellationToken.IsCancellationRequested()) {
+        return ResultType::Cancelled;
+    }
+
+    {
+        JobDataWriteLock lock(job);
+        job.TextStatus = std::format("Encoding {} in {} chunks with {} processes...",
+                                     targetName,
+                                     chunkCount,
+                                     processCount);
+    }
+
+    // each process reports into its own record, which are then summed up into the job's record
+    static constexpr int64_t ticksPerMicrosecond = TimeSpan::TICKS_PER_SECOND / 1000000;
+    job.Progress.Begin(JobProgressKind::Encode, inputDuration.Ticks / ticksPerMicrosecond);
+    auto progressScope = HyoutaUtils::MakeScopeGuard([&]() { job.Progress.End(); });
+    std::vector<std::unique_ptr<JobProgress>> processProgress;
+    for (size_t i = 0; i < processCount; ++i) {
+        processProgress.emplace_back(std::make_unique<JobProgress>());
+    }
+    std::atomic<int64_t> completedUs = 0;
+    std::atomic<uint64_t> completedBytes = 0;
+    auto publishProgress = [&]() {
+        int64_t outTimeUs = completedUs.load(std::memory_order_relaxed);
+        uint64_t totalSize = completedBytes.load(std::memory_order_relaxed);
+        uint64_t frame = 0;
+        double fps = 0.0;
+        double speed = 0.0;
+        for (const auto& p : processProgress) {
+            if (p->Kind.load(std::memory_order_relaxed) == JobProgressKind::None) {
+                continue;
+            }
+            outTimeUs += p->OutTimeUs.load(std::memory_order_relaxed);
+            totalSize += p->TotalSizeBytes.load(std::memory_order_relaxed);
+            frame += p->Frame.load(std::memory_order_relaxed);
+            fps += p->Fps.load(std::memory_order_relaxed);
+            speed += p->Speed.load(std::memory_order_relaxed);
+        }
+        // the job is alive as long as any of the workers is
+        int64_t lastUpdateTimeMs = 0;
+        for (const auto& p : processProgress) {
+            lastUpdateTimeMs =
+                std::max(lastUpdateTimeMs, p->LastUpdateTimeMs.load(std::memory_order_relaxed));
+        }
+        job.Progress.OutTimeUs.store(outTimeUs, std::memory_order_relaxed);
+        job.Progress.TotalSizeBytes.store(totalSize, std::memory_order_relaxed);
+        job.Progress.Frame.store(frame, std::memory_order_relaxed);
+        job.Progress.Fps.store(fps, std::memory_order_relaxed);
+        job.Progress.Speed.store(speed, std::memory_order_relaxed);
+        job.Progress.LastUpdateTimeMs.store(lastUpdateTimeMs, std::memory_order_relaxed);
+        job.Progress.Heartbeat();
+    };
+
+    std::atomic<size_t> nextChunk = 0;
+    std::atomic<bool> failed = false;
+    auto runChunks = [&](size_t processIndex) {
+        HyoutaUtils::SetThreadName("EncodeChunkThread");
+        JobProgress& progress = *processProgress[processIndex];
+        while (!failed.load() && !cancellationToken.IsCancellationRequested()) {
+            size_t index = nextChunk.fetch_add(1);
+            if (index >= chunkCount) {
+                break;
+            }
+            const TimeSpan length = getChunkLength(index);
+            std::string chunkPath = PathCombine(chunkDir, GetChunkFilename(index, ext));
+            if (HyoutaUtils::IO::FileExists(std::string_view(chunkPath))
+                == HyoutaUtils::IO::ExistsResult::DoesExist) {
+                // already done in a previous run
+                completedUs.fetch_add(length.Ticks / ticksPerMicrosecond);
+                completedBytes.fetch_add(
+                    HyoutaUtils::IO::GetFilesize(std::string_view(chunkPath)).value_or(0));
+                publishProgress();
+                continue;
+            }
+
+            // the governor splits the cores evenly between the processes of all the jobs
+            ProcessSlot slot = AcquireProcessSlot(
+                ProcessClass::Bulk, static_cast<uint32_t>(processCount) * concurrentJobs);
+            std::string tempChunkPath = PathCombine(chunkDir, GetTempChunkFilename(index, ext));
+            std::vector<std::string> args;
+            args.push_back("-nostats");
+            args.push_back("-progress");
+            args.push_back("pipe:1");
+            args.push_back("-ss");
+            args.push_back(TimeSpanToTotalSecondsString((*starts)[index]));
+            args.push_back("-i");
+            args.push_back(sourceName);
+            if (index + 1 < chunkCount) {
+                args.push_back("-t");
+                args.push_back(TimeSpanToTotalSecondsString(length));
+            }
+            args.push_back("-map");
+            args.push_back("0:v:0");
+            if (slot.ThreadCount > 0) {
+                args.push_back("-threads");
+                args.push_back(std::format("{}", slot.ThreadCount));
+            }
+            args.insert(args.end(), options.Video.begin(), options.Video.end());
+            args.push_back("-an");
+            args.push_back("-sn");
+            args.push_back("-dn");
+            args.push_back("-y");
+            args.push_back(tempChunkPath);
+
+            progress.Begin(JobProgressKind::Encode, length.Ticks / ticksPerMicrosecond);
+            FFMpegProgressParser parser(progress);
+            int retval = RunProgram(
+                "ffmpeg_encode.exe",
+                args,
+                [&](std::string_view sv) {
+                    parser.Feed(sv);
+                    publishProgress();
+                },
+                [](std::string_view sv) {},
+                slot,
+                &cancellationToken);
+            progress.End();
+            if (retval != 0 || !HyoutaUtils::IO::Move(tempChunkPath, chunkPath, false)) {
+                failed.store(true);
+                break;
+            }
+            completedUs.fetch_add(length.Ticks / ticksPerMicrosecond);
+            completedBytes.fetch_add(
+                HyoutaUtils::IO::GetFilesize(std::string_view(chunkPath)).value_or(0));
+            publishProgress();
+        }
+    };
+    {
+        std::vector<std::thread> threads;
+        auto joinScope = HyoutaUtils::MakeScopeGuard([&]() {
+            for (auto& t : threads) {
+                t.join();
+            }
+        });
+        for (size_t i = 1; i < processCount; ++i) {
+            threads.emplace_back(runChunks, i);
+        }
+        runChunks(0);
+    }
+
+    if (failed.load()) {
+        JobDataWriteLock lock(job);
+        job.TextStatus = "Encoding a chunk failed.";
+        return ResultType::Failure;
+    }
+    if (cancellationToken.IsCancellationRequested()) {
+        return ResultType::Cancelled;
+    }
+
+    std::string concatList;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        concatList.append(std::format("file '{}'\n", GetChunkFilename(i, ext)));
+    }
+    std::string concatListPath = PathCombine(chunkDir, "concat.txt");
+    if (!HyoutaUtils::IO::WriteFileAtomic(concatListPath, concatList.data(), concatList.size())) {
+        JobDataWriteLock lock(job);
+        job.TextStatus = "Internal error.";
+        return ResultType::Failure;
+    }
+
+    {
+        JobDataWriteLock lock(job);
+        job.TextStatus = "Combining chunks...";
+    }
+    std::vector<std::string> args;
+    args.push_back("-nostats");
+    args.push_back("-progress");
+    args.push_back("pipe:1");
+    args.push_back("-f");
+    args.push_back("concat");
+    args.push_back("-i");
+    args.push_back(concatListPath);
+    args.push_back("-i");
+    args.push_back(sourceName);
+    args.push_back("-map");
+    args.push_back("0:v:0");
+    args.push_back("-map");
+    args.push_back("1:a:0?");
+    args.insert(args.end(), options.Combine.begin(), options.Combine.end());
+    args.push_back("-c:v");
+    args.push_back("copy");
+    args.push_back("-y");
+    args.push_back(tempName);
+
+    job.Progress.Begin(JobProgressKind::Encode, inputDuration.Ticks / ticksPerMicrosecond);
+    FFMpegProgressParser parser(job.Progress);
+    if (RunProgram(
+            "ffmpeg_encode.exe",
+            args,
+            [&](std::string_view sv) { parser.Feed(sv); },
+            [](std::string_view sv) {},
+            AcquireProcessSlot(ProcessClass::Io),
+            &cancellationToken)
+        != 0) {
+        if (cancellationToken.IsCancellationRequested()) {
+            return ResultType::Cancelled;
+        }
+        JobDataWriteLock lock(job);
+        job.TextStatus = "Combining chunks failed.";
+        return ResultType::Failure;
+    }
+
+    // make sure we didn't lose or duplicate anything at the chunk boundaries
+    auto probe = FFMpegProbe(tempName);
+    if (!probe
+        || std::abs(probe->Duration.GetTotalSeconds() - inputDuration.GetTotalSeconds()) > 5.0) {
+        HyoutaUtils::IO::DeleteFile(std::string_view(tempName));
+        DeleteChunkDirectory(chunkDir, chunkCount, ext);
+        JobDataWriteLock lock(job);
+        job.TextStatus = probe ? std::format("Combined duration mismatch, expected {}s, got {}s.",
+                                             inputDuration.GetTotalSeconds(),
+                                             probe->Duration.GetTotalSeconds())
+                               : "Probe of combined file failed.";
+        return ResultType::DubiousCombine;
+    }
+
+    if (!HyoutaUtils::IO::Move(tempName, targetName, false)) {
+        JobDataWriteLock lock(job);
+        job.TextStatus = "Internal error.";
+        return ResultType::Failure;
+    }
+    DeleteChunkDirectory(chunkDir, chunkCount, ext);
+    return ResultType::Success;
+}
+
 static ResultType RunReencodeJob(FFMpegReencodeJob& job,
                                  JobConfig& jobConfig,
                                  TaskCancellation& cancellationToken) {
     std::unique_ptr<IVideoInfo> videoInfo;
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.JobStatus = VideoJobStatus::Running;
         job.TextStatus = "Checking files...";
         videoInfo = job.VideoInfo->Clone();
@@ -131,6 +611,8 @@ static ResultType RunReencodeJob(FFMpegReencodeJob& job,
         path, std::string(name.substr(0, name.size() - chunked.size())) + postfix + ext);
     std::string tempfile = PathCombine(
         path, std::string(name.substr(0, name.size() - chunked.size())) + postfix + "_TEMP" + ext);
+    std::string encodechunksdir = PathCombine(
+        path, std::string(name.substr(0, name.size() - chunked.size())) + postfix + "_TEMP_chunks");
     std::string chunkeddir = PathCombine(path, chunked);
     std::string postfixdir = PathCombine(path, postfix);
     std::string oldfileinchunked = PathCombine(chunkeddir, HyoutaUtils::IO::GetFileName(file));
@@ -152,7 +634,7 @@ static ResultType RunReencodeJob(FFMpegReencodeJob& job,
             file, *probe, ffmpegOptions, postfixOld, postfixNew, outputformat);
         videoInfo = newVideoInfo->Clone();
 
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.VideoInfo = std::move(newVideoInfo);
     }
 
@@ -166,7 +648,7 @@ static ResultType RunReencodeJob(FFMpegReencodeJob& job,
     if (!newfileexists && !newfilelocalexists) {
         if (!encodeinput.has_value()) {
             // neither input nor output exist, bail
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = "Missing!";
             return ResultType::Failure;
         }
@@ -174,7 +656,7 @@ static ResultType RunReencodeJob(FFMpegReencodeJob& job,
         if (HyoutaUtils::IO::FileExists(std::string_view(tempfile))
             == HyoutaUtils::IO::ExistsResult::DoesExist) {
             if (!HyoutaUtils::IO::DeleteFile(std::string_view(tempfile))) {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.TextStatus = "Internal error.";
                 return ResultType::Failure;
             }
@@ -185,36 +667,88 @@ static ResultType RunReencodeJob(FFMpegReencodeJob& job,
         }
 
         {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = ("Encoding " + newfile + "...");
         }
-        StallWrite(jobConfig,
-                   newfile,
-                   HyoutaUtils::IO::GetFilesize(std::string_view(*encodeinput)).value_or(0),
-                   cancellationToken,
-                   ShouldStallWriteRegularFile,
-                   [&](std::string status) {
-                       std::lock_guard lock(*jobConfig.JobsLock);
-                       job.TextStatus = std::move(status);
-                   });
+        auto reservedSpace = ReserveDiskSpace(
+            jobConfig,
+            job.Progress,
+            newfile,
+            HyoutaUtils::IO::GetFilesize(std::string_view(*encodeinput)).value_or(0),
+            cancellationToken,
+            GetMinimumFreeSpaceForRegularFile,
+            [&](std::string status) {
+                JobDataWriteLock lock(job);
+                job.TextStatus = std::move(status);
+            });
         if (cancellationToken.IsCancellationRequested()) {
             return ResultType::Cancelled;
         }
         if (!HyoutaUtils::IO::CreateDirectory(std::string_view(postfixdir))) {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = "Internal error.";
             return ResultType::Failure;
         }
         FFMpegReencodeJobVideoInfo* ffmpegVideoInfo =
             dynamic_cast<FFMpegReencodeJobVideoInfo*>(videoInfo.get());
         if (!ffmpegVideoInfo) {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = "Internal error.";
             return ResultType::Failure;
         }
-        if (!Reencode(
-                job, jobConfig, newfile, *encodeinput, tempfile, ffmpegVideoInfo->FFMpegOptions)) {
-            std::lock_guard lock(*jobConfig.JobsLock);
+        size_t processCount;
+        {
+            std::lock_guard lock(jobConfig.Mutex);
+            processCount = std::max(jobConfig.ReencodeParallelProcesses, uint32_t(1));
+        }
+        const uint32_t concurrentJobs = std::max(jobConfig.BulkJobConcurrency.load(), uint32_t(1));
+
+        std::optional<ChunkedEncodeOptions> chunkedOptions;
+        if (probe.has_value()) {
+            chunkedOptions = GetChunkedEncodeOptions(*probe, ffmpegVideoInfo->FFMpegOptions);
+        }
+
+        // always continue an interrupted chunked encode, even if the setting has changed since
+        const bool chunkDirExists =
+            HyoutaUtils::IO::DirectoryExists(std::string_view(encodechunksdir))
+            == HyoutaUtils::IO::ExistsResult::DoesExist;
+        bool useChunked = chunkDirExists && chunkedOptions.has_value();
+        if (!useChunked && processCount > 1 && chunkedOptions.has_value()) {
+            useChunked = probe->Duration.Ticks
+                         >= TimeSpan::FromIntegerSeconds(MinimumChunkLengthSeconds * 2).Ticks;
+        }
+        if (chunkDirExists && !chunkedOptions.has_value()) {
+            // left behind by a version that still encoded these options in chunks
+            auto starts = ReadChunkPlan(PathCombine(encodechunksdir, "plan.txt"));
+            DeleteChunkDirectory(encodechunksdir, starts ? starts->size() : 0, ext);
+        }
+        if (useChunked) {
+            ResultType result = ReencodeChunked(job,
+                                                cancellationToken,
+                                                newfile,
+                                                *encodeinput,
+                                                tempfile,
+                                                encodechunksdir,
+                                                ext,
+                                                *chunkedOptions,
+                                                probe->Duration,
+                                                processCount,
+                                                concurrentJobs);
+            if (result != ResultType::Success) {
+                return result;
+            }
+        } else if (!Reencode(job,
+                             newfile,
+                             *encodeinput,
+                             tempfile,
+                             ffmpegVideoInfo->FFMpegOptions,
+                             probe.has_value() ? probe->Duration : TimeSpan(),
+                             concurrentJobs,
+                             cancellationToken)) {
+            if (cancellationToken.IsCancellationRequested()) {
+                return ResultType::Cancelled;
+            }
+            JobDataWriteLock lock(job);
             job.TextStatus = "Internal error.";
             return ResultType::Failure;
         }
@@ -222,12 +756,12 @@ static ResultType RunReencodeJob(FFMpegReencodeJob& job,
 
     if (!newfileexists && newfilelocalexists) {
         if (!HyoutaUtils::IO::CreateDirectory(std::string_view(postfixdir))) {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = "Internal error.";
             return ResultType::Failure;
         }
         if (!HyoutaUtils::IO::Move(newfileinlocal, newfile)) {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = "Internal error.";
             return ResultType::Failure;
         }
@@ -238,19 +772,19 @@ static ResultType RunReencodeJob(FFMpegReencodeJob& job,
         && HyoutaUtils::IO::FileExists(std::string_view(oldfileinchunked))
                != HyoutaUtils::IO::ExistsResult::DoesExist) {
         if (!HyoutaUtils::IO::CreateDirectory(std::string_view(chunkeddir))) {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = "Internal error.";
             return ResultType::Failure;
         }
         if (!HyoutaUtils::IO::Move(file, oldfileinchunked)) {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = "Internal error.";
             return ResultType::Failure;
         }
     }
 
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Done!";
         job.JobStatus = VideoJobStatus::Finished;
     }
@@ -268,7 +802,7 @@ std::string FFMpegReencodeJob::GenerateOutputFilename() {
 std::unique_ptr<IVideoJob> FFMpegReencodeJob::Clone() const {
     auto clone = std::make_unique<FFMpegReencodeJob>();
     clone->TextStatus = this->TextStatus;
-    clone->JobStatus = this->JobStatus;
+    clone->JobStatus = this->JobStatus.load();
     clone->HasBeenValidated = this->HasBeenValidated;
     clone->VideoInfo = this->VideoInfo ? this->VideoInfo->Clone() : nullptr;
     clone->JobStartTimestamp = this->JobStartTimestamp;
@@ -112,7 +112,7 @@ static ResultType
     std::unique_ptr<IVideoInfo> videoInfo;
     std::string splitTimes;
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.JobStatus = VideoJobStatus::Running;
         job.TextStatus = "Checking files...";
         videoInfo = job.VideoInfo->Clone();
@@ -130,13 +130,13 @@ static ResultType
                                        std::format("{}", DateTime::UtcNow().GetTicks()));
     if (HyoutaUtils::IO::Exists(std::string_view(newdirpath))
         == HyoutaUtils::IO::ExistsResult::DoesExist) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus =
             std::format("File or directory at {} already exists, cancelling.", newdirpath);
         return ResultType::Failure;
     }
     if (!HyoutaUtils::IO::CreateDirectory(std::string_view(newdirpath))) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = std::format("Failed to create directory at {}, cancelling.", newdirpath);
         return ResultType::Failure;
     }
@@ -144,12 +144,12 @@ static ResultType
     HyoutaUtils::IO::AppendPathElement(inname, HyoutaUtils::IO::GetFileName(originalpath));
     if (HyoutaUtils::IO::Exists(std::string_view(inname))
         == HyoutaUtils::IO::ExistsResult::DoesExist) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = std::format("File or directory at {} already exists, cancelling.", inname);
         return ResultType::Failure;
     }
     if (!HyoutaUtils::IO::Move(originalpath, inname, false)) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = std::format("Moving to {} failed, cancelling.", inname);
         return ResultType::Failure;
     }
@@ -178,35 +178,42 @@ static ResultType
                          == HyoutaUtils::IO::ExistsResult::DoesExist;
 
     {
-        auto diskLock = jobConfig.ExpensiveDiskIO.WaitForFreeSlot(cancellationToken);
+        JobIdleWait idle(job.Progress);
+        auto diskLock = jobConfig.ExpensiveDiskIO.WaitForFreeSlot({inname}, cancellationToken);
+        idle.Finish();
         if (cancellationToken.IsCancellationRequested()) {
             return ResultType::Cancelled;
         }
 
         {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = "Splitting...";
         }
-        StallWrite(jobConfig,
-                   exampleOutname,
-                   HyoutaUtils::IO::GetFilesize(std::string_view(inname)).value_or(0),
-                   cancellationToken,
-                   ShouldStallWriteRegularFile,
-                   [&](std::string status) {
-                       std::lock_guard lock(*jobConfig.JobsLock);
-                       job.TextStatus = std::move(status);
-                   });
-        int retval = RunProgram(
-            "ffmpeg_split.exe", args, [](std::string_view sv) {}, [](std::string_view sv) {});
+        auto reservedSpace = ReserveDiskSpace(
+            jobConfig,
+            job.Progress,
+            exampleOutname,
+            HyoutaUtils::IO::GetFilesize(std::string_view(inname)).value_or(0),
+            cancellationToken,
+            GetMinimumFreeSpaceForRegularFile,
+            [&](std::string status) {
+                JobDataWriteLock lock(job);
+                job.TextStatus = std::move(status);
+            });
+        int retval = RunProgram("ffmpeg_split.exe",
+                                args,
+                                [](std::string_view sv) {},
+                                [](std::string_view sv) {},
+                                AcquireProcessSlot(ProcessClass::Io));
         if (retval != 0) {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = std::format("ffmpeg_split failed with return value {}", retval);
             return ResultType::Failure;
         }
     }
 
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Done!";
         job.JobStatus = VideoJobStatus::Finished;
     }
@@ -226,7 +233,7 @@ std::string FFMpegSplitJob::GenerateOutputFilename() {
 std::unique_ptr<IVideoJob> FFMpegSplitJob::Clone() const {
     auto clone = std::make_unique<FFMpegSplitJob>();
     clone->TextStatus = this->TextStatus;
-    clone->JobStatus = this->JobStatus;
+    clone->JobStatus = this->JobStatus.load();
     clone->HasBeenValidated = this->HasBeenValidated;
     clone->VideoInfo = this->VideoInfo ? this->VideoInfo->Clone() : nullptr;
     clone->JobStartTimestamp = this->JobStartTimestamp;
@@ -119,7 +119,7 @@ static ResultType RunGenericFileJob(GenericFileJob& job,
                                     TaskCancellation& cancellationToken) {
     std::unique_ptr<IVideoInfo> videoInfo;
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.JobStatus = VideoJobStatus::Running;
         job.TextStatus = "Downloading...";
         videoInfo = job.VideoInfo->Clone();
@@ -169,7 +169,11 @@ static ResultType RunGenericFileJob(GenericFileJob& job,
                 return ResultType::Failure;
             }
 
-            auto response = VodArchiver::curl::GetFromUrlToMemory(videoId);
+            auto response =
+                VodArchiver::curl::GetFromUrlToMemory(videoId, {}, {}, &cancellationToken);
+            if (cancellationToken.IsCancellationRequested()) {
+                return ResultType::Cancelled;
+            }
             if (!response || response->ResponseCode != 200) {
                 return ResultType::Failure;
             }
@@ -190,15 +194,17 @@ static ResultType RunGenericFileJob(GenericFileJob& job,
         if (cancellationToken.IsCancellationRequested()) {
             return ResultType::Cancelled;
         }
-        StallWrite(jobConfig,
-                   targetFilepath,
-                   HyoutaUtils::IO::GetFilesize(std::string_view(movedFilepath)).value_or(0),
-                   cancellationToken,
-                   ShouldStallWriteRegularFile,
-                   [&](std::string status) {
-                       std::lock_guard lock(*jobConfig.JobsLock);
-                       job.TextStatus = std::move(status);
-                   });
+        auto reservedSpace = ReserveDiskSpace(
+            jobConfig,
+            job.Progress,
+            targetFilepath,
+            HyoutaUtils::IO::GetFilesize(std::string_view(movedFilepath)).value_or(0),
+            cancellationToken,
+            GetMinimumFreeSpaceForRegularFile,
+            [&](std::string status) {
+                JobDataWriteLock lock(job);
+                job.TextStatus = std::move(status);
+            });
         if (cancellationToken.IsCancellationRequested()) {
             return ResultType::Cancelled;
         }
@@ -211,7 +217,7 @@ static ResultType RunGenericFileJob(GenericFileJob& job,
     }
 
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Done!";
         job.JobStatus = VideoJobStatus::Finished;
     }
@@ -229,7 +235,7 @@ std::string GenericFileJob::GenerateOutputFilename() {
 std::unique_ptr<IVideoJob> GenericFileJob::Clone() const {
     auto clone = std::make_unique<GenericFileJob>();
     clone->TextStatus = this->TextStatus;
-    clone->JobStatus = this->JobStatus;
+    clone->JobStatus = this->JobStatus.load();
     clone->HasBeenValidated = this->HasBeenValidated;
     clone->VideoInfo = this->VideoInfo ? this->VideoInfo->Clone() : nullptr;
     clone->JobStartTimestamp = this->JobStartTimestamp;
@@ -25,7 +25,7 @@ std::string HitboxVideoJob::GenerateOutputFilename() {
 std::unique_ptr<IVideoJob> HitboxVideoJob::Clone() const {
     auto clone = std::make_unique<HitboxVideoJob>();
     clone->TextStatus = this->TextStatus;
-    clone->JobStatus = this->JobStatus;
+    clone->JobStatus = this->JobStatus.load();
     clone->HasBeenValidated = this->HasBeenValidated;
     clone->VideoInfo = this->VideoInfo ? this->VideoInfo->Clone() : nullptr;
     clone->JobStartTimestamp = this->JobStartTimestamp;
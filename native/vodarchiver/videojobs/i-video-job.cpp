@@ -10,7 +10,6 @@
 #include "util/text.h"
 
 #include "vodarchiver/job_config.h"
-#include "vodarchiver/system_util.h"
 
 namespace VodArchiver {
 std::string_view VideoJobStatusToString(VideoJobStatus status) {
@@ -48,6 +47,7 @@ std::string_view ResultTypeToString(ResultType type) {
         case ResultType::TemporarilyUnavailable: return "TemporarilyUnavailable";
         case ResultType::DubiousCombine: return "DubiousCombine";
         case ResultType::DubiousRemux: return "DubiousRemux";
+        case ResultType::Stalled: return "Stalled";
         default: return "Unknown";
     }
 }
@@ -73,6 +73,8 @@ std::optional<ResultType> ResultTypeFromString(std::string_view sv) {
         return ResultType::DubiousCombine;
     } else if (sv == "DubiousRemux") {
         return ResultType::DubiousRemux;
+    } else if (sv == "Stalled") {
+        return ResultType::Stalled;
     }
     return std::nullopt;
 }
@@ -81,8 +83,31 @@ IUserInputRequest::~IUserInputRequest() = default;
 
 IVideoJob::~IVideoJob() = default;
 
+void IVideoJob::MarkChanged() {
+    Version.fetch_add(1, std::memory_order_release);
+}
+
+JobDataWriteLock::JobDataWriteLock(IVideoJob& job) : Job(job) {
+    Job.DataLock.lock();
+}
+
+JobDataWriteLock::~JobDataWriteLock() {
+    // bump the version before unlocking, so that a reader that sees the old version under the lock
+    // also sees the old data
+    Job.MarkChanged();
+    Job.DataLock.unlock();
+}
+
 void IVideoJob::SetStatus(std::string value) {
     TextStatus = value;
+    Progress.Heartbeat();
+}
+
+JobPriority IVideoJob::GetMinimumPriority() const {
+    if (VideoInfo && VideoInfo->GetVideoRecordingState() == RecordingState::Live) {
+        return JobPriority::Live;
+    }
+    return JobPriority::Backlog;
 }
 
 IUserInputRequest* IVideoJob::GetUserInputRequest() const {
@@ -110,44 +135,30 @@ std::string IVideoJob::GetHumanReadableJobName() const {
     }
 }
 
-bool ShouldStallWriteRegularFile(JobConfig& jobConfig, std::string_view path, uint64_t filesize) {
-    auto freeSpace = GetFreeDiskSpaceAtPath(path);
-    if (!freeSpace.has_value()) {
-        return false;
-    }
-
+uint64_t GetMinimumFreeSpaceForRegularFile(JobConfig& jobConfig) {
     std::lock_guard lock(jobConfig.Mutex);
-    return *freeSpace <= (jobConfig.MinimumFreeSpaceBytes + filesize);
+    return jobConfig.MinimumFreeSpaceBytes;
 }
-bool ShouldStallWriteSmallFile(JobConfig& jobConfig, std::string_view path, uint64_t filesize) {
-    auto freeSpace = GetFreeDiskSpaceAtPath(path);
-    if (!freeSpace.has_value()) {
-        return false;
-    }
-
+uint64_t GetMinimumFreeSpaceForSmallFile(JobConfig& jobConfig) {
     std::lock_guard lock(jobConfig.Mutex);
-    return *freeSpace
-           <= (std::min(jobConfig.AbsoluteMinimumFreeSpaceBytes, jobConfig.MinimumFreeSpaceBytes)
-               + filesize);
+    return std::min(jobConfig.AbsoluteMinimumFreeSpaceBytes, jobConfig.MinimumFreeSpaceBytes);
 }
 
-void StallWrite(
+DiskSpaceReservation ReserveDiskSpace(
     JobConfig& jobConfig,
+    JobProgress& progress,
     std::string_view path,
     uint64_t filesize,
     TaskCancellation& cancellationToken,
-    const std::function<bool(JobConfig& jobConfig, std::string_view path, uint64_t filesize)>&
-        shouldStallWriteCallback,
+    const std::function<uint64_t(JobConfig& jobConfig)>& getMinimumFreeSpace,
     const std::function<void(std::string status)>& setStatusCallback) {
-    if (shouldStallWriteCallback(jobConfig, path, filesize)) {
-        setStatusCallback("Not enough free space, stalling...");
-        do {
-            if (cancellationToken.IsCancellationRequested()) {
-                return;
-            }
-            cancellationToken.DelayFor(std::chrono::seconds(10));
-        } while (shouldStallWriteCallback(jobConfig, path, filesize));
-    }
+    JobIdleWait idle(progress);
+    return jobConfig.FreeSpace.Reserve(
+        path,
+        filesize,
+        [&]() { return getMinimumFreeSpace(jobConfig); },
+        cancellationToken,
+        setStatusCallback);
 }
 
 } // namespace VodArchiver
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -11,7 +13,9 @@
 
 #include "../videoinfo/i-video-info.h"
 
+#include "../disk_space.h"
 #include "../job_config.h"
+#include "../job_progress.h"
 #include "../task_cancellation.h"
 #include "../time_types.h"
 
@@ -37,10 +41,25 @@ enum class ResultType : uint8_t {
     TemporarilyUnavailable, // task is currently unavailable but may work if retried later
     DubiousCombine,         // combined video doesn't match what was expected
     DubiousRemux,           // remuxed video doesn't match what was expected
+    Stalled,                // task made no progress for too long and was cancelled by the watchdog
+    COUNT,
 };
 std::string_view ResultTypeToString(ResultType type);
 std::optional<ResultType> ResultTypeFromString(std::string_view sv);
 
+// Order in which waiting jobs are started, higher first. Not persisted.
+enum class JobPriority : uint8_t {
+    Backlog, // enqueued in bulk, eg. everything that hasn't been downloaded yet
+    Normal,  // enqueued individually, either by the user or by a fetch
+    Live,    // capture of an ongoing stream, which may become unavailable if we wait too long
+};
+
+// Which concurrency limit of the VideoTaskGroup a running job currently counts against.
+enum class JobResourcePool : uint8_t {
+    Network, // fetching metadata or downloading
+    Disk,    // only local work left, eg. combining, remuxing, verifying and moving files
+};
+
 struct IUserInputRequest {
     virtual ~IUserInputRequest();
     virtual const std::string& GetQuestion() const = 0;
@@ -54,40 +73,92 @@ struct IVideoJob {
     // in the JobList are accessed by multiple threads, so the access must be synchronized to avoid
     // race conditions. None of this applies to jobs that are not stored in the JobList.
     //
-    // All access (both read and write) to the job data *must* be done while holding the
-    // JobList::JobsLock. There is one exception to this: The Run() function may be called without
-    // holding this lock, it will take care of the locking on its own.
+    // All access (both read and write) to the job data *must* be done while holding the job's own
+    // DataLock. There is one exception to this: The Run() function may be called without holding
+    // this lock, it will take care of the locking on its own. The JobList::JobsLock only guards
+    // which jobs are in the list, so a job updating its status never waits for anything but another
+    // thread looking at that same job.
+    //
+    // If you need to hold more than one of these, lock them in this order: JobList::JobsLock, then
+    // the DataLock of a single job, then the JobQueueLock of a VideoTaskGroup. Never hold the
+    // DataLock of two jobs at once unless you lock them together with std::scoped_lock.
 
     virtual ~IVideoJob();
 
     void SetStatus(std::string value);
     std::string GetHumanReadableJobName() const;
 
+    // The lowest priority this job may be enqueued with. Live captures return Live, everything
+    // else takes whatever priority it was enqueued with.
+    virtual JobPriority GetMinimumPriority() const;
+
+    // Exempt from the DataLock rule, implementations must be safe to call from any thread.
     virtual bool IsWaitingForUserInput() const = 0;
+
     virtual IUserInputRequest* GetUserInputRequest() const;
     virtual ResultType Run(JobConfig& jobConfig, TaskCancellation& cancellationToken) = 0;
     virtual std::string GenerateOutputFilename() = 0;
     virtual std::unique_ptr<IVideoJob> Clone() const = 0; // may not clone user input requests!
 
+    mutable std::recursive_mutex DataLock;
+
+    // Incremented whenever the job data changes, see JobDataWriteLock. Not persisted.
+    std::atomic<uint64_t> Version = 0;
+    void MarkChanged();
+
     std::string TextStatus;
-    VideoJobStatus JobStatus = VideoJobStatus::NotStarted;
+
+    // Only written while holding the DataLock, but may be read without it, so that filtering and
+    // counting jobs by status doesn't have to lock every single job.
+    std::atomic<VideoJobStatus> JobStatus = VideoJobStatus::NotStarted;
+
     bool HasBeenValidated = false;
+
+    // May be replaced by a more up to date version while the job runs, but the service and video ID
+    // must stay the same, the JobList indexes jobs by those.
     std::unique_ptr<IVideoInfo> VideoInfo;
+
     DateTime JobStartTimestamp{.Internal = 0};
     DateTime JobFinishTimestamp{.Internal = 0};
     std::string Notes;
+
+    // Exempt from the DataLock rule, see JobProgress. Not persisted and not cloned.
+    JobProgress Progress;
+
+    // Also exempt from the DataLock rule. Run() switches this to Disk once it's done with the
+    // network, which frees up its slot for the next download while this job waits for the disk.
+    // Reset to Network by the VideoTaskGroup whenever the job is started.
+    std::atomic<JobResourcePool> ResourcePool = JobResourcePool::Network;
+};
+
+// Holds the DataLock of a job while changing its data, and marks the job as changed when released
+// so that observers like the GUI know they have to look at it again.
+struct JobDataWriteLock {
+    explicit JobDataWriteLock(IVideoJob& job);
+    JobDataWriteLock(const JobDataWriteLock& other) = delete;
+    JobDataWriteLock(JobDataWriteLock&& other) = delete;
+    JobDataWriteLock& operator=(const JobDataWriteLock& other) = delete;
+    JobDataWriteLock& operator=(JobDataWriteLock&& other) = delete;
+    ~JobDataWriteLock();
+
+private:
+    IVideoJob& Job;
 };
 
-bool ShouldStallWriteRegularFile(JobConfig& jobConfig, std::string_view path, uint64_t filesize);
-bool ShouldStallWriteSmallFile(JobConfig& jobConfig, std::string_view path, uint64_t filesize);
+uint64_t GetMinimumFreeSpaceForRegularFile(JobConfig& jobConfig);
+uint64_t GetMinimumFreeSpaceForSmallFile(JobConfig& jobConfig);
 
-void StallWrite(
+// Waits until 'filesize' bytes can be written to 'path' without dropping below the minimum free
+// space, taking into account what other jobs are about to write to the same volume. Keep the
+// returned reservation alive until the write has finished. The job is exempt from the stall
+// watchdog while waiting.
+[[nodiscard]] DiskSpaceReservation ReserveDiskSpace(
     JobConfig& jobConfig,
+    JobProgress& progress,
     std::string_view path,
     uint64_t filesize,
     TaskCancellation& cancellationToken,
-    const std::function<bool(JobConfig& jobConfig, std::string_view path, uint64_t filesize)>&
-        shouldStallWriteCallback,
+    const std::function<uint64_t(JobConfig& jobConfig)>& getMinimumFreeSpace,
     const std::function<void(std::string status)>& setStatusCallback);
 
 } // namespace VodArchiver
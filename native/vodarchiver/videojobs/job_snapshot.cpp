@@ -0,0 +1,878 @@
+#include "job_snapshot.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "util/endian.h"
+#include "util/file.h"
+#include "util/hash/crc32.h"
+#include "util/memread.h"
+#include "util/memwrite.h"
+#include "util/scope.h"
+
+#include "../log_buffer.h"
+
+#include "../videoinfo/ffmpeg-reencode-job-video-info.h"
+#include "../videoinfo/generic-video-info.h"
+#include "../videoinfo/hitbox-video-info.h"
+#include "../videoinfo/i-video-info.h"
+#include "../videoinfo/twitch-video-info.h"
+#include "../videoinfo/youtube-video-info.h"
+
+#include "ffmpeg-reencode-job.h"
+#include "ffmpeg-split-job.h"
+#include "generic-file-job.h"
+#include "hitbox-video-job.h"
+#include "i-video-job.h"
+#include "twitch-chat-replay-job.h"
+#include "twitch-video-job.h"
+#include "youtube-video-job.h"
+
+namespace VodArchiver {
+using HyoutaUtils::EndianUtils::Endianness;
+
+static constexpr std::array<char, 8> SnapshotMagic{'V', 'o', 'd', 'J', 'o', 'b', 's', '\x1a'};
+static constexpr uint32_t SnapshotVersion = 1;
+
+// header field offsets
+static constexpr size_t HeaderMagic = 0;
+static constexpr size_t HeaderVersion = 8;
+static constexpr size_t HeaderHeaderSize = 12;
+static constexpr size_t HeaderRecordSize = 16;
+static constexpr size_t HeaderJobCount = 24; // 20 to 23 are unused
+static constexpr size_t HeaderRecordsOffset = 32;
+static constexpr size_t HeaderStringsOffset = 40;
+static constexpr size_t HeaderStringsSize = 48;
+static constexpr size_t HeaderChecksum = 60; // CRC32 of everything before it, 56 to 59 are unused
+static constexpr size_t HeaderSize = 64;
+
+// record field offsets. string references are a 32-bit offset into the string table followed by a
+// 32-bit length
+static constexpr size_t RecordChecksum = 0; // CRC32 of the rest of the record and its strings
+static constexpr size_t RecordJobType = 4;
+static constexpr size_t RecordJobStatus = 5;
+static constexpr size_t RecordHasBeenValidated = 6;
+static constexpr size_t RecordVideoInfoType = 7;
+static constexpr size_t RecordService = 8;
+static constexpr size_t RecordJobStartTimestamp = 16; // 9 to 15 are unused
+static constexpr size_t RecordJobFinishTimestamp = 24;
+static constexpr size_t RecordTextStatus = 32;
+static constexpr size_t RecordNotes = 40;
+static constexpr size_t RecordVideoId = 48;
+static constexpr size_t RecordJobExtra = 56; // VideoQuality or SplitTimes, depending on job type
+static constexpr size_t RecordVideoInfo = 64;
+static constexpr size_t RecordSize = 72;
+
+static constexpr std::array<size_t, 5> RecordStringRefs{
+    RecordTextStatus, RecordNotes, RecordVideoId, RecordJobExtra, RecordVideoInfo};
+
+// whether the string table stores each of the RecordStringRefs only once, see StringTableWriter
+static constexpr std::array<bool, RecordStringRefs.size()> RecordStringDeduplicate{
+    true, true, false, true, false};
+
+// the numeric values are part of the file format, only ever append to these
+enum class SnapshotJobType : uint8_t {
+    GenericFile,
+    Hitbox,
+    TwitchChatReplay,
+    TwitchVideo,
+    Youtube,
+    FFMpegReencode,
+    FFMpegSplit,
+};
+
+enum class SnapshotVideoInfoType : uint8_t {
+    Generic,
+    Hitbox,
+    Twitch,
+    Youtube,
+    FFMpegReencode,
+};
+
+static constexpr StreamService LastStreamService =
+    static_cast<StreamService>(static_cast<uint8_t>(StreamService::COUNT) - 1);
+
+static uint32_t ReadLE32(const char* source) {
+    return HyoutaUtils::EndianUtils::FromEndian(HyoutaUtils::MemRead::ReadUInt32(source),
+                                                Endianness::LittleEndian);
+}
+
+static uint64_t ReadLE64(const char* source) {
+    return HyoutaUtils::EndianUtils::FromEndian(HyoutaUtils::MemRead::ReadUInt64(source),
+                                                Endianness::LittleEndian);
+}
+
+static void WriteLE32(char* target, uint32_t value) {
+    HyoutaUtils::MemWrite::WriteUInt32(
+        target, HyoutaUtils::EndianUtils::ToEndian(value, Endianness::LittleEndian));
+}
+
+static void WriteLE64(char* target, uint64_t value) {
+    HyoutaUtils::MemWrite::WriteUInt64(
+        target, HyoutaUtils::EndianUtils::ToEndian(value, Endianness::LittleEndian));
+}
+
+namespace {
+// The video infos have too many different fields for fixed records, so they're stored as a
+// sequence of values in a fixed order per type instead.
+struct VideoInfoWriter {
+    std::string Data;
+
+    void WriteUInt8(uint8_t value) {
+        Data.push_back(static_cast<char>(value));
+    }
+
+    void WriteUInt32(uint32_t value) {
+        std::array<char, 4> tmp;
+        WriteLE32(tmp.data(), value);
+        Data.append(tmp.data(), tmp.size());
+    }
+
+    void WriteUInt64(uint64_t value) {
+        std::array<char, 8> tmp;
+        WriteLE64(tmp.data(), value);
+        Data.append(tmp.data(), tmp.size());
+    }
+
+    void WriteInt32(int32_t value) {
+        WriteUInt32(static_cast<uint32_t>(value));
+    }
+
+    void WriteInt64(int64_t value) {
+        WriteUInt64(static_cast<uint64_t>(value));
+    }
+
+    void WriteFloat(float value) {
+        WriteUInt32(std::bit_cast<uint32_t>(value));
+    }
+
+    void WriteDouble(double value) {
+        WriteUInt64(std::bit_cast<uint64_t>(value));
+    }
+
+    template<typename T>
+    void WriteEnum(T value) {
+        WriteUInt8(static_cast<uint8_t>(value));
+    }
+
+    void WriteDateTime(const DateTime& value) {
+        WriteUInt64(value.Internal);
+    }
+
+    void WriteTimeSpan(const TimeSpan& value) {
+        WriteInt64(value.Ticks);
+    }
+
+    void WriteString(std::string_view value) {
+        WriteUInt32(static_cast<uint32_t>(value.size()));
+        Data.append(value);
+    }
+
+    void WriteOptionalString(const std::optional<std::string>& value) {
+        WriteUInt8(value.has_value() ? 1 : 0);
+        if (value.has_value()) {
+            WriteString(*value);
+        }
+    }
+
+    void WriteOptionalDateTime(const std::optional<DateTime>& value) {
+        WriteUInt8(value.has_value() ? 1 : 0);
+        if (value.has_value()) {
+            WriteDateTime(*value);
+        }
+    }
+};
+
+// Reads past the end or invalid enum values set Failed and return a default value, so the decode
+// functions only have to check once at the end.
+struct VideoInfoReader {
+    const char* Position;
+    const char* End;
+    bool Failed = false;
+
+    bool Has(size_t length) {
+        if (Failed || static_cast<size_t>(End - Position) < length) {
+            Failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool IsDone() const {
+        return !Failed && Position == End;
+    }
+
+    uint8_t ReadUInt8() {
+        if (!Has(1)) {
+            return 0;
+        }
+        return static_cast<uint8_t>(*Position++);
+    }
+
+    uint32_t ReadUInt32() {
+        if (!Has(4)) {
+            return 0;
+        }
+        uint32_t value = ReadLE32(Position);
+        Position += 4;
+        return value;
+    }
+
+    uint64_t ReadUInt64() {
+        if (!Has(8)) {
+            return 0;
+        }
+        uint64_t value = ReadLE64(Position);
+        Position += 8;
+        return value;
+    }
+
+    int32_t ReadInt32() {
+        return static_cast<int32_t>(ReadUInt32());
+    }
+
+    int64_t ReadInt64() {
+        return static_cast<int64_t>(ReadUInt64());
+    }
+
+    float ReadFloat() {
+        return std::bit_cast<float>(ReadUInt32());
+    }
+
+    double ReadDouble() {
+        return std::bit_cast<double>(ReadUInt64());
+    }
+
+    template<typename T>
+    T ReadEnum(T last) {
+        const uint8_t value = ReadUInt8();
+        if (value > static_cast<uint8_t>(last)) {
+            Failed = true;
+            return T{};
+        }
+        return static_cast<T>(value);
+    }
+
+    DateTime ReadDateTime() {
+        return DateTime{.Internal = ReadUInt64()};
+    }
+
+    TimeSpan ReadTimeSpan() {
+        return TimeSpan{.Ticks = ReadInt64()};
+    }
+
+    std::string ReadString() {
+        const uint32_t length = ReadUInt32();
+        if (!Has(length)) {
+            return std::string();
+        }
+        std::string value(Position, length);
+        Position += length;
+        return value;
+    }
+
+    std::optional<std::string> ReadOptionalString() {
+        if (ReadUInt8() == 0) {
+            return std::nullopt;
+        }
+        return ReadString();
+    }
+
+    std::optional<DateTime> ReadOptionalDateTime() {
+        if (ReadUInt8() == 0) {
+            return std::nullopt;
+        }
+        return ReadDateTime();
+    }
+};
+} // namespace
+
+static std::optional<SnapshotVideoInfoType> EncodeVideoInfo(VideoInfoWriter& w, IVideoInfo& info) {
+    if (auto* c = dynamic_cast<GenericVideoInfo*>(&info)) {
+        w.WriteEnum(c->Service);
+        w.WriteString(c->Username);
+        w.WriteString(c->VideoId);
+        w.WriteString(c->VideoTitle);
+        w.WriteString(c->VideoGame);
+        w.WriteDateTime(c->VideoTimestamp);
+        w.WriteTimeSpan(c->VideoLength);
+        w.WriteEnum(c->VideoRecordingState);
+        w.WriteEnum(c->VideoType);
+        return SnapshotVideoInfoType::Generic;
+    } else if (auto* c = dynamic_cast<HitboxVideoInfo*>(&info)) {
+        const HitboxVideo& v = c->VideoInfo;
+        w.WriteString(v.MediaUserName);
+        w.WriteInt32(v.MediaId);
+        w.WriteString(v.MediaFile);
+        w.WriteInt32(v.MediaUserId);
+        w.WriteUInt32(static_cast<uint32_t>(v.MediaProfiles.size()));
+        for (const auto& profile : v.MediaProfiles) {
+            w.WriteString(profile.Url);
+            w.WriteInt32(profile.Height);
+            w.WriteInt32(profile.Bitrate);
+        }
+        w.WriteDateTime(v.MediaDateAdded);
+        w.WriteString(v.MediaTitle);
+        w.WriteString(v.MediaDescription);
+        w.WriteString(v.MediaGame);
+        w.WriteDouble(v.MediaDuration);
+        w.WriteInt32(v.MediaTypeId);
+        return SnapshotVideoInfoType::Hitbox;
+    } else if (auto* c = dynamic_cast<TwitchVideoInfo*>(&info)) {
+        const TwitchVideo& v = c->Video;
+        w.WriteEnum(c->Service);
+        w.WriteInt64(v.ID);
+        w.WriteInt64(v.UserID);
+        w.WriteOptionalString(v.Username);
+        w.WriteOptionalString(v.Title);
+        w.WriteOptionalString(v.Game);
+        w.WriteOptionalString(v.Description);
+        w.WriteOptionalDateTime(v.CreatedAt);
+        w.WriteOptionalDateTime(v.PublishedAt);
+        w.WriteInt64(v.Duration);
+        w.WriteInt64(v.ViewCount);
+        w.WriteEnum(v.Type);
+        w.WriteEnum(v.State);
+        return SnapshotVideoInfoType::Twitch;
+    } else if (auto* c = dynamic_cast<YoutubeVideoInfo*>(&info)) {
+        w.WriteString(c->Username);
+        w.WriteString(c->VideoId);
+        w.WriteString(c->VideoTitle);
+        w.WriteString(c->VideoGame);
+        w.WriteDateTime(c->VideoTimestamp);
+        w.WriteTimeSpan(c->VideoLength);
+        w.WriteEnum(c->VideoRecordingState);
+        w.WriteEnum(c->VideoType);
+        w.WriteString(c->UserDisplayName);
+        w.WriteString(c->VideoDescription);
+        return SnapshotVideoInfoType::Youtube;
+    } else if (auto* c = dynamic_cast<FFMpegReencodeJobVideoInfo*>(&info)) {
+        w.WriteString(c->VideoTitle);
+        w.WriteString(c->VideoId);
+        w.WriteUInt64(c->Filesize);
+        w.WriteUInt64(c->Bitrate);
+        w.WriteFloat(c->Framerate);
+        w.WriteDateTime(c->VideoTimestamp);
+        w.WriteTimeSpan(c->VideoLength);
+        w.WriteString(c->PostfixOld);
+        w.WriteString(c->PostfixNew);
+        w.WriteString(c->OutputFormat);
+        w.WriteUInt32(static_cast<uint32_t>(c->FFMpegOptions.size()));
+        for (const auto& option : c->FFMpegOptions) {
+            w.WriteString(option);
+        }
+        return SnapshotVideoInfoType::FFMpegReencode;
+    }
+    return std::nullopt;
+}
+
+static std::unique_ptr<IVideoInfo> DecodeVideoInfo(SnapshotVideoInfoType type,
+                                                   std::string_view data) {
+    VideoInfoReader r{.Position = data.data(), .End = data.data() + data.size()};
+    std::unique_ptr<IVideoInfo> result;
+    switch (type) {
+        case SnapshotVideoInfoType::Generic: {
+            auto info = std::make_unique<GenericVideoInfo>();
+            info->Service = r.ReadEnum(LastStreamService);
+            info->Username = r.ReadString();
+            info->VideoId = r.ReadString();
+            info->VideoTitle = r.ReadString();
+            info->VideoGame = r.ReadString();
+            info->VideoTimestamp = r.ReadDateTime();
+            info->VideoLength = r.ReadTimeSpan();
+            info->VideoRecordingState = r.ReadEnum(RecordingState::Recorded);
+            info->VideoType = r.ReadEnum(VideoFileType::Unknown);
+            result = std::move(info);
+            break;
+        }
+        case SnapshotVideoInfoType::Hitbox: {
+            auto info = std::make_unique<HitboxVideoInfo>();
+            HitboxVideo& v = info->VideoInfo;
+            v.MediaUserName = r.ReadString();
+            v.MediaId = r.ReadInt32();
+            v.MediaFile = r.ReadString();
+            v.MediaUserId = r.ReadInt32();
+            const uint32_t profileCount = r.ReadUInt32();
+            for (uint32_t i = 0; i < profileCount && !r.Failed; ++i) {
+                HitboxMediaProfile profile;
+                profile.Url = r.ReadString();
+                profile.Height = r.ReadInt32();
+                profile.Bitrate = r.ReadInt32();
+                v.MediaProfiles.push_back(std::move(profile));
+            }
+            v.MediaDateAdded = r.ReadDateTime();
+            v.MediaTitle = r.ReadString();
+            v.MediaDescription = r.ReadString();
+            v.MediaGame = r.ReadString();
+            v.MediaDuration = r.ReadDouble();
+            v.MediaTypeId = r.ReadInt32();
+            result = std::move(info);
+            break;
+        }
+        case SnapshotVideoInfoType::Twitch: {
+            auto info = std::make_unique<TwitchVideoInfo>();
+            TwitchVideo& v = info->Video;
+            info->Service = r.ReadEnum(LastStreamService);
+            v.ID = r.ReadInt64();
+            v.UserID = r.ReadInt64();
+            v.Username = r.ReadOptionalString();
+            v.Title = r.ReadOptionalString();
+            v.Game = r.ReadOptionalString();
+            v.Description = r.ReadOptionalString();
+            v.CreatedAt = r.ReadOptionalDateTime();
+            v.PublishedAt = r.ReadOptionalDateTime();
+            v.Duration = r.ReadInt64();
+            v.ViewCount = r.ReadInt64();
+            v.Type = r.ReadEnum(TwitchVideoType::Unknown);
+            v.State = r.ReadEnum(RecordingState::Recorded);
+            result = std::move(info);
+            break;
+        }
+        case SnapshotVideoInfoType::Youtube: {
+            auto info = std::make_unique<YoutubeVideoInfo>();
+            info->Username = r.ReadString();
+            info->VideoId = r.ReadString();
+            info->VideoTitle = r.ReadString();
+            info->VideoGame = r.ReadString();
+            info->VideoTimestamp = r.ReadDateTime();
+            info->VideoLength = r.ReadTimeSpan();
+            info->VideoRecordingState = r.ReadEnum(RecordingState::Recorded);
+            info->VideoType = r.ReadEnum(VideoFileType::Unknown);
+            info->UserDisplayName = r.ReadString();
+            info->VideoDescription = r.ReadString();
+            result = std::move(info);
+            break;
+        }
+        case SnapshotVideoInfoType::FFMpegReencode: {
+            auto info = std::make_unique<FFMpegReencodeJobVideoInfo>();
+            info->VideoTitle = r.ReadString();
+            info->VideoId = r.ReadString();
+            info->Filesize = r.ReadUInt64();
+            info->Bitrate = r.ReadUInt64();
+            info->Framerate = r.ReadFloat();
+            info->VideoTimestamp = r.ReadDateTime();
+            info->VideoLength = r.ReadTimeSpan();
+            info->PostfixOld = r.ReadString();
+            info->PostfixNew = r.ReadString();
+            info->OutputFormat = r.ReadString();
+            const uint32_t optionCount = r.ReadUInt32();
+            for (uint32_t i = 0; i < optionCount && !r.Failed; ++i) {
+                info->FFMpegOptions.push_back(r.ReadString());
+            }
+            result = std::move(info);
+            break;
+        }
+        default: return nullptr;
+    }
+
+    if (!r.IsDone()) {
+        return nullptr;
+    }
+    return result;
+}
+
+static std::unique_ptr<IVideoJob> CreateJob(SnapshotJobType type) {
+    switch (type) {
+        case SnapshotJobType::GenericFile: return std::make_unique<GenericFileJob>();
+        case SnapshotJobType::Hitbox: return std::make_unique<HitboxVideoJob>();
+        case SnapshotJobType::TwitchChatReplay: return std::make_unique<TwitchChatReplayJob>();
+        case SnapshotJobType::TwitchVideo: return std::make_unique<TwitchVideoJob>();
+        case SnapshotJobType::Youtube: return std::make_unique<YoutubeVideoJob>();
+        case SnapshotJobType::FFMpegReencode: return std::make_unique<FFMpegReencodeJob>();
+        case SnapshotJobType::FFMpegSplit: return std::make_unique<FFMpegSplitJob>();
+        default: return nullptr;
+    }
+}
+
+// same order as the XML serializer, some of the job types derive from others
+static std::optional<SnapshotJobType> GetJobType(IVideoJob& job, std::string_view& extra) {
+    if (dynamic_cast<GenericFileJob*>(&job)) {
+        return SnapshotJobType::GenericFile;
+    } else if (dynamic_cast<HitboxVideoJob*>(&job)) {
+        return SnapshotJobType::Hitbox;
+    } else if (dynamic_cast<TwitchChatReplayJob*>(&job)) {
+        return SnapshotJobType::TwitchChatReplay;
+    } else if (auto* c = dynamic_cast<TwitchVideoJob*>(&job)) {
+        extra = c->VideoQuality;
+        return SnapshotJobType::TwitchVideo;
+    } else if (dynamic_cast<YoutubeVideoJob*>(&job)) {
+        return SnapshotJobType::Youtube;
+    } else if (dynamic_cast<FFMpegReencodeJob*>(&job)) {
+        return SnapshotJobType::FFMpegReencode;
+    } else if (auto* c = dynamic_cast<FFMpegSplitJob*>(&job)) {
+        extra = c->SplitTimes;
+        return SnapshotJobType::FFMpegSplit;
+    }
+    return std::nullopt;
+}
+
+JobSnapshot::JobSnapshot() = default;
+
+JobSnapshot::~JobSnapshot() = default;
+
+bool JobSnapshot::Open(std::string_view filename) {
+    Records = nullptr;
+    RecordSize = 0;
+    JobCount = 0;
+    Strings = nullptr;
+    StringsSize = 0;
+
+    if (!File.Open(filename)) {
+        return false;
+    }
+    auto fileScope = HyoutaUtils::MakeDisposableScopeGuard([&]() { File.Close(); });
+
+    const char* data = File.GetData();
+    const size_t size = File.GetSize();
+    if (size < HeaderSize) {
+        return false;
+    }
+    if (std::memcmp(data + HeaderMagic, SnapshotMagic.data(), SnapshotMagic.size()) != 0) {
+        return false;
+    }
+    crc_t crc = crc_init();
+    crc = crc_update(crc, data, HeaderChecksum);
+    crc = crc_finalize(crc);
+    if (static_cast<uint32_t>(crc) != ReadLE32(data + HeaderChecksum)) {
+        return false;
+    }
+    if (ReadLE32(data + HeaderVersion) != SnapshotVersion
+        || ReadLE32(data + HeaderHeaderSize) != HeaderSize) {
+        return false;
+    }
+
+    // later versions may append fields to the records, so only require what we need
+    const uint64_t recordSize = ReadLE32(data + HeaderRecordSize);
+    const uint64_t jobCount = ReadLE64(data + HeaderJobCount);
+    const uint64_t recordsOffset = ReadLE64(data + HeaderRecordsOffset);
+    const uint64_t stringsOffset = ReadLE64(data + HeaderStringsOffset);
+    const uint64_t stringsSize = ReadLE64(data + HeaderStringsSize);
+    if (recordSize < RecordSize || recordsOffset > size
+        || jobCount > (size - recordsOffset) / recordSize) {
+        return false;
+    }
+    if (stringsOffset > size || stringsSize > size - stringsOffset) {
+        return false;
+    }
+
+    Records = data + recordsOffset;
+    RecordSize = static_cast<size_t>(recordSize);
+    JobCount = static_cast<size_t>(jobCount);
+    Strings = data + stringsOffset;
+    StringsSize = static_cast<size_t>(stringsSize);
+    fileScope.Dispose();
+    return true;
+}
+
+const char* JobSnapshot::GetRecord(size_t index) const {
+    if (index >= JobCount) {
+        return nullptr;
+    }
+    return Records + index * RecordSize;
+}
+
+std::optional<std::string_view> JobSnapshot::GetString(const char* stringRef) const {
+    const uint32_t offset = ReadLE32(stringRef);
+    const uint32_t length = ReadLE32(stringRef + 4);
+    if (offset > StringsSize || length > StringsSize - offset) {
+        return std::nullopt;
+    }
+    return std::string_view(Strings + offset, length);
+}
+
+std::optional<VideoJobStatus> JobSnapshot::GetJobStatus(size_t index) const {
+    const char* record = GetRecord(index);
+    if (!record) {
+        return std::nullopt;
+    }
+    const uint8_t status = static_cast<uint8_t>(record[RecordJobStatus]);
+    if (status >= static_cast<uint8_t>(VideoJobStatus::COUNT)) {
+        return std::nullopt;
+    }
+    return static_cast<VideoJobStatus>(status);
+}
+
+std::optional<StreamService> JobSnapshot::GetService(size_t index) const {
+    const char* record = GetRecord(index);
+    if (!record) {
+        return std::nullopt;
+    }
+    const uint8_t service = static_cast<uint8_t>(record[RecordService]);
+    if (service >= static_cast<uint8_t>(StreamService::COUNT)) {
+        return std::nullopt;
+    }
+    return static_cast<StreamService>(service);
+}
+
+std::string_view JobSnapshot::GetVideoId(size_t index) const {
+    const char* record = GetRecord(index);
+    if (!record) {
+        return std::string_view();
+    }
+    return GetString(record + RecordVideoId).value_or(std::string_view());
+}
+
+bool JobSnapshot::IsJobIntact(size_t index) const {
+    const char* record = GetRecord(index);
+    if (!record) {
+        return false;
+    }
+
+    crc_t crc = crc_init();
+    crc = crc_update(crc, record + RecordJobType, RecordSize - RecordJobType);
+    for (size_t stringRef : RecordStringRefs) {
+        auto s = GetString(record + stringRef);
+        if (!s) {
+            return false;
+        }
+        crc = crc_update(crc, s->data(), s->size());
+    }
+    crc = crc_finalize(crc);
+    return static_cast<uint32_t>(crc) == ReadLE32(record + RecordChecksum);
+}
+
+std::unique_ptr<IVideoJob> JobSnapshot::DecodeJob(size_t index) const {
+    if (!IsJobIntact(index)) {
+        return nullptr;
+    }
+
+    // all of these were checked above
+    const char* record = GetRecord(index);
+    const std::string_view textStatus = *GetString(record + RecordTextStatus);
+    const std::string_view notes = *GetString(record + RecordNotes);
+    const std::string_view jobExtra = *GetString(record + RecordJobExtra);
+    const std::string_view videoInfoData = *GetString(record + RecordVideoInfo);
+
+    const uint8_t status = static_cast<uint8_t>(record[RecordJobStatus]);
+    if (status >= static_cast<uint8_t>(VideoJobStatus::COUNT)) {
+        return nullptr;
+    }
+    auto videoInfo = DecodeVideoInfo(
+        static_cast<SnapshotVideoInfoType>(static_cast<uint8_t>(record[RecordVideoInfoType])),
+        videoInfoData);
+    if (!videoInfo
+        || static_cast<uint8_t>(videoInfo->GetService())
+               != static_cast<uint8_t>(record[RecordService])) {
+        return nullptr;
+    }
+    const auto jobType = static_cast<SnapshotJobType>(static_cast<uint8_t>(record[RecordJobType]));
+    auto job = CreateJob(jobType);
+    if (!job) {
+        return nullptr;
+    }
+
+    job->TextStatus = std::string(textStatus);
+    job->JobStatus = static_cast<VideoJobStatus>(status);
+    job->HasBeenValidated = record[RecordHasBeenValidated] != 0;
+    job->VideoInfo = std::move(videoInfo);
+    job->JobStartTimestamp = DateTime{.Internal = ReadLE64(record + RecordJobStartTimestamp)};
+    job->JobFinishTimestamp = DateTime{.Internal = ReadLE64(record + RecordJobFinishTimestamp)};
+    job->Notes = std::string(notes);
+    if (jobType == SnapshotJobType::TwitchVideo) {
+        static_cast<TwitchVideoJob*>(job.get())->VideoQuality = std::string(jobExtra);
+    } else if (jobType == SnapshotJobType::FFMpegSplit) {
+        auto* splitJob = static_cast<FFMpegSplitJob*>(job.get());
+        splitJob->SplitTimes = std::string(jobExtra);
+
+        // same as when loading from XML
+        if (auto* gvi = dynamic_cast<GenericVideoInfo*>(splitJob->VideoInfo.get())) {
+            gvi->VideoTitle = splitJob->SplitTimes;
+        }
+    }
+    return job;
+}
+
+bool IsJobSnapshotFile(std::string_view filename) {
+    HyoutaUtils::IO::File file(filename, HyoutaUtils::IO::OpenMode::Read);
+    if (!file.IsOpen()) {
+        return false;
+    }
+    std::array<char, SnapshotMagic.size()> magic;
+    return file.Read(magic.data(), magic.size()) == magic.size() && magic == SnapshotMagic;
+}
+
+void LogDamagedJob(const JobSnapshot& snapshot, size_t index, std::string_view filename) {
+    // the service and ID may be what's damaged, but they're the best hint we have
+    const auto service = snapshot.GetService(index);
+    GetLogBuffer().Append(LogSource::General,
+                          LogSeverity::Error,
+                          std::format("Skipped damaged job {} ({} {}) in {}",
+                                      index,
+                                      service ? StreamServiceToString(*service) : "Unknown",
+                                      snapshot.GetVideoId(index),
+                                      filename));
+}
+
+std::optional<std::vector<std::unique_ptr<IVideoJob>>> ReadJobSnapshot(std::string_view filename) {
+    JobSnapshot snapshot;
+    if (!snapshot.Open(filename)) {
+        return std::nullopt;
+    }
+
+    std::vector<std::unique_ptr<IVideoJob>> result;
+    result.reserve(snapshot.GetJobCount());
+    for (size_t i = 0; i < snapshot.GetJobCount(); ++i) {
+        auto job = snapshot.DecodeJob(i);
+        if (!job) {
+            LogDamagedJob(snapshot, i, filename);
+            continue;
+        }
+        result.emplace_back(std::move(job));
+    }
+    return result;
+}
+
+namespace {
+struct StringTableWriter {
+    std::string Data;
+
+    // identical statuses, notes and qualities show up over and over again across jobs
+    std::unordered_map<std::string, uint32_t> Known;
+
+    bool Add(char* stringRef, std::string_view value, bool deduplicate) {
+        if (value.empty()) {
+            WriteLE32(stringRef, 0);
+            WriteLE32(stringRef + 4, 0);
+            return true;
+        }
+        if (deduplicate) {
+            auto it = Known.find(std::string(value));
+            if (it != Known.end()) {
+                WriteLE32(stringRef, it->second);
+                WriteLE32(stringRef + 4, static_cast<uint32_t>(value.size()));
+                return true;
+            }
+        }
+        if (Data.size() + value.size() > std::numeric_limits<uint32_t>::max()) {
+            return false;
+        }
+        const uint32_t offset = static_cast<uint32_t>(Data.size());
+        Data.append(value);
+        if (deduplicate) {
+            Known.emplace(std::string(value), offset);
+        }
+        WriteLE32(stringRef, offset);
+        WriteLE32(stringRef + 4, static_cast<uint32_t>(value.size()));
+        return true;
+    }
+};
+} // namespace
+
+static void WriteRecordChecksum(char* record, const StringTableWriter& strings) {
+    crc_t crc = crc_init();
+    crc = crc_update(crc, record + RecordJobType, RecordSize - RecordJobType);
+    for (size_t stringRef : RecordStringRefs) {
+        const uint32_t offset = ReadLE32(record + stringRef);
+        const uint32_t length = ReadLE32(record + stringRef + 4);
+        crc = crc_update(crc, strings.Data.data() + offset, length);
+    }
+    crc = crc_finalize(crc);
+    WriteLE32(record + RecordChecksum, static_cast<uint32_t>(crc));
+}
+
+bool WriteJobSnapshot(const std::vector<std::unique_ptr<IVideoJob>>& jobs,
+                      std::string_view filename,
+                      const DormantJobList* dormant) {
+    const size_t dormantCount = dormant ? dormant->Indices.size() : 0;
+    std::vector<char> records((jobs.size() + dormantCount) * RecordSize, 0);
+    StringTableWriter strings;
+    VideoInfoWriter videoInfoWriter;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        IVideoJob& job = *jobs[i];
+        char* record = records.data() + i * RecordSize;
+
+        std::string_view jobExtra;
+        auto jobType = GetJobType(job, jobExtra);
+        if (!jobType) {
+            return false;
+        }
+        videoInfoWriter.Data.clear();
+        auto videoInfoType = EncodeVideoInfo(videoInfoWriter, *job.VideoInfo);
+        if (!videoInfoType) {
+            return false;
+        }
+        std::array<char, 256> buffer;
+        const std::string_view videoId = job.VideoInfo->GetVideoId(buffer);
+
+        record[RecordJobType] = static_cast<char>(*jobType);
+        record[RecordJobStatus] = static_cast<char>(job.JobStatus.load());
+        record[RecordHasBeenValidated] = job.HasBeenValidated ? 1 : 0;
+        record[RecordVideoInfoType] = static_cast<char>(*videoInfoType);
+        record[RecordService] = static_cast<char>(job.VideoInfo->GetService());
+        WriteLE64(record + RecordJobStartTimestamp, job.JobStartTimestamp.Internal);
+        WriteLE64(record + RecordJobFinishTimestamp, job.JobFinishTimestamp.Internal);
+        if (!strings.Add(record + RecordTextStatus, job.TextStatus, true)
+            || !strings.Add(record + RecordNotes, job.Notes, true)
+            || !strings.Add(record + RecordVideoId, videoId, false)
+            || !strings.Add(record + RecordJobExtra, jobExtra, true)
+            || !strings.Add(record + RecordVideoInfo, videoInfoWriter.Data, false)) {
+            return false;
+        }
+        WriteRecordChecksum(record, strings);
+    }
+
+    // dormant jobs were checked when they were loaded and the mapping is read-only, so they can
+    // be copied over as they are, just with their strings moved into the new string table
+    for (size_t i = 0; i < dormantCount; ++i) {
+        const JobSnapshot& source = *dormant->Snapshot;
+        const char* sourceRecord = source.GetRecord(dormant->Indices[i]);
+        if (!sourceRecord) {
+            return false;
+        }
+        char* record = records.data() + (jobs.size() + i) * RecordSize;
+        std::memcpy(record, sourceRecord, RecordSize);
+        for (size_t j = 0; j < RecordStringRefs.size(); ++j) {
+            auto value = source.GetString(sourceRecord + RecordStringRefs[j]);
+            if (!value
+                || !strings.Add(record + RecordStringRefs[j], *value, RecordStringDeduplicate[j])) {
+                return false;
+            }
+        }
+        WriteRecordChecksum(record, strings);
+    }
+
+    std::array<char, HeaderSize> header{};
+    std::memcpy(header.data() + HeaderMagic, SnapshotMagic.data(), SnapshotMagic.size());
+    WriteLE32(header.data() + HeaderVersion, SnapshotVersion);
+    WriteLE32(header.data() + HeaderHeaderSize, HeaderSize);
+    WriteLE32(header.data() + HeaderRecordSize, RecordSize);
+    WriteLE64(header.data() + HeaderJobCount, jobs.size() + dormantCount);
+    WriteLE64(header.data() + HeaderRecordsOffset, HeaderSize);
+    WriteLE64(header.data() + HeaderStringsOffset, HeaderSize + records.size());
+    WriteLE64(header.data() + HeaderStringsSize, strings.Data.size());
+    crc_t crc = crc_init();
+    crc = crc_update(crc, header.data(), HeaderChecksum);
+    crc = crc_finalize(crc);
+    WriteLE32(header.data() + HeaderChecksum, static_cast<uint32_t>(crc));
+
+    HyoutaUtils::IO::File outfile;
+    if (!outfile.OpenWithTempFilename(filename, HyoutaUtils::IO::OpenMode::Write)) {
+        return false;
+    }
+    auto outfileScope = HyoutaUtils::MakeDisposableScopeGuard([&]() { outfile.Delete(); });
+    if (outfile.Write(header.data(), header.size()) != header.size()) {
+        return false;
+    }
+    if (outfile.Write(records.data(), records.size()) != records.size()) {
+        return false;
+    }
+    if (outfile.Write(strings.Data.data(), strings.Data.size()) != strings.Data.size()) {
+        return false;
+    }
+    if (!outfile.Rename(filename)) {
+        return false;
+    }
+    outfileScope.Dispose();
+    return true;
+}
+} // namespace VodArchiver
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "../mapped_file.h"
+#include "../videoinfo/i-video-info.h"
+
+#include "i-video-job.h"
+
+namespace VodArchiver {
+struct DormantJobList;
+
+// Binary alternative to the gzipped XML job store. The file is mapped instead of read and every job
+// is stored as a fixed-size record, so a single job can be found and decoded without looking at any
+// of the others, and nothing has to be inflated or parsed up front.
+//
+// Layout, all integers little endian:
+//   header        magic, version, record size, job count, offsets and sizes of the sections below,
+//                 and a CRC32 of the header itself
+//   records       one fixed-size record per job: job type, status, service, timestamps and
+//                 references into the string table for the text fields and the encoded video info
+//   string table  the bytes referenced by the records, identical strings are only stored once
+// Each record carries a CRC32 over itself and all the bytes it references, which is checked when
+// the job is decoded, so a damaged job doesn't go unnoticed but also doesn't cost anything until
+// it's actually used.
+struct JobSnapshot {
+    JobSnapshot();
+    JobSnapshot(const JobSnapshot& other) = delete;
+    JobSnapshot(JobSnapshot&& other) = delete;
+    JobSnapshot& operator=(const JobSnapshot& other) = delete;
+    JobSnapshot& operator=(JobSnapshot&& other) = delete;
+    ~JobSnapshot();
+
+    // Maps the file and validates the header, the job records are only validated once they're
+    // decoded.
+    bool Open(std::string_view filename);
+
+    size_t GetJobCount() const {
+        return JobCount;
+    }
+
+    // Read straight from the record without decoding or validating the rest of the job, for
+    // looking things up cheaply. Return nullopt or an empty string if the record is damaged.
+    std::optional<VideoJobStatus> GetJobStatus(size_t index) const;
+    std::optional<StreamService> GetService(size_t index) const;
+    std::string_view GetVideoId(size_t index) const;
+
+    // Checks the record and everything it references against its checksum without decoding it.
+    bool IsJobIntact(size_t index) const;
+
+    // Builds the job stored at index. Returns nullptr if the record is damaged.
+    std::unique_ptr<IVideoJob> DecodeJob(size_t index) const;
+
+private:
+    const char* GetRecord(size_t index) const;
+    std::optional<std::string_view> GetString(const char* stringRef) const;
+
+    MappedFile File;
+    const char* Records = nullptr;
+    size_t RecordSize = 0;
+    size_t JobCount = 0;
+    const char* Strings = nullptr;
+    size_t StringsSize = 0;
+
+    // copies dormant jobs over without decoding them
+    friend bool WriteJobSnapshot(const std::vector<std::unique_ptr<IVideoJob>>& jobs,
+                                 std::string_view filename,
+                                 const DormantJobList* dormant);
+};
+
+// Jobs that were left undecoded in a snapshot, see JobList::Dormant. The snapshot is shared so
+// that a save running on another thread can keep reading it.
+struct DormantJobList {
+    std::shared_ptr<const JobSnapshot> Snapshot;
+    std::vector<size_t> Indices;
+};
+
+// Only checks the magic, the file may still turn out to be broken when it's opened.
+bool IsJobSnapshotFile(std::string_view filename);
+
+// Decodes every job in the snapshot. Damaged jobs are logged and left out, so this only fails if
+// the file itself can't be opened.
+std::optional<std::vector<std::unique_ptr<IVideoJob>>> ReadJobSnapshot(std::string_view filename);
+
+// Logs that the job at index failed to decode and is being skipped.
+void LogDamagedJob(const JobSnapshot& snapshot, size_t index, std::string_view filename);
+
+// Replaces the file atomically. The dormant jobs, if any, are written after the others.
+bool WriteJobSnapshot(const std::vector<std::unique_ptr<IVideoJob>>& jobs,
+                      std::string_view filename,
+                      const DormantJobList* dormant = nullptr);
+} // namespace VodArchiver
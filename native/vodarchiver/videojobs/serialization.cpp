@@ -34,6 +34,7 @@
 #include "generic-file-job.h"
 #include "hitbox-video-job.h"
 #include "i-video-job.h"
+#include "job_snapshot.h"
 #include "twitch-chat-replay-job.h"
 #include "twitch-video-job.h"
 #include "youtube-video-job.h"
@@ -667,8 +668,8 @@ static bool ParseFFMpegSplitJob(FFMpegSplitJob& job, rapidxml::xml_node<char>* n
     return splitTimesRead;
 }
 
-std::optional<std::vector<std::unique_ptr<IVideoJob>>>
-    ParseJobsFromFile(std::string_view filename) {
+static std::optional<std::vector<std::unique_ptr<IVideoJob>>>
+    ParseJobsFromXmlFile(std::string_view filename) {
     HyoutaUtils::IO::File file(filename, HyoutaUtils::IO::OpenMode::Read);
     if (!file.IsOpen()) {
         return std::nullopt;
@@ -865,7 +866,18 @@ std::optional<std::vector<std::unique_ptr<IVideoJob>>>
         }
     }
 
-    for (auto& job : result) {
+    return result;
+}
+
+std::optional<std::vector<std::unique_ptr<IVideoJob>>>
+    ParseJobsFromFile(std::string_view filename) {
+    auto result = IsJobSnapshotFile(filename) ? ReadJobSnapshot(filename)
+                                              : ParseJobsFromXmlFile(filename);
+    if (!result) {
+        return std::nullopt;
+    }
+
+    for (auto& job : *result) {
         if (job->JobStatus == VideoJobStatus::Running) {
             job->JobStatus = VideoJobStatus::NotStarted;
         }
@@ -1077,7 +1089,8 @@ static bool SerializeJob(rapidxml::xml_document<char>& xml,
 }
 
 static std::optional<std::string>
-    WriteJobsToString(const std::vector<std::unique_ptr<IVideoJob>>& jobs) {
+    WriteJobsToString(const std::vector<std::unique_ptr<IVideoJob>>& jobs,
+                      const DormantJobList* dormant) {
     rapidxml::xml_document<char> xml;
     {
         auto* declaration = xml.allocate_node(rapidxml::node_type::node_declaration);
@@ -1094,6 +1107,20 @@ static std::optional<std::string>
             }
             root->append_node(xmlJob);
         }
+        if (dormant) {
+            // the attributes are copied into the document, so each job can go right away
+            for (size_t index : dormant->Indices) {
+                auto job = dormant->Snapshot->DecodeJob(index);
+                if (!job) {
+                    return std::nullopt;
+                }
+                auto* xmlJob = xml.allocate_node(rapidxml::node_type::node_element, "Job");
+                if (!SerializeJob(xml, *xmlJob, *job)) {
+                    return std::nullopt;
+                }
+                root->append_node(xmlJob);
+            }
+        }
         xml.append_node(root);
     }
 
@@ -1102,9 +1129,10 @@ static std::optional<std::string>
     return str;
 }
 
-bool WriteJobsToFile(const std::vector<std::unique_ptr<IVideoJob>>& jobs,
-                     std::string_view filename) {
-    auto str = WriteJobsToString(jobs);
+static bool WriteJobsToXmlFile(const std::vector<std::unique_ptr<IVideoJob>>& jobs,
+                               std::string_view filename,
+                               const DormantJobList* dormant) {
+    auto str = WriteJobsToString(jobs, dormant);
     if (!str) {
         return false;
     }
@@ -1150,4 +1178,45 @@ bool WriteJobsToFile(const std::vector<std::unique_ptr<IVideoJob>>& jobs,
     outfileScope.Dispose();
     return true;
 }
+
+bool WriteJobsToFile(const std::vector<std::unique_ptr<IVideoJob>>& jobs,
+                     std::string_view filename,
+                     JobStoreFormat format,
+                     const DormantJobList* dormant) {
+    switch (format) {
+        case JobStoreFormat::Xml: return WriteJobsToXmlFile(jobs, filename, dormant);
+        case JobStoreFormat::Snapshot: return WriteJobSnapshot(jobs, filename, dormant);
+        default: return false;
+    }
+}
+
+std::string_view ChooseJobStoreFile(std::string_view xmlPath,
+                                    std::string_view snapshotPath,
+                                    JobStoreFormat preferred) {
+    const std::string_view preferredPath =
+        preferred == JobStoreFormat::Snapshot ? snapshotPath : xmlPath;
+    const std::string_view otherPath =
+        preferred == JobStoreFormat::Snapshot ? xmlPath : snapshotPath;
+    if (HyoutaUtils::IO::FileExists(preferredPath) != HyoutaUtils::IO::ExistsResult::DoesExist
+        && HyoutaUtils::IO::FileExists(otherPath) == HyoutaUtils::IO::ExistsResult::DoesExist) {
+        return otherPath;
+    }
+    return preferredPath;
+}
+
+bool WriteJobStore(const std::vector<std::unique_ptr<IVideoJob>>& jobs,
+                   std::string_view xmlPath,
+                   std::string_view snapshotPath,
+                   JobStoreFormat format,
+                   const DormantJobList* dormant) {
+    const bool snapshot = (format == JobStoreFormat::Snapshot);
+    if (!WriteJobsToFile(jobs, snapshot ? snapshotPath : xmlPath, format, dormant)) {
+        return false;
+    }
+    const std::string_view otherPath = snapshot ? xmlPath : snapshotPath;
+    if (HyoutaUtils::IO::FileExists(otherPath) == HyoutaUtils::IO::ExistsResult::DoesExist) {
+        HyoutaUtils::IO::DeleteFile(otherPath);
+    }
+    return true;
+}
 } // namespace VodArchiver
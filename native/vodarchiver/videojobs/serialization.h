@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string_view>
@@ -8,7 +9,34 @@
 #include "i-video-job.h"
 
 namespace VodArchiver {
+struct DormantJobList;
+
+enum class JobStoreFormat : uint8_t {
+    Xml,      // gzipped XML, readable by every version
+    Snapshot, // see JobSnapshot, much faster to load
+};
+
+// Accepts both formats.
 std::optional<std::vector<std::unique_ptr<IVideoJob>>> ParseJobsFromFile(std::string_view filename);
+
+// The dormant jobs, if any, are written after the others. For the XML format they're decoded one
+// at a time while writing.
 bool WriteJobsToFile(const std::vector<std::unique_ptr<IVideoJob>>& jobs,
-                     std::string_view filename);
+                     std::string_view filename,
+                     JobStoreFormat format,
+                     const DormantJobList* dormant = nullptr);
+
+// The job store is kept in a different file for each format, see WriteJobStore(). Returns the one
+// to load from, which is the file of the preferred format if that exists and the other otherwise.
+std::string_view ChooseJobStoreFile(std::string_view xmlPath,
+                                    std::string_view snapshotPath,
+                                    JobStoreFormat preferred);
+
+// Writes the file of the given format, then removes the file of the other format so that an
+// outdated copy of the jobs is never loaded after switching formats.
+bool WriteJobStore(const std::vector<std::unique_ptr<IVideoJob>>& jobs,
+                   std::string_view xmlPath,
+                   std::string_view snapshotPath,
+                   JobStoreFormat format,
+                   const DormantJobList* dormant = nullptr);
 } // namespace VodArchiver
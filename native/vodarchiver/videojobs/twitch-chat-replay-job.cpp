@@ -109,7 +109,7 @@ static ResultType RunChatJob(TwitchChatReplayJob& job,
     std::unique_ptr<IVideoInfo> videoInfo;
     bool assumeFinished = false;
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.JobStatus = VideoJobStatus::Running;
         videoInfo = job.VideoInfo->Clone();
         assumeFinished = job.AssumeFinished;
@@ -131,25 +131,25 @@ static ResultType RunChatJob(TwitchChatReplayJob& job,
     std::string_view videoIdString = videoInfo->GetVideoId(buffer);
     auto videoId = HyoutaUtils::NumberUtils::ParseInt64(videoIdString);
     if (!videoId) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = std::format("Failed to parse '{}' as integer", videoIdString);
         return ResultType::Failure;
     }
 
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.JobStatus = VideoJobStatus::Running;
         job.TextStatus = "Retrieving video info...";
     }
     auto video_json = TwitchYTDL::GetVideoJson(*videoId);
     if (!video_json) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Failed to retrieve video information";
         return ResultType::NetworkError;
     }
     auto twitchVideoData = TwitchYTDL::VideoFromJson(*video_json);
     if (!twitchVideoData) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Failed to parse video information";
         return ResultType::NetworkError;
     }
@@ -160,13 +160,13 @@ static ResultType RunChatJob(TwitchChatReplayJob& job,
         newVideoInfo->Video = std::move(*twitchVideoData);
         videoInfo = newVideoInfo->Clone();
 
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         MergeTwitchVideoInfo(newVideoInfo.get(), job.VideoInfo.get());
         job.VideoInfo = std::move(newVideoInfo);
     }
 
     if (!assumeFinished && videoInfo->GetVideoRecordingState() != RecordingState::Recorded) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.UserInputRequest = std::make_unique<UserInputRequestStreamLiveTwitchChatReplay>(&job);
         job.TextStatus = "Still live, retrying later";
         return ResultType::TemporarilyUnavailable;
@@ -181,19 +181,19 @@ static ResultType RunChatJob(TwitchChatReplayJob& job,
     if (HyoutaUtils::IO::DirectoryExists(std::string_view(tempfolder))
         == HyoutaUtils::IO::ExistsResult::DoesExist) {
         if (!DeleteDirectoryRecursive(std::string_view(tempfolder))) {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = "Failed to delete temp folder";
             return ResultType::IOError;
         }
     }
     if (!HyoutaUtils::IO::CreateDirectory(std::string_view(tempfolder))) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Failed to create temp folder";
         return ResultType::IOError;
     }
 
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Downloading chat data...";
     }
     std::vector<std::string> args;
@@ -215,21 +215,26 @@ static ResultType RunChatJob(TwitchChatReplayJob& job,
             "TwitchDownloaderCLI\\TwitchDownloaderCLI.exe",
             args,
             [&](std::string_view) {},
-            [&](std::string_view) {})
+            [&](std::string_view) {},
+            AcquireProcessSlot(ProcessClass::Io),
+            &cancellationToken)
         != 0) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        if (cancellationToken.IsCancellationRequested()) {
+            return ResultType::Cancelled;
+        }
+        JobDataWriteLock lock(job);
         job.TextStatus = "Failed to download chat json";
         return ResultType::NetworkError;
     }
     if (HyoutaUtils::IO::FileExists(std::string_view(tempname))
         != HyoutaUtils::IO::ExistsResult::DoesExist) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Chat json does not exist after download";
         return ResultType::NetworkError;
     }
 
     if (!HyoutaUtils::IO::Move(std::string_view(tempname), std::string_view(filename), true)) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Failed to move chat json";
         return ResultType::IOError;
     }
@@ -237,7 +242,7 @@ static ResultType RunChatJob(TwitchChatReplayJob& job,
     DeleteDirectoryRecursive(std::string_view(tempfolder));
 
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Done!";
         job.JobStatus = VideoJobStatus::Finished;
     }
@@ -255,7 +260,7 @@ std::string TwitchChatReplayJob::GenerateOutputFilename() {
 std::unique_ptr<IVideoJob> TwitchChatReplayJob::Clone() const {
     auto clone = std::make_unique<TwitchChatReplayJob>();
     clone->TextStatus = this->TextStatus;
-    clone->JobStatus = this->JobStatus;
+    clone->JobStatus = this->JobStatus.load();
     clone->HasBeenValidated = this->HasBeenValidated;
     clone->VideoInfo = this->VideoInfo ? this->VideoInfo->Clone() : nullptr;
     clone->JobStartTimestamp = this->JobStartTimestamp;
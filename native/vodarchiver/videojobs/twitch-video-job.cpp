@@ -16,6 +16,7 @@
 #include "vodarchiver/exec.h"
 #include "vodarchiver/ffmpeg_util.h"
 #include "vodarchiver/filename_util.h"
+#include "vodarchiver/metrics.h"
 #include "vodarchiver/twitch_util.h"
 #include "vodarchiver/videoinfo/twitch-video-info.h"
 
@@ -159,7 +160,7 @@ static ResultType Download(TwitchVideoJob& job,
     int triesLeft = MaxTries;
     while (files.size() < downloadInfos.size()) {
         if (triesLeft <= 0) {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = std::format(
                 "Failed to download individual parts after {} tries, aborting.", MaxTries);
             return ResultType::NetworkError;
@@ -184,7 +185,7 @@ static ResultType Download(TwitchVideoJob& job,
                 if (HyoutaUtils::IO::FileExists(std::string_view(alt_outpath))
                     == HyoutaUtils::IO::ExistsResult::DoesExist) {
                     if (i % 100 == 99) {
-                        std::lock_guard lock(*jobConfig.JobsLock);
+                        JobDataWriteLock lock(job);
                         job.TextStatus =
                             std::format("Already have part {}/{}...", i + 1, downloadInfos.size());
                     }
@@ -196,7 +197,7 @@ static ResultType Download(TwitchVideoJob& job,
             if (HyoutaUtils::IO::FileExists(std::string_view(outpath))
                 == HyoutaUtils::IO::ExistsResult::DoesExist) {
                 if (i % 100 == 99) {
-                    std::lock_guard lock(*jobConfig.JobsLock);
+                    JobDataWriteLock lock(job);
                     job.TextStatus =
                         std::format("Already have part {}/{}...", i + 1, downloadInfos.size());
                 }
@@ -206,7 +207,7 @@ static ResultType Download(TwitchVideoJob& job,
 
             bool success = false;
             {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.TextStatus = std::format(
                     "Downloading files... ({}/{})", files.size() + 1, downloadInfos.size());
             }
@@ -219,23 +220,25 @@ static ResultType Download(TwitchVideoJob& job,
                                                                      + *downloadInfo.Length - 1});
                 }
                 auto data = VodArchiver::curl::GetFromUrlToMemory(
-                    downloadInfo.Url, std::vector<std::string>(), ranges);
+                    downloadInfo.Url, std::vector<std::string>(), ranges, &cancellationToken);
                 if (!data || data->ResponseCode != 200) {
                     continue;
                 }
 
-                StallWrite(jobConfig,
-                           outpath_temp,
-                           data->Data.size(),
-                           cancellationToken,
-                           ShouldStallWriteRegularFile,
-                           [&](std::string status) {
-                               std::lock_guard lock(*jobConfig.JobsLock);
-                               job.TextStatus = std::move(status);
-                           });
+                auto reservedSpace = ReserveDiskSpace(
+                    jobConfig,
+                    job.Progress,
+                    outpath_temp,
+                    data->Data.size(),
+                    cancellationToken,
+                    GetMinimumFreeSpaceForRegularFile,
+                    [&](std::string status) {
+                        JobDataWriteLock lock(job);
+                        job.TextStatus = std::move(status);
+                    });
                 if (!HyoutaUtils::IO::WriteFileAtomic(
                         std::string_view(outpath_temp), data->Data.data(), data->Data.size())) {
-                    std::lock_guard lock(*jobConfig.JobsLock);
+                    JobDataWriteLock lock(job);
                     job.TextStatus = std::format("Failed to write {}", outpath_temp);
                     return ResultType::IOError;
                 }
@@ -243,17 +246,21 @@ static ResultType Download(TwitchVideoJob& job,
             }
 
             if (success) {
-                StallWrite(jobConfig,
-                           outpath,
-                           HyoutaUtils::IO::GetFilesize(std::string_view(outpath_temp)).value_or(0),
-                           cancellationToken,
-                           ShouldStallWriteRegularFile,
-                           [&](std::string status) {
-                               std::lock_guard lock(*jobConfig.JobsLock);
-                               job.TextStatus = std::move(status);
-                           });
+                auto reservedSpace = ReserveDiskSpace(
+                    jobConfig,
+                    job.Progress,
+                    outpath,
+                    HyoutaUtils::IO::GetFilesize(std::string_view(outpath_temp)).value_or(0),
+                    cancellationToken,
+                    GetMinimumFreeSpaceForRegularFile,
+                    [&](std::string status) {
+                        JobDataWriteLock lock(job);
+                        job.TextStatus = std::move(status);
+                    });
                 HyoutaUtils::IO::Move(outpath_temp, outpath, false);
                 files.push_back(std::move(outpath));
+                job.Progress.Heartbeat();
+                ++GetArchiverMetrics().TwitchSegmentsDownloaded;
             }
 
             if (cancellationToken.IsCancellationRequested()) {
@@ -279,6 +286,7 @@ static ResultType Download(TwitchVideoJob& job,
 }
 
 static ResultType Combine(TaskCancellation& cancellationToken,
+                          JobProgress& progress,
                           const std::string& combinedFilename,
                           const std::vector<std::string>& files) {
     // Console.WriteLine("Combining into " + combinedFilename + "...");
@@ -303,6 +311,7 @@ static ResultType Combine(TaskCancellation& cancellationToken,
         if (fs.Write(part, *len) != *len) {
             return ResultType::IOError;
         }
+        progress.Heartbeat();
     }
     if (!fs.Rename(std::string_view(combinedFilename))) {
         return ResultType::IOError;
@@ -310,7 +319,8 @@ static ResultType Combine(TaskCancellation& cancellationToken,
     return ResultType::Success;
 }
 
-static bool Remux(const std::string& targetName,
+static bool Remux(JobProgress& progress,
+                  const std::string& targetName,
                   const std::string& sourceName,
                   const std::string& tempName) {
     HyoutaUtils::IO::CreateDirectory(HyoutaUtils::IO::GetDirectoryName(targetName));
@@ -319,7 +329,8 @@ static bool Remux(const std::string& targetName,
         "ffmpeg_remux.exe",
         {{"-i", sourceName, "-codec", "copy", "-bsf:a", "aac_adtstoasc", tempName}},
         [&](std::string_view) {},
-        [&](std::string_view) {});
+        [&](std::string_view) { progress.Heartbeat(); }, // ffmpeg periodically prints stats here
+        AcquireProcessSlot(ProcessClass::Io));
     if (!HyoutaUtils::IO::Move(tempName, targetName, true)) {
         return false;
     }
@@ -593,7 +604,7 @@ static ResultType GetFileUrlsOfVod(TwitchVideoJob& job,
         newVideoInfo->Video = *twitchVideoFromJson;
         videoInfo = newVideoInfo->Clone();
 
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         MergeTwitchVideoInfo(newVideoInfo.get(), job.VideoInfo.get());
         job.VideoInfo = std::move(newVideoInfo);
     }
@@ -636,7 +647,11 @@ static ResultType GetFileUrlsOfVod(TwitchVideoJob& job,
                 return ResultType::Failure;
             }
             folderpath = GetFolder(*m3u8path);
-            auto result = VodArchiver::curl::GetFromUrlToMemory(*m3u8path);
+            auto result = VodArchiver::curl::GetFromUrlToMemory(
+                *m3u8path, std::vector<std::string>(), {}, &cancellationToken);
+            if (cancellationToken.IsCancellationRequested()) {
+                return ResultType::Cancelled;
+            }
             if (!result) {
                 return ResultType::NetworkError;
             }
@@ -662,7 +677,7 @@ static ResultType GetFileUrlsOfVod(TwitchVideoJob& job,
                     newVideoInfo->Video = *twitchVideoFromJson;
                     videoInfo = newVideoInfo->Clone();
 
-                    std::lock_guard lock(*jobConfig.JobsLock);
+                    JobDataWriteLock lock(job);
                     MergeTwitchVideoInfo(newVideoInfo.get(), job.VideoInfo.get());
                     job.VideoInfo = std::move(newVideoInfo);
                 }
@@ -686,7 +701,7 @@ static ResultType RunTwitchVideoJob(TwitchVideoJob& job,
     std::unique_ptr<IVideoInfo> videoInfo;
     std::string videoQuality;
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.JobStatus = VideoJobStatus::Running;
         job.TextStatus = "Retrieving video info...";
         videoInfo = job.VideoInfo->Clone();
@@ -709,12 +724,12 @@ static ResultType RunTwitchVideoJob(TwitchVideoJob& job,
     ResultType getFileUrlsResult = GetFileUrlsOfVod(
         job, jobConfig, videoInfo, downloadInfos, tempFolderPath, cancellationToken, videoQuality);
     if (getFileUrlsResult == ResultType::UserInputRequired) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Need manual fetch of file URLs.";
         return ResultType::UserInputRequired;
     }
     if (getFileUrlsResult != ResultType::Success) {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Failed retrieving file URLs.";
         return getFileUrlsResult;
     }
@@ -749,7 +764,7 @@ static ResultType RunTwitchVideoJob(TwitchVideoJob& job,
             }
 
             {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.TextStatus = "Downloading files...";
             }
             std::vector<std::string> files;
@@ -768,7 +783,7 @@ static ResultType RunTwitchVideoJob(TwitchVideoJob& job,
                 }
                 bool assumeFinished = false;
                 {
-                    std::lock_guard lock(*jobConfig.JobsLock);
+                    JobDataWriteLock lock(job);
                     assumeFinished = job.AssumeFinished;
                 }
                 if (assumeFinished
@@ -784,7 +799,7 @@ static ResultType RunTwitchVideoJob(TwitchVideoJob& job,
                         auto ts = std::chrono::seconds(150) - timerDifference;
                         const std::chrono::duration<double, std::ratio<1, 1>> tsDouble = ts;
                         {
-                            std::lock_guard lock(*jobConfig.JobsLock);
+                            JobDataWriteLock lock(job);
                             job.TextStatus = std::format(
                                 "Waiting {} seconds for stream to update...", tsDouble.count());
                             job.UserInputRequest =
@@ -803,19 +818,24 @@ static ResultType RunTwitchVideoJob(TwitchVideoJob& job,
                                                          cancellationToken,
                                                          videoQuality);
                     if (getFileUrlsResult != ResultType::Success) {
-                        std::lock_guard lock(*jobConfig.JobsLock);
+                        JobDataWriteLock lock(job);
                         job.TextStatus = "Failed retrieving file URLs.";
                         return getFileUrlsResult;
                     }
                 }
             }
             {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.UserInputRequest = nullptr;
                 job.TextStatus = "Waiting for free disk IO slot to combine...";
             }
+            job.ResourcePool.store(JobResourcePool::Disk);
             {
-                auto diskLock = jobConfig.ExpensiveDiskIO.WaitForFreeSlot(cancellationToken);
+                // the parts are in a subfolder next to the combined file, so one device covers both
+                JobIdleWait idle(job.Progress);
+                auto diskLock = jobConfig.ExpensiveDiskIO.WaitForFreeSlot(
+                    {combinedTempname}, cancellationToken);
+                idle.Finish();
                 if (cancellationToken.IsCancellationRequested()) {
                     return ResultType::Cancelled;
                 }
@@ -826,44 +846,47 @@ static ResultType RunTwitchVideoJob(TwitchVideoJob& job,
                 }
 
                 {
-                    std::lock_guard lock(*jobConfig.JobsLock);
+                    JobDataWriteLock lock(job);
                     job.TextStatus = "Combining downloaded video parts...";
                 }
                 HyoutaUtils::IO::DeleteFile(std::string_view(combinedTempname));
-                StallWrite(jobConfig,
-                           combinedFilename,
-                           expectedTargetFilesize,
-                           cancellationToken,
-                           ShouldStallWriteRegularFile,
-                           [&](std::string status) {
-                               std::lock_guard lock(*jobConfig.JobsLock);
-                               job.TextStatus = std::move(status);
-                           });
+                auto reservedSpace = ReserveDiskSpace(
+                    jobConfig,
+                    job.Progress,
+                    combinedFilename,
+                    expectedTargetFilesize,
+                    cancellationToken,
+                    GetMinimumFreeSpaceForRegularFile,
+                    [&](std::string status) {
+                        JobDataWriteLock lock(job);
+                        job.TextStatus = std::move(status);
+                    });
                 if (cancellationToken.IsCancellationRequested()) {
                     return ResultType::Cancelled;
                 }
-                ResultType combineResult = Combine(cancellationToken, combinedTempname, files);
+                ResultType combineResult =
+                    Combine(cancellationToken, job.Progress, combinedTempname, files);
                 if (combineResult != ResultType::Success) {
-                    std::lock_guard lock(*jobConfig.JobsLock);
+                    JobDataWriteLock lock(job);
                     job.TextStatus = "Combining failed.";
                     return combineResult;
                 }
 
                 // sanity check
                 {
-                    std::lock_guard lock(*jobConfig.JobsLock);
+                    JobDataWriteLock lock(job);
                     job.TextStatus = "Sanity check on combined video...";
                 }
                 auto probe = FFMpegProbe(combinedTempname);
                 if (!probe) {
-                    std::lock_guard lock(*jobConfig.JobsLock);
+                    JobDataWriteLock lock(job);
                     job.TextStatus = "Probing combined video failed.";
                     return ResultType::DubiousCombine;
                 }
                 TimeSpan actualVideoLength = probe->Duration;
                 TimeSpan expectedVideoLength = videoInfo->GetVideoLength();
                 {
-                    std::lock_guard lock(*jobConfig.JobsLock);
+                    JobDataWriteLock lock(job);
                     if (!job.IgnoreTimeDifferenceCombined
                         && std::abs((actualVideoLength - expectedVideoLength).GetTotalSeconds())
                                > 5.0) {
@@ -889,52 +912,59 @@ static ResultType RunTwitchVideoJob(TwitchVideoJob& job,
         }
 
         {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = "Waiting for free disk IO slot to remux...";
         }
+        job.ResourcePool.store(JobResourcePool::Disk);
         {
-            auto diskLock = jobConfig.ExpensiveDiskIO.WaitForFreeSlot(cancellationToken);
+            JobIdleWait idle(job.Progress);
+            // the final move may copy across volumes, so this also holds the target drive
+            auto diskLock = jobConfig.ExpensiveDiskIO.WaitForFreeSlot(
+                {remuxedTempname, targetFilename}, cancellationToken);
+            idle.Finish();
             if (cancellationToken.IsCancellationRequested()) {
                 return ResultType::Cancelled;
             }
             {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.TextStatus = "Remuxing to MP4...";
             }
             HyoutaUtils::IO::DeleteFile(std::string_view(remuxedTempname));
-            StallWrite(jobConfig,
-                       remuxedFilename,
-                       HyoutaUtils::IO::GetFilesize(std::string_view(combinedFilename)).value_or(0),
-                       cancellationToken,
-                       ShouldStallWriteRegularFile,
-                       [&](std::string status) {
-                           std::lock_guard lock(*jobConfig.JobsLock);
-                           job.TextStatus = std::move(status);
-                       });
+            auto reservedSpace = ReserveDiskSpace(
+                jobConfig,
+                job.Progress,
+                remuxedFilename,
+                HyoutaUtils::IO::GetFilesize(std::string_view(combinedFilename)).value_or(0),
+                cancellationToken,
+                GetMinimumFreeSpaceForRegularFile,
+                [&](std::string status) {
+                    JobDataWriteLock lock(job);
+                    job.TextStatus = std::move(status);
+                });
             if (cancellationToken.IsCancellationRequested()) {
                 return ResultType::Cancelled;
             }
-            if (!Remux(remuxedFilename, combinedFilename, remuxedTempname)) {
-                std::lock_guard lock(*jobConfig.JobsLock);
+            if (!Remux(job.Progress, remuxedFilename, combinedFilename, remuxedTempname)) {
+                JobDataWriteLock lock(job);
                 job.TextStatus = "Remuxing failed.";
                 return ResultType::Failure;
             }
 
             // sanity check
             {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.TextStatus = "Sanity check on remuxed video...";
             }
             auto probe = FFMpegProbe(remuxedFilename);
             if (!probe) {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.TextStatus = "Probe on remuxed video failed.";
                 return ResultType::DubiousRemux;
             }
             TimeSpan actualVideoLength = probe->Duration;
             TimeSpan expectedVideoLength = videoInfo->GetVideoLength();
             {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 if (!job.IgnoreTimeDifferenceRemuxed
                     && std::abs((actualVideoLength - expectedVideoLength).GetTotalSeconds())
                            > 5.0) {
@@ -958,7 +988,7 @@ static ResultType RunTwitchVideoJob(TwitchVideoJob& job,
     HyoutaUtils::IO::DeleteFile(std::string_view(tsnamesfilepath));
     HyoutaUtils::IO::DeleteFile(std::string_view(baseurlfilepath));
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Done!";
         job.JobStatus = VideoJobStatus::Finished;
     }
@@ -976,7 +1006,7 @@ std::string TwitchVideoJob::GenerateOutputFilename() {
 std::unique_ptr<IVideoJob> TwitchVideoJob::Clone() const {
     auto clone = std::make_unique<TwitchVideoJob>();
     clone->TextStatus = this->TextStatus;
-    clone->JobStatus = this->JobStatus;
+    clone->JobStatus = this->JobStatus.load();
     clone->HasBeenValidated = this->HasBeenValidated;
     clone->VideoInfo = this->VideoInfo ? this->VideoInfo->Clone() : nullptr;
     clone->JobStartTimestamp = this->JobStartTimestamp;
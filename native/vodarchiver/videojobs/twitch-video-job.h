@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -17,7 +18,7 @@ struct TwitchVideoJob : public IVideoJob {
 
     IUserInputRequest* GetUserInputRequest() const override;
     std::unique_ptr<IUserInputRequest> UserInputRequest = nullptr;
-    bool WaitingForUserInput = false;
+    std::atomic<bool> WaitingForUserInput = false; // see IsWaitingForUserInput()
     bool AssumeFinished = false;
 
     bool IgnoreTimeDifferenceCombined = false;
@@ -7,11 +7,12 @@
 #include <utility>
 
 #include "util/file.h"
-#include "util/text.h"
+#include "util/scope.h"
 
 #include "vodarchiver/exec.h"
 #include "vodarchiver/ffmpeg_util.h"
 #include "vodarchiver/filename_util.h"
+#include "vodarchiver/job_progress.h"
 #include "vodarchiver/videoinfo/youtube-video-info.h"
 #include "vodarchiver/youtube_util.h"
 
@@ -43,7 +44,7 @@ static ResultType RunYoutubeVideoJob(YoutubeVideoJob& job,
     std::unique_ptr<IVideoInfo> vi;
     bool wantCookies = false;
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.JobStatus = VideoJobStatus::Running;
         vi = job.VideoInfo->Clone();
         wantCookies = (job.Notes.find("cookies") != std::string::npos);
@@ -65,7 +66,7 @@ static ResultType RunYoutubeVideoJob(YoutubeVideoJob& job,
     std::array<char, 256> buffer2;
     if (dynamic_cast<YoutubeVideoInfo*>(vi.get()) == nullptr) {
         {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = "Retrieving video info...";
         }
         auto result =
@@ -75,19 +76,19 @@ static ResultType RunYoutubeVideoJob(YoutubeVideoJob& job,
             case Youtube::RetrieveVideoResult::Success:
                 vi = result.info->Clone();
                 {
-                    std::lock_guard lock(*jobConfig.JobsLock);
+                    JobDataWriteLock lock(job);
                     job.VideoInfo = std::move(result.info);
                 }
                 break;
             case Youtube::RetrieveVideoResult::ParseFailure:
                 // this seems to happen randomly from time to time, just retry later
                 {
-                    std::lock_guard lock(*jobConfig.JobsLock);
+                    JobDataWriteLock lock(job);
                     job.TextStatus = "Video info parsing failed, retrying later";
                 }
                 return ResultType::TemporarilyUnavailable;
             default: {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.TextStatus = "Video info retrieval failed";
                 return ResultType::NetworkError;
             }
@@ -113,19 +114,21 @@ static ResultType RunYoutubeVideoJob(YoutubeVideoJob& job,
                 return ResultType::Failure;
             }
             {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.TextStatus = "Running youtube-dl...";
             }
             // don't know expected filesize, so hope we have a sensible value in minimum free space
-            StallWrite(jobConfig,
-                       tempFilepath,
-                       0,
-                       cancellationToken,
-                       ShouldStallWriteRegularFile,
-                       [&](std::string status) {
-                           std::lock_guard lock(*jobConfig.JobsLock);
-                           job.TextStatus = std::move(status);
-                       });
+            auto reservedSpace = ReserveDiskSpace(
+                jobConfig,
+                job.Progress,
+                tempFilepath,
+                0,
+                cancellationToken,
+                GetMinimumFreeSpaceForRegularFile,
+                [&](std::string status) {
+                    JobDataWriteLock lock(job);
+                    job.TextStatus = std::move(status);
+                });
             if (cancellationToken.IsCancellationRequested()) {
                 return ResultType::Cancelled;
             }
@@ -140,6 +143,9 @@ static ResultType RunYoutubeVideoJob(YoutubeVideoJob& job,
                 "--abort-on-error",
                 "--abort-on-unavailable-fragment",
                 "--no-sponsorblock",
+                "--newline",
+                "--progress-template",
+                std::string(YtDlpProgressTemplate),
             }};
             if (wantCookies) {
                 args.push_back("--cookies");
@@ -148,27 +154,24 @@ static ResultType RunYoutubeVideoJob(YoutubeVideoJob& job,
             std::array<char, 256> buffer;
             args.push_back(
                 std::format("https://www.youtube.com/watch?v={}", vi->GetVideoId(buffer)));
-            std::string output;
-            if (RunProgram(
+            int rv;
+            {
+                // progress is reported lock-free through job.Progress
+                job.Progress.Begin(JobProgressKind::Download);
+                auto progressScope = HyoutaUtils::MakeScopeGuard([&]() { job.Progress.End(); });
+                YtDlpProgressParser parser(job.Progress);
+                rv = RunProgram(
                     "yt-dlp.exe",
                     args,
-                    [&](std::string_view sv) {
-                        output.append(sv);
-
-                        // only keep the last line
-                        std::string_view trimmed = HyoutaUtils::TextUtils::Trim(output);
-                        auto pos = trimmed.find_last_of("\r\n");
-                        if (pos != std::string_view::npos) {
-                            output.assign(trimmed.substr(pos + 1));
-                        }
-
-                        {
-                            std::lock_guard lock(*jobConfig.JobsLock);
-                            job.TextStatus = output;
-                        }
-                    },
-                    [](std::string_view sv) {})
-                != 0) {
+                    [&](std::string_view sv) { parser.Feed(sv); },
+                    [](std::string_view sv) {},
+                    AcquireProcessSlot(ProcessClass::Io),
+                    &cancellationToken);
+            }
+            if (cancellationToken.IsCancellationRequested()) {
+                return ResultType::Cancelled;
+            }
+            if (rv != 0) {
                 return ResultType::Failure;
             }
         }
@@ -177,29 +180,33 @@ static ResultType RunYoutubeVideoJob(YoutubeVideoJob& job,
         std::string finalFilepath = PathCombine(targetFolderPath, finalFilename);
         if (HyoutaUtils::IO::Exists(std::string_view(finalFilepath))
             == HyoutaUtils::IO::ExistsResult::DoesExist) {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = ("File exists: " + finalFilepath);
             return ResultType::Failure;
         }
 
         {
-            std::lock_guard lock(*jobConfig.JobsLock);
+            JobDataWriteLock lock(job);
             job.TextStatus = "Waiting for free disk IO slot to move...";
         }
+        job.ResourcePool.store(JobResourcePool::Disk);
         {
-            auto diskLock = jobConfig.ExpensiveDiskIO.WaitForFreeSlot(cancellationToken);
+            JobIdleWait idle(job.Progress);
+            auto diskLock = jobConfig.ExpensiveDiskIO.WaitForFreeSlot(
+                {tempFilepath, finalFilepath}, cancellationToken);
+            idle.Finish();
             if (cancellationToken.IsCancellationRequested()) {
                 return ResultType::Cancelled;
             }
 
             // sanity check
             {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.TextStatus = "Sanity check on downloaded video...";
             }
             auto probe = FFMpegProbe(tempFilepath);
             if (!probe) {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.TextStatus = "Probe failed!";
                 return ResultType::Failure;
             }
@@ -207,7 +214,7 @@ static ResultType RunYoutubeVideoJob(YoutubeVideoJob& job,
             TimeSpan expectedVideoLength = vi->GetVideoLength();
             if (std::abs((actualVideoLength - expectedVideoLength).GetTotalSeconds()) > 5.0) {
                 // if difference is bigger than 5 seconds something is off, report
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.TextStatus = std::format(
                     "Large time difference between expected ({}s) and actual ({}s), stopping.",
                     expectedVideoLength.GetTotalSeconds(),
@@ -216,7 +223,7 @@ static ResultType RunYoutubeVideoJob(YoutubeVideoJob& job,
             }
 
             {
-                std::lock_guard lock(*jobConfig.JobsLock);
+                JobDataWriteLock lock(job);
                 job.TextStatus = "Moving...";
             }
             if (!HyoutaUtils::IO::Move(
@@ -230,7 +237,7 @@ static ResultType RunYoutubeVideoJob(YoutubeVideoJob& job,
     }
 
     {
-        std::lock_guard lock(*jobConfig.JobsLock);
+        JobDataWriteLock lock(job);
         job.TextStatus = "Done!";
         job.JobStatus = VideoJobStatus::Finished;
     }
@@ -248,7 +255,7 @@ std::string YoutubeVideoJob::GenerateOutputFilename() {
 std::unique_ptr<IVideoJob> YoutubeVideoJob::Clone() const {
     auto clone = std::make_unique<YoutubeVideoJob>();
     clone->TextStatus = this->TextStatus;
-    clone->JobStatus = this->JobStatus;
+    clone->JobStatus = this->JobStatus.load();
     clone->HasBeenValidated = this->HasBeenValidated;
     clone->VideoInfo = this->VideoInfo ? this->VideoInfo->Clone() : nullptr;
     clone->JobStartTimestamp = this->JobStartTimestamp;
@@ -0,0 +1,209 @@
+#include "youtube_playlist_parser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "rapidjson/document.h"
+#include "rapidjson/reader.h"
+
+namespace VodArchiver::Youtube {
+void ProcessOutputStream::Append(std::string_view data) {
+    if (data.empty()) {
+        return;
+    }
+    std::unique_lock lock(Mutex);
+    CondVar.wait(lock, [&] { return QueuedBytes < MaxQueuedBytes || Abandoned; });
+    if (Abandoned) {
+        return;
+    }
+    Chunks.emplace_back(data);
+    QueuedBytes += data.size();
+    CondVar.notify_all();
+}
+
+void ProcessOutputStream::Close() {
+    std::lock_guard lock(Mutex);
+    Closed = true;
+    CondVar.notify_all();
+}
+
+void ProcessOutputStream::Abandon() {
+    std::lock_guard lock(Mutex);
+    Abandoned = true;
+    Chunks.clear();
+    QueuedBytes = 0;
+    CondVar.notify_all();
+}
+
+bool ProcessOutputStream::Refill() {
+    std::unique_lock lock(Mutex);
+    CondVar.wait(lock, [&] { return !Chunks.empty() || Closed; });
+    if (Chunks.empty()) {
+        return false;
+    }
+    Current = std::move(Chunks.front());
+    Chunks.pop_front();
+    QueuedBytes -= Current.size();
+    Position = 0;
+    CondVar.notify_all();
+    return true;
+}
+
+namespace {
+// SAX handler for the top level of a 'yt-dlp -J' playlist document. Everything is skipped except
+// for noting when an object inside the root 'entries' array starts, at which point the caller
+// takes over and collects that object with an EntryForwarder.
+struct PlaylistHandler : rapidjson::BaseReaderHandler<rapidjson::UTF8<char>, PlaylistHandler> {
+    bool Default() {
+        IsEntriesKey = false;
+        return Depth > 0;
+    }
+    bool Key(const char* str, rapidjson::SizeType length, bool) {
+        IsEntriesKey = (Depth == 1 && std::string_view(str, length) == "entries");
+        return true;
+    }
+    bool StartObject() {
+        IsEntriesKey = false;
+        if (InEntries && Depth == 2) {
+            EntryStarted = true;
+        }
+        ++Depth;
+        return true;
+    }
+    bool EndObject(rapidjson::SizeType) {
+        --Depth;
+        return true;
+    }
+    bool StartArray() {
+        if (Depth == 0) {
+            return false;
+        }
+        if (IsEntriesKey) {
+            IsEntriesKey = false;
+            InEntries = true;
+            SawEntries = true;
+        }
+        ++Depth;
+        return true;
+    }
+    bool EndArray(rapidjson::SizeType) {
+        --Depth;
+        if (Depth == 1) {
+            InEntries = false;
+        }
+        return true;
+    }
+
+    // called by the caller once it has consumed the entry object
+    void EntryConsumed() {
+        EntryStarted = false;
+        --Depth;
+    }
+
+    int Depth = 0;
+    bool IsEntriesKey = false;
+    bool InEntries = false;
+    bool SawEntries = false;
+    bool EntryStarted = false;
+};
+
+// Forwards SAX events into a document until the object that was open when it was created closes.
+struct EntryForwarder {
+    explicit EntryForwarder(rapidjson::Document& document) : Document(document) {}
+
+    bool Null() {
+        return Document.Null();
+    }
+    bool Bool(bool b) {
+        return Document.Bool(b);
+    }
+    bool Int(int i) {
+        return Document.Int(i);
+    }
+    bool Uint(unsigned i) {
+        return Document.Uint(i);
+    }
+    bool Int64(int64_t i) {
+        return Document.Int64(i);
+    }
+    bool Uint64(uint64_t i) {
+        return Document.Uint64(i);
+    }
+    bool Double(double d) {
+        return Document.Double(d);
+    }
+    bool RawNumber(const char* str, rapidjson::SizeType length, bool copy) {
+        return Document.RawNumber(str, length, copy);
+    }
+    bool String(const char* str, rapidjson::SizeType length, bool copy) {
+        return Document.String(str, length, copy);
+    }
+    bool Key(const char* str, rapidjson::SizeType length, bool copy) {
+        return Document.Key(str, length, copy);
+    }
+    bool StartObject() {
+        ++Depth;
+        return Document.StartObject();
+    }
+    bool EndObject(rapidjson::SizeType memberCount) {
+        --Depth;
+        return Document.EndObject(memberCount);
+    }
+    bool StartArray() {
+        ++Depth;
+        return Document.StartArray();
+    }
+    bool EndArray(rapidjson::SizeType elementCount) {
+        --Depth;
+        return Document.EndArray(elementCount);
+    }
+
+    rapidjson::Document& Document;
+    int Depth = 1;
+};
+} // namespace
+
+bool ParsePlaylistStream(ProcessOutputStream& stream,
+                         const std::function<void(const rapidjson::Document& entry)>& onEntry) {
+    rapidjson::Reader reader;
+    PlaylistHandler handler;
+    reader.IterativeParseInit();
+    while (!reader.IterativeParseComplete()) {
+        if (!reader.IterativeParseNext<YtDlpJsonParseFlags>(stream, handler)) {
+            return false;
+        }
+        if (!handler.EntryStarted) {
+            continue;
+        }
+
+        // collect just this entry into a document
+        rapidjson::Document entry;
+        bool entryComplete = false;
+        auto generator = [&](rapidjson::Document& document) {
+            EntryForwarder forwarder(document);
+            if (!document.StartObject()) {
+                return false;
+            }
+            while (forwarder.Depth > 0) {
+                if (!reader.IterativeParseNext<YtDlpJsonParseFlags>(stream, forwarder)) {
+                    return false;
+                }
+            }
+            entryComplete = true;
+            return true;
+        };
+        entry.Populate(generator);
+        if (!entryComplete) {
+            return false;
+        }
+        handler.EntryConsumed();
+        onEntry(entry);
+    }
+    return handler.SawEntries;
+}
+} // namespace VodArchiver::Youtube
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "rapidjson/document.h"
+#include "rapidjson/reader.h"
+
+namespace VodArchiver::Youtube {
+static constexpr unsigned YtDlpJsonParseFlags =
+    rapidjson::kParseFullPrecisionFlag | rapidjson::kParseNanAndInfFlag
+    | rapidjson::kParseCommentsFlag;
+
+// rapidjson input stream over the stdout of a child process. The process thread appends chunks as
+// they arrive while the parser thread reads them, blocking until more data is available. The
+// writer blocks while too much unparsed data is queued so memory use stays bounded.
+struct ProcessOutputStream {
+    using Ch = char;
+
+    Ch Peek() {
+        if (Position >= Current.size() && !Refill()) {
+            return '\0';
+        }
+        return Current[Position];
+    }
+    Ch Take() {
+        if (Position >= Current.size() && !Refill()) {
+            return '\0';
+        }
+        ++Consumed;
+        return Current[Position++];
+    }
+    size_t Tell() const {
+        return Consumed;
+    }
+
+    // only needed for in-situ parsing
+    Ch* PutBegin() {
+        return nullptr;
+    }
+    void Put(Ch) {}
+    void Flush() {}
+    size_t PutEnd(Ch*) {
+        return 0;
+    }
+
+    // called from the process thread
+    void Append(std::string_view data);
+    void Close();
+
+    // called from the parser thread once it stops reading, any further output is dropped
+    void Abandon();
+
+private:
+    bool Refill();
+
+    static constexpr size_t MaxQueuedBytes = 1024 * 1024;
+
+    std::string Current;
+    size_t Position = 0;
+    size_t Consumed = 0;
+
+    std::mutex Mutex;
+    std::condition_variable CondVar;
+    std::deque<std::string> Chunks;
+    size_t QueuedBytes = 0;
+    bool Closed = false;
+    bool Abandoned = false;
+};
+
+// Parses a 'yt-dlp -J' playlist document from the stream and calls onEntry for every object in its
+// 'entries' array as soon as that object has been read. Only a single entry is kept in memory at a
+// time. Returns false if the document is malformed or has no 'entries', in which case onEntry may
+// already have been called for some entries.
+bool ParsePlaylistStream(ProcessOutputStream& stream,
+                         const std::function<void(const rapidjson::Document& entry)>& onEntry);
+} // namespace VodArchiver::Youtube
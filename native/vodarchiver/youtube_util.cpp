@@ -1,21 +1,30 @@
 #include "youtube_util.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <format>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 #include "rapidjson/document.h"
 
 #include "util/number.h"
+#include "util/scope.h"
 #include "util/text.h"
+#include "util/thread.h"
 
 #include "vodarchiver/exec.h"
+#include "vodarchiver/process_governor.h"
+#include "vodarchiver/task_cancellation.h"
 #include "vodarchiver/videoinfo/generic-video-info.h"
 #include "vodarchiver/videoinfo/i-video-info.h"
 #include "vodarchiver/videoinfo/youtube-video-info.h"
+#include "vodarchiver/youtube_playlist_parser.h"
 
 namespace VodArchiver::Youtube {
 static std::optional<std::string>
@@ -183,9 +192,7 @@ RetrieveVideoResultStruct
     }
 
     rapidjson::Document json;
-    json.Parse<rapidjson::kParseFullPrecisionFlag | rapidjson::kParseNanAndInfFlag
-                   | rapidjson::kParseCommentsFlag,
-               rapidjson::UTF8<char>>(raw.data(), raw.size());
+    json.Parse<YtDlpJsonParseFlags, rapidjson::UTF8<char>>(raw.data(), raw.size());
     if (json.HasParseError() || !json.IsObject()) {
         return RetrieveVideoResultStruct{.result = RetrieveVideoResult::FetchFailure,
                                          .info = nullptr};
@@ -195,51 +202,111 @@ RetrieveVideoResultStruct
     return ParseFromJson(constJson.GetObject(), false, usernameIfNotInJson);
 }
 
-static std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
-    RetrieveVideosFromParameterString(const std::string& parameter,
-                                      bool flat,
-                                      const std::string& usernameIfNotInJson) {
-    std::string raw;
-    {
+namespace {
+struct PlaylistListing {
+    std::vector<std::unique_ptr<IVideoInfo>> Videos;
+    size_t EntryCount = 0; // including entries that failed to parse
+};
+} // namespace
+
+// playlistEnd of 0 lists the entire playlist
+static std::optional<PlaylistListing> ListPlaylist(const std::string& parameter,
+                                                   bool flat,
+                                                   const std::string& usernameIfNotInJson,
+                                                   size_t playlistEnd) {
+    // the output for large channels can be tens of megabytes, so parse it while yt-dlp is still
+    // writing it and only ever keep a single entry in memory
+    ProcessOutputStream stream;
+    TaskCancellation cancellationToken;
+    std::thread ytdlpThread([&]() {
+        HyoutaUtils::SetThreadName("YtDlpThread");
         std::vector<std::string> args;
         if (flat) {
             args.push_back("--flat-playlist");
         }
+        if (playlistEnd > 0) {
+            args.push_back("--playlist-end");
+            args.push_back(std::format("{}", playlistEnd));
+        }
         args.push_back("--ignore-errors");
         args.push_back("-J");
         args.push_back(parameter);
         RunProgram(
             "yt-dlp.exe",
             args,
-            [&](std::string_view a) { raw.append(a); },
-            [&](std::string_view) {});
-    }
+            [&](std::string_view a) { stream.Append(a); },
+            [&](std::string_view) {},
+            AcquireProcessSlot(ProcessClass::Interactive),
+            &cancellationToken);
+        stream.Close();
+    });
+    auto ytdlpThreadScope = HyoutaUtils::MakeScopeGuard([&]() {
+        // if we stopped parsing early yt-dlp may still be listing, nothing reads its output anymore
+        cancellationToken.CancelTask();
+        stream.Abandon();
+        ytdlpThread.join();
+    });
+
     // try parsing regardless of exit code
-    rapidjson::Document json;
-    json.Parse<rapidjson::kParseFullPrecisionFlag | rapidjson::kParseNanAndInfFlag
-                   | rapidjson::kParseCommentsFlag,
-               rapidjson::UTF8<char>>(raw.data(), raw.size());
-    if (json.HasParseError() || !json.IsObject()) {
+    PlaylistListing listing;
+    const bool success = ParsePlaylistStream(stream, [&](const rapidjson::Document& entry) {
+        ++listing.EntryCount;
+        auto d = ParseFromJson(entry.GetObject(), flat, usernameIfNotInJson);
+        if (d.result == RetrieveVideoResult::Success) {
+            listing.Videos.push_back(std::move(d.info));
+        }
+    });
+    if (!success) {
         return std::nullopt;
     }
+    return listing;
+}
 
-    const auto jo = json.GetObject();
-    const auto entriesIt = jo.FindMember("entries");
-    if (entriesIt == jo.MemberEnd() || !entriesIt->value.IsArray()) {
+static std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
+    RetrieveVideosFromParameterString(const std::string& parameter,
+                                      bool flat,
+                                      const std::string& usernameIfNotInJson) {
+    auto listing = ListPlaylist(parameter, flat, usernameIfNotInJson, 0);
+    if (!listing) {
         return std::nullopt;
     }
-    const auto jsonEntries = entriesIt->value.GetArray();
-
-    std::vector<std::unique_ptr<IVideoInfo>> list;
-    for (const auto& jsonEntry : jsonEntries) {
-        if (jsonEntry.IsObject()) {
-            auto d = ParseFromJson(jsonEntry.GetObject(), flat, usernameIfNotInJson);
-            if (d.result == RetrieveVideoResult::Success) {
-                list.push_back(std::move(d.info));
+    return std::move(listing->Videos);
+}
+
+static std::optional<std::vector<std::unique_ptr<IVideoInfo>>> RetrieveNewVideosFromParameterString(
+    const std::string& parameter,
+    const std::string& usernameIfNotInJson,
+    const std::function<bool(const IVideoInfo& info)>& isKnown,
+    const std::function<bool()>& waitForRequestSlot) {
+    // list a small window of the newest videos first and widen it until it reaches a video we
+    // already know about. re-listing the start of the window each time is cheap compared to
+    // enumerating a channel with thousands of videos.
+    static constexpr size_t InitialWindowSize = 30;
+    static constexpr size_t MaximumWindowSize = 1920;
+    size_t windowSize = InitialWindowSize;
+    while (true) {
+        if (!waitForRequestSlot()) {
+            return std::nullopt;
+        }
+        auto listing = ListPlaylist(parameter, true, usernameIfNotInJson, windowSize);
+        if (!listing) {
+            return std::nullopt;
+        }
+        if (listing->EntryCount < windowSize
+            || std::any_of(listing->Videos.begin(),
+                           listing->Videos.end(),
+                           [&](const std::unique_ptr<IVideoInfo>& v) { return isKnown(*v); })) {
+            return std::move(listing->Videos);
+        }
+        if (windowSize >= MaximumWindowSize) {
+            // nothing we know about anywhere near the top, just list everything
+            if (!waitForRequestSlot()) {
+                return std::nullopt;
             }
+            return RetrieveVideosFromParameterString(parameter, true, usernameIfNotInJson);
         }
+        windowSize *= 4;
     }
-    return list;
 }
 
 std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
@@ -267,4 +334,30 @@ std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
     RetrieveVideosFromUrl(const std::string& url, bool flat) {
     return RetrieveVideosFromParameterString(url, flat, url);
 }
+
+std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
+    RetrieveNewVideosFromChannel(const std::string& channel,
+                                 const std::string& usernameIfNotInJson,
+                                 const std::function<bool(const IVideoInfo& info)>& isKnown,
+                                 const std::function<bool()>& waitForRequestSlot) {
+    return RetrieveNewVideosFromParameterString("https://www.youtube.com/channel/" + channel,
+                                                usernameIfNotInJson,
+                                                isKnown,
+                                                waitForRequestSlot);
+}
+
+std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
+    RetrieveNewVideosFromUser(const std::string& user,
+                              const std::function<bool(const IVideoInfo& info)>& isKnown,
+                              const std::function<bool()>& waitForRequestSlot) {
+    return RetrieveNewVideosFromParameterString(
+        "ytuser:" + user, user, isKnown, waitForRequestSlot);
+}
+
+std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
+    RetrieveNewVideosFromUrl(const std::string& url,
+                             const std::function<bool(const IVideoInfo& info)>& isKnown,
+                             const std::function<bool()>& waitForRequestSlot) {
+    return RetrieveNewVideosFromParameterString(url, url, isKnown, waitForRequestSlot);
+}
 } // namespace VodArchiver::Youtube
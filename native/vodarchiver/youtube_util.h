@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -22,6 +23,25 @@ std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
 std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
     RetrieveVideosFromUrl(const std::string& url, bool flat);
 
+// Flat listings of only the newest videos. These assume the listing is ordered newest first and
+// stop once they reach a video for which isKnown returns true, though the returned list may still
+// contain some known videos.
+// Every yt-dlp run is a request of its own, waitForRequestSlot is called before each one. If it
+// returns false the listing is abandoned.
+std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
+    RetrieveNewVideosFromChannel(const std::string& channel,
+                                 const std::string& usernameIfNotInJson,
+                                 const std::function<bool(const IVideoInfo& info)>& isKnown,
+                                 const std::function<bool()>& waitForRequestSlot);
+std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
+    RetrieveNewVideosFromUser(const std::string& user,
+                              const std::function<bool(const IVideoInfo& info)>& isKnown,
+                              const std::function<bool()>& waitForRequestSlot);
+std::optional<std::vector<std::unique_ptr<IVideoInfo>>>
+    RetrieveNewVideosFromUrl(const std::string& url,
+                             const std::function<bool(const IVideoInfo& info)>& isKnown,
+                             const std::function<bool()>& waitForRequestSlot);
+
 enum class RetrieveVideoResult : uint8_t { Success, FetchFailure, ParseFailure };
 struct RetrieveVideoResultStruct {
     RetrieveVideoResult result;